@@ -134,6 +134,7 @@ HEADERS += sources/document.h
 SOURCES += sources/document.cc
 SOURCES += sources/document_component.cc
 SOURCES += sources/document_edge.cc
+SOURCES += sources/document_history.cc
 SOURCES += sources/document_node.cc
 SOURCES += sources/document_part.cc
 HEADERS += sources/document_saver.h
@@ -150,6 +151,8 @@ HEADERS += sources/float_number_widget.h
 SOURCES += sources/float_number_widget.cc
 HEADERS += sources/flow_layout.h
 SOURCES += sources/flow_layout.cc
+HEADERS += sources/generation_server.h
+SOURCES += sources/generation_server.cc
 HEADERS += sources/glb_file.h
 SOURCES += sources/glb_file.cc
 HEADERS += sources/glb_forever.h
@@ -224,6 +227,8 @@ HEADERS += sources/preview_overlay_controller.h
 SOURCES += sources/preview_overlay_controller.cc
 HEADERS += sources/export_animation_worker.h
 SOURCES += sources/export_animation_worker.cc
+HEADERS += sources/export_planner.h
+SOURCES += sources/export_planner.cc
 HEADERS += sources/export_progress_widget.h
 SOURCES += sources/export_progress_widget.cc
 HEADERS += sources/preferences.h
@@ -232,6 +237,8 @@ HEADERS += sources/preview_grid_view.h
 SOURCES += sources/preview_grid_view.cc
 HEADERS += sources/skeleton_graphics_edge_item.h
 SOURCES += sources/skeleton_graphics_edge_item.cc
+HEADERS += sources/skeleton_graphics_item_index.h
+SOURCES += sources/skeleton_graphics_item_index.cc
 HEADERS += sources/skeleton_graphics_node_item.h
 SOURCES += sources/skeleton_graphics_node_item.cc
 HEADERS += sources/skeleton_graphics_origin_item.h
@@ -275,6 +282,7 @@ HEADERS += third_party/miniz/miniz.h
 HEADERS += ../dust3d/base/axis_aligned_bounding_box.h
 HEADERS += ../dust3d/base/axis_aligned_bounding_box_tree.h
 SOURCES += ../dust3d/base/axis_aligned_bounding_box_tree.cc
+HEADERS += ../dust3d/base/cancellation_token.h
 HEADERS += ../dust3d/base/color.h
 HEADERS += ../dust3d/base/combine_mode.h
 SOURCES += ../dust3d/base/combine_mode.cc
@@ -286,13 +294,18 @@ SOURCES += ../dust3d/base/ds3_file.cc
 HEADERS += ../dust3d/base/math.h
 HEADERS += ../dust3d/base/matrix4x4.h
 HEADERS += ../dust3d/base/object.h
+HEADERS += ../dust3d/base/parallel.h
 HEADERS += ../dust3d/base/part_target.h
 SOURCES += ../dust3d/base/part_target.cc
+HEADERS += ../dust3d/base/point_kd_tree.h
+SOURCES += ../dust3d/base/point_kd_tree.cc
 HEADERS += ../dust3d/base/position_key.h
 SOURCES += ../dust3d/base/position_key.cc
 HEADERS += ../dust3d/base/quaternion.h
 HEADERS += ../dust3d/base/rectangle.h
 HEADERS += ../dust3d/base/snapshot.h
+HEADERS += ../dust3d/base/snapshot_binary.h
+SOURCES += ../dust3d/base/snapshot_binary.cc
 HEADERS += ../dust3d/base/snapshot_xml.h
 SOURCES += ../dust3d/base/snapshot_xml.cc
 HEADERS += ../dust3d/base/string.h
@@ -402,6 +415,8 @@ SOURCES += ../dust3d/animation/snake/idle.cc
 SOURCES += ../dust3d/mesh/base_normal.cc
 HEADERS += ../dust3d/mesh/centripetal_catmull_rom_spline.h
 SOURCES += ../dust3d/mesh/centripetal_catmull_rom_spline.cc
+HEADERS += ../dust3d/mesh/encode_meshopt_buffer.h
+SOURCES += ../dust3d/mesh/encode_meshopt_buffer.cc
 HEADERS += ../dust3d/mesh/solid_mesh.h
 SOURCES += ../dust3d/mesh/solid_mesh.cc
 HEADERS += ../dust3d/mesh/solid_mesh_boolean_operation.h
@@ -414,11 +429,15 @@ HEADERS += ../dust3d/mesh/mesh_combiner.h
 SOURCES += ../dust3d/mesh/mesh_combiner.cc
 HEADERS += ../dust3d/mesh/mesh_generator.h
 SOURCES += ../dust3d/mesh/mesh_generator.cc
+HEADERS += ../dust3d/mesh/mesh_generator_disk_cache.h
+SOURCES += ../dust3d/mesh/mesh_generator_disk_cache.cc
 HEADERS += ../dust3d/mesh/mesh_node.h
 HEADERS += ../dust3d/mesh/mesh_recombiner.h
 SOURCES += ../dust3d/mesh/mesh_recombiner.cc
 HEADERS += ../dust3d/mesh/mesh_state.h
 SOURCES += ../dust3d/mesh/mesh_state.cc
+HEADERS += ../dust3d/mesh/optimize_triangle_order.h
+SOURCES += ../dust3d/mesh/optimize_triangle_order.cc
 HEADERS += ../dust3d/mesh/re_triangulator.h
 SOURCES += ../dust3d/mesh/re_triangulator.cc
 HEADERS += ../dust3d/mesh/resolve_triangle_tangent.h
@@ -427,6 +446,8 @@ HEADERS += ../dust3d/mesh/rope_mesh.h
 SOURCES += ../dust3d/mesh/rope_mesh.cc
 HEADERS += ../dust3d/mesh/section_remesher.h
 SOURCES += ../dust3d/mesh/section_remesher.cc
+HEADERS += ../dust3d/mesh/simplify_mesh.h
+SOURCES += ../dust3d/mesh/simplify_mesh.cc
 HEADERS += ../dust3d/mesh/smooth_normal.h
 SOURCES += ../dust3d/mesh/smooth_normal.cc
 HEADERS += ../dust3d/mesh/spine_deformer.h
@@ -440,12 +461,16 @@ HEADERS += ../dust3d/mesh/trim_vertices.h
 SOURCES += ../dust3d/mesh/trim_vertices.cc
 HEADERS += ../dust3d/mesh/tube_mesh_builder.h
 SOURCES += ../dust3d/mesh/tube_mesh_builder.cc
+HEADERS += ../dust3d/mesh/write_obj.h
+SOURCES += ../dust3d/mesh/write_obj.cc
 HEADERS += ../dust3d/rig/rig_generator.h
 SOURCES += ../dust3d/rig/rig_generator.cc
 HEADERS += ../dust3d/uv/chart_packer.h
 SOURCES += ../dust3d/uv/chart_packer.cc
 HEADERS += ../dust3d/uv/max_rectangles.h
 SOURCES += ../dust3d/uv/max_rectangles.cc
+HEADERS += ../dust3d/uv/texture_baker.h
+SOURCES += ../dust3d/uv/texture_baker.cc
 HEADERS += ../dust3d/uv/uv_map_packer.h
 SOURCES += ../dust3d/uv/uv_map_packer.cc
 HEADERS += ../third_party/GuigueDevillers03/tri_tri_intersect.h
@@ -353,7 +353,7 @@ void AnimationManageWidget::displayCurrentFrame()
     if (m_currentFrame < 0 || m_currentFrame >= (int)m_animationFrames.size())
         m_currentFrame = 0;
 
-    ModelMesh& frameSource = m_animationFrames[m_currentFrame];
+    const ModelMesh& frameSource = m_animationFrames[m_currentFrame];
     if (m_modelWidget->isWireframeVisible()) {
         int skeletonCount = frameSource.skeletonVertexCount();
         int totalCount = frameSource.triangleVertexCount();
@@ -117,8 +117,8 @@ void AnimationPreviewWorker::process()
 
                 if (i < m_rigObject->vertexBone1.size()) {
                     const auto& b1 = m_rigObject->vertexBone1[i];
-                    if (!b1.first.empty()) {
-                        auto it = frame.boneSkinMatrices.find(b1.first);
+                    if (b1.first >= 0) {
+                        auto it = frame.boneSkinMatrices.find(m_rigObject->vertexBoneName(b1.first));
                         if (it != frame.boneSkinMatrices.end()) {
                             transformed += it->second.transformPoint(origin) * b1.second;
                             totalWeight += b1.second;
@@ -128,8 +128,8 @@ void AnimationPreviewWorker::process()
 
                 if (i < m_rigObject->vertexBone2.size()) {
                     const auto& b2 = m_rigObject->vertexBone2[i];
-                    if (!b2.first.empty()) {
-                        auto it = frame.boneSkinMatrices.find(b2.first);
+                    if (b2.first >= 0) {
+                        auto it = frame.boneSkinMatrices.find(m_rigObject->vertexBoneName(b2.first));
                         if (it != frame.boneSkinMatrices.end()) {
                             transformed += it->second.transformPoint(origin) * b2.second;
                             totalWeight += b2.second;
@@ -200,13 +200,13 @@ void AnimationPreviewWorker::process()
     }
 
     if (!m_selectedBoneName.isEmpty() && m_rigObject) {
-        std::string selectedBoneStd = m_selectedBoneName.toStdString();
+        int selectedBone = m_rigObject->findBoneName(m_selectedBoneName.toStdString());
         std::vector<dust3d::Color> vertexWeightColors(m_rigObject->vertices.size());
         for (size_t i = 0; i < m_rigObject->vertices.size(); ++i) {
             float weight = 0.0f;
-            if (i < m_rigObject->vertexBone1.size() && m_rigObject->vertexBone1[i].first == selectedBoneStd)
+            if (-1 != selectedBone && i < m_rigObject->vertexBone1.size() && m_rigObject->vertexBone1[i].first == selectedBone)
                 weight += m_rigObject->vertexBone1[i].second;
-            if (i < m_rigObject->vertexBone2.size() && m_rigObject->vertexBone2[i].first == selectedBoneStd)
+            if (-1 != selectedBone && i < m_rigObject->vertexBone2.size() && m_rigObject->vertexBone2[i].first == selectedBone)
                 weight += m_rigObject->vertexBone2[i].second;
             vertexWeightColors[i] = calculateBoneWeightColor(weight);
         }
@@ -230,6 +230,10 @@ void AnimationPreviewWorker::process()
         }
     }
 
+    // Frames are packed once here instead of on every display
+    for (auto& frame : m_previewMeshes)
+        frame.packTriangleVertices();
+
     qDebug() << "Animation preview: generated" << m_previewMeshes.size() << "frames";
 
     emit finished();
@@ -401,7 +401,7 @@ ComponentPropertyWidget::ComponentPropertyWidget(Document* document,
         ImagePreviewWidget* colorImagePreviewWidget = new ImagePreviewWidget;
         colorImagePreviewWidget->setFixedSize(Theme::partPreviewImageSize * 2, Theme::partPreviewImageSize * 2);
         auto colorImageId = lastColorImageId();
-        const QImage* colorImage = nullptr;
+        std::shared_ptr<const QImage> colorImage;
         if (!colorImageId.isNull())
             colorImage = ImageForever::get(colorImageId);
         colorImagePreviewWidget->updateImage(nullptr == colorImage ? QImage() : *colorImage);
@@ -1,11 +1,13 @@
 #include "document.h"
 #include "glb_forever.h"
 #include "mesh_generator.h"
+#include "preferences.h"
 #include "rig_generator_worker.h"
 #include "uv_map_generator.h"
 #include <QApplication>
 #include <QClipboard>
 #include <QDebug>
+#include <QDir>
 #include <QElapsedTimer>
 #include <QFile>
 #include <QFileDialog>
@@ -24,12 +26,27 @@ unsigned long Document::m_maxSnapshot = 1000;
 
 Document::Document()
 {
-    loadRigStructures();
+    loadRigStructures(&m_rigStructures);
+
+    // Edits which leave parts and components clean still change their records in the generation snapshot
+    auto markPartChanged = [this](dust3d::Uuid partId) {
+        m_changedGenerationPartIds.insert(partId);
+    };
+    auto markComponentChanged = [this](dust3d::Uuid componentId) {
+        m_changedGenerationComponentIds.insert(componentId);
+    };
+    connect(this, &Document::partLockStateChanged, this, markPartChanged);
+    connect(this, &Document::partVisibleStateChanged, this, markPartChanged);
+    connect(this, &Document::componentNameChanged, this, markComponentChanged);
+    connect(this, &Document::componentChildrenChanged, this, markComponentChanged);
+    connect(this, &Document::componentExpandStateChanged, this, markComponentChanged);
 }
 
 Document::~Document()
 {
     // Ensure workers are stopped before cleanup
+    if (nullptr != m_meshGenerationCancellationToken)
+        m_meshGenerationCancellationToken->cancel();
     if (nullptr != m_meshGeneratorThread) {
         m_meshGeneratorThread->quit();
         m_meshGeneratorThread->wait();
@@ -45,6 +62,7 @@ Document::~Document()
     }
 
     m_generatedCacheContext.reset();
+    m_draftGeneratedCacheContext.reset();
     m_resultMesh.reset();
     textureImage.reset();
     textureNormalImage.reset();
@@ -1134,15 +1152,20 @@ void Document::setComponentColorImage(const dust3d::Uuid& componentId, const dus
     component->second.colorImageId = imageId;
     component->second.isPreviewMeshObsolete = true;
     component->second.dirty = true;
-    if (nullptr != m_currentSnapshot) {
-        auto componentSnapshotIt = m_currentSnapshot->components.find(componentId.toString());
-        if (componentSnapshotIt != m_currentSnapshot->components.end()) {
-            if (imageId.isNull())
-                componentSnapshotIt->second.erase("colorImageId");
-            else
-                componentSnapshotIt->second["colorImageId"] = imageId.toString();
-        }
-    }
+    // The texture can be regenerated from the current mesh, so the generated snapshot takes the image right away
+    auto patchColorImageId = [&](dust3d::Snapshot* snapshot) {
+        auto componentSnapshotIt = snapshot->components.find(componentId.toString());
+        if (componentSnapshotIt == snapshot->components.end())
+            return;
+        if (imageId.isNull())
+            componentSnapshotIt->second.erase("colorImageId");
+        else
+            componentSnapshotIt->second["colorImageId"] = imageId.toString();
+    };
+    if (!m_isGenerationSnapshotLent)
+        patchColorImageId(m_generationSnapshot.get());
+    if (nullptr != m_currentSnapshotOverlay)
+        patchColorImageId(&m_currentSnapshotOverlay->records);
     emit componentColorImageChanged(componentId);
 
     // For stitching loop components, changing colorImageId changes the UV layout (single
@@ -1625,6 +1648,7 @@ void Document::setEdgeBoneName(dust3d::Uuid edgeId, const QString& boneName)
         return;
 
     edgeIt->second.boneName = boneName;
+    m_changedGenerationEdgeIds.insert(edgeId);
     emit skeletonChanged();
 }
 
@@ -1646,6 +1670,8 @@ void Document::resetDirtyFlags()
     for (auto& component : componentMap) {
         component.second.dirty = false;
     }
+    m_removedPartIds.clear();
+    m_removedComponentIds.clear();
 }
 
 void Document::markAllDirty()
@@ -1729,10 +1755,12 @@ void Document::generateRig()
 
     m_isRigObsolete = false;
 
-    if (!m_uvMappedObject || m_uvMappedObject->vertices.empty() || nullptr == m_currentSnapshot)
+    if (!m_uvMappedObject || m_uvMappedObject->vertices.empty())
         return;
 
-    auto snapshot = std::make_unique<dust3d::Snapshot>(*m_currentSnapshot);
+    auto snapshot = generatedSnapshot();
+    if (nullptr == snapshot)
+        return;
 
     auto object = std::make_unique<dust3d::Object>(*m_uvMappedObject);
 
@@ -1774,7 +1802,7 @@ void Document::rigReady()
     }
 }
 
-void Document::loadRigStructures()
+void Document::loadRigStructures(std::map<QString, RigStructure>* rigStructures)
 {
     const QStringList rigFiles = {
         ":/resources/rig_biped.xml",
@@ -1787,13 +1815,13 @@ void Document::loadRigStructures()
     };
 
     for (const auto& filePath : rigFiles) {
-        loadRigFromXml(filePath);
+        loadRigFromXml(filePath, rigStructures);
     }
 
-    qDebug() << "Document loaded" << m_rigStructures.size() << "rig structures";
+    qDebug() << "Document loaded" << rigStructures->size() << "rig structures";
 }
 
-bool Document::loadRigFromXml(const QString& filePath)
+bool Document::loadRigFromXml(const QString& filePath, std::map<QString, RigStructure>* rigStructures)
 {
     QFile file(filePath);
     if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
@@ -1870,7 +1898,7 @@ bool Document::loadRigFromXml(const QString& filePath)
         }
 
         if (!rigStruct.type.isEmpty()) {
-            m_rigStructures[rigStruct.type] = rigStruct;
+            (*rigStructures)[rigStruct.type] = rigStruct;
             return true;
         }
 
@@ -2047,6 +2075,294 @@ void Document::setNodeAddProfile(Document::Profile profile)
     emit nodeAddProfileChanged(profile);
 }
 
+std::map<std::string, std::string> Document::partSnapshotRecord(const Part& source) const
+{
+    std::map<std::string, std::string> part;
+    part["id"] = source.id.toString();
+    part["visible"] = source.visible ? "true" : "false";
+    part["locked"] = source.locked ? "true" : "false";
+    part["subdived"] = source.subdived ? "true" : "false";
+    part["disabled"] = source.disabled ? "true" : "false";
+    part["xMirrored"] = source.xMirrored ? "true" : "false";
+    part["rounded"] = source.rounded ? "true" : "false";
+    part["chamfered"] = source.chamfered ? "true" : "false";
+    if (source.fillLoopInterior)
+        part["fillLoopInterior"] = "true";
+    if (dust3d::PartTarget::Model != source.target)
+        part["target"] = PartTargetToString(source.target);
+    if (source.cutRotationAdjusted())
+        part["cutRotation"] = std::to_string(source.cutRotation);
+    if (source.cutFaceAdjusted()) {
+        if (dust3d::CutFace::UserDefined == source.cutFace) {
+            if (!source.cutFaceLinkedId.isNull()) {
+                part["cutFace"] = source.cutFaceLinkedId.toString();
+            }
+        } else {
+            part["cutFace"] = CutFaceToString(source.cutFace);
+        }
+    }
+    if (source.metalnessAdjusted())
+        part["metallic"] = std::to_string(source.metalness);
+    if (source.roughnessAdjusted())
+        part["roughness"] = std::to_string(source.roughness);
+    if (source.deformThicknessAdjusted())
+        part["deformThickness"] = std::to_string(source.deformThickness);
+    if (source.deformWidthAdjusted())
+        part["deformWidth"] = std::to_string(source.deformWidth);
+    if (source.deformUnified)
+        part["deformUnified"] = "true";
+    if (source.hollowThicknessAdjusted())
+        part["hollowThickness"] = std::to_string(source.hollowThickness);
+    if (!source.importedModelId.isNull())
+        part["importedModelId"] = source.importedModelId.toString();
+    if (!source.name.isEmpty())
+        part["name"] = source.name.toUtf8().constData();
+    return part;
+}
+
+std::map<std::string, std::string> Document::nodeSnapshotRecord(const Node& source) const
+{
+    std::map<std::string, std::string> node;
+    node["id"] = source.id.toString();
+    node["radius"] = std::to_string(source.radius);
+    node["x"] = std::to_string(source.getX());
+    node["y"] = std::to_string(source.getY());
+    node["z"] = std::to_string(source.getZ());
+    node["partId"] = source.partId.toString();
+    if (source.hasCutFaceSettings) {
+        node["cutRotation"] = std::to_string(source.cutRotation);
+        if (dust3d::CutFace::UserDefined == source.cutFace) {
+            if (!source.cutFaceLinkedId.isNull()) {
+                node["cutFace"] = source.cutFaceLinkedId.toString();
+            }
+        } else {
+            node["cutFace"] = CutFaceToString(source.cutFace);
+        }
+    }
+    if (!source.name.isEmpty())
+        node["name"] = source.name.toUtf8().constData();
+    return node;
+}
+
+std::map<std::string, std::string> Document::edgeSnapshotRecord(const Edge& source) const
+{
+    std::map<std::string, std::string> edge;
+    edge["id"] = source.id.toString();
+    edge["from"] = source.nodeIds[0].toString();
+    edge["to"] = source.nodeIds[1].toString();
+    edge["partId"] = source.partId.toString();
+    if (!source.name.isEmpty())
+        edge["name"] = source.name.toUtf8().constData();
+    if (!source.boneName.isEmpty())
+        edge["boneName"] = source.boneName.toUtf8().constData();
+    return edge;
+}
+
+std::map<std::string, std::string> Document::componentSnapshotRecord(const Component& source) const
+{
+    std::map<std::string, std::string> component;
+    component["id"] = source.id.toString();
+    if (!source.name.isEmpty())
+        component["name"] = source.name.toUtf8().constData();
+    component["expanded"] = source.expanded ? "true" : "false";
+    component["combineMode"] = CombineModeToString(source.combineMode);
+    if (!source.colorImageId.isNull())
+        component["colorImageId"] = source.colorImageId.toString();
+    if (source.hasColor)
+        component["color"] = source.color.name(QColor::HexArgb).toUtf8().constData();
+    if (source.sideClosed)
+        component["sideClosed"] = "true";
+    if (source.frontClosed)
+        component["frontClosed"] = "true";
+    if (source.backClosed)
+        component["backClosed"] = "true";
+    if (source.backCloseDepthRatio != 1.0f)
+        component["backCloseDepthRatio"] = std::to_string(source.backCloseDepthRatio);
+    if (source.backCloseSharpness != 0.0f)
+        component["backCloseSharpness"] = std::to_string(source.backCloseSharpness);
+    if (source.smoothCutoffDegrees > 0)
+        component["smoothCutoffDegrees"] = std::to_string(source.smoothCutoffDegrees);
+    if (source.targetSegments > 0)
+        component["targetSegments"] = std::to_string(source.targetSegments);
+    std::vector<std::string> childIdList;
+    for (const auto& childId : source.childrenIds) {
+        childIdList.push_back(childId.toString());
+    }
+    std::string children = dust3d::String::join(childIdList, ",");
+    if (!children.empty())
+        component["children"] = children;
+    std::string linkData = source.linkData().toUtf8().constData();
+    if (!linkData.empty()) {
+        component["linkData"] = linkData;
+        component["linkDataType"] = source.linkDataType().toUtf8().constData();
+    }
+    return component;
+}
+
+void Document::canvasToSnapshot(dust3d::Snapshot* snapshot) const
+{
+    std::map<std::string, std::string> canvas;
+    canvas["originX"] = std::to_string(getOriginX());
+    canvas["originY"] = std::to_string(getOriginY());
+    canvas["originZ"] = std::to_string(getOriginZ());
+    canvas["rigType"] = m_rigType.toUtf8().constData();
+    if (m_headHasEyelids)
+        canvas["headHasEyelids"] = "true";
+    snapshot->canvas = canvas;
+
+    // Serialize animations
+    for (const auto& animationIt : m_animations) {
+        const auto& anim = animationIt.second;
+        std::map<std::string, std::string> animation;
+        animation["id"] = anim.id.toString();
+        animation["name"] = anim.name.toStdString();
+        animation["type"] = anim.type.toStdString();
+        // Add all parameters from the params map
+        for (const auto& paramIt : anim.params) {
+            animation[paramIt.first] = paramIt.second;
+        }
+        snapshot->animations[anim.id.toString()] = animation;
+    }
+}
+
+void Document::updateGenerationSnapshot(dust3d::MeshGenerator::ChangeSet* changeSet)
+{
+    // A generation which never handed the snapshot back may still be reading it
+    if (m_isGenerationSnapshotLent) {
+        m_generationSnapshot = std::make_shared<dust3d::Snapshot>(*m_generationSnapshot);
+        m_isGenerationSnapshotLent = false;
+    }
+    dust3d::Snapshot& snapshot = *m_generationSnapshot;
+
+    // The dirty flags and change sets are consumed below, the history still needs them for its next save
+    collectHistoryDirtyIds();
+
+    // Nodes and edges are only written out again for parts which changed since the previous generation
+    for (auto it = m_generationSnapshotParts.begin(); it != m_generationSnapshotParts.end();) {
+        auto findPart = partMap.find(it->first);
+        if (findPart != partMap.end() && !findPart->second.dirty) {
+            ++it;
+            continue;
+        }
+        std::string partIdString = it->first.toString();
+        // Nodes and edges may have been moved to another part, those are not ours to erase
+        for (const auto& nodeIdString : it->second.nodeIds) {
+            auto findNode = snapshot.nodes.find(nodeIdString);
+            if (findNode != snapshot.nodes.end() && dust3d::String::valueOrEmpty(findNode->second, "partId") == partIdString)
+                snapshot.nodes.erase(findNode);
+        }
+        for (const auto& edgeIdString : it->second.edgeIds) {
+            auto findEdge = snapshot.edges.find(edgeIdString);
+            if (findEdge != snapshot.edges.end() && dust3d::String::valueOrEmpty(findEdge->second, "partId") == partIdString)
+                snapshot.edges.erase(findEdge);
+        }
+        if (findPart == partMap.end()) {
+            m_removedPartIds.insert(it->first);
+            snapshot.parts.erase(partIdString);
+        }
+        it = m_generationSnapshotParts.erase(it);
+    }
+
+    // Attributes which do not make the part dirty, such as bone names, are patched one by one
+    for (const auto& edgeId : m_changedGenerationEdgeIds) {
+        const Edge* edge = findEdge(edgeId);
+        if (nullptr == edge)
+            continue;
+        auto findRecord = snapshot.edges.find(edgeId.toString());
+        if (findRecord != snapshot.edges.end())
+            findRecord->second = edgeSnapshotRecord(*edge);
+    }
+    m_changedGenerationEdgeIds.clear();
+
+    // Records of parts and components are only rebuilt when they changed since the previous generation,
+    // dirty parts were dropped above, so they are written out again here together with their nodes and edges
+    for (const auto& partIt : partMap) {
+        const Part& part = partIt.second;
+        auto insertResult = m_generationSnapshotParts.insert({ partIt.first, GenerationSnapshotPart() });
+        if (!insertResult.second) {
+            if (m_changedGenerationPartIds.find(partIt.first) != m_changedGenerationPartIds.end())
+                snapshot.parts[part.id.toString()] = partSnapshotRecord(part);
+            continue;
+        }
+        std::string partIdString = part.id.toString();
+        snapshot.parts[partIdString] = partSnapshotRecord(part);
+        changeSet->changedPartIds.insert(partIdString);
+        auto& records = insertResult.first->second;
+        for (const auto& nodeId : part.nodeIds) {
+            const Node* node = findNode(nodeId);
+            if (nullptr == node || node->partId != part.id)
+                continue;
+            std::string nodeIdString = nodeId.toString();
+            if (!records.nodeIds.insert(nodeIdString).second)
+                continue;
+            snapshot.nodes[nodeIdString] = nodeSnapshotRecord(*node);
+            for (const auto& edgeId : node->edgeIds) {
+                const Edge* edge = findEdge(edgeId);
+                if (nullptr == edge || edge->partId != part.id || edge->nodeIds.size() != 2)
+                    continue;
+                std::string edgeIdString = edgeId.toString();
+                if (!records.edgeIds.insert(edgeIdString).second)
+                    continue;
+                snapshot.edges[edgeIdString] = edgeSnapshotRecord(*edge);
+            }
+        }
+    }
+
+    m_changedGenerationPartIds.clear();
+
+    // New components are dirty, so every component has its record once these are written out
+    for (const auto& componentIt : componentMap) {
+        const Component& component = componentIt.second;
+        bool isChanged = m_changedGenerationComponentIds.find(componentIt.first) != m_changedGenerationComponentIds.end();
+        if (!component.dirty && !isChanged)
+            continue;
+        std::string componentIdString = component.id.toString();
+        snapshot.components[componentIdString] = componentSnapshotRecord(component);
+        if (component.dirty)
+            changeSet->changedComponentIds.insert(componentIdString);
+    }
+    m_changedGenerationComponentIds.clear();
+    // Only records left behind by removed components can outnumber the components
+    if (snapshot.components.size() > componentMap.size()) {
+        for (auto it = snapshot.components.begin(); it != snapshot.components.end();) {
+            dust3d::Uuid componentId(it->first);
+            if (componentMap.find(componentId) != componentMap.end()) {
+                ++it;
+                continue;
+            }
+            m_removedComponentIds.insert(componentId);
+            it = snapshot.components.erase(it);
+        }
+    }
+
+    std::vector<std::string> childIdList;
+    for (const auto& childId : rootComponent.childrenIds)
+        childIdList.push_back(childId.toString());
+    std::string children = dust3d::String::join(childIdList, ",");
+    if (children.empty())
+        snapshot.rootComponent.erase("children");
+    else
+        snapshot.rootComponent["children"] = children;
+
+    snapshot.animations.clear();
+    canvasToSnapshot(&snapshot);
+
+    for (const auto& partId : m_removedPartIds)
+        changeSet->removedPartIds.insert(partId.toString());
+    for (const auto& componentId : m_removedComponentIds)
+        changeSet->removedComponentIds.insert(componentId.toString());
+}
+
+std::unique_ptr<dust3d::Snapshot> Document::generatedSnapshot() const
+{
+    // While a generation runs the snapshot already describes that one, not the current result
+    if (m_isGenerationSnapshotLent || nullptr == m_currentSnapshotOverlay)
+        return nullptr;
+    auto snapshot = std::make_unique<dust3d::Snapshot>(*m_generationSnapshot);
+    dust3d::MeshGenerator::applySnapshotOverlay(snapshot.get(), *m_currentSnapshotOverlay);
+    return snapshot;
+}
+
 void Document::toSnapshot(dust3d::Snapshot* snapshot, const std::set<dust3d::Uuid>& limitNodeIds,
     Document::SnapshotFor forWhat) const
 {
@@ -2072,131 +2388,27 @@ void Document::toSnapshot(dust3d::Snapshot* snapshot, const std::set<dust3d::Uui
         for (const auto& partIt : partMap) {
             if (!limitPartIds.empty() && limitPartIds.find(partIt.first) == limitPartIds.end())
                 continue;
-            std::map<std::string, std::string> part;
-            part["id"] = partIt.second.id.toString();
-            part["visible"] = partIt.second.visible ? "true" : "false";
-            part["locked"] = partIt.second.locked ? "true" : "false";
-            part["subdived"] = partIt.second.subdived ? "true" : "false";
-            part["disabled"] = partIt.second.disabled ? "true" : "false";
-            part["xMirrored"] = partIt.second.xMirrored ? "true" : "false";
-            part["rounded"] = partIt.second.rounded ? "true" : "false";
-            part["chamfered"] = partIt.second.chamfered ? "true" : "false";
-            if (partIt.second.fillLoopInterior)
-                part["fillLoopInterior"] = "true";
-            if (dust3d::PartTarget::Model != partIt.second.target)
-                part["target"] = PartTargetToString(partIt.second.target);
-            if (partIt.second.cutRotationAdjusted())
-                part["cutRotation"] = std::to_string(partIt.second.cutRotation);
-            if (partIt.second.cutFaceAdjusted()) {
-                if (dust3d::CutFace::UserDefined == partIt.second.cutFace) {
-                    if (!partIt.second.cutFaceLinkedId.isNull()) {
-                        part["cutFace"] = partIt.second.cutFaceLinkedId.toString();
-                    }
-                } else {
-                    part["cutFace"] = CutFaceToString(partIt.second.cutFace);
-                }
-            }
+            std::map<std::string, std::string> part = partSnapshotRecord(partIt.second);
             part["__dirty"] = partIt.second.dirty ? "true" : "false";
-            if (partIt.second.metalnessAdjusted())
-                part["metallic"] = std::to_string(partIt.second.metalness);
-            if (partIt.second.roughnessAdjusted())
-                part["roughness"] = std::to_string(partIt.second.roughness);
-            if (partIt.second.deformThicknessAdjusted())
-                part["deformThickness"] = std::to_string(partIt.second.deformThickness);
-            if (partIt.second.deformWidthAdjusted())
-                part["deformWidth"] = std::to_string(partIt.second.deformWidth);
-            if (partIt.second.deformUnified)
-                part["deformUnified"] = "true";
-            if (partIt.second.hollowThicknessAdjusted())
-                part["hollowThickness"] = std::to_string(partIt.second.hollowThickness);
-            if (!partIt.second.importedModelId.isNull())
-                part["importedModelId"] = partIt.second.importedModelId.toString();
-            if (!partIt.second.name.isEmpty())
-                part["name"] = partIt.second.name.toUtf8().constData();
             snapshot->parts[part["id"]] = part;
         }
         for (const auto& nodeIt : nodeMap) {
             if (!limitNodeIds.empty() && limitNodeIds.find(nodeIt.first) == limitNodeIds.end())
                 continue;
-            std::map<std::string, std::string> node;
-            node["id"] = nodeIt.second.id.toString();
-            node["radius"] = std::to_string(nodeIt.second.radius);
-            node["x"] = std::to_string(nodeIt.second.getX());
-            node["y"] = std::to_string(nodeIt.second.getY());
-            node["z"] = std::to_string(nodeIt.second.getZ());
-            node["partId"] = nodeIt.second.partId.toString();
-            if (nodeIt.second.hasCutFaceSettings) {
-                node["cutRotation"] = std::to_string(nodeIt.second.cutRotation);
-                if (dust3d::CutFace::UserDefined == nodeIt.second.cutFace) {
-                    if (!nodeIt.second.cutFaceLinkedId.isNull()) {
-                        node["cutFace"] = nodeIt.second.cutFaceLinkedId.toString();
-                    }
-                } else {
-                    node["cutFace"] = CutFaceToString(nodeIt.second.cutFace);
-                }
-            }
-            if (!nodeIt.second.name.isEmpty())
-                node["name"] = nodeIt.second.name.toUtf8().constData();
-            snapshot->nodes[node["id"]] = node;
+            snapshot->nodes[nodeIt.second.id.toString()] = nodeSnapshotRecord(nodeIt.second);
         }
         for (const auto& edgeIt : edgeMap) {
             if (edgeIt.second.nodeIds.size() != 2)
                 continue;
             if (!limitNodeIds.empty() && (limitNodeIds.find(edgeIt.second.nodeIds[0]) == limitNodeIds.end() || limitNodeIds.find(edgeIt.second.nodeIds[1]) == limitNodeIds.end()))
                 continue;
-            std::map<std::string, std::string> edge;
-            edge["id"] = edgeIt.second.id.toString();
-            edge["from"] = edgeIt.second.nodeIds[0].toString();
-            edge["to"] = edgeIt.second.nodeIds[1].toString();
-            edge["partId"] = edgeIt.second.partId.toString();
-            if (!edgeIt.second.name.isEmpty())
-                edge["name"] = edgeIt.second.name.toUtf8().constData();
-            if (!edgeIt.second.boneName.isEmpty())
-                edge["boneName"] = edgeIt.second.boneName.toUtf8().constData();
-            snapshot->edges[edge["id"]] = edge;
+            snapshot->edges[edgeIt.second.id.toString()] = edgeSnapshotRecord(edgeIt.second);
         }
         for (const auto& componentIt : componentMap) {
             if (!limitComponentIds.empty() && limitComponentIds.find(componentIt.first) == limitComponentIds.end())
                 continue;
-            std::map<std::string, std::string> component;
-            component["id"] = componentIt.second.id.toString();
-            if (!componentIt.second.name.isEmpty())
-                component["name"] = componentIt.second.name.toUtf8().constData();
-            component["expanded"] = componentIt.second.expanded ? "true" : "false";
-            component["combineMode"] = CombineModeToString(componentIt.second.combineMode);
-            if (!componentIt.second.colorImageId.isNull())
-                component["colorImageId"] = componentIt.second.colorImageId.toString();
-            if (componentIt.second.hasColor)
-                component["color"] = componentIt.second.color.name(QColor::HexArgb).toUtf8().constData();
-            if (componentIt.second.sideClosed)
-                component["sideClosed"] = "true";
-            if (componentIt.second.frontClosed)
-                component["frontClosed"] = "true";
-            if (componentIt.second.backClosed)
-                component["backClosed"] = "true";
-            if (componentIt.second.backCloseDepthRatio != 1.0f)
-                component["backCloseDepthRatio"] = std::to_string(componentIt.second.backCloseDepthRatio);
-            if (componentIt.second.backCloseSharpness != 0.0f)
-                component["backCloseSharpness"] = std::to_string(componentIt.second.backCloseSharpness);
-            if (componentIt.second.smoothCutoffDegrees > 0)
-                component["smoothCutoffDegrees"] = std::to_string(componentIt.second.smoothCutoffDegrees);
-            if (componentIt.second.targetSegments > 0)
-                component["targetSegments"] = std::to_string(componentIt.second.targetSegments);
+            std::map<std::string, std::string> component = componentSnapshotRecord(componentIt.second);
             component["__dirty"] = componentIt.second.dirty ? "true" : "false";
-            std::vector<std::string> childIdList;
-            for (const auto& childId : componentIt.second.childrenIds) {
-                childIdList.push_back(childId.toString());
-            }
-            std::string children = dust3d::String::join(childIdList, ",");
-            if (!children.empty())
-                component["children"] = children;
-            std::string linkData = componentIt.second.linkData().toUtf8().constData();
-            if (!linkData.empty()) {
-                component["linkData"] = linkData;
-                component["linkDataType"] = componentIt.second.linkDataType().toUtf8().constData();
-            }
-            if (!componentIt.second.name.isEmpty())
-                component["name"] = componentIt.second.name.toUtf8().constData();
             snapshot->components[component["id"]] = component;
         }
         if (limitComponentIds.empty() || limitComponentIds.find(dust3d::Uuid()) != limitComponentIds.end()) {
@@ -2209,30 +2421,8 @@ void Document::toSnapshot(dust3d::Snapshot* snapshot, const std::set<dust3d::Uui
                 snapshot->rootComponent["children"] = children;
         }
     }
-    if (Document::SnapshotFor::Document == forWhat) {
-        std::map<std::string, std::string> canvas;
-        canvas["originX"] = std::to_string(getOriginX());
-        canvas["originY"] = std::to_string(getOriginY());
-        canvas["originZ"] = std::to_string(getOriginZ());
-        canvas["rigType"] = m_rigType.toUtf8().constData();
-        if (m_headHasEyelids)
-            canvas["headHasEyelids"] = "true";
-        snapshot->canvas = canvas;
-
-        // Serialize animations
-        for (const auto& animationIt : m_animations) {
-            const auto& anim = animationIt.second;
-            std::map<std::string, std::string> animation;
-            animation["id"] = anim.id.toString();
-            animation["name"] = anim.name.toStdString();
-            animation["type"] = anim.type.toStdString();
-            // Add all parameters from the params map
-            for (const auto& paramIt : anim.params) {
-                animation[paramIt.first] = paramIt.second;
-            }
-            snapshot->animations[anim.id.toString()] = animation;
-        }
-    }
+    if (Document::SnapshotFor::Document == forWhat)
+        canvasToSnapshot(snapshot);
 }
 
 void Document::addFromSnapshot(const dust3d::Snapshot& snapshot, enum SnapshotSource source)
@@ -2273,10 +2463,12 @@ void Document::addFromSnapshot(const dust3d::Snapshot& snapshot, enum SnapshotSo
     std::map<dust3d::Uuid, dust3d::Uuid> oldNewIdMap;
     std::map<dust3d::Uuid, dust3d::Uuid> cutFaceLinkedIdModifyMap;
     for (const auto& partKv : snapshot.parts) {
-        const auto newUuid = dust3d::Uuid::createUuid();
+        // Whole document loads keep the saved ids, so history records keep matching the document
+        dust3d::Uuid oldPartId = dust3d::Uuid(partKv.first);
+        const auto newUuid = (SnapshotSource::Unknown == source && !oldPartId.isNull() && partMap.find(oldPartId) == partMap.end()) ? oldPartId : dust3d::Uuid::createUuid();
         Document::Part& part = partMap[newUuid];
         part.id = newUuid;
-        oldNewIdMap[dust3d::Uuid(partKv.first)] = part.id;
+        oldNewIdMap[oldPartId] = part.id;
         part.name = dust3d::String::valueOrEmpty(partKv.second, "name").c_str();
         const auto& visibleIt = partKv.second.find("visible");
         if (visibleIt != partKv.second.end()) {
@@ -2443,9 +2635,10 @@ void Document::addFromSnapshot(const dust3d::Snapshot& snapshot, enum SnapshotSo
             if ("partId" != linkDataType)
                 continue;
         }
-        Document::Component component(dust3d::Uuid(), linkData, linkDataType);
+        dust3d::Uuid oldComponentId = dust3d::Uuid(componentKv.first);
+        Document::Component component((SnapshotSource::Unknown == source && componentMap.find(oldComponentId) == componentMap.end()) ? oldComponentId : dust3d::Uuid(), linkData, linkDataType);
         auto componentId = component.id;
-        oldNewIdMap[dust3d::Uuid(componentKv.first)] = componentId;
+        oldNewIdMap[oldComponentId] = componentId;
         component.name = dust3d::String::valueOrEmpty(componentKv.second, "name").c_str();
         component.expanded = dust3d::String::isTrue(dust3d::String::valueOrEmpty(componentKv.second, "expanded"));
         component.combineMode = dust3d::CombineModeFromString(dust3d::String::valueOrEmpty(componentKv.second, "combineMode").c_str());
@@ -2646,12 +2839,14 @@ void Document::clearResults()
         m_resultMesh.reset();
         m_resultTextureMesh.reset();
         m_generatedCacheContext.reset();
+        m_draftGeneratedCacheContext.reset();
+        m_draftPendingChangeSet = dust3d::MeshGenerator::ChangeSet();
     }
 
     // Clear unique_ptr objects (these will delete their contents safely)
     m_wireframeMesh.reset();
     m_currentObject.reset();
-    m_currentSnapshot.reset();
+    m_currentSnapshotOverlay.reset();
     m_uvMappedObject = std::make_unique<dust3d::Object>();
 
     // Only clear rig object if rig generator is not running
@@ -2662,6 +2857,7 @@ void Document::clearResults()
 
     // Reset flags
     m_isResultMeshObsolete = false;
+    m_isResultMeshDraft = false;
     m_isMeshGenerationSucceed = true;
     m_isTextureObsolete = false;
     m_isRigObsolete = false;
@@ -2728,10 +2924,33 @@ quint64 Document::resultTextureMeshId()
 
 void Document::meshReady()
 {
+    if (m_meshGenerator->isCancelled()) {
+        // Components the cancelled generation did not get to still need to be rebuilt,
+        // everything it finished stays in the generated cache context
+        for (const auto& componentIdString : m_meshGenerator->unfinishedComponentIds()) {
+            auto findComponent = componentMap.find(dust3d::Uuid(componentIdString));
+            if (findComponent != componentMap.end())
+                findComponent->second.dirty = true;
+        }
+        m_meshGenerator->takeSourceSnapshot();
+        m_isGenerationSnapshotLent = false;
+        delete m_meshGenerator;
+        m_meshGenerator = nullptr;
+        m_meshGeneratorThread = nullptr;
+        m_meshGenerationCancellationToken.reset();
+        qDebug() << "Mesh generation cancelled";
+        if (m_isResultMeshObsolete)
+            generateMesh();
+        return;
+    }
+
     ModelMesh* resultMesh = m_meshGenerator->takeResultMesh();
     m_wireframeMesh.reset(m_meshGenerator->takeWireframeMesh());
     dust3d::Object* object = m_meshGenerator->takeObject();
-    dust3d::Snapshot* snapshot = m_meshGenerator->takeSnapshot();
+    m_currentSnapshotOverlay = m_meshGenerator->takeSnapshotOverlay();
+    // The generation is done reading the snapshot, it can be patched in place again
+    m_meshGenerator->takeSourceSnapshot();
+    m_isGenerationSnapshotLent = false;
     bool isSuccessful = m_meshGenerator->isSuccessful();
 
     std::unique_ptr<std::map<dust3d::Uuid, std::unique_ptr<ModelMesh>>> componentPreviewMeshes;
@@ -2753,11 +2972,11 @@ void Document::meshReady()
     }
 
     m_resultMesh.reset(resultMesh);
+    m_isResultMeshDraft = m_meshGenerator->isDraftMode();
 
     m_isMeshGenerationSucceed = isSuccessful;
 
     m_currentObject.reset(object);
-    m_currentSnapshot.reset(snapshot);
 
     if (nullptr == m_resultMesh) {
         qDebug() << "Result mesh is null";
@@ -2767,6 +2986,7 @@ void Document::meshReady()
     m_meshGenerator = nullptr;
 
     m_meshGeneratorThread = nullptr;
+    m_meshGenerationCancellationToken.reset();
 
     qDebug() << "Mesh generation done";
 
@@ -2792,6 +3012,19 @@ void Document::batchChangeEnd()
     }
 }
 
+void Document::interactiveMoveBegin()
+{
+    m_isInteractiveMoving = true;
+}
+
+void Document::interactiveMoveEnd()
+{
+    m_isInteractiveMoving = false;
+    // A draft generation still running is cancelled here and followed by a full quality one
+    if (m_isResultMeshDraft || (nullptr != m_meshGenerator && m_meshGenerator->isDraftMode()))
+        generateMesh();
+}
+
 void Document::regenerateMesh()
 {
     markAllDirty();
@@ -2810,10 +3043,21 @@ void Document::enableWeld(bool enabled)
     regenerateMesh();
 }
 
+void Document::mergeChangeSet(dust3d::MeshGenerator::ChangeSet* changeSet, const dust3d::MeshGenerator::ChangeSet& other)
+{
+    changeSet->changedPartIds.insert(other.changedPartIds.begin(), other.changedPartIds.end());
+    changeSet->changedComponentIds.insert(other.changedComponentIds.begin(), other.changedComponentIds.end());
+    changeSet->removedPartIds.insert(other.removedPartIds.begin(), other.removedPartIds.end());
+    changeSet->removedComponentIds.insert(other.removedComponentIds.begin(), other.removedComponentIds.end());
+}
+
 void Document::generateMesh()
 {
     if (nullptr != m_meshGenerator || m_batchChangeRefCount > 0) {
         m_isResultMeshObsolete = true;
+        // The running generation is already stale, let it stop at its next checkpoint
+        if (nullptr != m_meshGenerationCancellationToken)
+            m_meshGenerationCancellationToken->cancel();
         return;
     }
 
@@ -2825,17 +3069,49 @@ void Document::generateMesh()
 
     m_isResultMeshObsolete = false;
 
+    // While nodes are being dragged only a draft is generated, to keep up with the mouse
+    bool draftMode = m_isInteractiveMoving;
+
     m_meshGeneratorThread = new QThread;
 
-    dust3d::Snapshot* snapshot = new dust3d::Snapshot;
-    toSnapshot(snapshot);
-    resetDirtyFlags();
-    m_meshGenerator = new MeshGenerator(snapshot);
+    auto changeSet = std::make_unique<dust3d::MeshGenerator::ChangeSet>();
+    updateGenerationSnapshot(changeSet.get());
+    // The draft cache outlives full quality generations, so a drag only rebuilds the drafts of what changed since the last one
+    if (draftMode) {
+        mergeChangeSet(changeSet.get(), m_draftPendingChangeSet);
+        m_draftPendingChangeSet = dust3d::MeshGenerator::ChangeSet();
+    } else if (m_draftGeneratedCacheContext) {
+        mergeChangeSet(&m_draftPendingChangeSet, *changeSet);
+    }
+    // The full quality generation after the drag still needs to know what the drafts touched
+    if (!draftMode)
+        resetDirtyFlags();
+    m_meshGenerator = new MeshGenerator(std::shared_ptr<const dust3d::Snapshot>(m_generationSnapshot));
+    m_isGenerationSnapshotLent = true;
+    m_meshGenerator->setChangeSet(std::move(changeSet));
     m_meshGenerator->setId(m_nextMeshGenerationId++);
     m_meshGenerator->setDefaultPartColor(dust3d::Color::createWhite());
-    if (!m_generatedCacheContext)
-        m_generatedCacheContext = std::make_unique<dust3d::MeshGenerator::GeneratedCacheContext>();
-    m_meshGenerator->setGeneratedCacheContext(m_generatedCacheContext.get());
+    m_meshGenerator->setDraftMode(draftMode);
+    if (draftMode) {
+        if (!m_draftGeneratedCacheContext)
+            m_draftGeneratedCacheContext = std::make_unique<dust3d::MeshGenerator::GeneratedCacheContext>();
+        m_meshGenerator->setGeneratedCacheContext(m_draftGeneratedCacheContext.get());
+    } else {
+        if (!m_generatedCacheContext)
+            m_generatedCacheContext = std::make_unique<dust3d::MeshGenerator::GeneratedCacheContext>();
+        m_meshGenerator->setGeneratedCacheContext(m_generatedCacheContext.get());
+        QString diskCacheDirectory = Preferences::instance().generationCacheDirectory();
+        if (diskCacheDirectory != m_generationDiskCacheDirectory) {
+            m_generationDiskCacheDirectory = diskCacheDirectory;
+            m_generationDiskCache.reset();
+            if (!diskCacheDirectory.isEmpty() && QDir().mkpath(diskCacheDirectory))
+                m_generationDiskCache = std::make_shared<dust3d::MeshGeneratorDiskCache>(QDir(diskCacheDirectory).absolutePath().toLocal8Bit().toStdString());
+        }
+        if (m_generationDiskCache)
+            m_meshGenerator->setDiskCache(m_generationDiskCache);
+    }
+    m_meshGenerationCancellationToken = std::make_shared<dust3d::CancellationToken>();
+    m_meshGenerator->setCancellationToken(m_meshGenerationCancellationToken);
 
     // Pass raw GLB data to mesh generator for parsing on the worker thread
     {
@@ -2864,8 +3140,10 @@ void Document::generateMesh()
     connect(m_meshGeneratorThread, &QThread::started, m_meshGenerator, &MeshGenerator::process);
     connect(m_meshGenerator, &MeshGenerator::importedModelTextureReady, this, [this](dust3d::Uuid componentId, dust3d::Uuid textureId) {
         auto componentIt = componentMap.find(componentId);
-        if (componentIt != componentMap.end() && componentIt->second.colorImageId != textureId)
+        if (componentIt != componentMap.end() && componentIt->second.colorImageId != textureId) {
             componentIt->second.colorImageId = textureId;
+            m_changedGenerationComponentIds.insert(componentId);
+        }
     });
     connect(m_meshGenerator, &MeshGenerator::finished, this, &Document::meshReady);
     connect(m_meshGenerator, &MeshGenerator::finished, m_meshGeneratorThread, &QThread::quit);
@@ -2882,7 +3160,15 @@ void Document::generateTexture()
 
     m_isTextureObsolete = false;
 
-    if (nullptr == m_currentObject || nullptr == m_currentSnapshot)
+    if (nullptr == m_currentObject || nullptr == m_currentSnapshotOverlay)
+        return;
+
+    // Texture and rig are deferred until the full quality mesh replaces the draft
+    if (m_isResultMeshDraft)
+        return;
+
+    // The snapshot already describes the running generation, whose result asks for the texture again
+    if (m_isGenerationSnapshotLent)
         return;
 
     qDebug() << "UV mapping generating..";
@@ -2890,10 +3176,11 @@ void Document::generateTexture()
 
     auto object = std::make_unique<dust3d::Object>(*m_currentObject);
 
-    auto snapshot = std::make_unique<dust3d::Snapshot>(*m_currentSnapshot);
+    auto snapshot = generatedSnapshot();
 
     QThread* thread = new QThread;
     m_textureGenerator = new UvMapGenerator(std::move(object), std::move(snapshot));
+    m_textureGenerator->setAmbientOcclusionBaked(m_isAmbientOcclusionBaked);
     m_textureGenerator->moveToThread(thread);
     connect(thread, &QThread::started, m_textureGenerator, &UvMapGenerator::process);
     connect(m_textureGenerator, &UvMapGenerator::finished, this, &Document::textureReady);
@@ -2935,11 +3222,24 @@ void Document::textureReady()
     }
 }
 
+void Document::setAmbientOcclusionBaked(bool baked)
+{
+    if (m_isAmbientOcclusionBaked == baked)
+        return;
+    m_isAmbientOcclusionBaked = baked;
+    generateTexture();
+}
+
 quint64 Document::resultTextureImageUpdateVersion()
 {
     return m_textureImageUpdateVersion;
 }
 
+const dust3d::Object* Document::currentObject() const
+{
+    return m_currentObject.get();
+}
+
 const dust3d::Object& Document::currentUvMappedObject() const
 {
     return *m_uvMappedObject;
@@ -3319,43 +3619,6 @@ void Document::setComponentColorState(const dust3d::Uuid& componentId, bool hasC
     emit skeletonChanged();
 }
 
-void Document::saveSnapshot()
-{
-    Document::HistoryItem item;
-    toSnapshot(&item.snapshot);
-    if (m_undoItems.size() + 1 > m_maxSnapshot)
-        m_undoItems.pop_front();
-    m_undoItems.push_back(item);
-}
-
-void Document::undo()
-{
-    if (!undoable())
-        return;
-    m_redoItems.push_back(m_undoItems.back());
-    m_undoItems.pop_back();
-    const auto& item = m_undoItems.back();
-    fromSnapshot(item.snapshot);
-    qDebug() << "Undo/Redo items:" << m_undoItems.size() << m_redoItems.size();
-}
-
-void Document::redo()
-{
-    if (m_redoItems.empty())
-        return;
-    m_undoItems.push_back(m_redoItems.back());
-    const auto& item = m_redoItems.back();
-    fromSnapshot(item.snapshot);
-    m_redoItems.pop_back();
-    qDebug() << "Undo/Redo items:" << m_undoItems.size() << m_redoItems.size();
-}
-
-void Document::clearHistories()
-{
-    m_undoItems.clear();
-    m_redoItems.clear();
-}
-
 void Document::paste()
 {
     const QClipboard* clipboard = QApplication::clipboard();
@@ -3397,16 +3660,6 @@ bool Document::hasPastableNodesInClipboard() const
     return false;
 }
 
-bool Document::undoable() const
-{
-    return m_undoItems.size() >= 2;
-}
-
-bool Document::redoable() const
-{
-    return !m_redoItems.empty();
-}
-
 bool Document::isNodeEditable(dust3d::Uuid nodeId) const
 {
     const Document::Node* node = findNode(nodeId);
@@ -3432,7 +3685,7 @@ bool Document::isExportReady() const
     if (m_meshGenerator || m_textureGenerator || m_rigGeneratorWorker)
         return false;
 
-    if (m_isResultMeshObsolete || m_isTextureObsolete || m_isRigObsolete)
+    if (m_isResultMeshObsolete || m_isResultMeshDraft || m_isTextureObsolete || m_isRigObsolete)
         return false;
 
     return true;
@@ -3467,6 +3720,15 @@ void Document::copyNodes(std::set<dust3d::Uuid> nodeIdSet) const
     dust3d::saveSnapshotToXmlString(snapshot, snapshotXml);
     QClipboard* clipboard = QApplication::clipboard();
     clipboard->setText(snapshotXml.c_str());
+
+    // A paste may come long after the history dropped the copied parts, so their images are held until the next copy
+    std::set<dust3d::Uuid> imageIds;
+    for (const auto& componentIt : snapshot.components) {
+        auto findImageIdString = componentIt.second.find("colorImageId");
+        if (findImageIdString != componentIt.second.end())
+            imageIds.insert(dust3d::Uuid(findImageIdString->second));
+    }
+    m_clipboardImageReferences = std::make_shared<ImageForever::References>(imageIds);
 }
 
 void Document::collectCutFaceList(std::vector<QString>& cutFaces) const
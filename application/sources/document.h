@@ -3,6 +3,7 @@
 
 #include "bone_structure.h"
 #include "debug.h"
+#include "image_forever.h"
 #include "model_mesh.h"
 #include "monochrome_mesh.h"
 #include "theme.h"
@@ -19,6 +20,7 @@
 #include <dust3d/base/texture_type.h>
 #include <dust3d/base/uuid.h>
 #include <dust3d/mesh/mesh_generator.h>
+#include <dust3d/mesh/mesh_generator_disk_cache.h>
 #include <map>
 #include <memory>
 #include <set>
@@ -43,9 +45,43 @@ public:
         Document = (SnapshotFor::Nodes)
     };
 
+    typedef std::shared_ptr<const std::map<std::string, std::string>> HistoryRecord;
+
+    enum HistoryCategory {
+        HistoryCanvas = 0,
+        HistoryRootComponent,
+        HistoryNodes,
+        HistoryEdges,
+        HistoryParts,
+        HistoryComponents,
+        HistoryAnimations,
+        HistoryCategoryCount
+    };
+
+    class HistoryChange {
+    public:
+        HistoryRecord before;
+        HistoryRecord after;
+    };
+
+    // Only the records of the entities changed by one edit are kept, the records
+    // themselves are shared with the history state and the neighbouring items
     class HistoryItem {
     public:
-        dust3d::Snapshot snapshot;
+        std::map<std::string, HistoryChange> changes[HistoryCategoryCount];
+        std::shared_ptr<ImageForever::References> imageReferences;
+        bool empty() const;
+    };
+
+    // Latest saved state as per entity records, the canvas and the root component
+    // are single records stored under an empty id, node and edge ids are also kept
+    // per part, so the records of one part are found without a scan
+    class HistoryState {
+    public:
+        std::map<std::string, HistoryRecord> records[HistoryCategoryCount];
+        std::map<std::string, std::set<std::string>> partNodeIds;
+        std::map<std::string, std::set<std::string>> partEdgeIds;
+        void setRecord(int category, const std::string& id, const HistoryRecord& record);
     };
 
     enum class Profile {
@@ -344,6 +380,7 @@ public:
     void updateTextureMetalnessImage(QImage* image);
     void updateTextureRoughnessImage(QImage* image);
     void updateTextureAmbientOcclusionImage(QImage* image);
+    const dust3d::Object* currentObject() const;
     const dust3d::Object& currentUvMappedObject() const;
     const RigStructure& currentActualRigStructure() const;
     bool isExportReady() const;
@@ -404,6 +441,7 @@ public:
     {
         return m_actualRigStructure;
     }
+    static void loadRigStructures(std::map<QString, RigStructure>* rigStructures);
     dust3d::Object* takeRigObject() const
     {
         if (nullptr == m_rigObject)
@@ -456,6 +494,7 @@ public slots:
     void meshReady();
     void generateTexture();
     void textureReady();
+    void setAmbientOcclusionBaked(bool baked);
     void setPartSubdivState(dust3d::Uuid partId, bool subdived);
     void setPartXmirrorState(dust3d::Uuid partId, bool mirrored);
     void setPartDeformThickness(dust3d::Uuid partId, float thickness);
@@ -478,6 +517,8 @@ public slots:
     void saveSnapshot();
     void batchChangeBegin();
     void batchChangeEnd();
+    void interactiveMoveBegin();
+    void interactiveMoveEnd();
     void reset();
     void clearHistories();
     void silentReset();
@@ -570,6 +611,14 @@ private:
     void removeComponentRecursively(dust3d::Uuid componentId);
     void updateLinkedPart(dust3d::Uuid oldPartId, dust3d::Uuid newPartId);
     dust3d::Uuid createNode(dust3d::Uuid nodeId, float x, float y, float z, float radius, dust3d::Uuid fromNodeId);
+    std::map<std::string, std::string> partSnapshotRecord(const Part& source) const;
+    std::map<std::string, std::string> nodeSnapshotRecord(const Node& source) const;
+    std::map<std::string, std::string> edgeSnapshotRecord(const Edge& source) const;
+    std::map<std::string, std::string> componentSnapshotRecord(const Component& source) const;
+    void canvasToSnapshot(dust3d::Snapshot* snapshot) const;
+    void updateGenerationSnapshot(dust3d::MeshGenerator::ChangeSet* changeSet);
+    std::unique_ptr<dust3d::Snapshot> generatedSnapshot() const;
+    static void mergeChangeSet(dust3d::MeshGenerator::ChangeSet* changeSet, const dust3d::MeshGenerator::ChangeSet& other);
 
     bool m_isResultMeshObsolete = false;
     MeshGenerator* m_meshGenerator = nullptr;
@@ -579,8 +628,11 @@ private:
     bool m_isMeshGenerationSucceed = true;
     int m_batchChangeRefCount = 0;
     std::unique_ptr<dust3d::Object> m_currentObject;
-    std::unique_ptr<dust3d::Snapshot> m_currentSnapshot;
+    // What the last generation added on top of the generation snapshot, such as mirrored parts
+    std::unique_ptr<dust3d::MeshGenerator::SnapshotOverlay> m_currentSnapshotOverlay;
     bool m_isTextureObsolete = false;
+    // Interactive textures skip the slow occlusion bake unless the result is meant for export
+    bool m_isAmbientOcclusionBaked = false;
     UvMapGenerator* m_textureGenerator = nullptr;
     std::unique_ptr<dust3d::Object> m_uvMappedObject = std::make_unique<dust3d::Object>();
     std::unique_ptr<ModelMesh> m_resultTextureMesh;
@@ -589,6 +641,30 @@ private:
     quint64 m_meshGenerationId = 0;
     quint64 m_nextMeshGenerationId = 0;
     std::unique_ptr<dust3d::MeshGenerator::GeneratedCacheContext> m_generatedCacheContext;
+    // Draft results are built into their own cache, so they never stand in for full quality ones
+    std::unique_ptr<dust3d::MeshGenerator::GeneratedCacheContext> m_draftGeneratedCacheContext;
+    // Changes the full quality generations took since the last draft, handed to the next draft
+    dust3d::MeshGenerator::ChangeSet m_draftPendingChangeSet;
+    std::shared_ptr<dust3d::MeshGeneratorDiskCache> m_generationDiskCache;
+    QString m_generationDiskCacheDirectory;
+    bool m_isInteractiveMoving = false;
+    // Snapshot lent to mesh generation and patched in place once handed back, nodes and edges of a part are only
+    // written out again once the part is dirty, edges are also patched one by one when an edit leaves the part clean
+    struct GenerationSnapshotPart {
+        std::set<std::string> nodeIds;
+        std::set<std::string> edgeIds;
+    };
+    std::shared_ptr<dust3d::Snapshot> m_generationSnapshot = std::make_shared<dust3d::Snapshot>();
+    bool m_isGenerationSnapshotLent = false;
+    std::map<dust3d::Uuid, GenerationSnapshotPart> m_generationSnapshotParts;
+    std::set<dust3d::Uuid> m_changedGenerationEdgeIds;
+    // Parts and components whose records changed without making them dirty, such as names or lock states
+    std::set<dust3d::Uuid> m_changedGenerationPartIds;
+    std::set<dust3d::Uuid> m_changedGenerationComponentIds;
+    std::set<dust3d::Uuid> m_removedPartIds;
+    std::set<dust3d::Uuid> m_removedComponentIds;
+    bool m_isResultMeshDraft = false;
+    std::shared_ptr<dust3d::CancellationToken> m_meshGenerationCancellationToken;
     float m_originX = 0;
     float m_originY = 0;
     float m_originZ = 0;
@@ -601,15 +677,34 @@ private:
     bool m_isRigObsolete = false;
     RigStructure m_actualRigStructure;
     std::unique_ptr<dust3d::Object> m_rigObject;
-    void loadRigStructures();
-    bool loadRigFromXml(const QString& filePath);
+    static bool loadRigFromXml(const QString& filePath, std::map<QString, RigStructure>* rigStructures);
     std::map<dust3d::Uuid, Animation> m_animations;
     dust3d::Uuid m_currentAnimationId;
 
 private:
+    void collectHistoryDirtyIds();
+    void diffDirtyHistoryRecords(HistoryItem* item);
+    void applyHistoryItem(const HistoryItem& item, bool backward);
+    bool applyHistoryChanges(const HistoryItem& item, bool backward);
+    bool applyHistoryPartChanges(const HistoryItem& item, bool backward);
+    bool applyHistoryNodeAndEdgeChanges(const HistoryItem& item, bool backward);
+    bool applyHistoryComponentChanges(const HistoryItem& item, bool backward);
+    void applyHistoryCanvasChanges(const HistoryItem& item, bool backward);
+    bool applyHistoryAnimationChanges(const HistoryItem& item, bool backward);
+    void historyStateToSnapshot(dust3d::Snapshot* snapshot) const;
+
     static unsigned long m_maxSnapshot;
     std::deque<HistoryItem> m_undoItems;
     std::deque<HistoryItem> m_redoItems;
+    HistoryState m_historyState;
+    bool m_hasHistoryState = false;
+    std::shared_ptr<ImageForever::References> m_historyStateImageReferences;
+    mutable std::shared_ptr<ImageForever::References> m_clipboardImageReferences;
+    // Parts, components and edges which may differ from the history state, taken from the
+    // same dirty flags and change sets the generation snapshot is patched with
+    std::set<dust3d::Uuid> m_historyDirtyPartIds;
+    std::set<dust3d::Uuid> m_historyDirtyComponentIds;
+    std::set<dust3d::Uuid> m_historyDirtyEdgeIds;
 };
 
 #endif
@@ -0,0 +1,1011 @@
+#include "document.h"
+#include <QDebug>
+#include <algorithm>
+#include <dust3d/base/cut_face.h>
+#include <dust3d/base/string.h>
+
+typedef std::map<std::string, std::map<std::string, std::string>> SnapshotEntityMap;
+
+static SnapshotEntityMap* snapshotEntities(dust3d::Snapshot* snapshot, int category)
+{
+    switch (category) {
+    case Document::HistoryNodes:
+        return &snapshot->nodes;
+    case Document::HistoryEdges:
+        return &snapshot->edges;
+    case Document::HistoryParts:
+        return &snapshot->parts;
+    case Document::HistoryComponents:
+        return &snapshot->components;
+    case Document::HistoryAnimations:
+        return &snapshot->animations;
+    }
+    return nullptr;
+}
+
+static std::map<std::string, std::string>* snapshotSingleRecord(dust3d::Snapshot* snapshot, int category)
+{
+    switch (category) {
+    case Document::HistoryCanvas:
+        return &snapshot->canvas;
+    case Document::HistoryRootComponent:
+        return &snapshot->rootComponent;
+    }
+    return nullptr;
+}
+
+// Attributes starting with "__", such as the dirty flags, describe the generation state, not the document
+static void removeInternalAttributes(std::map<std::string, std::string>& record)
+{
+    for (auto it = record.begin(); it != record.end();) {
+        if (dust3d::String::startsWith(it->first, "__"))
+            it = record.erase(it);
+        else
+            ++it;
+    }
+}
+
+static void diffHistoryRecords(std::map<std::string, Document::HistoryRecord>& stateRecords,
+    SnapshotEntityMap& entities,
+    std::map<std::string, Document::HistoryChange>& changes)
+{
+    // Both maps are ordered by id, so a single merge pass finds every difference
+    auto stateIt = stateRecords.begin();
+    auto entityIt = entities.begin();
+    while (stateIt != stateRecords.end() || entityIt != entities.end()) {
+        if (entityIt == entities.end() || (stateIt != stateRecords.end() && stateIt->first < entityIt->first)) {
+            changes[stateIt->first].before = stateIt->second;
+            ++stateIt;
+        } else if (stateIt == stateRecords.end() || entityIt->first < stateIt->first) {
+            changes[entityIt->first].after = std::make_shared<const std::map<std::string, std::string>>(std::move(entityIt->second));
+            ++entityIt;
+        } else {
+            if (*stateIt->second != entityIt->second) {
+                auto& change = changes[entityIt->first];
+                change.before = stateIt->second;
+                change.after = std::make_shared<const std::map<std::string, std::string>>(std::move(entityIt->second));
+            }
+            ++stateIt;
+            ++entityIt;
+        }
+    }
+}
+
+static void collectHistoryImageIds(const Document::HistoryRecord& record, std::set<dust3d::Uuid>& imageIds)
+{
+    if (nullptr == record)
+        return;
+    auto findImageIdString = record->find("colorImageId");
+    if (findImageIdString == record->end())
+        return;
+    imageIds.insert(dust3d::Uuid(findImageIdString->second));
+}
+
+// Attributes are read the same way a loaded document reads them, a missing one takes the default
+static void loadHistoryPartRecord(Document::Part& part, const std::map<std::string, std::string>& record)
+{
+    part.name = dust3d::String::valueOrEmpty(record, "name").c_str();
+    const auto& visibleIt = record.find("visible");
+    if (visibleIt != record.end())
+        part.visible = dust3d::String::isTrue(visibleIt->second);
+    part.locked = dust3d::String::isTrue(dust3d::String::valueOrEmpty(record, "locked"));
+    part.subdived = dust3d::String::isTrue(dust3d::String::valueOrEmpty(record, "subdived"));
+    part.disabled = dust3d::String::isTrue(dust3d::String::valueOrEmpty(record, "disabled"));
+    part.xMirrored = dust3d::String::isTrue(dust3d::String::valueOrEmpty(record, "xMirrored"));
+    part.rounded = dust3d::String::isTrue(dust3d::String::valueOrEmpty(record, "rounded"));
+    part.chamfered = dust3d::String::isTrue(dust3d::String::valueOrEmpty(record, "chamfered"));
+    part.fillLoopInterior = dust3d::String::isTrue(dust3d::String::valueOrEmpty(record, "fillLoopInterior"));
+    part.target = dust3d::PartTargetFromString(dust3d::String::valueOrEmpty(record, "target").c_str());
+    const auto& cutRotationIt = record.find("cutRotation");
+    if (cutRotationIt != record.end())
+        part.setCutRotation(dust3d::String::toFloat(cutRotationIt->second));
+    const auto& cutFaceIt = record.find("cutFace");
+    if (cutFaceIt != record.end()) {
+        dust3d::Uuid cutFaceLinkedId = dust3d::Uuid(cutFaceIt->second);
+        if (cutFaceLinkedId.isNull())
+            part.setCutFace(dust3d::CutFaceFromString(cutFaceIt->second.c_str()));
+        else
+            part.setCutFaceLinkedId(cutFaceLinkedId);
+    }
+    const auto& metalnessIt = record.find("metallic");
+    if (metalnessIt != record.end())
+        part.metalness = dust3d::String::toFloat(metalnessIt->second);
+    const auto& roughnessIt = record.find("roughness");
+    if (roughnessIt != record.end())
+        part.roughness = dust3d::String::toFloat(roughnessIt->second);
+    const auto& deformThicknessIt = record.find("deformThickness");
+    if (deformThicknessIt != record.end())
+        part.setDeformThickness(dust3d::String::toFloat(deformThicknessIt->second));
+    const auto& deformWidthIt = record.find("deformWidth");
+    if (deformWidthIt != record.end())
+        part.setDeformWidth(dust3d::String::toFloat(deformWidthIt->second));
+    part.deformUnified = dust3d::String::isTrue(dust3d::String::valueOrEmpty(record, "deformUnified"));
+    const auto& hollowThicknessIt = record.find("hollowThickness");
+    if (hollowThicknessIt != record.end())
+        part.hollowThickness = dust3d::String::toFloat(hollowThicknessIt->second);
+    part.importedModelId = dust3d::Uuid(dust3d::String::valueOrEmpty(record, "importedModelId"));
+}
+
+static void loadHistoryComponentRecord(Document::Component& component, const std::map<std::string, std::string>& record)
+{
+    component.name = dust3d::String::valueOrEmpty(record, "name").c_str();
+    component.expanded = dust3d::String::isTrue(dust3d::String::valueOrEmpty(record, "expanded"));
+    component.combineMode = dust3d::CombineModeFromString(dust3d::String::valueOrEmpty(record, "combineMode").c_str());
+    component.sideClosed = dust3d::String::isTrue(dust3d::String::valueOrEmpty(record, "sideClosed"));
+    component.frontClosed = dust3d::String::isTrue(dust3d::String::valueOrEmpty(record, "frontClosed"));
+    component.backClosed = dust3d::String::isTrue(dust3d::String::valueOrEmpty(record, "backClosed"));
+    const auto& backCloseDepthRatioIt = record.find("backCloseDepthRatio");
+    if (backCloseDepthRatioIt != record.end())
+        component.backCloseDepthRatio = dust3d::String::toFloat(backCloseDepthRatioIt->second);
+    const auto& backCloseSharpnessIt = record.find("backCloseSharpness");
+    if (backCloseSharpnessIt != record.end())
+        component.backCloseSharpness = dust3d::String::toFloat(backCloseSharpnessIt->second);
+    const auto& smoothCutoffDegreesIt = record.find("smoothCutoffDegrees");
+    if (smoothCutoffDegreesIt != record.end())
+        component.smoothCutoffDegrees = dust3d::String::toFloat(smoothCutoffDegreesIt->second);
+    const auto& targetSegmentsIt = record.find("targetSegments");
+    if (targetSegmentsIt != record.end())
+        component.targetSegments = dust3d::String::toFloat(targetSegmentsIt->second);
+    component.colorImageId = dust3d::Uuid(dust3d::String::valueOrEmpty(record, "colorImageId"));
+    const auto& colorIt = record.find("color");
+    if (colorIt != record.end()) {
+        component.color = QColor(colorIt->second.c_str());
+        component.hasColor = true;
+    }
+}
+
+static std::vector<dust3d::Uuid> historyChildrenIds(const Document::HistoryRecord& record)
+{
+    std::vector<dust3d::Uuid> childrenIds;
+    if (nullptr == record)
+        return childrenIds;
+    for (const auto& childId : dust3d::String::split(dust3d::String::valueOrEmpty(*record, "children"), ',')) {
+        if (!childId.empty())
+            childrenIds.push_back(dust3d::Uuid(childId));
+    }
+    return childrenIds;
+}
+
+void Document::HistoryState::setRecord(int category, const std::string& id, const HistoryRecord& record)
+{
+    auto& categoryRecords = records[category];
+    std::map<std::string, std::set<std::string>>* partIds = nullptr;
+    if (HistoryNodes == category)
+        partIds = &partNodeIds;
+    else if (HistoryEdges == category)
+        partIds = &partEdgeIds;
+    auto findRecord = categoryRecords.find(id);
+    if (nullptr != partIds && findRecord != categoryRecords.end()) {
+        auto findPart = partIds->find(dust3d::String::valueOrEmpty(*findRecord->second, "partId"));
+        if (findPart != partIds->end()) {
+            findPart->second.erase(id);
+            if (findPart->second.empty())
+                partIds->erase(findPart);
+        }
+    }
+    if (nullptr == record) {
+        if (findRecord != categoryRecords.end())
+            categoryRecords.erase(findRecord);
+        return;
+    }
+    if (nullptr != partIds)
+        (*partIds)[dust3d::String::valueOrEmpty(*record, "partId")].insert(id);
+    if (findRecord != categoryRecords.end())
+        findRecord->second = record;
+    else
+        categoryRecords.emplace(id, record);
+}
+
+bool Document::HistoryItem::empty() const
+{
+    for (size_t category = 0; category < HistoryCategoryCount; ++category) {
+        if (!changes[category].empty())
+            return false;
+    }
+    return true;
+}
+
+void Document::historyStateToSnapshot(dust3d::Snapshot* snapshot) const
+{
+    for (int category = 0; category < HistoryCategoryCount; ++category) {
+        const auto& records = m_historyState.records[category];
+        if (auto singleRecord = snapshotSingleRecord(snapshot, category)) {
+            if (!records.empty())
+                *singleRecord = *records.begin()->second;
+            continue;
+        }
+        SnapshotEntityMap* entities = snapshotEntities(snapshot, category);
+        for (const auto& it : records)
+            entities->emplace_hint(entities->end(), it.first, *it.second);
+    }
+}
+
+void Document::collectHistoryDirtyIds()
+{
+    for (const auto& it : partMap) {
+        if (it.second.dirty)
+            m_historyDirtyPartIds.insert(it.first);
+    }
+    m_historyDirtyPartIds.insert(m_changedGenerationPartIds.begin(), m_changedGenerationPartIds.end());
+    for (const auto& it : componentMap) {
+        if (it.second.dirty)
+            m_historyDirtyComponentIds.insert(it.first);
+    }
+    m_historyDirtyComponentIds.insert(m_changedGenerationComponentIds.begin(), m_changedGenerationComponentIds.end());
+    m_historyDirtyEdgeIds.insert(m_changedGenerationEdgeIds.begin(), m_changedGenerationEdgeIds.end());
+}
+
+// Only dirty parts together with their nodes and edges, and dirty components are written out and compared,
+// the canvas, the root component and the animations are small enough to be compared on every save
+void Document::diffDirtyHistoryRecords(HistoryItem* item)
+{
+    collectHistoryDirtyIds();
+
+    // New parts and components start out dirty, removed ones are only known from the records they left behind
+    for (const auto& it : m_historyState.records[HistoryParts]) {
+        dust3d::Uuid partId(it.first);
+        if (partMap.find(partId) == partMap.end())
+            m_historyDirtyPartIds.insert(partId);
+    }
+    for (const auto& it : m_historyState.records[HistoryComponents]) {
+        dust3d::Uuid componentId(it.first);
+        if (componentMap.find(componentId) == componentMap.end())
+            m_historyDirtyComponentIds.insert(componentId);
+    }
+
+    SnapshotEntityMap entities[HistoryCategoryCount];
+    std::map<std::string, HistoryRecord> stateRecords[HistoryCategoryCount];
+    auto addStateRecord = [&](int category, const std::string& idString) {
+        const auto& records = m_historyState.records[category];
+        auto findRecord = records.find(idString);
+        if (findRecord != records.end())
+            stateRecords[category].insert(*findRecord);
+    };
+    auto addEdge = [&](const std::string& edgeIdString) {
+        addStateRecord(HistoryEdges, edgeIdString);
+        const Edge* edge = findEdge(dust3d::Uuid(edgeIdString));
+        if (nullptr != edge && edge->nodeIds.size() == 2)
+            entities[HistoryEdges][edgeIdString] = edgeSnapshotRecord(*edge);
+    };
+    auto addNode = [&](const std::string& nodeIdString) {
+        addStateRecord(HistoryNodes, nodeIdString);
+        const Node* node = findNode(dust3d::Uuid(nodeIdString));
+        if (nullptr == node)
+            return;
+        entities[HistoryNodes][nodeIdString] = nodeSnapshotRecord(*node);
+        for (const auto& edgeId : node->edgeIds)
+            addEdge(edgeId.toString());
+    };
+
+    for (const auto& partId : m_historyDirtyPartIds) {
+        std::string partIdString = partId.toString();
+        addStateRecord(HistoryParts, partIdString);
+        const Part* part = findPart(partId);
+        if (nullptr != part) {
+            entities[HistoryParts][partIdString] = partSnapshotRecord(*part);
+            for (const auto& nodeId : part->nodeIds)
+                addNode(nodeId.toString());
+        }
+        // Nodes and edges which left the part or were removed are compared against the saved ones
+        auto findNodeIds = m_historyState.partNodeIds.find(partIdString);
+        if (findNodeIds != m_historyState.partNodeIds.end()) {
+            for (const auto& nodeIdString : findNodeIds->second)
+                addNode(nodeIdString);
+        }
+        auto findEdgeIds = m_historyState.partEdgeIds.find(partIdString);
+        if (findEdgeIds != m_historyState.partEdgeIds.end()) {
+            for (const auto& edgeIdString : findEdgeIds->second)
+                addEdge(edgeIdString);
+        }
+    }
+    for (const auto& edgeId : m_historyDirtyEdgeIds)
+        addEdge(edgeId.toString());
+
+    for (const auto& componentId : m_historyDirtyComponentIds) {
+        std::string componentIdString = componentId.toString();
+        addStateRecord(HistoryComponents, componentIdString);
+        const Component* component = findComponent(componentId);
+        if (nullptr != component)
+            entities[HistoryComponents][componentIdString] = componentSnapshotRecord(*component);
+    }
+
+    auto& rootComponentRecord = entities[HistoryRootComponent][std::string()];
+    std::vector<std::string> childIdList;
+    for (const auto& childId : rootComponent.childrenIds)
+        childIdList.push_back(childId.toString());
+    std::string children = dust3d::String::join(childIdList, ",");
+    if (!children.empty())
+        rootComponentRecord["children"] = children;
+
+    dust3d::Snapshot snapshot;
+    canvasToSnapshot(&snapshot);
+    entities[HistoryCanvas][std::string()] = std::move(snapshot.canvas);
+    entities[HistoryAnimations] = std::move(snapshot.animations);
+
+    for (int category : { HistoryCanvas, HistoryRootComponent, HistoryAnimations })
+        stateRecords[category] = m_historyState.records[category];
+    for (int category = 0; category < HistoryCategoryCount; ++category)
+        diffHistoryRecords(stateRecords[category], entities[category], item->changes[category]);
+}
+
+void Document::saveSnapshot()
+{
+    Document::HistoryItem item;
+    if (m_hasHistoryState) {
+        diffDirtyHistoryRecords(&item);
+    } else {
+        dust3d::Snapshot snapshot;
+        toSnapshot(&snapshot);
+        for (int category = 0; category < HistoryCategoryCount; ++category) {
+            auto& stateRecords = m_historyState.records[category];
+            if (auto singleRecord = snapshotSingleRecord(&snapshot, category)) {
+                SnapshotEntityMap entities;
+                entities[std::string()] = std::move(*singleRecord);
+                removeInternalAttributes(entities.begin()->second);
+                diffHistoryRecords(stateRecords, entities, item.changes[category]);
+            } else {
+                SnapshotEntityMap* entities = snapshotEntities(&snapshot, category);
+                for (auto& it : *entities)
+                    removeInternalAttributes(it.second);
+                diffHistoryRecords(stateRecords, *entities, item.changes[category]);
+            }
+        }
+    }
+    m_historyDirtyPartIds.clear();
+    m_historyDirtyComponentIds.clear();
+    m_historyDirtyEdgeIds.clear();
+
+    for (int category = 0; category < HistoryCategoryCount; ++category) {
+        for (const auto& it : item.changes[category])
+            m_historyState.setRecord(category, it.first, it.second.after);
+    }
+
+    // The first state after clearing is the base of the history, there is nothing to undo to
+    bool isHistoryBase = !m_hasHistoryState;
+    m_hasHistoryState = true;
+
+    if (item.empty())
+        return;
+
+    if (!item.changes[HistoryComponents].empty() || nullptr == m_historyStateImageReferences) {
+        std::set<dust3d::Uuid> imageIds;
+        for (const auto& it : m_historyState.records[HistoryComponents])
+            collectHistoryImageIds(it.second, imageIds);
+        m_historyStateImageReferences = std::make_shared<ImageForever::References>(imageIds);
+    }
+
+    if (isHistoryBase)
+        return;
+
+    std::set<dust3d::Uuid> imageIds;
+    for (const auto& it : item.changes[HistoryComponents]) {
+        collectHistoryImageIds(it.second.before, imageIds);
+        collectHistoryImageIds(it.second.after, imageIds);
+    }
+    if (!imageIds.empty())
+        item.imageReferences = std::make_shared<ImageForever::References>(imageIds);
+
+    if (m_undoItems.size() + 1 > m_maxSnapshot)
+        m_undoItems.pop_front();
+    m_undoItems.push_back(std::move(item));
+    m_redoItems.clear();
+
+    // Images no longer reachable from the history can be dropped now that the
+    // current state holds its own references
+    ImageForever::collect();
+}
+
+bool Document::applyHistoryPartChanges(const HistoryItem& item, bool backward)
+{
+    const auto& partChanges = item.changes[HistoryParts];
+    const auto& nodeChanges = item.changes[HistoryNodes];
+
+    // A part is only removed together with all of its nodes
+    for (const auto& it : partChanges) {
+        if (nullptr != (backward ? it.second.before : it.second.after))
+            continue;
+        auto findPart = partMap.find(dust3d::Uuid(it.first));
+        if (findPart == partMap.end())
+            return false;
+        for (const auto& nodeId : findPart->second.nodeIds) {
+            if (nodeChanges.find(nodeId.toString()) == nodeChanges.end())
+                return false;
+        }
+    }
+
+    for (const auto& it : partChanges) {
+        const auto& record = backward ? it.second.before : it.second.after;
+        if (nullptr == record)
+            continue;
+        dust3d::Uuid partId = dust3d::Uuid(it.first);
+        Document::Part loaded(partId);
+        loadHistoryPartRecord(loaded, *record);
+        m_changedGenerationPartIds.insert(partId);
+
+        auto findPart = partMap.find(partId);
+        if (findPart == partMap.end()) {
+            Document::Part& part = partMap[partId];
+            part.id = partId;
+            part.copyAttributes(loaded);
+            part.name = loaded.name;
+            part.fillLoopInterior = loaded.fillLoopInterior;
+            emit partAdded(partId);
+            continue;
+        }
+
+        Document::Part& part = findPart->second;
+        Document::Part old(partId);
+        old.copyAttributes(part);
+        old.fillLoopInterior = part.fillLoopInterior;
+        dust3d::Uuid componentId = part.componentId;
+        bool dirty = part.dirty;
+        part.copyAttributes(loaded);
+        part.name = loaded.name;
+        part.fillLoopInterior = loaded.fillLoopInterior;
+        part.componentId = componentId;
+
+        // Visibility and lock states only change the record, everything else changes the mesh
+        part.dirty = dirty || old.subdived != part.subdived || old.disabled != part.disabled || old.xMirrored != part.xMirrored
+            || old.deformThickness != part.deformThickness || old.deformWidth != part.deformWidth || old.deformUnified != part.deformUnified
+            || old.rounded != part.rounded || old.chamfered != part.chamfered || old.fillLoopInterior != part.fillLoopInterior
+            || old.cutRotation != part.cutRotation || old.cutFace != part.cutFace || old.cutFaceLinkedId != part.cutFaceLinkedId
+            || old.target != part.target || old.metalness != part.metalness || old.roughness != part.roughness
+            || old.hollowThickness != part.hollowThickness || old.importedModelId != part.importedModelId;
+
+        if (old.visible != part.visible)
+            emit partVisibleStateChanged(partId);
+        if (old.locked != part.locked)
+            emit partLockStateChanged(partId);
+        if (old.subdived != part.subdived)
+            emit partSubdivStateChanged(partId);
+        if (old.disabled != part.disabled)
+            emit partDisableStateChanged(partId);
+        if (old.xMirrored != part.xMirrored)
+            emit partXmirrorStateChanged(partId);
+        if (old.deformThickness != part.deformThickness)
+            emit partDeformThicknessChanged(partId);
+        if (old.deformWidth != part.deformWidth)
+            emit partDeformWidthChanged(partId);
+        if (old.deformUnified != part.deformUnified)
+            emit partDeformUnifyStateChanged(partId);
+        if (old.rounded != part.rounded)
+            emit partRoundStateChanged(partId);
+        if (old.chamfered != part.chamfered)
+            emit partChamferStateChanged(partId);
+        if (old.fillLoopInterior != part.fillLoopInterior)
+            emit partFillLoopInteriorStateChanged(partId);
+        if (old.cutRotation != part.cutRotation)
+            emit partCutRotationChanged(partId);
+        if (old.cutFace != part.cutFace || old.cutFaceLinkedId != part.cutFaceLinkedId)
+            emit partCutFaceChanged(partId);
+        if (old.target != part.target)
+            emit partTargetChanged(partId);
+        if (old.metalness != part.metalness)
+            emit partMetalnessChanged(partId);
+        if (old.roughness != part.roughness)
+            emit partRoughnessChanged(partId);
+        if (old.hollowThickness != part.hollowThickness)
+            emit partHollowThicknessChanged(partId);
+        if (old.importedModelId != part.importedModelId)
+            emit partImportedModelIdChanged(partId);
+    }
+    return true;
+}
+
+bool Document::applyHistoryNodeAndEdgeChanges(const HistoryItem& item, bool backward)
+{
+    const auto& nodeChanges = item.changes[HistoryNodes];
+    const auto& edgeChanges = item.changes[HistoryEdges];
+    auto targetRecord = [&](const HistoryChange& change) -> const HistoryRecord& {
+        return backward ? change.before : change.after;
+    };
+    auto nodeExistsAfterApply = [&](const std::string& nodeIdString) {
+        auto findChange = nodeChanges.find(nodeIdString);
+        if (findChange != nodeChanges.end())
+            return nullptr != targetRecord(findChange->second);
+        return nodeMap.find(dust3d::Uuid(nodeIdString)) != nodeMap.end();
+    };
+    auto partExists = [&](const std::map<std::string, std::string>& record) {
+        return partMap.find(dust3d::Uuid(dust3d::String::valueOrEmpty(record, "partId"))) != partMap.end();
+    };
+
+    // Check the changes fit the current document before touching anything
+    for (const auto& it : nodeChanges) {
+        const auto& record = targetRecord(it.second);
+        if (nullptr == record) {
+            auto findNode = nodeMap.find(dust3d::Uuid(it.first));
+            if (findNode == nodeMap.end())
+                return false;
+            for (const auto& edgeId : findNode->second.edgeIds) {
+                if (edgeChanges.find(edgeId.toString()) == edgeChanges.end())
+                    return false;
+            }
+            continue;
+        }
+        if (record->find("radius") == record->end() || record->find("x") == record->end() || record->find("y") == record->end() || record->find("z") == record->end())
+            return false;
+        if (!partExists(*record))
+            return false;
+    }
+    for (const auto& it : edgeChanges) {
+        const auto& record = targetRecord(it.second);
+        if (nullptr == record)
+            continue;
+        if (!nodeExistsAfterApply(dust3d::String::valueOrEmpty(*record, "from")) || !nodeExistsAfterApply(dust3d::String::valueOrEmpty(*record, "to")))
+            return false;
+        if (!partExists(*record))
+            return false;
+    }
+
+    auto markPartDirty = [&](const dust3d::Uuid& partId) {
+        auto findPart = partMap.find(partId);
+        if (findPart != partMap.end())
+            findPart->second.dirty = true;
+    };
+
+    // Detach the changed and removed edges first, they are attached again below
+    for (const auto& it : edgeChanges) {
+        dust3d::Uuid edgeId = dust3d::Uuid(it.first);
+        auto findEdge = edgeMap.find(edgeId);
+        if (findEdge == edgeMap.end())
+            continue;
+        for (const auto& nodeId : findEdge->second.nodeIds) {
+            auto findNode = nodeMap.find(nodeId);
+            if (findNode == nodeMap.end())
+                continue;
+            auto& edgeIds = findNode->second.edgeIds;
+            edgeIds.erase(std::remove(edgeIds.begin(), edgeIds.end(), edgeId), edgeIds.end());
+        }
+        markPartDirty(findEdge->second.partId);
+        if (nullptr == targetRecord(it.second)) {
+            edgeMap.erase(findEdge);
+            emit edgeRemoved(edgeId);
+        }
+    }
+
+    for (const auto& it : nodeChanges) {
+        dust3d::Uuid nodeId = dust3d::Uuid(it.first);
+        const auto& record = targetRecord(it.second);
+        auto findNode = nodeMap.find(nodeId);
+        if (nullptr == record) {
+            auto findPart = partMap.find(findNode->second.partId);
+            if (findPart != partMap.end()) {
+                auto& nodeIds = findPart->second.nodeIds;
+                nodeIds.erase(std::remove(nodeIds.begin(), nodeIds.end(), nodeId), nodeIds.end());
+                findPart->second.dirty = true;
+            }
+            nodeMap.erase(findNode);
+            emit nodeRemoved(nodeId);
+            continue;
+        }
+        bool isNewNode = findNode == nodeMap.end();
+        if (isNewNode)
+            findNode = nodeMap.emplace(nodeId, Document::Node(nodeId)).first;
+        Document::Node& node = findNode->second;
+        float oldX = node.getX();
+        float oldY = node.getY();
+        float oldZ = node.getZ();
+        float oldRadius = node.radius;
+        dust3d::CutFace oldCutFace = node.cutFace;
+        dust3d::Uuid oldCutFaceLinkedId = node.cutFaceLinkedId;
+        float oldCutRotation = node.cutRotation;
+        dust3d::Uuid oldPartId = node.partId;
+
+        node.name = dust3d::String::valueOrEmpty(*record, "name").c_str();
+        node.radius = dust3d::String::toFloat(dust3d::String::valueOrEmpty(*record, "radius"));
+        node.setX(dust3d::String::toFloat(dust3d::String::valueOrEmpty(*record, "x")));
+        node.setY(dust3d::String::toFloat(dust3d::String::valueOrEmpty(*record, "y")));
+        node.setZ(dust3d::String::toFloat(dust3d::String::valueOrEmpty(*record, "z")));
+        node.partId = dust3d::Uuid(dust3d::String::valueOrEmpty(*record, "partId"));
+        node.clearCutFaceSettings();
+        const auto& cutRotationIt = record->find("cutRotation");
+        if (cutRotationIt != record->end())
+            node.setCutRotation(dust3d::String::toFloat(cutRotationIt->second));
+        const auto& cutFaceIt = record->find("cutFace");
+        if (cutFaceIt != record->end()) {
+            dust3d::Uuid cutFaceLinkedId = dust3d::Uuid(cutFaceIt->second);
+            if (cutFaceLinkedId.isNull())
+                node.setCutFace(dust3d::CutFaceFromString(cutFaceIt->second.c_str()));
+            else
+                node.setCutFaceLinkedId(cutFaceLinkedId);
+        }
+
+        if (isNewNode || oldPartId != node.partId) {
+            auto findOldPart = partMap.find(oldPartId);
+            if (!isNewNode && findOldPart != partMap.end()) {
+                auto& nodeIds = findOldPart->second.nodeIds;
+                nodeIds.erase(std::remove(nodeIds.begin(), nodeIds.end(), nodeId), nodeIds.end());
+                findOldPart->second.dirty = true;
+            }
+            partMap[node.partId].nodeIds.push_back(nodeId);
+        }
+        markPartDirty(node.partId);
+
+        if (isNewNode) {
+            emit nodeAdded(nodeId);
+            continue;
+        }
+        if (oldX != node.getX() || oldY != node.getY() || oldZ != node.getZ())
+            emit nodeOriginChanged(nodeId);
+        if (oldRadius != node.radius)
+            emit nodeRadiusChanged(nodeId);
+        if (oldCutRotation != node.cutRotation)
+            emit nodeCutRotationChanged(nodeId);
+        if (oldCutFace != node.cutFace || oldCutFaceLinkedId != node.cutFaceLinkedId)
+            emit nodeCutFaceChanged(nodeId);
+    }
+
+    for (const auto& it : edgeChanges) {
+        const auto& record = targetRecord(it.second);
+        if (nullptr == record)
+            continue;
+        dust3d::Uuid edgeId = dust3d::Uuid(it.first);
+        auto findEdge = edgeMap.find(edgeId);
+        bool isNewEdge = findEdge == edgeMap.end();
+        if (isNewEdge)
+            findEdge = edgeMap.emplace(edgeId, Document::Edge(edgeId)).first;
+        Document::Edge& edge = findEdge->second;
+        edge.name = dust3d::String::valueOrEmpty(*record, "name").c_str();
+        edge.boneName = dust3d::String::valueOrEmpty(*record, "boneName").c_str();
+        edge.partId = dust3d::Uuid(dust3d::String::valueOrEmpty(*record, "partId"));
+        edge.nodeIds = {
+            dust3d::Uuid(dust3d::String::valueOrEmpty(*record, "from")),
+            dust3d::Uuid(dust3d::String::valueOrEmpty(*record, "to"))
+        };
+        for (const auto& nodeId : edge.nodeIds)
+            nodeMap[nodeId].edgeIds.push_back(edgeId);
+        markPartDirty(edge.partId);
+        if (isNewEdge)
+            emit edgeAdded(edgeId);
+        else
+            emit edgeNodeChanged(edgeId);
+    }
+
+    return true;
+}
+
+bool Document::applyHistoryComponentChanges(const HistoryItem& item, bool backward)
+{
+    const auto& componentChanges = item.changes[HistoryComponents];
+    const auto& rootChanges = item.changes[HistoryRootComponent];
+    auto targetRecord = [&](const HistoryChange& change) -> const HistoryRecord& {
+        return backward ? change.before : change.after;
+    };
+    auto componentExistsAfterApply = [&](const dust3d::Uuid& componentId) {
+        auto findChange = componentChanges.find(componentId.toString());
+        if (findChange != componentChanges.end())
+            return nullptr != targetRecord(findChange->second);
+        return componentMap.find(componentId) != componentMap.end();
+    };
+    auto childrenExistAfterApply = [&](const HistoryRecord& record) {
+        for (const auto& childId : historyChildrenIds(record)) {
+            if (!componentExistsAfterApply(childId))
+                return false;
+        }
+        return true;
+    };
+
+    // Parts are already in place, a component keeps the part it was created for
+    for (const auto& it : componentChanges) {
+        const auto& record = targetRecord(it.second);
+        if (nullptr == record)
+            continue;
+        QString linkData = dust3d::String::valueOrEmpty(*record, "linkData").c_str();
+        auto findComponent = componentMap.find(dust3d::Uuid(it.first));
+        if (findComponent != componentMap.end() && findComponent->second.linkData() != linkData)
+            return false;
+        if ("partId" == dust3d::String::valueOrEmpty(*record, "linkDataType") && partMap.find(dust3d::Uuid(linkData.toUtf8().constData())) == partMap.end())
+            return false;
+        if (!childrenExistAfterApply(record))
+            return false;
+    }
+    for (const auto& it : rootChanges) {
+        if (!childrenExistAfterApply(targetRecord(it.second)))
+            return false;
+    }
+
+    std::set<dust3d::Uuid> childrenChangedIds;
+    auto setChildren = [&](Document::Component& component, const std::vector<dust3d::Uuid>& childrenIds) {
+        if (component.childrenIds == childrenIds)
+            return;
+        auto oldChildrenIds = component.childrenIds;
+        for (const auto& childId : oldChildrenIds)
+            component.removeChild(childId);
+        for (const auto& childId : childrenIds)
+            component.addChild(childId);
+        childrenChangedIds.insert(component.id);
+    };
+
+    std::vector<dust3d::Uuid> addedComponentIds;
+    for (const auto& it : componentChanges) {
+        const auto& record = targetRecord(it.second);
+        if (nullptr == record)
+            continue;
+        dust3d::Uuid componentId = dust3d::Uuid(it.first);
+        QString linkData = dust3d::String::valueOrEmpty(*record, "linkData").c_str();
+        QString linkDataType = dust3d::String::valueOrEmpty(*record, "linkDataType").c_str();
+        Document::Component loaded(componentId, linkData, linkDataType);
+        loadHistoryComponentRecord(loaded, *record);
+        m_changedGenerationComponentIds.insert(componentId);
+
+        auto findComponent = componentMap.find(componentId);
+        if (findComponent == componentMap.end()) {
+            if (!loaded.linkToPartId.isNull())
+                partMap[loaded.linkToPartId].componentId = componentId;
+            findComponent = componentMap.emplace(componentId, std::move(loaded)).first;
+            setChildren(findComponent->second, historyChildrenIds(record));
+            addedComponentIds.push_back(componentId);
+            continue;
+        }
+
+        Document::Component& component = findComponent->second;
+        bool isNameChanged = component.name != loaded.name;
+        bool isExpandStateChanged = component.expanded != loaded.expanded;
+        bool isCombineModeChanged = component.combineMode != loaded.combineMode;
+        bool isColorImageChanged = component.colorImageId != loaded.colorImageId;
+        bool isColorStateChanged = component.hasColor != loaded.hasColor || component.color != loaded.color;
+        bool isSideCloseStateChanged = component.sideClosed != loaded.sideClosed;
+        bool isFrontCloseStateChanged = component.frontClosed != loaded.frontClosed;
+        bool isBackCloseStateChanged = component.backClosed != loaded.backClosed;
+        bool isBackCloseDepthRatioChanged = component.backCloseDepthRatio != loaded.backCloseDepthRatio;
+        bool isBackCloseSharpnessChanged = component.backCloseSharpness != loaded.backCloseSharpness;
+        bool isSmoothCutoffDegreesChanged = component.smoothCutoffDegrees != loaded.smoothCutoffDegrees;
+        bool isTargetSegmentsChanged = component.targetSegments != loaded.targetSegments;
+        component.name = loaded.name;
+        component.expanded = loaded.expanded;
+        component.combineMode = loaded.combineMode;
+        component.colorImageId = loaded.colorImageId;
+        component.hasColor = loaded.hasColor;
+        component.color = loaded.color;
+        component.sideClosed = loaded.sideClosed;
+        component.frontClosed = loaded.frontClosed;
+        component.backClosed = loaded.backClosed;
+        component.backCloseDepthRatio = loaded.backCloseDepthRatio;
+        component.backCloseSharpness = loaded.backCloseSharpness;
+        component.smoothCutoffDegrees = loaded.smoothCutoffDegrees;
+        component.targetSegments = loaded.targetSegments;
+        setChildren(component, historyChildrenIds(record));
+
+        // Names and expand states only change the record, everything else changes the mesh
+        if (isCombineModeChanged || isColorImageChanged || isColorStateChanged || isSideCloseStateChanged
+            || isFrontCloseStateChanged || isBackCloseStateChanged || isBackCloseDepthRatioChanged
+            || isBackCloseSharpnessChanged || isSmoothCutoffDegreesChanged || isTargetSegmentsChanged
+            || childrenChangedIds.find(componentId) != childrenChangedIds.end())
+            component.dirty = true;
+        if (isColorImageChanged)
+            component.isPreviewMeshObsolete = true;
+
+        if (isNameChanged)
+            emit componentNameChanged(componentId);
+        if (isExpandStateChanged)
+            emit componentExpandStateChanged(componentId);
+        if (isCombineModeChanged)
+            emit componentCombineModeChanged(componentId);
+        if (isColorImageChanged)
+            emit componentColorImageChanged(componentId);
+        if (isColorStateChanged)
+            emit componentColorStateChanged(componentId);
+        if (isSideCloseStateChanged)
+            emit componentSideCloseStateChanged(componentId);
+        if (isFrontCloseStateChanged)
+            emit componentFrontCloseStateChanged(componentId);
+        if (isBackCloseStateChanged)
+            emit componentBackCloseStateChanged(componentId);
+        if (isBackCloseDepthRatioChanged)
+            emit componentBackCloseDepthRatioChanged(componentId);
+        if (isBackCloseSharpnessChanged)
+            emit componentBackCloseSharpnessChanged(componentId);
+        if (isSmoothCutoffDegreesChanged)
+            emit componentSmoothCutoffDegreesChanged(componentId);
+        if (isTargetSegmentsChanged)
+            emit componentTargetSegmentsChanged(componentId);
+    }
+    for (const auto& it : rootChanges)
+        setChildren(rootComponent, historyChildrenIds(targetRecord(it.second)));
+
+    std::vector<dust3d::Uuid> removedComponentIds;
+    for (const auto& it : componentChanges) {
+        if (nullptr != targetRecord(it.second))
+            continue;
+        dust3d::Uuid componentId = dust3d::Uuid(it.first);
+        if (0 == componentMap.erase(componentId))
+            continue;
+        childrenChangedIds.erase(componentId);
+        removedComponentIds.push_back(componentId);
+    }
+
+    // Every component which moved is listed by its new parent, so only those parents need to be visited
+    for (const auto& componentId : childrenChangedIds) {
+        const auto& childrenIds = componentId.isNull() ? rootComponent.childrenIds : componentMap[componentId].childrenIds;
+        for (const auto& childId : childrenIds)
+            componentMap[childId].parentId = componentId;
+    }
+    if (!m_currentCanvasComponentId.isNull() && componentMap.find(m_currentCanvasComponentId) == componentMap.end())
+        setCurrentCanvasComponentId(dust3d::Uuid());
+
+    for (const auto& componentId : removedComponentIds)
+        emit componentRemoved(componentId);
+    for (const auto& componentId : addedComponentIds)
+        emit componentAdded(componentId);
+    for (const auto& componentId : childrenChangedIds)
+        emit componentChildrenChanged(componentId);
+    return true;
+}
+
+void Document::applyHistoryCanvasChanges(const HistoryItem& item, bool backward)
+{
+    for (const auto& it : item.changes[HistoryCanvas]) {
+        const auto& record = backward ? it.second.before : it.second.after;
+        if (nullptr == record)
+            continue;
+        const auto& originXit = record->find("originX");
+        const auto& originYit = record->find("originY");
+        const auto& originZit = record->find("originZ");
+        if (originXit != record->end() && originYit != record->end() && originZit != record->end()) {
+            float originX = dust3d::String::toFloat(originXit->second);
+            float originY = dust3d::String::toFloat(originYit->second);
+            float originZ = dust3d::String::toFloat(originZit->second);
+            if (originX != getOriginX() || originY != getOriginY() || originZ != getOriginZ()) {
+                setOriginX(originX);
+                setOriginY(originY);
+                setOriginZ(originZ);
+                emit originChanged();
+            }
+        }
+        const auto& rigTypeIt = record->find("rigType");
+        if (rigTypeIt != record->end())
+            setRigType(QString::fromUtf8(rigTypeIt->second.c_str()));
+        setHeadHasEyelids(dust3d::String::isTrue(dust3d::String::valueOrEmpty(*record, "headHasEyelids")));
+    }
+}
+
+bool Document::applyHistoryAnimationChanges(const HistoryItem& item, bool backward)
+{
+    const auto& animationChanges = item.changes[HistoryAnimations];
+    if (animationChanges.empty())
+        return true;
+
+    for (const auto& it : animationChanges) {
+        const auto& record = backward ? it.second.before : it.second.after;
+        if (nullptr != record && (record->find("name") == record->end() || record->find("type") == record->end()))
+            return false;
+    }
+
+    for (const auto& it : animationChanges) {
+        const auto& record = backward ? it.second.before : it.second.after;
+        dust3d::Uuid animationId = dust3d::Uuid(it.first);
+        auto findAnimation = m_animations.find(animationId);
+        if (nullptr == record) {
+            if (findAnimation == m_animations.end())
+                continue;
+            m_animations.erase(findAnimation);
+            if (m_currentAnimationId == animationId)
+                m_currentAnimationId = dust3d::Uuid();
+            emit animationRemoved(animationId);
+            continue;
+        }
+
+        Animation loaded;
+        loaded.id = animationId;
+        loaded.name = QString::fromUtf8(record->at("name").c_str());
+        loaded.type = QString::fromUtf8(record->at("type").c_str());
+        for (const auto& attrIt : *record) {
+            if (attrIt.first != "id" && attrIt.first != "name" && attrIt.first != "type")
+                loaded.params[attrIt.first] = attrIt.second;
+        }
+
+        if (findAnimation == m_animations.end()) {
+            m_animations[animationId] = loaded;
+            emit animationAdded(animationId);
+            continue;
+        }
+        Animation& animation = findAnimation->second;
+        bool isNameChanged = animation.name != loaded.name;
+        bool isTypeChanged = animation.type != loaded.type;
+        bool isParamsChanged = animation.params != loaded.params;
+        animation = loaded;
+        if (isNameChanged)
+            emit animationNameChanged(animationId);
+        if (isTypeChanged)
+            emit animationTypeChanged(animationId);
+        if (isParamsChanged)
+            emit animationParamsChanged(animationId);
+    }
+    emit animationsChanged();
+    return true;
+}
+
+// Parts come first, so the nodes and components placed next find them, and are
+// removed last, once none of their nodes are left
+bool Document::applyHistoryChanges(const HistoryItem& item, bool backward)
+{
+    if (!applyHistoryPartChanges(item, backward))
+        return false;
+    if (!applyHistoryNodeAndEdgeChanges(item, backward))
+        return false;
+    for (const auto& it : item.changes[HistoryParts]) {
+        if (nullptr != (backward ? it.second.before : it.second.after))
+            continue;
+        dust3d::Uuid partId = dust3d::Uuid(it.first);
+        partMap.erase(partId);
+        emit partRemoved(partId);
+    }
+    if (!applyHistoryComponentChanges(item, backward))
+        return false;
+    applyHistoryCanvasChanges(item, backward);
+    if (!applyHistoryAnimationChanges(item, backward))
+        return false;
+
+    bool isSkeletonChanged = false;
+    for (int category = 0; category < HistoryCategoryCount; ++category) {
+        if (HistoryAnimations != category && !item.changes[category].empty()) {
+            isSkeletonChanged = true;
+            break;
+        }
+    }
+    if (isSkeletonChanged)
+        emit skeletonChanged();
+    else
+        emit optionsChanged();
+    return true;
+}
+
+void Document::applyHistoryItem(const HistoryItem& item, bool backward)
+{
+    for (int category = 0; category < HistoryCategoryCount; ++category) {
+        for (const auto& it : item.changes[category])
+            m_historyState.setRecord(category, it.first, backward ? it.second.before : it.second.after);
+    }
+
+    // Changes are applied in place with the signals of the matching edits, only a document
+    // which no longer fits the recorded changes is rebuilt from the history state
+    if (applyHistoryChanges(item, backward))
+        return;
+
+    dust3d::Snapshot snapshot;
+    historyStateToSnapshot(&snapshot);
+    fromSnapshot(snapshot);
+}
+
+void Document::undo()
+{
+    if (!undoable())
+        return;
+    HistoryItem item = std::move(m_undoItems.back());
+    m_undoItems.pop_back();
+    applyHistoryItem(item, true);
+    m_redoItems.push_back(std::move(item));
+    qDebug() << "Undo/Redo items:" << m_undoItems.size() << m_redoItems.size();
+}
+
+void Document::redo()
+{
+    if (!redoable())
+        return;
+    HistoryItem item = std::move(m_redoItems.back());
+    m_redoItems.pop_back();
+    applyHistoryItem(item, false);
+    m_undoItems.push_back(std::move(item));
+    qDebug() << "Undo/Redo items:" << m_undoItems.size() << m_redoItems.size();
+}
+
+void Document::clearHistories()
+{
+    m_undoItems.clear();
+    m_redoItems.clear();
+    m_historyState = HistoryState();
+    m_hasHistoryState = false;
+    m_historyDirtyPartIds.clear();
+    m_historyDirtyComponentIds.clear();
+    m_historyDirtyEdgeIds.clear();
+}
+
+bool Document::undoable() const
+{
+    return !m_undoItems.empty();
+}
+
+bool Document::redoable() const
+{
+    return !m_redoItems.empty();
+}
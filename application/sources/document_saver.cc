@@ -4,6 +4,7 @@
 #include <QGuiApplication>
 #include <QtCore/qbuffer.h>
 #include <dust3d/base/ds3_file.h>
+#include <dust3d/base/snapshot_binary.h>
 #include <dust3d/base/snapshot_xml.h>
 #include <set>
 
@@ -63,6 +64,13 @@ bool DocumentSaver::save(dust3d::Ds3FileWriter& ds3Writer,
         }
     }
 
+    {
+        // Loaded in preference to model.xml, which is still written for older versions
+        std::vector<std::uint8_t> modelBinary;
+        saveSnapshotToBinary(*snapshot, modelBinary);
+        ds3Writer.add("model.bin", "snapshot", modelBinary.data(), modelBinary.size());
+    }
+
     if (nullptr != turnaroundPngByteArray && turnaroundPngByteArray->size() > 0)
         ds3Writer.add("canvas.png", "asset", turnaroundPngByteArray->data(), turnaroundPngByteArray->size());
 
@@ -71,11 +79,9 @@ bool DocumentSaver::save(dust3d::Ds3FileWriter& ds3Writer,
     collectUsedResourceIds(snapshot, imageIds, glbIds);
 
     for (const auto& imageId : imageIds) {
-        const QByteArray* pngByteArray = ImageForever::getPngByteArray(imageId);
-        if (nullptr == pngByteArray)
-            continue;
-        if (pngByteArray->size() > 0)
-            ds3Writer.add("images/" + imageId.toString() + ".png", "asset", pngByteArray->data(), pngByteArray->size());
+        QByteArray pngByteArray = ImageForever::getPngByteArray(imageId);
+        if (pngByteArray.size() > 0)
+            ds3Writer.add("images/" + imageId.toString() + ".png", "asset", pngByteArray.data(), pngByteArray.size());
     }
 
     for (const auto& glbId : glbIds) {
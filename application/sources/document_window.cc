@@ -5,9 +5,8 @@
 #include "cut_face_preview.h"
 #include "document.h"
 #include "document_saver.h"
-#include "export_animation_worker.h"
+#include "export_planner.h"
 #include "export_progress_widget.h"
-#include "fbx_file.h"
 #include "float_number_widget.h"
 #include "flow_layout.h"
 #include "glb_file.h"
@@ -64,12 +63,12 @@
 #include <QWidgetAction>
 #include <QtCore/qbuffer.h>
 #include <dust3d/animation/animation_generator.h>
-#include <dust3d/animation/sound_event_detector.h>
-#include <dust3d/animation/sound_generator.h>
 #include <dust3d/base/debug.h>
 #include <dust3d/base/ds3_file.h>
 #include <dust3d/base/snapshot.h>
+#include <dust3d/base/snapshot_binary.h>
 #include <dust3d/base/snapshot_xml.h>
+#include <limits>
 #include <map>
 #include <unordered_map>
 #include <unordered_set>
@@ -427,8 +426,50 @@ DocumentWindow::DocumentWindow()
     m_exportAsFbxAction = new QAction(tr("Export as FBX..."), this);
     connect(m_exportAsFbxAction, &QAction::triggered, this, &DocumentWindow::exportFbxResult, Qt::QueuedConnection);
     m_fileMenu->addAction(m_exportAsFbxAction);
+
+    m_exportAsAllFormatsAction = new QAction(tr("Export as GLB, FBX and OBJ..."), this);
+    connect(m_exportAsAllFormatsAction, &QAction::triggered, this, &DocumentWindow::exportAllFormatsResult, Qt::QueuedConnection);
+    m_fileMenu->addAction(m_exportAsAllFormatsAction);
 #endif
 
+    m_exportLodChainAction = new QAction(tr("Export with Levels of Detail"), this);
+    m_exportLodChainAction->setCheckable(true);
+    m_exportLodChainAction->setChecked(Preferences::instance().exportLodChain());
+    connect(m_exportLodChainAction, &QAction::toggled, &Preferences::instance(), &Preferences::setExportLodChain);
+    connect(&Preferences::instance(), &Preferences::exportLodChainChanged, this, [=]() {
+        m_exportLodChainAction->setChecked(Preferences::instance().exportLodChain());
+    });
+    m_fileMenu->addAction(m_exportLodChainAction);
+
+    m_exportQuantizedGlbAction = new QAction(tr("Quantize GLB Attributes"), this);
+    m_exportQuantizedGlbAction->setCheckable(true);
+    m_exportQuantizedGlbAction->setChecked(Preferences::instance().exportQuantizedGlb());
+    connect(m_exportQuantizedGlbAction, &QAction::toggled, &Preferences::instance(), &Preferences::setExportQuantizedGlb);
+    connect(&Preferences::instance(), &Preferences::exportQuantizedGlbChanged, this, [=]() {
+        m_exportQuantizedGlbAction->setChecked(Preferences::instance().exportQuantizedGlb());
+    });
+    m_fileMenu->addAction(m_exportQuantizedGlbAction);
+
+    m_exportMeshoptGlbAction = new QAction(tr("Compress GLB with Meshopt"), this);
+    m_exportMeshoptGlbAction->setCheckable(true);
+    m_exportMeshoptGlbAction->setChecked(Preferences::instance().exportMeshoptGlb());
+    connect(m_exportMeshoptGlbAction, &QAction::toggled, &Preferences::instance(), &Preferences::setExportMeshoptGlb);
+    connect(&Preferences::instance(), &Preferences::exportMeshoptGlbChanged, this, [=]() {
+        m_exportMeshoptGlbAction->setChecked(Preferences::instance().exportMeshoptGlb());
+    });
+    m_fileMenu->addAction(m_exportMeshoptGlbAction);
+
+    m_bakeAmbientOcclusionAction = new QAction(tr("Bake Ambient Occlusion"), this);
+    m_bakeAmbientOcclusionAction->setCheckable(true);
+    m_bakeAmbientOcclusionAction->setChecked(Preferences::instance().bakeAmbientOcclusion());
+    connect(m_bakeAmbientOcclusionAction, &QAction::toggled, &Preferences::instance(), &Preferences::setBakeAmbientOcclusion);
+    connect(&Preferences::instance(), &Preferences::bakeAmbientOcclusionChanged, this, [=]() {
+        m_bakeAmbientOcclusionAction->setChecked(Preferences::instance().bakeAmbientOcclusion());
+        m_document->setAmbientOcclusionBaked(Preferences::instance().bakeAmbientOcclusion());
+    });
+    m_fileMenu->addAction(m_bakeAmbientOcclusionAction);
+    m_document->setAmbientOcclusionBaked(Preferences::instance().bakeAmbientOcclusion());
+
     m_fileMenu->addSeparator();
 
     m_exportAsGlbAndWavsAction = new QAction(tr("Export as GLB and WAVs..."), this);
@@ -482,6 +523,7 @@ DocumentWindow::DocumentWindow()
         m_exportAsObjAction->setEnabled(m_canvasGraphicsWidget->hasItems());
         m_exportAsGlbAction->setEnabled(m_canvasGraphicsWidget->hasItems() && m_document->isExportReady());
         m_exportAsFbxAction->setEnabled(m_canvasGraphicsWidget->hasItems() && m_document->isExportReady());
+        m_exportAsAllFormatsAction->setEnabled(m_canvasGraphicsWidget->hasItems() && m_document->isExportReady());
     });
 
     m_editMenu = menuBar()->addMenu(tr("&Edit"));
@@ -749,6 +791,8 @@ DocumentWindow::DocumentWindow()
     connect(canvasGraphicsWidget, &SkeletonGraphicsWidget::paste, m_document, &Document::paste);
     connect(canvasGraphicsWidget, &SkeletonGraphicsWidget::batchChangeBegin, m_document, &Document::batchChangeBegin);
     connect(canvasGraphicsWidget, &SkeletonGraphicsWidget::batchChangeEnd, m_document, &Document::batchChangeEnd);
+    connect(canvasGraphicsWidget, &SkeletonGraphicsWidget::interactiveMoveBegin, m_document, &Document::interactiveMoveBegin);
+    connect(canvasGraphicsWidget, &SkeletonGraphicsWidget::interactiveMoveEnd, m_document, &Document::interactiveMoveEnd);
     connect(canvasGraphicsWidget, &SkeletonGraphicsWidget::breakEdge, m_document, &Document::breakEdge);
     connect(canvasGraphicsWidget, &SkeletonGraphicsWidget::reduceNode, m_document, &Document::reduceNode);
     connect(canvasGraphicsWidget, &SkeletonGraphicsWidget::reverseEdge, m_document, &Document::reverseEdge);
@@ -1363,35 +1407,57 @@ void DocumentWindow::openPathDataAs(const QString& path, const QByteArray& fileD
                 std::string imageIdString = dust3d::String::split(filename, '.')[0];
                 dust3d::Uuid imageId = dust3d::Uuid(imageIdString);
                 if (!imageId.isNull()) {
-                    std::vector<std::uint8_t> data;
-                    ds3Reader.loadItem(item.name, &data);
-                    QImage image = QImage::fromData(data.data(), (int)data.size(), "PNG");
-                    (void)ImageForever::add(&image, imageId);
+                    dust3d::Ds3ReaderSpan span = ds3Reader.itemSpan(item.name);
+                    QImage image = QImage::fromData(span.data, (int)span.size, "PNG");
+                    // The png bytes outlive the file mapping, so they are copied once here
+                    QByteArray pngByteArray((const char*)span.data, (int)span.size);
+                    (void)ImageForever::add(&image, pngByteArray, imageId);
                 }
             } else if (dust3d::String::startsWith(item.name, "models/")) {
                 std::string filename = dust3d::String::split(item.name, '/')[1];
                 std::string glbIdString = dust3d::String::split(filename, '.')[0];
                 dust3d::Uuid glbId = dust3d::Uuid(glbIdString);
                 if (!glbId.isNull()) {
-                    std::vector<std::uint8_t> data;
-                    ds3Reader.loadItem(item.name, &data);
-                    QByteArray glbData((const char*)data.data(), (int)data.size());
+                    dust3d::Ds3ReaderSpan span = ds3Reader.itemSpan(item.name);
+                    QByteArray glbData((const char*)span.data, (int)span.size);
                     (void)GlbForever::add(&glbData, glbId);
                 }
             }
         }
     }
 
+    bool snapshotLoaded = false;
+    for (const auto& item : ds3Reader.items()) {
+        if (item.type != "snapshot")
+            continue;
+        dust3d::Ds3ReaderSpan span = ds3Reader.itemSpan(item.name);
+        dust3d::Snapshot snapshot;
+        if (!loadSnapshotFromBinary(&snapshot, span.data, span.size)) {
+            qWarning() << "Falling back to model XML, unable to load binary snapshot:" << item.name;
+            continue;
+        }
+        unifySnapshotEdgeLinkDirection(snapshot);
+        m_document->fromSnapshot(snapshot);
+        m_document->saveSnapshot();
+        snapshotLoaded = true;
+        break;
+    }
+
     for (int i = 0; i < (int)ds3Reader.items().size(); ++i) {
         const dust3d::Ds3ReaderItem& item = ds3Reader.items()[i];
         if (item.type == "model") {
+            if (snapshotLoaded)
+                continue;
             static constexpr size_t maxXmlSize = 256 * 1024 * 1024; // 256 MB
-            std::vector<std::uint8_t> data;
-            ds3Reader.loadItem(item.name, &data);
-            if (data.size() > maxXmlSize) {
-                qWarning() << "Skipping oversized model XML chunk:" << data.size() << "bytes (limit" << maxXmlSize << ")";
+            dust3d::Ds3ReaderSpan span = ds3Reader.itemSpan(item.name);
+            if (span.size > maxXmlSize) {
+                qWarning() << "Skipping oversized model XML chunk:" << span.size << "bytes (limit" << maxXmlSize << ")";
                 continue;
             }
+            // The xml parser works in place, so it needs a writable, null terminated copy
+            std::vector<std::uint8_t> data;
+            data.reserve(span.size + 1);
+            data.assign(span.data, span.data + span.size);
             data.push_back('\0');
             dust3d::Snapshot snapshot;
             loadSnapshotFromXmlString(&snapshot, reinterpret_cast<char*>(data.data()));
@@ -1400,9 +1466,8 @@ void DocumentWindow::openPathDataAs(const QString& path, const QByteArray& fileD
             m_document->saveSnapshot();
         } else if (item.type == "asset") {
             if (item.name == "canvas.png") {
-                std::vector<std::uint8_t> data;
-                ds3Reader.loadItem(item.name, &data);
-                QImage canvasImage = QImage::fromData(data.data(), (int)data.size(), "PNG");
+                dust3d::Ds3ReaderSpan span = ds3Reader.itemSpan(item.name);
+                QImage canvasImage = QImage::fromData(span.data, (int)span.size, "PNG");
                 if (!canvasImage.isNull())
                     m_document->updateTurnaround(canvasImage);
             }
@@ -1423,10 +1488,21 @@ void DocumentWindow::openPathDataAs(const QString& path, const QByteArray& fileD
 void DocumentWindow::openPathAs(const QString& path, const QString& asName)
 {
     QFile file(path);
-    file.open(QFile::ReadOnly);
-    QByteArray fileData = file.readAll();
+    if (!file.open(QFile::ReadOnly))
+        return;
 
+    // Map the file instead of reading it, the reader only borrows the bytes and
+    // every item is decoded straight from the mapping
+    qint64 fileSize = file.size();
+    uchar* mappedData = fileSize > 0 && fileSize <= std::numeric_limits<int>::max() ? file.map(0, fileSize) : nullptr;
+    if (nullptr == mappedData) {
+        QByteArray fileData = file.readAll();
+        openPathDataAs(path, fileData, asName);
+        return;
+    }
+    QByteArray fileData = QByteArray::fromRawData((const char*)mappedData, (int)fileSize);
     openPathDataAs(path, fileData, asName);
+    file.unmap(mappedData);
 }
 
 bool DocumentWindow::openDroppedDs3File(const QString& filename)
@@ -1630,13 +1706,13 @@ void DocumentWindow::exportObjResult()
 {
 #if defined(Q_OS_WASM)
     QByteArray fileData;
-    QTextStream stream(&fileData);
-    ModelMesh* resultMesh = m_document->takeResultMesh();
-    if (nullptr != resultMesh) {
-        resultMesh->exportAsObj(&stream);
-        delete resultMesh;
+    const dust3d::Object* object = m_document->isExportReady() ? &m_document->currentUvMappedObject() : m_document->currentObject();
+    if (nullptr != object) {
+        ExportPlanner::writeObj(*object, [&](const char* data, size_t size) {
+            fileData.append(data, (qsizetype)size);
+            return true;
+        });
     }
-    stream.flush();
     QFileDialog::saveFileContent(fileData, exportedFilename(m_currentFilename, ".obj"));
 #else
     QString filename = QFileDialog::getSaveFileName(this, QString(), QString(),
@@ -1651,13 +1727,7 @@ void DocumentWindow::exportObjResult()
 
 void DocumentWindow::exportObjToFilename(const QString& filename)
 {
-    QApplication::setOverrideCursor(Qt::WaitCursor);
-    ModelMesh* resultMesh = m_document->takeResultMesh();
-    if (nullptr != resultMesh) {
-        resultMesh->exportAsObj(filename);
-        delete resultMesh;
-    }
-    QApplication::restoreOverrideCursor();
+    exportToFilenames(QStringList() << filename);
 }
 
 void DocumentWindow::exportFbxResult()
@@ -1677,110 +1747,62 @@ void DocumentWindow::exportFbxToFilename(const QString& filename)
         qDebug() << "Export but document is not export ready";
         return;
     }
+    exportToFilenames(QStringList() << filename);
+}
 
-    if (!m_document->hasRigWithBindings()) {
-        // No rig: export mesh + UV + textures only
-        QApplication::setOverrideCursor(Qt::WaitCursor);
-        dust3d::Object uvObject = m_document->currentUvMappedObject();
-        FbxFileWriter fbxFileWriter(uvObject, filename,
-            m_document->textureImage.get(),
-            m_document->textureNormalImage.get(),
-            m_document->textureMetalnessImage.get(),
-            m_document->textureRoughnessImage.get(),
-            m_document->textureAmbientOcclusionImage.get());
-        fbxFileWriter.save();
-        QApplication::restoreOverrideCursor();
+void DocumentWindow::exportAllFormatsResult()
+{
+    QString filename = QFileDialog::getSaveFileName(this, QString(), QString(),
+        tr("glTF Binary Format, Autodesk FBX and Wavefront (*.glb *.fbx *.obj)"));
+    if (filename.isEmpty()) {
         return;
     }
+    QFileInfo fileInfo(filename);
+    if (fileInfo.suffix() == "glb" || fileInfo.suffix() == "fbx" || fileInfo.suffix() == "obj")
+        filename = fileInfo.dir().filePath(fileInfo.completeBaseName());
+    exportToFilenames(QStringList() << filename + ".glb" << filename + ".fbx" << filename + ".obj");
+}
 
-    // Verify meshIds match
-    const dust3d::Object* rigObject = m_document->currentRigObject();
-    const dust3d::Object& uvObject = m_document->currentUvMappedObject();
-    if (rigObject->meshId != uvObject.meshId) {
+void DocumentWindow::exportToFilenames(const QStringList& filenames, std::function<void(const QString& filename, bool isSuccessful)> onFileFinished, const QString& wavFilenamePrefix)
+{
+    ExportPlanner* planner = new ExportPlanner(m_document, filenames, wavFilenamePrefix);
+    if (planner->isRigPending())
         QMessageBox::warning(this, tr("Export"), tr("Rig generation is still in progress. Please wait and try again."));
-        return;
-    }
-
-    // Collect animations
-    std::vector<Document::Animation> animations;
-    {
-        std::vector<dust3d::Uuid> animationIds;
-        m_document->getAllAnimationIds(animationIds);
-        for (const auto& id : animationIds) {
-            const Document::Animation* anim = m_document->findAnimation(id);
-            if (anim)
-                animations.push_back(*anim);
-        }
-    }
 
-    if (animations.empty()) {
-        // Rig but no animations
+    // Only animations take long enough to show progress for
+    ExportProgressWidget* progressWidget = nullptr;
+    if (planner->hasAnimations()) {
+        progressWidget = new ExportProgressWidget(this);
+        progressWidget->show();
+        progressWidget->setStep(tr("Generating animations..."));
+    } else {
         QApplication::setOverrideCursor(Qt::WaitCursor);
-        ExportAnimationWorker worker;
-        worker.setParameters(m_document->getActualRigStructure(), animations);
-        worker.process();
-        dust3d::Object rigWithUv = *rigObject;
-        rigWithUv.copyUvFrom(uvObject);
-        FbxFileWriter fbxFileWriter(rigWithUv, filename,
-            m_document->textureImage.get(),
-            m_document->textureNormalImage.get(),
-            m_document->textureMetalnessImage.get(),
-            m_document->textureRoughnessImage.get(),
-            m_document->textureAmbientOcclusionImage.get(),
-            &m_document->getActualRigStructure(),
-            &worker.inverseBindMatrices(),
-            nullptr);
-        fbxFileWriter.save();
-        QApplication::restoreOverrideCursor();
-        return;
     }
 
-    // Rig + animations: background thread with progress dialog
-    ExportProgressWidget* progressWidget = new ExportProgressWidget(this);
-    progressWidget->show();
-    progressWidget->setStep(tr("Generating animations..."));
-
-    ExportAnimationWorker* worker = new ExportAnimationWorker;
-    worker->setParameters(m_document->getActualRigStructure(), animations);
-
     QThread* thread = new QThread;
-    worker->moveToThread(thread);
-
-    RigStructure rigStructure = m_document->getActualRigStructure();
-    dust3d::Object rigObjectCopy = *rigObject;
-    rigObjectCopy.copyUvFrom(uvObject);
-    QImage* textureImage = m_document->textureImage.get() ? new QImage(*m_document->textureImage.get()) : nullptr;
-    QImage* normalImage = m_document->textureNormalImage.get() ? new QImage(*m_document->textureNormalImage.get()) : nullptr;
-    QImage* metalnessImage = m_document->textureMetalnessImage.get() ? new QImage(*m_document->textureMetalnessImage.get()) : nullptr;
-    QImage* roughnessImage = m_document->textureRoughnessImage.get() ? new QImage(*m_document->textureRoughnessImage.get()) : nullptr;
-    QImage* aoImage = m_document->textureAmbientOcclusionImage.get() ? new QImage(*m_document->textureAmbientOcclusionImage.get()) : nullptr;
-
-    connect(thread, &QThread::started, worker, &ExportAnimationWorker::process);
-    connect(worker, &ExportAnimationWorker::progress, this, [progressWidget](int current, int total) {
-        progressWidget->updateProgress(tr("Generating animations..."), current, total);
-    });
-    connect(worker, &ExportAnimationWorker::finished, this, [=]() mutable {
-        progressWidget->setStep(tr("Writing file..."));
-        QApplication::processEvents();
-
-        auto clips = worker->takeAnimationClips();
-        const auto& ibm = worker->inverseBindMatrices();
-
-        FbxFileWriter fbxFileWriter(rigObjectCopy, filename,
-            textureImage, normalImage, metalnessImage, roughnessImage, aoImage,
-            &rigStructure,
-            &ibm,
-            &clips);
-        fbxFileWriter.save();
-
-        delete textureImage;
-        delete normalImage;
-        delete metalnessImage;
-        delete roughnessImage;
-        delete aoImage;
-        progressWidget->close();
-        progressWidget->deleteLater();
-        worker->deleteLater();
+    planner->moveToThread(thread);
+
+    connect(thread, &QThread::started, planner, &ExportPlanner::process);
+    if (nullptr != progressWidget) {
+        connect(planner, &ExportPlanner::progress, this, [progressWidget](int current, int total) {
+            if (current < total)
+                progressWidget->updateProgress(tr("Generating animations..."), current, total);
+            else
+                progressWidget->setStep(tr("Writing files..."));
+        });
+    }
+    connect(planner, &ExportPlanner::finished, this, [=]() {
+        if (nullptr != progressWidget) {
+            progressWidget->close();
+            progressWidget->deleteLater();
+        } else {
+            QApplication::restoreOverrideCursor();
+        }
+        if (onFileFinished) {
+            for (const auto& filename : planner->filenames())
+                onFileFinished(filename, planner->isSuccessful(filename));
+        }
+        planner->deleteLater();
         thread->quit();
     });
     connect(thread, &QThread::finished, thread, &QThread::deleteLater);
@@ -1799,7 +1821,11 @@ void DocumentWindow::exportGlbResult()
         m_document->textureRoughnessImage.get(),
         m_document->textureAmbientOcclusionImage.get());
     GlbFileWriter glbFileWriter(skeletonResult, m_currentFilename + ".glb",
-        m_document->textureImage.get(), m_document->textureNormalImage.get(), textureMetalnessRoughnessAmbientOcclusionImage);
+        m_document->textureImage.get(), m_document->textureNormalImage.get(), textureMetalnessRoughnessAmbientOcclusionImage,
+        nullptr, nullptr, nullptr,
+        Preferences::instance().exportLodRatios(),
+        Preferences::instance().exportQuantizedGlb(),
+        Preferences::instance().exportMeshoptGlb());
     {
         QDataStream stream(&fileData, QIODeviceBase::Append);
         glbFileWriter.save(stream);
@@ -1817,127 +1843,13 @@ void DocumentWindow::exportGlbResult()
 #endif
 }
 
-void DocumentWindow::exportGlbToFilename(const QString& filename, std::function<void()> onFinished)
+void DocumentWindow::exportGlbToFilename(const QString& filename)
 {
     if (!m_document->isExportReady()) {
         qDebug() << "Export but document is not export ready";
-        if (onFinished)
-            onFinished();
-        return;
-    }
-
-    QImage* ormImage = UvMapGenerator::combineMetalnessRoughnessAmbientOcclusionImages(
-        m_document->textureMetalnessImage.get(),
-        m_document->textureRoughnessImage.get(),
-        m_document->textureAmbientOcclusionImage.get());
-
-    if (!m_document->hasRigWithBindings()) {
-        // No rig case: export mesh + UV + textures only
-        QApplication::setOverrideCursor(Qt::WaitCursor);
-        dust3d::Object uvObject = m_document->currentUvMappedObject();
-        GlbFileWriter glbFileWriter(uvObject, filename,
-            m_document->textureImage.get(), m_document->textureNormalImage.get(), ormImage);
-        glbFileWriter.save();
-        delete ormImage;
-        QApplication::restoreOverrideCursor();
-        if (onFinished)
-            onFinished();
-        return;
-    }
-
-    // Verify meshIds match between rig and UV objects
-    const dust3d::Object* rigObject = m_document->currentRigObject();
-    const dust3d::Object& uvObject = m_document->currentUvMappedObject();
-    if (rigObject->meshId != uvObject.meshId) {
-        QMessageBox::warning(this, tr("Export"), tr("Rig generation is still in progress. Please wait and try again."));
-        delete ormImage;
-        if (onFinished)
-            onFinished();
         return;
     }
-
-    // Collect animations
-    std::vector<Document::Animation> animations;
-    {
-        std::vector<dust3d::Uuid> animationIds;
-        m_document->getAllAnimationIds(animationIds);
-        for (const auto& id : animationIds) {
-            const Document::Animation* anim = m_document->findAnimation(id);
-            if (anim)
-                animations.push_back(*anim);
-        }
-    }
-
-    if (animations.empty()) {
-        // Rig but no animations
-        QApplication::setOverrideCursor(Qt::WaitCursor);
-        ExportAnimationWorker worker;
-        worker.setParameters(m_document->getActualRigStructure(), animations);
-        worker.process();
-        dust3d::Object rigWithUv = *rigObject;
-        rigWithUv.copyUvFrom(uvObject);
-        GlbFileWriter glbFileWriter(rigWithUv, filename,
-            m_document->textureImage.get(), m_document->textureNormalImage.get(), ormImage,
-            &m_document->getActualRigStructure(),
-            &worker.inverseBindMatrices(),
-            nullptr);
-        glbFileWriter.save();
-        delete ormImage;
-        QApplication::restoreOverrideCursor();
-        if (onFinished)
-            onFinished();
-        return;
-    }
-
-    // Rig + animations: run worker in background thread with progress dialog
-    ExportProgressWidget* progressWidget = new ExportProgressWidget(this);
-    progressWidget->show();
-    progressWidget->setStep(tr("Generating animations..."));
-
-    ExportAnimationWorker* worker = new ExportAnimationWorker;
-    worker->setParameters(m_document->getActualRigStructure(), animations);
-
-    QThread* thread = new QThread;
-    worker->moveToThread(thread);
-
-    // Capture data needed after thread finishes
-    RigStructure rigStructure = m_document->getActualRigStructure();
-    dust3d::Object rigObjectCopy = *rigObject;
-    rigObjectCopy.copyUvFrom(uvObject);
-    QImage* textureImage = m_document->textureImage.get() ? new QImage(*m_document->textureImage.get()) : nullptr;
-    QImage* normalImage = m_document->textureNormalImage.get() ? new QImage(*m_document->textureNormalImage.get()) : nullptr;
-
-    connect(thread, &QThread::started, worker, &ExportAnimationWorker::process);
-    connect(worker, &ExportAnimationWorker::progress, this, [progressWidget](int current, int total) {
-        progressWidget->updateProgress(tr("Generating animations..."), current, total);
-    });
-    connect(worker, &ExportAnimationWorker::finished, this, [=]() mutable {
-        progressWidget->setStep(tr("Writing file..."));
-        QApplication::processEvents();
-
-        auto clips = worker->takeAnimationClips();
-        const auto& ibm = worker->inverseBindMatrices();
-
-        GlbFileWriter glbFileWriter(rigObjectCopy, filename,
-            textureImage, normalImage, ormImage,
-            &rigStructure,
-            &ibm,
-            &clips);
-        glbFileWriter.save();
-
-        delete textureImage;
-        delete normalImage;
-        delete ormImage;
-        progressWidget->close();
-        progressWidget->deleteLater();
-        worker->deleteLater();
-        thread->quit();
-        if (onFinished)
-            onFinished();
-    });
-    connect(thread, &QThread::finished, thread, &QThread::deleteLater);
-
-    thread->start();
+    exportToFilenames(QStringList() << filename);
 }
 
 void DocumentWindow::exportGlbAndWavsResult()
@@ -1977,186 +1889,9 @@ void DocumentWindow::exportModelAndWavs(const QString& directory, const QString&
             modelName = "model";
     }
 
-    // Collect animations from the document
-    std::vector<Document::Animation> animations;
-    {
-        std::vector<dust3d::Uuid> animationIds;
-        m_document->getAllAnimationIds(animationIds);
-        for (const auto& id : animationIds) {
-            const Document::Animation* anim = m_document->findAnimation(id);
-            if (anim)
-                animations.push_back(*anim);
-        }
-    }
-
-    // Capture document data needed for model export on background thread
-    bool hasRig = m_document->hasRigWithBindings();
-    RigStructure rigStructure = m_document->getActualRigStructure();
-    dust3d::Object uvObject = m_document->currentUvMappedObject();
-
-    dust3d::Object rigObjectCopy;
-    if (hasRig) {
-        const dust3d::Object* rigObject = m_document->currentRigObject();
-        if (rigObject->meshId != uvObject.meshId) {
-            QMessageBox::warning(this, tr("Export"), tr("Rig generation is still in progress. Please wait and try again."));
-            return;
-        }
-        rigObjectCopy = *rigObject;
-        rigObjectCopy.copyUvFrom(uvObject);
-    }
-
-    // Copy texture images
-    QImage* textureImage = m_document->textureImage.get() ? new QImage(*m_document->textureImage.get()) : nullptr;
-    QImage* normalImage = m_document->textureNormalImage.get() ? new QImage(*m_document->textureNormalImage.get()) : nullptr;
-    QImage* metalnessImage = m_document->textureMetalnessImage.get() ? new QImage(*m_document->textureMetalnessImage.get()) : nullptr;
-    QImage* roughnessImage = m_document->textureRoughnessImage.get() ? new QImage(*m_document->textureRoughnessImage.get()) : nullptr;
-    QImage* aoImage = m_document->textureAmbientOcclusionImage.get() ? new QImage(*m_document->textureAmbientOcclusionImage.get()) : nullptr;
-    QImage* ormImage = UvMapGenerator::combineMetalnessRoughnessAmbientOcclusionImages(
-        m_document->textureMetalnessImage.get(),
-        m_document->textureRoughnessImage.get(),
-        m_document->textureAmbientOcclusionImage.get());
-
-    // Show progress dialog
-    ExportProgressWidget* progressWidget = new ExportProgressWidget(this);
-    progressWidget->show();
-    progressWidget->setStep(tr("Generating animations..."));
-
-    // Set up worker to generate animation clips in background thread
-    ExportAnimationWorker* worker = new ExportAnimationWorker;
-    worker->setParameters(rigStructure, animations);
-
-    QThread* thread = new QThread;
-    worker->moveToThread(thread);
-
-    // Capture animation type/name info for WAV generation
-    std::vector<std::string> animTypes;
-    std::vector<std::string> animNames;
-    for (const auto& anim : animations) {
-        animTypes.push_back(anim.type.toStdString());
-        animNames.push_back(anim.name.toStdString());
-    }
-
-    QString modelPath = directory + "/" + modelName + "." + format;
-
-    connect(thread, &QThread::started, worker, &ExportAnimationWorker::process);
-    connect(worker, &ExportAnimationWorker::progress, this, [progressWidget](int current, int total) {
-        progressWidget->updateProgress(tr("Generating animations..."), current, total);
-    });
-    connect(worker, &ExportAnimationWorker::finished, this, [=]() mutable {
-        progressWidget->setStep(tr("Writing model and WAV files..."));
-        QApplication::processEvents();
-
-        auto clips = worker->takeAnimationClips();
-        const auto& ibm = worker->inverseBindMatrices();
-
-        // Write model file
-        if (format == "glb") {
-            if (hasRig && !clips.empty()) {
-                GlbFileWriter glbFileWriter(rigObjectCopy, modelPath,
-                    textureImage, normalImage, ormImage,
-                    &rigStructure, &ibm, &clips);
-                glbFileWriter.save();
-            } else if (hasRig) {
-                GlbFileWriter glbFileWriter(rigObjectCopy, modelPath,
-                    textureImage, normalImage, ormImage,
-                    &rigStructure, &ibm, nullptr);
-                glbFileWriter.save();
-            } else {
-                GlbFileWriter glbFileWriter(uvObject, modelPath,
-                    textureImage, normalImage, ormImage);
-                glbFileWriter.save();
-            }
-        } else {
-            if (hasRig && !clips.empty()) {
-                FbxFileWriter fbxFileWriter(rigObjectCopy, modelPath,
-                    textureImage, normalImage, metalnessImage, roughnessImage, aoImage,
-                    &rigStructure, &ibm, &clips);
-                fbxFileWriter.save();
-            } else if (hasRig) {
-                FbxFileWriter fbxFileWriter(rigObjectCopy, modelPath,
-                    textureImage, normalImage, metalnessImage, roughnessImage, aoImage,
-                    &rigStructure, &ibm, nullptr);
-                fbxFileWriter.save();
-            } else {
-                FbxFileWriter fbxFileWriter(uvObject, modelPath,
-                    textureImage, normalImage, metalnessImage, roughnessImage, aoImage);
-                fbxFileWriter.save();
-            }
-        }
-
-        // All surface materials
-        std::vector<dust3d::SurfaceMaterial> materials = {
-            dust3d::SurfaceMaterial::Stone,
-            dust3d::SurfaceMaterial::Wood,
-            dust3d::SurfaceMaterial::Sand,
-            dust3d::SurfaceMaterial::Metal,
-            dust3d::SurfaceMaterial::Grass,
-            dust3d::SurfaceMaterial::Water,
-            dust3d::SurfaceMaterial::Dirt,
-            dust3d::SurfaceMaterial::Snow
-        };
-
-        // Run WAV generation in another thread
-        QThread* wavThread = new QThread;
-        auto wavWorker = new QObject;
-        wavWorker->moveToThread(wavThread);
-
-        connect(wavThread, &QThread::started, wavWorker, [=]() {
-            for (size_t i = 0; i < clips.size(); ++i) {
-                const auto& clip = clips[i];
-                if (clip.frames.empty())
-                    continue;
-
-                auto soundEvents = dust3d::SoundEventDetector::detect(clip, animTypes[i]);
-                if (soundEvents.empty())
-                    continue;
-
-                for (auto material : materials) {
-                    auto soundData = dust3d::SoundGenerator::generate(
-                        soundEvents, clip.durationSeconds, material);
-                    if (soundData.pcmSamples.empty())
-                        continue;
-
-                    auto wavData = dust3d::SoundGenerator::encodeWav(soundData);
-
-                    std::string materialName = dust3d::surfaceMaterialName(material);
-                    QString wavFilename = QString("%1/%2_%3_%4.wav")
-                                              .arg(directory)
-                                              .arg(modelName)
-                                              .arg(QString::fromStdString(animNames[i]))
-                                              .arg(QString::fromStdString(materialName));
-
-                    QFile file(wavFilename);
-                    if (file.open(QIODevice::WriteOnly)) {
-                        file.write(reinterpret_cast<const char*>(wavData.data()), static_cast<qint64>(wavData.size()));
-                        file.close();
-                    }
-                }
-            }
-
-            QMetaObject::invokeMethod(wavWorker, "deleteLater");
-        });
-        connect(wavWorker, &QObject::destroyed, this, [=]() {
-            delete textureImage;
-            delete normalImage;
-            delete metalnessImage;
-            delete roughnessImage;
-            delete aoImage;
-            delete ormImage;
-            progressWidget->close();
-            progressWidget->deleteLater();
-            wavThread->quit();
-        });
-        connect(wavThread, &QThread::finished, wavThread, &QThread::deleteLater);
-
-        wavThread->start();
-
-        worker->deleteLater();
-        thread->quit();
-    });
-    connect(thread, &QThread::finished, thread, &QThread::deleteLater);
-
-    thread->start();
+    // The WAV files share the animation clips generated for the model file
+    QString filenamePrefix = directory + "/" + modelName;
+    exportToFilenames(QStringList() << filenamePrefix + "." + format, nullptr, filenamePrefix);
 }
 
 void DocumentWindow::updateXlockButtonState()
@@ -2204,6 +1939,9 @@ void DocumentWindow::unregisterDialog(QWidget* widget)
 void DocumentWindow::setExportWaitingList(const QStringList& filenames)
 {
     m_waitingForExportToFilenames = filenames;
+    // Files exported from the command line are final results
+    if (!m_waitingForExportToFilenames.empty())
+        m_document->setAmbientOcclusionBaked(true);
 }
 
 void DocumentWindow::checkExportWaitingList()
@@ -2214,18 +1952,12 @@ void DocumentWindow::checkExportWaitingList()
     auto list = m_waitingForExportToFilenames;
     m_waitingForExportToFilenames.clear();
 
+    // Model files are exported together, sharing the stages their formats have in common
     bool isSuccessful = m_document->isMeshGenerationSucceed();
+    QStringList modelFilenames;
     for (const auto& filename : list) {
-        if (filename.endsWith(".obj")) {
-            exportObjToFilename(filename);
-            emit waitingExportFinished(filename, isSuccessful);
-        } else if (filename.endsWith(".fbx")) {
-            exportFbxToFilename(filename);
-            emit waitingExportFinished(filename, isSuccessful);
-        } else if (filename.endsWith(".glb")) {
-            exportGlbToFilename(filename, [this, filename, isSuccessful]() {
-                emit waitingExportFinished(filename, isSuccessful);
-            });
+        if (filename.endsWith(".obj") || filename.endsWith(".fbx") || filename.endsWith(".glb")) {
+            modelFilenames.append(filename);
         } else if (filename.endsWith(".ds3")) {
             saveTo(filename);
             emit waitingExportFinished(filename, true);
@@ -2233,6 +1965,11 @@ void DocumentWindow::checkExportWaitingList()
             emit waitingExportFinished(filename, false);
         }
     }
+    if (!modelFilenames.isEmpty()) {
+        exportToFilenames(modelFilenames, [this, isSuccessful](const QString& filename, bool isWritten) {
+            emit waitingExportFinished(filename, isSuccessful && isWritten);
+        });
+    }
 }
 
 void DocumentWindow::generateComponentPreviewImages()
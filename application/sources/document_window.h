@@ -57,6 +57,7 @@ public:
     static void showSupporters();
     static void showAbout();
     static size_t total();
+    static void unifySnapshotEdgeLinkDirection(dust3d::Snapshot& snapshot);
 
 protected:
     void showEvent(QShowEvent* event);
@@ -80,6 +81,7 @@ public slots:
     void exportObjResult();
     void exportGlbResult();
     void exportFbxResult();
+    void exportAllFormatsResult();
     void exportGlbAndWavsResult();
     void exportFbxAndWavsResult();
     void newWindow();
@@ -103,7 +105,8 @@ public slots:
     void checkExportWaitingList();
     void exportObjToFilename(const QString& filename);
     void exportFbxToFilename(const QString& filename);
-    void exportGlbToFilename(const QString& filename, std::function<void()> onFinished = nullptr);
+    void exportGlbToFilename(const QString& filename);
+    void exportToFilenames(const QStringList& filenames, std::function<void(const QString& filename, bool isSuccessful)> onFileFinished = nullptr, const QString& wavFilenamePrefix = QString());
     void exportModelAndWavs(const QString& directory, const QString& format);
     void toggleRotation();
     void generateComponentPreviewImages();
@@ -134,7 +137,6 @@ private:
     QString strippedName(const QString& fullFileName);
     bool openFiles(const QStringList& pathList);
     void reset();
-    void unifySnapshotEdgeLinkDirection(dust3d::Snapshot& snapshot);
 
     Document* m_document = nullptr;
     bool m_firstShow = true;
@@ -180,8 +182,13 @@ private:
     QAction* m_exportAsObjAction = nullptr;
     QAction* m_exportAsGlbAction = nullptr;
     QAction* m_exportAsFbxAction = nullptr;
+    QAction* m_exportAsAllFormatsAction = nullptr;
     QAction* m_exportAsGlbAndWavsAction = nullptr;
     QAction* m_exportAsFbxAndWavsAction = nullptr;
+    QAction* m_exportLodChainAction = nullptr;
+    QAction* m_exportQuantizedGlbAction = nullptr;
+    QAction* m_exportMeshoptGlbAction = nullptr;
+    QAction* m_bakeAmbientOcclusionAction = nullptr;
 
     QMenu* m_viewMenu = nullptr;
     QAction* m_toggleWireframeAction = nullptr;
@@ -0,0 +1,278 @@
+#include "export_planner.h"
+#include "export_animation_worker.h"
+#include "fbx_file.h"
+#include "glb_file.h"
+#include "preferences.h"
+#include "uv_map_generator.h"
+#include "version.h"
+#include <QFile>
+#include <algorithm>
+#include <dust3d/animation/sound_event_detector.h>
+#include <dust3d/animation/sound_generator.h>
+#include <dust3d/base/parallel.h>
+#include <dust3d/mesh/write_obj.h>
+
+static std::unique_ptr<QImage> copyImage(const std::unique_ptr<QImage>& image)
+{
+    if (nullptr == image)
+        return nullptr;
+    return std::make_unique<QImage>(*image);
+}
+
+ExportPlanner::ExportPlanner(const Document* document, const QStringList& filenames, const QString& wavFilenamePrefix)
+    : m_filenames(filenames)
+    , m_wavFilenamePrefix(wavFilenamePrefix)
+    , m_lodRatios(Preferences::instance().exportLodRatios())
+    , m_quantizeGlbAttributes(Preferences::instance().exportQuantizedGlb())
+    , m_meshoptCompressGlb(Preferences::instance().exportMeshoptGlb())
+{
+    m_isExportReady = document->isExportReady();
+    if (m_isExportReady) {
+        m_object = std::make_unique<dust3d::Object>(document->currentUvMappedObject());
+        m_textureImage = copyImage(document->textureImage);
+        m_textureNormalImage = copyImage(document->textureNormalImage);
+        m_textureMetalnessImage = copyImage(document->textureMetalnessImage);
+        m_textureRoughnessImage = copyImage(document->textureRoughnessImage);
+        m_textureAmbientOcclusionImage = copyImage(document->textureAmbientOcclusionImage);
+        if (document->hasRigWithBindings()) {
+            const dust3d::Object* rigObject = document->currentRigObject();
+            if (rigObject->meshId != m_object->meshId) {
+                m_isRigPending = true;
+            } else {
+                m_riggedObject = std::make_unique<dust3d::Object>(*rigObject);
+                m_rigStructure = document->getActualRigStructure();
+                std::vector<dust3d::Uuid> animationIds;
+                document->getAllAnimationIds(animationIds);
+                for (const auto& animationId : animationIds) {
+                    const Document::Animation* animation = document->findAnimation(animationId);
+                    if (nullptr != animation)
+                        m_animations.push_back(*animation);
+                }
+            }
+        }
+    } else if (nullptr != document->currentObject()) {
+        m_object = std::make_unique<dust3d::Object>(*document->currentObject());
+    }
+    plan();
+}
+
+const QStringList& ExportPlanner::filenames() const
+{
+    return m_filenames;
+}
+
+bool ExportPlanner::isSuccessful(const QString& filename) const
+{
+    auto findResult = m_fileResults.find(filename);
+    if (findResult == m_fileResults.end())
+        return false;
+    return findResult->second;
+}
+
+bool ExportPlanner::isRigPending() const
+{
+    return m_isRigPending;
+}
+
+bool ExportPlanner::hasAnimations() const
+{
+    return nullptr != m_riggedObject && !m_animations.empty();
+}
+
+bool ExportPlanner::writeObj(const dust3d::Object& object, const std::function<bool(const char* data, size_t size)>& write)
+{
+    // Without per-corner normals and UVs the faces keep their quads, as the exported OBJ always did
+    return dust3d::writeObj(object, "# " APP_NAME " " APP_HUMAN_VER "\n# " APP_HOMEPAGE_URL "\n", false, false, false, write);
+}
+
+size_t ExportPlanner::addStage(std::function<bool()> run, const std::vector<size_t>& dependencies)
+{
+    Stage stage;
+    stage.run = std::move(run);
+    stage.dependencies = dependencies;
+    m_stages.push_back(std::move(stage));
+    return m_stages.size() - 1;
+}
+
+void ExportPlanner::plan()
+{
+    if (nullptr == m_object)
+        return;
+
+    // Stages shared by the files are added on first use, so each runs at most once
+    std::vector<size_t> rigDependencies;
+    std::vector<size_t> glbDependencies;
+    bool isGlbPlanned = false;
+    for (const auto& filename : m_filenames) {
+        if (filename.endsWith(".obj")) {
+            m_stageFilenames[addStage([this, filename]() { return writeObjFile(filename); })] = filename;
+            continue;
+        }
+        bool isGlb = filename.endsWith(".glb");
+        if (!isGlb && !filename.endsWith(".fbx"))
+            continue;
+        if (!m_isExportReady || m_isRigPending)
+            continue;
+        if (nullptr != m_riggedObject && rigDependencies.empty()) {
+            rigDependencies.push_back(addStage([this]() { return prepareRiggedObject(); }));
+            rigDependencies.push_back(addStage([this]() { return generateAnimations(); }));
+        }
+        if (isGlb) {
+            if (!isGlbPlanned) {
+                glbDependencies = rigDependencies;
+                glbDependencies.push_back(addStage([this]() { return combineOrmImage(); }));
+                isGlbPlanned = true;
+            }
+            m_stageFilenames[addStage([this, filename]() { return writeGlbFile(filename); }, glbDependencies)] = filename;
+        } else {
+            m_stageFilenames[addStage([this, filename]() { return writeFbxFile(filename); }, rigDependencies)] = filename;
+        }
+    }
+
+    if (!m_wavFilenamePrefix.isEmpty() && m_isExportReady && hasAnimations()) {
+        if (rigDependencies.empty()) {
+            rigDependencies.push_back(addStage([this]() { return prepareRiggedObject(); }));
+            rigDependencies.push_back(addStage([this]() { return generateAnimations(); }));
+        }
+        addStage([this]() { return writeWavFiles(); }, rigDependencies);
+    }
+}
+
+void ExportPlanner::runStages()
+{
+    // Stages only depend on stages added before them, so every round runs at least one
+    std::vector<bool> isDone(m_stages.size(), false);
+    size_t doneCount = 0;
+    while (doneCount < m_stages.size()) {
+        std::vector<size_t> readyStages;
+        for (size_t i = 0; i < m_stages.size(); ++i) {
+            if (isDone[i])
+                continue;
+            const auto& dependencies = m_stages[i].dependencies;
+            if (std::all_of(dependencies.begin(), dependencies.end(), [&](size_t dependency) { return isDone[dependency]; }))
+                readyStages.push_back(i);
+        }
+        dust3d::parallelFor(readyStages.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                Stage& stage = m_stages[readyStages[i]];
+                bool isDependenciesSuccessful = std::all_of(stage.dependencies.begin(), stage.dependencies.end(), [&](size_t dependency) {
+                    return m_stages[dependency].isSuccessful;
+                });
+                stage.isSuccessful = isDependenciesSuccessful && stage.run();
+            }
+        });
+        for (const auto& i : readyStages)
+            isDone[i] = true;
+        doneCount += readyStages.size();
+    }
+}
+
+void ExportPlanner::process()
+{
+    runStages();
+    for (const auto& it : m_stageFilenames)
+        m_fileResults[it.second] = m_stages[it.first].isSuccessful;
+    emit finished();
+}
+
+bool ExportPlanner::prepareRiggedObject()
+{
+    m_riggedObject->copyUvFrom(*m_object);
+    return true;
+}
+
+bool ExportPlanner::combineOrmImage()
+{
+    m_ormImage.reset(UvMapGenerator::combineMetalnessRoughnessAmbientOcclusionImages(m_textureMetalnessImage.get(),
+        m_textureRoughnessImage.get(),
+        m_textureAmbientOcclusionImage.get()));
+    return true;
+}
+
+bool ExportPlanner::generateAnimations()
+{
+    ExportAnimationWorker worker;
+    worker.setParameters(m_rigStructure, m_animations);
+    connect(&worker, &ExportAnimationWorker::progress, this, &ExportPlanner::progress, Qt::DirectConnection);
+    worker.process();
+    m_inverseBindMatrices = worker.inverseBindMatrices();
+    m_animationClips = worker.takeAnimationClips();
+    return worker.isSuccessful();
+}
+
+bool ExportPlanner::writeObjFile(const QString& filename)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    return writeObj(*m_object, [&](const char* data, size_t size) {
+        return file.write(data, (qint64)size) == (qint64)size;
+    });
+}
+
+bool ExportPlanner::writeGlbFile(const QString& filename)
+{
+    bool hasRig = nullptr != m_riggedObject;
+    GlbFileWriter glbFileWriter(hasRig ? *m_riggedObject : *m_object, filename,
+        m_textureImage.get(), m_textureNormalImage.get(), m_ormImage.get(),
+        hasRig ? &m_rigStructure : nullptr,
+        hasRig ? &m_inverseBindMatrices : nullptr,
+        m_animationClips.empty() ? nullptr : &m_animationClips,
+        m_lodRatios,
+        m_quantizeGlbAttributes,
+        m_meshoptCompressGlb);
+    return glbFileWriter.save();
+}
+
+bool ExportPlanner::writeFbxFile(const QString& filename)
+{
+    bool hasRig = nullptr != m_riggedObject;
+    FbxFileWriter fbxFileWriter(hasRig ? *m_riggedObject : *m_object, filename,
+        m_textureImage.get(),
+        m_textureNormalImage.get(),
+        m_textureMetalnessImage.get(),
+        m_textureRoughnessImage.get(),
+        m_textureAmbientOcclusionImage.get(),
+        hasRig ? &m_rigStructure : nullptr,
+        hasRig ? &m_inverseBindMatrices : nullptr,
+        m_animationClips.empty() ? nullptr : &m_animationClips,
+        m_lodRatios);
+    return fbxFileWriter.save();
+}
+
+bool ExportPlanner::writeWavFiles()
+{
+    const dust3d::SurfaceMaterial materials[] = {
+        dust3d::SurfaceMaterial::Stone,
+        dust3d::SurfaceMaterial::Wood,
+        dust3d::SurfaceMaterial::Sand,
+        dust3d::SurfaceMaterial::Metal,
+        dust3d::SurfaceMaterial::Grass,
+        dust3d::SurfaceMaterial::Water,
+        dust3d::SurfaceMaterial::Dirt,
+        dust3d::SurfaceMaterial::Snow
+    };
+    // The clips are generated one per animation, in the same order
+    bool isSuccessful = true;
+    for (size_t i = 0; i < m_animationClips.size() && i < m_animations.size(); ++i) {
+        const auto& clip = m_animationClips[i];
+        if (clip.frames.empty())
+            continue;
+        auto soundEvents = dust3d::SoundEventDetector::detect(clip, m_animations[i].type.toStdString());
+        if (soundEvents.empty())
+            continue;
+        for (const auto& material : materials) {
+            auto soundData = dust3d::SoundGenerator::generate(soundEvents, clip.durationSeconds, material);
+            if (soundData.pcmSamples.empty())
+                continue;
+            auto wavData = dust3d::SoundGenerator::encodeWav(soundData);
+            QFile file(QString("%1_%2_%3.wav")
+                           .arg(m_wavFilenamePrefix)
+                           .arg(m_animations[i].name)
+                           .arg(QString::fromStdString(dust3d::surfaceMaterialName(material))));
+            if (!file.open(QIODevice::WriteOnly) || file.write(reinterpret_cast<const char*>(wavData.data()), (qint64)wavData.size()) != (qint64)wavData.size())
+                isSuccessful = false;
+        }
+    }
+    return isSuccessful;
+}
@@ -0,0 +1,85 @@
+#ifndef DUST3D_APPLICATION_EXPORT_PLANNER_H_
+#define DUST3D_APPLICATION_EXPORT_PLANNER_H_
+
+#include "bone_structure.h"
+#include "document.h"
+#include <QImage>
+#include <QObject>
+#include <QStringList>
+#include <dust3d/animation/animation_generator.h>
+#include <dust3d/base/matrix4x4.h>
+#include <dust3d/base/object.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Exports the current result of a document to any number of OBJ, GLB and FBX files at once.
+// The export is planned as a graph of stages: the intermediates shared by the formats, which are
+// the rigged object with UVs, the combined metalness roughness ambient occlusion image, the inverse
+// bind matrices and the animation clips, are each computed once and only if a requested file needs
+// them; the file writers then run in parallel, once the stages they depend on are done.
+// Footstep sounds of the animations can be written next to the files, as WAV files named after the given prefix.
+class ExportPlanner : public QObject {
+    Q_OBJECT
+public:
+    // Copies everything the export reads from the document and the export preferences, so process can run on any thread
+    ExportPlanner(const Document* document, const QStringList& filenames, const QString& wavFilenamePrefix = QString());
+    const QStringList& filenames() const;
+    bool isSuccessful(const QString& filename) const;
+    // The rig is generated from an older mesh than the UV map, so rigged files can't be written yet
+    bool isRigPending() const;
+    bool hasAnimations() const;
+    static bool writeObj(const dust3d::Object& object, const std::function<bool(const char* data, size_t size)>& write);
+
+signals:
+    void progress(int current, int total);
+    void finished();
+
+public slots:
+    void process();
+
+private:
+    struct Stage {
+        std::function<bool()> run;
+        std::vector<size_t> dependencies;
+        bool isSuccessful = false;
+    };
+
+    QStringList m_filenames;
+    QString m_wavFilenamePrefix;
+    std::map<QString, bool> m_fileResults;
+    std::vector<Stage> m_stages;
+    std::map<size_t, QString> m_stageFilenames;
+    bool m_isExportReady = false;
+    bool m_isRigPending = false;
+    RigStructure m_rigStructure;
+    std::vector<Document::Animation> m_animations;
+    std::unique_ptr<dust3d::Object> m_object;
+    std::unique_ptr<dust3d::Object> m_riggedObject;
+    std::unique_ptr<QImage> m_textureImage;
+    std::unique_ptr<QImage> m_textureNormalImage;
+    std::unique_ptr<QImage> m_textureMetalnessImage;
+    std::unique_ptr<QImage> m_textureRoughnessImage;
+    std::unique_ptr<QImage> m_textureAmbientOcclusionImage;
+    std::unique_ptr<QImage> m_ormImage;
+    std::map<std::string, dust3d::Matrix4x4> m_inverseBindMatrices;
+    std::vector<dust3d::RigAnimationClip> m_animationClips;
+    std::vector<float> m_lodRatios;
+    bool m_quantizeGlbAttributes = false;
+    bool m_meshoptCompressGlb = false;
+
+    void plan();
+    size_t addStage(std::function<bool()> run, const std::vector<size_t>& dependencies = {});
+    void runStages();
+    bool prepareRiggedObject();
+    bool combineOrmImage();
+    bool generateAnimations();
+    bool writeObjFile(const QString& filename);
+    bool writeGlbFile(const QString& filename);
+    bool writeFbxFile(const QString& filename);
+    bool writeWavFiles();
+};
+
+#endif
@@ -7,14 +7,19 @@
 #include <QtCore/qbuffer.h>
 #include <QtMath>
 #include <cmath>
+#include <dust3d/base/parallel.h>
+#include <dust3d/mesh/simplify_mesh.h>
 #include <fbxnode.h>
 #include <fbxproperty.h>
+#include <fstream>
+#include <memory>
 #include <set>
 
 static double normalizeFbxEulerAngle(double angle);
 static double shortestFbxEulerAngleDifference(double a, double b);
 static double wrapFbxEulerAngleToPrevious(double value, double previous);
 static std::vector<uint8_t> makeFbxTypedName(const QString& name, const char* typeName);
+static void deflateFbxArrays(fbx::FBXNode* nodes, size_t nodeCount);
 
 using namespace fbx;
 
@@ -41,6 +46,19 @@ static std::vector<uint8_t> makeFbxTypedName(const QString& name, const char* ty
     return typedName;
 }
 
+// Large arrays are zlib encoded as soon as their nodes are complete, in parallel,
+// so the document holds the compressed bytes which are written as they are
+static void deflateFbxArrays(fbx::FBXNode* nodes, size_t nodeCount)
+{
+    std::vector<fbx::FBXProperty*> arrayProperties;
+    for (size_t i = 0; i < nodeCount; ++i)
+        nodes[i].collectArrayProperties(&arrayProperties);
+    dust3d::parallelFor(arrayProperties.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            arrayProperties[i]->deflateArray();
+    });
+}
+
 void FbxFileWriter::createFbxHeader()
 {
     FBXNode headerExtension("FBXHeaderExtension");
@@ -444,7 +462,8 @@ void FbxFileWriter::createDefinitions(size_t deformerCount,
     size_t animationStackCount,
     size_t animationLayerCount,
     size_t animationCurveNodeCount,
-    size_t animationCurveCount)
+    size_t animationCurveCount,
+    size_t lodCount)
 {
     FBXNode definitions("Definitions");
     definitions.addPropertyNode("Version", (int32_t)100);
@@ -461,7 +480,7 @@ void FbxFileWriter::createDefinitions(size_t deformerCount,
         FBXNode objectType("ObjectType");
         objectType.addProperty("Geometry");
         FBXNode count("Count");
-        count.addProperty((int32_t)1);
+        count.addProperty((int32_t)(1 + lodCount));
         objectType.addChild(count);
         FBXNode propertyTemplate("PropertyTemplate");
         propertyTemplate.addProperty("FbxMesh");
@@ -539,7 +558,7 @@ void FbxFileWriter::createDefinitions(size_t deformerCount,
         FBXNode objectType("ObjectType");
         objectType.addProperty("Model");
         FBXNode count("Count");
-        count.addProperty((int32_t)(1 + deformerCount)); // 1 for mesh, deformerCount for limbNodes
+        count.addProperty((int32_t)(1 + lodCount + deformerCount)); // 1 for mesh, lodCount for simplified meshes, deformerCount for limbNodes
         objectType.addChild(count);
         FBXNode propertyTemplate("PropertyTemplate");
         propertyTemplate.addProperty("FbxNode");
@@ -2221,37 +2240,11 @@ void FbxFileWriter::createDefinitions(size_t deformerCount,
     m_fbxDocument.nodes.push_back(definitions);
 }
 
-FbxFileWriter::FbxFileWriter(dust3d::Object& object,
-    const QString& filename,
-    QImage* textureImage,
-    QImage* normalImage,
-    QImage* metalnessImage,
-    QImage* roughnessImage,
-    QImage* ambientOcclusionImage,
-    const RigStructure* rigStructure,
-    const std::map<std::string, dust3d::Matrix4x4>* inverseBindMatrices,
-    const std::vector<dust3d::RigAnimationClip>* animationClips)
-    : m_filename(filename)
-    , m_baseName(QFileInfo(m_filename).baseName())
+FBXNode FbxFileWriter::createGeometry(const dust3d::Object& object, int64_t geometryId, const QString& name)
 {
-    createFbxHeader();
-    createFileId();
-    createCreationTime();
-    createCreator();
-    createGlobalSettings();
-    createDocuments();
-    createReferences();
-
-    FBXNode connections("Connections");
-
-    size_t deformerCount = 0;
-    if (rigStructure && !rigStructure->bones.empty() && inverseBindMatrices && !inverseBindMatrices->empty())
-        deformerCount = 1 + rigStructure->bones.size(); // 1 for the root Skin deformer
-
     FBXNode geometry("Geometry");
-    int64_t geometryId = m_next64Id++;
     geometry.addProperty(geometryId);
-    geometry.addProperty(std::vector<uint8_t>({ 'u', 'n', 'a', 'm', 'e', 'd', 'm', 'e', 's', 'h', 0, 1, 'G', 'e', 'o', 'm', 'e', 't', 'r', 'y' }), 'S');
+    geometry.addProperty(makeFbxTypedName(name, "Geometry"), 'S');
     geometry.addProperty("Mesh");
     std::vector<double> positions;
     for (const auto& vertex : object.vertices) {
@@ -2351,11 +2344,15 @@ FbxFileWriter::FbxFileWriter(dust3d::Object& object,
         geometry.addChild(layerElementUv);
     geometry.addChild(layer);
     geometry.addChild(FBXNode());
+    deflateFbxArrays(&geometry, 1);
+    return geometry;
+}
 
-    int64_t modelId = m_next64Id++;
+FBXNode FbxFileWriter::createModel(int64_t modelId, const QString& name)
+{
     FBXNode model("Model");
     model.addProperty(modelId);
-    model.addProperty(std::vector<uint8_t>({ 'u', 'n', 'a', 'm', 'e', 'd', 0, 1, 'M', 'o', 'd', 'e', 'l' }), 'S');
+    model.addProperty(makeFbxTypedName(name, "Model"), 'S');
     model.addProperty("Mesh");
     model.addPropertyNode("Version", (int32_t)232);
     {
@@ -2417,6 +2414,65 @@ FbxFileWriter::FbxFileWriter(dust3d::Object& object,
     model.addPropertyNode("Shading", (bool)true);
     model.addPropertyNode("Culling", "CullingOff");
     model.addChild(FBXNode());
+    return model;
+}
+
+FbxFileWriter::FbxFileWriter(dust3d::Object& object,
+    const QString& filename,
+    QImage* textureImage,
+    QImage* normalImage,
+    QImage* metalnessImage,
+    QImage* roughnessImage,
+    QImage* ambientOcclusionImage,
+    const RigStructure* rigStructure,
+    const std::map<std::string, dust3d::Matrix4x4>* inverseBindMatrices,
+    const std::vector<dust3d::RigAnimationClip>* animationClips,
+    const std::vector<float>& lodRatios)
+    : m_filename(filename)
+    , m_baseName(QFileInfo(m_filename).baseName())
+    , m_lodRatios(lodRatios)
+{
+    createFbxHeader();
+    createFileId();
+    createCreationTime();
+    createCreator();
+    createGlobalSettings();
+    createDocuments();
+    createReferences();
+
+    FBXNode connections("Connections");
+
+    size_t deformerCount = 0;
+    if (rigStructure && !rigStructure->bones.empty() && inverseBindMatrices && !inverseBindMatrices->empty())
+        deformerCount = 1 + rigStructure->bones.size(); // 1 for the root Skin deformer
+
+    // Simplified levels of detail are written as sibling models following the common _LODn naming,
+    // only for static meshes because every level of a skinned mesh would need its own skin deformer
+    std::vector<std::unique_ptr<dust3d::Object>> lodObjects;
+    if (0 == deformerCount && !object.triangles.empty()) {
+        for (const auto& ratio : m_lodRatios) {
+            auto lodObject = std::make_unique<dust3d::Object>();
+            dust3d::simplifyObject(object, ratio, lodObject.get());
+            lodObjects.push_back(std::move(lodObject));
+        }
+    }
+
+    int64_t geometryId = m_next64Id++;
+    FBXNode geometry = createGeometry(object, geometryId, "unamedmesh");
+
+    int64_t modelId = m_next64Id++;
+    FBXNode model = createModel(modelId, lodObjects.empty() ? "unamed" : "unamed_LOD0");
+
+    std::vector<FBXNode> lodGeometries;
+    std::vector<int64_t> lodGeometryIds;
+    std::vector<FBXNode> lodModels;
+    std::vector<int64_t> lodModelIds;
+    for (size_t i = 0; i < lodObjects.size(); ++i) {
+        lodGeometryIds.push_back(m_next64Id++);
+        lodGeometries.push_back(createGeometry(*lodObjects[i], lodGeometryIds.back(), QString("unamedmesh_LOD%1").arg(i + 1)));
+        lodModelIds.push_back(m_next64Id++);
+        lodModels.push_back(createModel(lodModelIds.back(), QString("unamed_LOD%1").arg(i + 1)));
+    }
 
     FBXNode pose("Pose");
     int64_t poseId = 0;
@@ -2435,29 +2491,30 @@ FbxFileWriter::FbxFileWriter(dust3d::Object& object,
         for (size_t i = 0; i < rigStructure->bones.size(); ++i)
             boneNameToIndex[rigStructure->bones[i].name.toStdString()] = i;
 
+        // Rig bone of each bone the object vertices refer to, -1 for bones missing from the rig
+        std::vector<int> objectBoneToRigBone(object.boneNames.size(), -1);
+        for (size_t i = 0; i < object.boneNames.size(); ++i) {
+            auto it = boneNameToIndex.find(object.boneNames[i]);
+            if (it != boneNameToIndex.end())
+                objectBoneToRigBone[i] = (int)it->second;
+        }
+
         // Build per-bone vertex index/weight arrays from object vertex bindings
         std::vector<std::pair<std::vector<int32_t>, std::vector<double>>> bindPerBone(rigStructure->bones.size());
+        auto addBinding = [&](size_t vIdx, const std::pair<int, float>& b) {
+            if (b.first < 0 || b.first >= (int)objectBoneToRigBone.size())
+                return;
+            int rigBone = objectBoneToRigBone[b.first];
+            if (rigBone < 0)
+                return;
+            bindPerBone[rigBone].first.push_back((int32_t)vIdx);
+            bindPerBone[rigBone].second.push_back((double)b.second);
+        };
         for (size_t vIdx = 0; vIdx < object.vertices.size(); ++vIdx) {
-            if (vIdx < object.vertexBone1.size()) {
-                const auto& b = object.vertexBone1[vIdx];
-                if (!b.first.empty()) {
-                    auto it = boneNameToIndex.find(b.first);
-                    if (it != boneNameToIndex.end()) {
-                        bindPerBone[it->second].first.push_back((int32_t)vIdx);
-                        bindPerBone[it->second].second.push_back((double)b.second);
-                    }
-                }
-            }
-            if (vIdx < object.vertexBone2.size()) {
-                const auto& b = object.vertexBone2[vIdx];
-                if (!b.first.empty()) {
-                    auto it = boneNameToIndex.find(b.first);
-                    if (it != boneNameToIndex.end()) {
-                        bindPerBone[it->second].first.push_back((int32_t)vIdx);
-                        bindPerBone[it->second].second.push_back((double)b.second);
-                    }
-                }
-            }
+            if (vIdx < object.vertexBone1.size())
+                addBinding(vIdx, object.vertexBone1[vIdx]);
+            if (vIdx < object.vertexBone2.size())
+                addBinding(vIdx, object.vertexBone2[vIdx]);
         }
 
         // Skin deformer
@@ -3736,6 +3793,7 @@ FbxFileWriter::FbxFileWriter(dust3d::Object& object,
         for (const auto& clip : *animationClips) {
             if (clip.frames.empty())
                 continue;
+            size_t clipFirstCurve = animationCurves.size();
 
             FBXNode animationStack("AnimationStack");
             int64_t animationStackId = m_next64Id++;
@@ -3965,7 +4023,7 @@ FbxFileWriter::FbxFileWriter(dust3d::Object& object,
                     animationCurve.addPropertyNode("KeyAttrDataFloat", std::vector<float>(4, 0.000000));
                     animationCurve.addPropertyNode("KeyAttrRefCount", std::vector<int32_t>(1, (int32_t)ktimes.size()));
                     animationCurve.addChild(FBXNode());
-                    animationCurves.push_back(animationCurve);
+                    animationCurves.push_back(std::move(animationCurve));
                 }
             }
 
@@ -4096,9 +4154,11 @@ FbxFileWriter::FbxFileWriter(dust3d::Object& object,
                     animationCurve.addPropertyNode("KeyAttrDataFloat", std::vector<float>(4, 0.000000));
                     animationCurve.addPropertyNode("KeyAttrRefCount", std::vector<int32_t>(1, (int32_t)ktimes.size()));
                     animationCurve.addChild(FBXNode());
-                    animationCurves.push_back(animationCurve);
+                    animationCurves.push_back(std::move(animationCurve));
                 }
             }
+
+            deflateFbxArrays(animationCurves.data() + clipFirstCurve, animationCurves.size() - clipFirstCurve);
         }
 
         animationStackCount = animationStacks.size();
@@ -4110,51 +4170,56 @@ FbxFileWriter::FbxFileWriter(dust3d::Object& object,
     createDefinitions(deformerCount,
         textureCount, videoCount,
         hasAnimation,
-        animationStackCount, animationLayerCount, animationCurveNodeCount, animationCurveCount);
+        animationStackCount, animationLayerCount, animationCurveNodeCount, animationCurveCount,
+        lodObjects.size());
 
     FBXNode objects("Objects");
-    objects.addChild(geometry);
-    objects.addChild(model);
-    for (const auto& limbNode : limbNodes) {
-        objects.addChild(limbNode);
+    objects.addChild(std::move(geometry));
+    objects.addChild(std::move(model));
+    for (size_t i = 0; i < lodModels.size(); ++i) {
+        objects.addChild(std::move(lodGeometries[i]));
+        objects.addChild(std::move(lodModels[i]));
+    }
+    for (auto& limbNode : limbNodes) {
+        objects.addChild(std::move(limbNode));
     }
     if (deformerCount > 0)
-        objects.addChild(pose);
-    objects.addChild(material);
-    objects.addChild(implementation);
-    objects.addChild(bindingTable);
+        objects.addChild(std::move(pose));
+    objects.addChild(std::move(material));
+    objects.addChild(std::move(implementation));
+    objects.addChild(std::move(bindingTable));
     if (textureCount > 0) {
-        for (const auto& texture : textures) {
-            objects.addChild(texture);
+        for (auto& texture : textures) {
+            objects.addChild(std::move(texture));
         }
     }
     if (videoCount > 0) {
-        for (const auto& video : videos) {
-            objects.addChild(video);
+        for (auto& video : videos) {
+            objects.addChild(std::move(video));
         }
     }
-    for (const auto& deformer : deformers) {
-        objects.addChild(deformer);
+    for (auto& deformer : deformers) {
+        objects.addChild(std::move(deformer));
     }
-    for (const auto& nodeAttribute : nodeAttributes) {
-        objects.addChild(nodeAttribute);
+    for (auto& nodeAttribute : nodeAttributes) {
+        objects.addChild(std::move(nodeAttribute));
     }
     if (hasAnimation) {
-        for (const auto& animationStack : animationStacks) {
-            objects.addChild(animationStack);
+        for (auto& animationStack : animationStacks) {
+            objects.addChild(std::move(animationStack));
         }
-        for (const auto& animationLayer : animationLayers) {
-            objects.addChild(animationLayer);
+        for (auto& animationLayer : animationLayers) {
+            objects.addChild(std::move(animationLayer));
         }
-        for (const auto& animationCurveNode : animationCurveNodes) {
-            objects.addChild(animationCurveNode);
+        for (auto& animationCurveNode : animationCurveNodes) {
+            objects.addChild(std::move(animationCurveNode));
         }
-        for (const auto& animationCurve : animationCurves) {
-            objects.addChild(animationCurve);
+        for (auto& animationCurve : animationCurves) {
+            objects.addChild(std::move(animationCurve));
         }
     }
     objects.addChild(FBXNode());
-    m_fbxDocument.nodes.push_back(objects);
+    m_fbxDocument.nodes.push_back(std::move(objects));
 
     {
         FBXNode p("C");
@@ -4177,6 +4242,22 @@ FbxFileWriter::FbxFileWriter(dust3d::Object& object,
         p.addProperty(modelId);
         connections.addChild(p);
     }
+    for (size_t i = 0; i < lodModelIds.size(); ++i) {
+        {
+            FBXNode p("C");
+            p.addProperty("OO");
+            p.addProperty(lodModelIds[i]);
+            p.addProperty((int64_t)0);
+            connections.addChild(p);
+        }
+        {
+            FBXNode p("C");
+            p.addProperty("OO");
+            p.addProperty(lodGeometryIds[i]);
+            p.addProperty(lodModelIds[i]);
+            connections.addChild(p);
+        }
+    }
     if (skinId > 0) {
         FBXNode p("C");
         p.addProperty("OO");
@@ -4245,8 +4326,15 @@ FbxFileWriter::FbxFileWriter(dust3d::Object& object,
         p.addProperty(modelId);
         connections.addChild(p);
     }
+    for (const auto& lodModelId : lodModelIds) {
+        FBXNode p("C");
+        p.addProperty("OO");
+        p.addProperty(materialId);
+        p.addProperty(lodModelId);
+        connections.addChild(p);
+    }
     connections.addChild(FBXNode());
-    m_fbxDocument.nodes.push_back(connections);
+    m_fbxDocument.nodes.push_back(std::move(connections));
 
     createTakes();
 }
@@ -4262,8 +4350,26 @@ void FbxFileWriter::createTakes()
 bool FbxFileWriter::save()
 {
     //m_fbxDocument.print();
-    m_fbxDocument.write(m_filename.toStdString());
-    return true;
+    // Arrays not deflated while building, such as the skin weights, are deflated here,
+    // then each top level node is released as soon as it is streamed out
+    deflateFbxArrays(m_fbxDocument.nodes.data(), m_fbxDocument.nodes.size());
+
+    std::ofstream file;
+    constexpr int bufferSize = 1 << 16;
+    std::vector<char> buffer(bufferSize);
+    file.rdbuf()->pubsetbuf(buffer.data(), bufferSize);
+    file.open(m_filename.toStdString(), std::ios::out | std::ios::binary);
+    if (!file.is_open())
+        return false;
+    m_fbxDocument.beginWrite(file);
+    for (auto& node : m_fbxDocument.nodes) {
+        m_fbxDocument.writeNode(file, node);
+        node = FBXNode();
+    }
+    m_fbxDocument.endWrite(file);
+    m_fbxDocument.nodes.clear();
+    file.close();
+    return !file.fail();
 }
 
 std::vector<double> FbxFileWriter::matrixToVector(const QMatrix4x4& matrix)
@@ -26,7 +26,8 @@ public:
         QImage* ambientOcclusionImage = nullptr,
         const RigStructure* rigStructure = nullptr,
         const std::map<std::string, dust3d::Matrix4x4>* inverseBindMatrices = nullptr,
-        const std::vector<dust3d::RigAnimationClip>* animationClips = nullptr);
+        const std::vector<dust3d::RigAnimationClip>* animationClips = nullptr,
+        const std::vector<float>& lodRatios = std::vector<float>());
     bool save();
 
 private:
@@ -44,7 +45,10 @@ private:
         size_t animationStackCount = 0,
         size_t animationLayerCount = 0,
         size_t animationCurveNodeCount = 0,
-        size_t animationCurveCount = 0);
+        size_t animationCurveCount = 0,
+        size_t lodCount = 0);
+    fbx::FBXNode createGeometry(const dust3d::Object& object, int64_t geometryId, const QString& name);
+    fbx::FBXNode createModel(int64_t modelId, const QString& name);
     void createTakes();
     std::vector<double> matrixToVector(const QMatrix4x4& matrix);
     std::vector<double> matrixToVector(const dust3d::Matrix4x4& matrix);
@@ -56,6 +60,8 @@ private:
     QString m_baseName;
     fbx::FBXDocument m_fbxDocument;
     std::map<QString, int64_t> m_uuidTo64Map;
+    // Triangle ratios of the simplified levels of detail written next to a static mesh
+    std::vector<float> m_lodRatios;
     static std::vector<double> m_identityMatrix;
 };
 
@@ -0,0 +1,631 @@
+#include "generation_server.h"
+#include "document.h"
+#include "document_window.h"
+#include "export_animation_worker.h"
+#include "glb_file.h"
+#include "glb_forever.h"
+#include "image_forever.h"
+#include "mesh_generator.h"
+#include "preferences.h"
+#include "rig_generator_worker.h"
+#include "uv_map_generator.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutexLocker>
+#include <QThread>
+#include <QThreadPool>
+#include <dust3d/base/ds3_file.h>
+#include <dust3d/base/snapshot_binary.h>
+#include <cstdio>
+#include <dust3d/base/snapshot_xml.h>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <set>
+#include <string>
+#ifdef Q_OS_WIN
+#include <io.h>
+#define dup _dup
+#define dup2 _dup2
+#define fdopen _fdopen
+#define fileno _fileno
+#else
+#include <unistd.h>
+#endif
+
+GenerationServer::GenerationServer()
+{
+    // Responses keep the original stdout to themselves, anything else printed there from now on,
+    // such as dust3dDebug output of the core library on worker threads, goes to stderr instead
+    std::cout.flush();
+    std::fflush(stdout);
+    int responseDescriptor = dup(fileno(stdout));
+    if (-1 != responseDescriptor) {
+        m_responseStream = fdopen(responseDescriptor, "w");
+        if (nullptr != m_responseStream)
+            dup2(fileno(stderr), fileno(stdout));
+    }
+    if (nullptr == m_responseStream)
+        m_responseStream = stdout;
+
+    Document::loadRigStructures(&m_rigStructures);
+
+    QString diskCacheDirectory = Preferences::instance().generationCacheDirectory();
+    if (!diskCacheDirectory.isEmpty() && QDir().mkpath(diskCacheDirectory))
+        m_diskCache = std::make_shared<dust3d::MeshGeneratorDiskCache>(QDir(diskCacheDirectory).absolutePath().toLocal8Bit().toStdString());
+}
+
+GenerationServer::~GenerationServer()
+{
+    QThreadPool::globalInstance()->waitForDone();
+    if (nullptr != m_inputThread) {
+        m_inputThread->wait();
+        delete m_inputThread;
+    }
+}
+
+void GenerationServer::start()
+{
+    // Reading stdin blocks, so it has a thread of its own, requests are handed to the main thread line by line
+    m_inputThread = QThread::create([this]() {
+        std::string line;
+        while (std::getline(std::cin, line)) {
+            QString text = QString::fromStdString(line);
+            QMetaObject::invokeMethod(
+                this, [this, text]() { handleRequestLine(text); }, Qt::QueuedConnection);
+        }
+        QMetaObject::invokeMethod(
+            this, [this]() {
+                m_inputEnded = true;
+                checkFinished();
+            },
+            Qt::QueuedConnection);
+    });
+    m_inputThread->start();
+}
+
+void GenerationServer::handleRequestLine(const QString& line)
+{
+    if (line.trimmed().isEmpty())
+        return;
+
+    nlohmann::json request = nlohmann::json::parse(line.toStdString(), nullptr, false);
+    if (request.is_discarded() || !request.is_object()) {
+        writeResponse({ { "ok", false }, { "error", "Invalid request" } });
+        return;
+    }
+
+    dispatchRequest(std::move(request));
+}
+
+void GenerationServer::dispatchRequest(nlohmann::json request)
+{
+    nlohmann::json idValue = request.contains("id") ? request["id"] : nlohmann::json();
+    if (!request.contains("document") || !request["document"].is_string()) {
+        writeResponse({ { "id", idValue }, { "ok", false }, { "error", "Missing document name" } });
+        return;
+    }
+
+    std::string command = request.value("command", std::string());
+    QString name = QString::fromStdString(request["document"].get<std::string>());
+    auto findDocument = m_documents.find(name);
+    if (findDocument == m_documents.end()) {
+        if ("open" != command) {
+            writeResponse({ { "id", idValue }, { "ok", false }, { "error", "Document is not open" } });
+            return;
+        }
+        auto document = std::make_unique<ServerDocument>();
+        document->name = name;
+        findDocument = m_documents.insert({ name, std::move(document) }).first;
+    }
+
+    ServerDocument* document = findDocument->second.get();
+    if ("close" == command) {
+        // The name is free from here on, the closing document only drains what was queued before the close
+        m_closingDocuments.insert({ document, std::move(findDocument->second) });
+        m_documents.erase(findDocument);
+    }
+    document->pendingRequests.push_back(std::move(request));
+    if (!document->isBusy)
+        runNextRequest(document);
+}
+
+void GenerationServer::runNextRequest(ServerDocument* document)
+{
+    if (document->pendingRequests.empty()) {
+        if (document->isClosed)
+            m_closingDocuments.erase(document);
+        checkFinished();
+        return;
+    }
+
+    document->isBusy = true;
+    nlohmann::json request = std::move(document->pendingRequests.front());
+    document->pendingRequests.pop_front();
+
+    // One request of a document runs at a time, different documents run side by side
+    QThreadPool::globalInstance()->start([this, document, request]() {
+        writeResponse(processRequest(document, request));
+        QMetaObject::invokeMethod(
+            this, [this, document]() {
+                document->isBusy = false;
+                auto findDocument = m_documents.find(document->name);
+                if (!document->isOpen && findDocument != m_documents.end() && findDocument->second.get() == document) {
+                    // The first open failed, so the document is dropped and what was queued behind it is answered as if it never existed
+                    std::deque<nlohmann::json> pendingRequests = std::move(document->pendingRequests);
+                    m_documents.erase(findDocument);
+                    for (auto& request : pendingRequests)
+                        dispatchRequest(std::move(request));
+                    checkFinished();
+                    return;
+                }
+                runNextRequest(document);
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void GenerationServer::checkFinished()
+{
+    if (!m_inputEnded)
+        return;
+    for (const auto& it : m_documents) {
+        if (it.second->isBusy || !it.second->pendingRequests.empty())
+            return;
+    }
+    if (!m_closingDocuments.empty())
+        return;
+    emit finished();
+}
+
+void GenerationServer::writeResponse(const nlohmann::json& response)
+{
+    std::string line = response.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+    QMutexLocker locker(&m_outputMutex);
+    std::fputs(line.c_str(), m_responseStream);
+    std::fputc('\n', m_responseStream);
+    std::fflush(m_responseStream);
+}
+
+nlohmann::json GenerationServer::processRequest(ServerDocument* document, const nlohmann::json& request)
+{
+    nlohmann::json response;
+    if (request.contains("id"))
+        response["id"] = request["id"];
+
+    QElapsedTimer countTimeConsumed;
+    countTimeConsumed.start();
+
+    try {
+        std::string command = request.value("command", std::string());
+        std::string error;
+        if ("open" == command) {
+            if (!openDocument(document, QString::fromStdString(request.value("path", std::string())), &error)) {
+                response["ok"] = false;
+                response["error"] = error;
+                return response;
+            }
+            response["partCount"] = document->snapshot.parts.size();
+            response["componentCount"] = document->snapshot.components.size();
+        } else if ("patch" == command) {
+            patchDocument(document, request);
+        } else if ("generate" == command) {
+            bool isIncremental = nullptr != document->changeSet;
+            if (!generateMesh(document)) {
+                response["ok"] = false;
+                response["error"] = "Mesh generation failed";
+                return response;
+            }
+            response["incremental"] = isIncremental;
+            response["vertexCount"] = document->object->vertices.size();
+            response["triangleCount"] = document->object->triangles.size();
+        } else if ("exportGlb" == command) {
+            if (!exportGlb(document, QString::fromStdString(request.value("path", std::string())), &error)) {
+                response["ok"] = false;
+                response["error"] = error;
+                return response;
+            }
+        } else if ("close" == command) {
+            releaseAssets(document->imageIds, document->glbIds);
+            document->isClosed = true;
+        } else {
+            response["ok"] = false;
+            response["error"] = "Unknown command: " + command;
+            return response;
+        }
+    } catch (const std::exception& e) {
+        response["ok"] = false;
+        response["error"] = e.what();
+        return response;
+    }
+
+    response["ok"] = true;
+    response["milliseconds"] = countTimeConsumed.elapsed();
+    return response;
+}
+
+bool GenerationServer::openDocument(ServerDocument* document, const QString& path, std::string* error)
+{
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly)) {
+        *error = "Unable to open " + path.toStdString();
+        return false;
+    }
+
+    qint64 fileSize = file.size();
+    uchar* mappedData = fileSize > 0 && fileSize <= std::numeric_limits<int>::max() ? file.map(0, fileSize) : nullptr;
+    QByteArray fileData = nullptr != mappedData ? QByteArray::fromRawData((const char*)mappedData, (int)fileSize) : file.readAll();
+
+    dust3d::Ds3FileReader ds3Reader((const std::uint8_t*)fileData.data(), fileData.size());
+    std::set<dust3d::Uuid> imageIds;
+    std::set<dust3d::Uuid> glbIds;
+    for (const auto& item : ds3Reader.items()) {
+        if (item.type != "asset")
+            continue;
+        if (dust3d::String::startsWith(item.name, "images/")) {
+            std::string filename = dust3d::String::split(item.name, '/')[1];
+            dust3d::Uuid imageId = dust3d::Uuid(dust3d::String::split(filename, '.')[0]);
+            if (imageId.isNull())
+                continue;
+            dust3d::Ds3ReaderSpan span = ds3Reader.itemSpan(item.name);
+            QImage image = QImage::fromData(span.data, (int)span.size, "PNG");
+            QByteArray pngByteArray((const char*)span.data, (int)span.size);
+            if (!ImageForever::add(&image, pngByteArray, imageId).isNull() && imageIds.insert(imageId).second)
+                ImageForever::retain(imageId);
+        } else if (dust3d::String::startsWith(item.name, "models/")) {
+            std::string filename = dust3d::String::split(item.name, '/')[1];
+            dust3d::Uuid glbId = dust3d::Uuid(dust3d::String::split(filename, '.')[0]);
+            if (glbId.isNull())
+                continue;
+            dust3d::Ds3ReaderSpan span = ds3Reader.itemSpan(item.name);
+            QByteArray glbData((const char*)span.data, (int)span.size);
+            if (!GlbForever::add(&glbData, glbId).isNull() && glbIds.insert(glbId).second) {
+                QMutexLocker locker(&m_glbMutex);
+                ++m_glbUseCounts[glbId];
+            }
+        }
+    }
+
+    dust3d::Snapshot snapshot;
+    bool snapshotLoaded = false;
+    for (const auto& item : ds3Reader.items()) {
+        if (item.type != "snapshot")
+            continue;
+        dust3d::Ds3ReaderSpan span = ds3Reader.itemSpan(item.name);
+        if (loadSnapshotFromBinary(&snapshot, span.data, span.size)) {
+            snapshotLoaded = true;
+            break;
+        }
+    }
+    if (!snapshotLoaded) {
+        for (const auto& item : ds3Reader.items()) {
+            if (item.type != "model")
+                continue;
+            dust3d::Ds3ReaderSpan span = ds3Reader.itemSpan(item.name);
+            std::vector<std::uint8_t> data;
+            data.reserve(span.size + 1);
+            data.assign(span.data, span.data + span.size);
+            data.push_back('\0');
+            snapshot = dust3d::Snapshot();
+            loadSnapshotFromXmlString(&snapshot, reinterpret_cast<char*>(data.data()));
+            snapshotLoaded = true;
+            break;
+        }
+    }
+
+    if (nullptr != mappedData)
+        file.unmap(mappedData);
+
+    if (!snapshotLoaded) {
+        releaseAssets(imageIds, glbIds);
+        *error = "No model found in " + path.toStdString();
+        return false;
+    }
+
+    DocumentWindow::unifySnapshotEdgeLinkDirection(snapshot);
+
+    // The request queue belongs to the main thread, so only the generated state is reset here
+    document->snapshot = std::move(snapshot);
+    document->generatedCacheContext.reset();
+    document->changeSet.reset();
+    document->object.reset();
+    document->generatedSnapshot.reset();
+    document->uvMappedObject.reset();
+    document->rigObject.reset();
+    document->isRigReady = false;
+    document->isOpen = true;
+    document->isClosed = false;
+    releaseAssets(document->imageIds, document->glbIds);
+    document->imageIds = std::move(imageIds);
+    document->glbIds = std::move(glbIds);
+    return true;
+}
+
+void GenerationServer::releaseAssets(std::set<dust3d::Uuid>& imageIds, std::set<dust3d::Uuid>& glbIds)
+{
+    for (const auto& imageId : imageIds)
+        ImageForever::release(imageId);
+    imageIds.clear();
+    ImageForever::collect();
+
+    QMutexLocker locker(&m_glbMutex);
+    for (const auto& glbId : glbIds) {
+        auto findCount = m_glbUseCounts.find(glbId);
+        if (findCount == m_glbUseCounts.end() || --findCount->second > 0)
+            continue;
+        m_glbUseCounts.erase(findCount);
+        GlbForever::remove(glbId);
+    }
+    glbIds.clear();
+}
+
+void GenerationServer::patchDocument(ServerDocument* document, const nlohmann::json& request)
+{
+    auto& snapshot = document->snapshot;
+    dust3d::MeshGenerator::ChangeSet* changeSet = document->changeSet.get();
+    bool isMeshObsolete = false;
+    bool isRigObsolete = false;
+
+    auto patchAttributes = [](std::map<std::string, std::string>& record, const nlohmann::json& attributes) {
+        for (const auto& attribute : attributes.items()) {
+            if (attribute.value().is_null())
+                record.erase(attribute.key());
+            else if (attribute.value().is_string())
+                record[attribute.key()] = attribute.value().get<std::string>();
+            else
+                record[attribute.key()] = attribute.value().dump();
+        }
+    };
+
+    // A null record removes the entity, a null attribute removes the attribute
+    auto patchRecords = [&](const char* category,
+                            std::map<std::string, std::map<std::string, std::string>>& records,
+                            const std::function<void(const std::map<std::string, std::string>&)>& touched,
+                            std::set<std::string>* removedIds) {
+        auto findPatch = request.find(category);
+        if (findPatch == request.end() || !findPatch->is_object())
+            return;
+        for (const auto& it : findPatch->items()) {
+            isMeshObsolete = true;
+            auto findRecord = records.find(it.key());
+            if (findRecord != records.end())
+                touched(findRecord->second);
+            if (it.value().is_null()) {
+                if (findRecord != records.end())
+                    records.erase(findRecord);
+                if (nullptr != removedIds)
+                    removedIds->insert(it.key());
+                continue;
+            }
+            if (!it.value().is_object())
+                continue;
+            auto& record = records[it.key()];
+            record["id"] = it.key();
+            patchAttributes(record, it.value());
+            touched(record);
+        }
+    };
+
+    auto touchPart = [&](const std::string& partIdString) {
+        if (nullptr != changeSet && !partIdString.empty())
+            changeSet->changedPartIds.insert(partIdString);
+    };
+    auto touchComponent = [&](const std::string& componentIdString) {
+        if (nullptr != changeSet)
+            changeSet->changedComponentIds.insert(componentIdString);
+    };
+
+    patchRecords(
+        "nodes", snapshot.nodes, [&](const std::map<std::string, std::string>& record) {
+            touchPart(dust3d::String::valueOrEmpty(record, "partId"));
+        },
+        nullptr);
+    patchRecords(
+        "edges", snapshot.edges, [&](const std::map<std::string, std::string>& record) {
+            touchPart(dust3d::String::valueOrEmpty(record, "partId"));
+        },
+        nullptr);
+    patchRecords(
+        "parts", snapshot.parts, [&](const std::map<std::string, std::string>& record) {
+            touchPart(dust3d::String::valueOrEmpty(record, "id"));
+        },
+        nullptr != changeSet ? &changeSet->removedPartIds : nullptr);
+    patchRecords(
+        "components", snapshot.components, [&](const std::map<std::string, std::string>& record) {
+            touchComponent(dust3d::String::valueOrEmpty(record, "id"));
+        },
+        nullptr != changeSet ? &changeSet->removedComponentIds : nullptr);
+
+    auto findRootComponent = request.find("rootComponent");
+    if (findRootComponent != request.end() && findRootComponent->is_object()) {
+        patchAttributes(snapshot.rootComponent, *findRootComponent);
+        touchComponent(to_string(dust3d::Uuid()));
+        isMeshObsolete = true;
+    }
+
+    auto findCanvas = request.find("canvas");
+    if (findCanvas != request.end() && findCanvas->is_object()) {
+        for (const auto& attribute : findCanvas->items()) {
+            // Only the rig depends on these, anything else on the canvas moves every part
+            if ("rigType" == attribute.key() || "headHasEyelids" == attribute.key()) {
+                isRigObsolete = true;
+                continue;
+            }
+            isMeshObsolete = true;
+            document->generatedCacheContext.reset();
+            document->changeSet.reset();
+        }
+        patchAttributes(snapshot.canvas, *findCanvas);
+    }
+
+    auto findAnimations = request.find("animations");
+    if (findAnimations != request.end() && findAnimations->is_object()) {
+        for (const auto& it : findAnimations->items()) {
+            if (it.value().is_null()) {
+                snapshot.animations.erase(it.key());
+                continue;
+            }
+            auto& record = snapshot.animations[it.key()];
+            record["id"] = it.key();
+            patchAttributes(record, it.value());
+        }
+    }
+
+    if (isMeshObsolete) {
+        document->object.reset();
+        document->generatedSnapshot.reset();
+        document->uvMappedObject.reset();
+    }
+    if (isMeshObsolete || isRigObsolete) {
+        // The generated snapshot carries the canvas the rig is read from
+        if (nullptr != document->generatedSnapshot)
+            document->generatedSnapshot->canvas = snapshot.canvas;
+        document->rigObject.reset();
+        document->isRigReady = false;
+    }
+}
+
+bool GenerationServer::generateMesh(ServerDocument* document)
+{
+    if (nullptr != document->object)
+        return true;
+
+    dust3d::Snapshot* snapshot = new dust3d::Snapshot(document->snapshot);
+    MeshGenerator meshGenerator(snapshot);
+    if (nullptr != document->changeSet)
+        meshGenerator.setChangeSet(std::move(document->changeSet));
+    meshGenerator.setId(++document->meshId);
+    meshGenerator.setDefaultPartColor(dust3d::Color::createWhite());
+    if (!document->generatedCacheContext)
+        document->generatedCacheContext = std::make_unique<dust3d::MeshGenerator::GeneratedCacheContext>();
+    meshGenerator.setGeneratedCacheContext(document->generatedCacheContext.get());
+    if (m_diskCache)
+        meshGenerator.setDiskCache(m_diskCache);
+
+    std::set<std::string> processedGlbIds;
+    for (const auto& partIt : document->snapshot.parts) {
+        if (dust3d::PartTarget::ImportedModel != dust3d::PartTargetFromString(dust3d::String::valueOrEmpty(partIt.second, "target").c_str()))
+            continue;
+        dust3d::Uuid importedModelId = dust3d::Uuid(dust3d::String::valueOrEmpty(partIt.second, "importedModelId"));
+        if (importedModelId.isNull())
+            continue;
+        if (!processedGlbIds.insert(importedModelId.toString()).second)
+            continue;
+        const QByteArray* glbData = GlbForever::get(importedModelId);
+        if (nullptr == glbData)
+            continue;
+        std::string componentIdString;
+        for (const auto& componentIt : document->snapshot.components) {
+            if (dust3d::String::valueOrEmpty(componentIt.second, "linkData") == partIt.first) {
+                componentIdString = componentIt.first;
+                break;
+            }
+        }
+        meshGenerator.addPendingGlbData(importedModelId.toString(), *glbData, componentIdString);
+    }
+
+    meshGenerator.process();
+
+    // Everything is cached now, later generations only rebuild what the patches touch
+    document->changeSet = std::make_unique<dust3d::MeshGenerator::ChangeSet>();
+
+    document->object.reset(meshGenerator.takeObject());
+    document->generatedSnapshot.reset(meshGenerator.takeSnapshot());
+    document->uvMappedObject.reset();
+    document->rigObject.reset();
+    document->isRigReady = false;
+    return nullptr != document->object;
+}
+
+void GenerationServer::generateTexture(ServerDocument* document)
+{
+    if (nullptr != document->uvMappedObject)
+        return;
+
+    UvMapGenerator uvMapGenerator(std::make_unique<dust3d::Object>(*document->object),
+        std::make_unique<dust3d::Snapshot>(*document->generatedSnapshot));
+    // Textures are only generated for export, so they always carry the occlusion
+    uvMapGenerator.setAmbientOcclusionBaked(true);
+    uvMapGenerator.generate();
+    document->textureColorImage = uvMapGenerator.takeResultTextureColorImage();
+    document->textureNormalImage = uvMapGenerator.takeResultTextureNormalImage();
+    document->textureMetalnessImage = uvMapGenerator.takeResultTextureMetalnessImage();
+    document->textureRoughnessImage = uvMapGenerator.takeResultTextureRoughnessImage();
+    document->textureAmbientOcclusionImage = uvMapGenerator.takeResultTextureAmbientOcclusionImage();
+    document->uvMappedObject = uvMapGenerator.takeObject();
+    if (nullptr == document->uvMappedObject)
+        document->uvMappedObject = std::make_unique<dust3d::Object>(*document->object);
+}
+
+void GenerationServer::generateRig(ServerDocument* document)
+{
+    if (document->isRigReady)
+        return;
+    document->isRigReady = true;
+    document->rigObject.reset();
+
+    QString rigType = QString::fromUtf8(dust3d::String::valueOrEmpty(document->generatedSnapshot->canvas, "rigType").c_str());
+    if (rigType == "None" || rigType.isEmpty())
+        return;
+    auto findRigStructure = m_rigStructures.find(rigType);
+    if (findRigStructure == m_rigStructures.end() || findRigStructure->second.bones.empty())
+        return;
+    if (document->uvMappedObject->vertices.empty())
+        return;
+
+    RigStructure rigWithSettings = findRigStructure->second;
+    rigWithSettings.headHasEyelids = dust3d::String::isTrue(dust3d::String::valueOrEmpty(document->generatedSnapshot->canvas, "headHasEyelids"));
+
+    RigGeneratorWorker rigGeneratorWorker;
+    rigGeneratorWorker.setParameters(std::make_unique<dust3d::Snapshot>(*document->generatedSnapshot),
+        std::make_unique<dust3d::Object>(*document->uvMappedObject),
+        rigWithSettings);
+    rigGeneratorWorker.process();
+    if (!rigGeneratorWorker.isSuccessful())
+        return;
+    document->rigObject = rigGeneratorWorker.takeObject();
+    document->actualRigStructure = rigGeneratorWorker.getActualRig();
+}
+
+bool GenerationServer::exportGlb(ServerDocument* document, const QString& path, std::string* error)
+{
+    if (path.isEmpty()) {
+        *error = "Missing output path";
+        return false;
+    }
+    if (!generateMesh(document)) {
+        *error = "Mesh generation failed";
+        return false;
+    }
+    generateTexture(document);
+    generateRig(document);
+
+    std::unique_ptr<QImage> ormImage(UvMapGenerator::combineMetalnessRoughnessAmbientOcclusionImages(
+        document->textureMetalnessImage.get(),
+        document->textureRoughnessImage.get(),
+        document->textureAmbientOcclusionImage.get()));
+
+    bool isSuccessful = false;
+    if (nullptr != document->rigObject && !document->rigObject->vertexBone1.empty()) {
+        ExportAnimationWorker exportAnimationWorker;
+        exportAnimationWorker.setParameters(document->actualRigStructure, std::vector<Document::Animation>());
+        exportAnimationWorker.process();
+        dust3d::Object rigWithUv = *document->rigObject;
+        rigWithUv.copyUvFrom(*document->uvMappedObject);
+        GlbFileWriter glbFileWriter(rigWithUv, path,
+            document->textureColorImage.get(), document->textureNormalImage.get(), ormImage.get(),
+            &document->actualRigStructure,
+            &exportAnimationWorker.inverseBindMatrices(),
+            nullptr);
+        isSuccessful = glbFileWriter.save();
+    } else {
+        dust3d::Object uvObject = *document->uvMappedObject;
+        GlbFileWriter glbFileWriter(uvObject, path,
+            document->textureColorImage.get(), document->textureNormalImage.get(), ormImage.get());
+        isSuccessful = glbFileWriter.save();
+    }
+    if (!isSuccessful)
+        *error = "Unable to write " + path.toStdString();
+    return isSuccessful;
+}
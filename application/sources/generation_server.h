@@ -0,0 +1,99 @@
+#ifndef DUST3D_APPLICATION_GENERATION_SERVER_H_
+#define DUST3D_APPLICATION_GENERATION_SERVER_H_
+
+#include "bone_structure.h"
+#include "json.hpp"
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <deque>
+#include <dust3d/base/object.h>
+#include <dust3d/base/snapshot.h>
+#include <dust3d/mesh/mesh_generator.h>
+#include <dust3d/mesh/mesh_generator_disk_cache.h>
+#include <map>
+#include <memory>
+#include <cstdio>
+#include <set>
+
+class QThread;
+
+// Headless generation service, started with the -server command line option.
+// Requests are read from stdin, one JSON object per line, and each one is answered
+// on stdout with one JSON line carrying the "id" of the request, every other output goes to stderr:
+//   {"id":1,"command":"open","document":"a","path":"a.ds3"}
+//   {"id":2,"command":"patch","document":"a","parts":{"{...}":{"deformThickness":"1.2"}}}
+//   {"id":3,"command":"generate","document":"a"}
+//   {"id":4,"command":"exportGlb","document":"a","path":"a.glb"}
+//   {"id":5,"command":"close","document":"a"}
+// Every open document keeps its snapshot, generation cache, UV map and rig between
+// requests, so a request following a patch only regenerates what the patch touched.
+// Requests run on the global thread pool, those of one document in the order received.
+class GenerationServer : public QObject {
+    Q_OBJECT
+public:
+    GenerationServer();
+    ~GenerationServer();
+    void start();
+
+signals:
+    void finished();
+
+private:
+    struct ServerDocument {
+        QString name;
+        dust3d::Snapshot snapshot;
+        std::unique_ptr<dust3d::MeshGenerator::GeneratedCacheContext> generatedCacheContext;
+        // Null until the first generation, which builds everything
+        std::unique_ptr<dust3d::MeshGenerator::ChangeSet> changeSet;
+        std::unique_ptr<dust3d::Object> object;
+        std::unique_ptr<dust3d::Snapshot> generatedSnapshot;
+        uint64_t meshId = 0;
+        std::unique_ptr<dust3d::Object> uvMappedObject;
+        std::unique_ptr<QImage> textureColorImage;
+        std::unique_ptr<QImage> textureNormalImage;
+        std::unique_ptr<QImage> textureMetalnessImage;
+        std::unique_ptr<QImage> textureRoughnessImage;
+        std::unique_ptr<QImage> textureAmbientOcclusionImage;
+        std::unique_ptr<dust3d::Object> rigObject;
+        RigStructure actualRigStructure;
+        bool isRigReady = false;
+        // Images and models registered when the document was opened, released when it is closed
+        std::set<dust3d::Uuid> imageIds;
+        std::set<dust3d::Uuid> glbIds;
+        std::deque<nlohmann::json> pendingRequests;
+        bool isBusy = false;
+        bool isOpen = false;
+        bool isClosed = false;
+    };
+
+    QThread* m_inputThread = nullptr;
+    std::map<QString, std::unique_ptr<ServerDocument>> m_documents;
+    // Documents a close was queued for, kept until the close has run
+    std::map<ServerDocument*, std::unique_ptr<ServerDocument>> m_closingDocuments;
+    std::map<QString, RigStructure> m_rigStructures;
+    std::shared_ptr<dust3d::MeshGeneratorDiskCache> m_diskCache;
+    bool m_inputEnded = false;
+    QMutex m_outputMutex;
+    std::FILE* m_responseStream = nullptr;
+    // Documents opened from the same file share their models, which are removed with the last one
+    std::map<dust3d::Uuid, size_t> m_glbUseCounts;
+    QMutex m_glbMutex;
+
+    void handleRequestLine(const QString& line);
+    void dispatchRequest(nlohmann::json request);
+    void runNextRequest(ServerDocument* document);
+    void checkFinished();
+    nlohmann::json processRequest(ServerDocument* document, const nlohmann::json& request);
+    void writeResponse(const nlohmann::json& response);
+    bool openDocument(ServerDocument* document, const QString& path, std::string* error);
+    void releaseAssets(std::set<dust3d::Uuid>& imageIds, std::set<dust3d::Uuid>& glbIds);
+    void patchDocument(ServerDocument* document, const nlohmann::json& request);
+    bool generateMesh(ServerDocument* document);
+    void generateTexture(ServerDocument* document);
+    void generateRig(ServerDocument* document);
+    bool exportGlb(ServerDocument* document, const QString& path, std::string* error);
+};
+
+#endif
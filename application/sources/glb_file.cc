@@ -8,10 +8,527 @@
 #include <QFileInfo>
 #include <QQuaternion>
 #include <QtCore/qbuffer.h>
+#include <QtEndian>
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <dust3d/mesh/encode_meshopt_buffer.h>
+#include <dust3d/mesh/simplify_mesh.h>
+#include <limits>
+#include <memory>
 
 bool GlbFileWriter::m_enableComment = false;
 
+template <class T>
+static QByteArray toLittleEndianByteArray(const std::vector<T>& values)
+{
+    QByteArray byteArray((int)(values.size() * sizeof(T)), Qt::Uninitialized);
+    qToLittleEndian<T>(values.data(), (qsizetype)values.size(), byteArray.data());
+    return byteArray;
+}
+
+static int alignedBinSize(int size)
+{
+    return (size + 3) & ~3;
+}
+
+int GlbFileWriter::appendBinBlock(const QByteArray& block)
+{
+    int byteOffset = m_binByteLength;
+    m_binBlocks.push_back(block);
+    m_binByteLength += alignedBinSize(block.size());
+    return byteOffset;
+}
+
+void GlbFileWriter::appendMeshoptBufferView(int bufferViewIndex, const std::vector<uint8_t>& encoded, int byteLength, int byteStride, size_t count, const char* mode)
+{
+    // The compressed bytes go to the BIN chunk, while the buffer view itself addresses the
+    // uncompressed fallback buffer, which has no data and is only there to size the decoded view
+    int byteOffset = appendBinBlock(QByteArray((const char*)encoded.data(), (int)encoded.size()));
+    auto& extension = m_json["bufferViews"][bufferViewIndex]["extensions"]["EXT_meshopt_compression"];
+    extension["buffer"] = 0;
+    extension["byteOffset"] = byteOffset;
+    extension["byteLength"] = (int)encoded.size();
+    extension["byteStride"] = byteStride;
+    extension["count"] = count;
+    extension["mode"] = mode;
+    m_json["bufferViews"][bufferViewIndex]["buffer"] = 1;
+    m_json["bufferViews"][bufferViewIndex]["byteOffset"] = m_fallbackByteLength;
+    m_fallbackByteLength += alignedBinSize(byteLength);
+}
+
+void GlbFileWriter::appendVertexBufferView(int bufferViewIndex, const QByteArray& block, int byteStride, size_t count)
+{
+    m_json["bufferViews"][bufferViewIndex]["byteLength"] = block.size();
+    m_json["bufferViews"][bufferViewIndex]["byteStride"] = byteStride;
+    m_json["bufferViews"][bufferViewIndex]["target"] = 34962;
+    if (!m_meshoptCompression) {
+        m_json["bufferViews"][bufferViewIndex]["buffer"] = 0;
+        m_json["bufferViews"][bufferViewIndex]["byteOffset"] = appendBinBlock(block);
+        return;
+    }
+    std::vector<uint8_t> encoded;
+    dust3d::encodeMeshoptVertexBuffer((const uint8_t*)block.constData(), count, byteStride, &encoded);
+    appendMeshoptBufferView(bufferViewIndex, encoded, block.size(), byteStride, count, "ATTRIBUTES");
+}
+
+void GlbFileWriter::appendIndexBufferView(int bufferViewIndex, const std::vector<uint32_t>& indices, bool useIntIndices)
+{
+    int indexComponentSize = useIntIndices ? sizeof(quint32) : sizeof(quint16);
+    int byteLength = (int)indices.size() * indexComponentSize;
+    m_json["bufferViews"][bufferViewIndex]["byteLength"] = byteLength;
+    m_json["bufferViews"][bufferViewIndex]["target"] = 34963;
+    if (m_meshoptCompression) {
+        std::vector<uint8_t> encoded;
+        dust3d::encodeMeshoptIndexBuffer(indices, &encoded);
+        appendMeshoptBufferView(bufferViewIndex, encoded, byteLength, indexComponentSize, indices.size(), "TRIANGLES");
+        return;
+    }
+    m_json["bufferViews"][bufferViewIndex]["buffer"] = 0;
+    if (useIntIndices) {
+        m_json["bufferViews"][bufferViewIndex]["byteOffset"] = appendBinBlock(toLittleEndianByteArray(indices));
+    } else {
+        std::vector<quint16> shortIndices(indices.begin(), indices.end());
+        m_json["bufferViews"][bufferViewIndex]["byteOffset"] = appendBinBlock(toLittleEndianByteArray(shortIndices));
+    }
+}
+
+// Every attribute of one vertex as written by the quantized path, unused fields stay zero,
+// so the raw bytes identify the vertex while welding triangle corners
+struct GlbQuantizedVertex {
+    quint16 position[4];
+    qint8 normal[4];
+    quint16 uv[2];
+    float floatUv[2];
+    quint16 joints[4];
+    quint8 weights[4];
+};
+
+// Full precision counterpart of GlbQuantizedVertex, for the float path
+struct GlbFloatVertex {
+    float position[3];
+    float normal[3];
+    float uv[2];
+    quint16 joints[4];
+    float weights[4];
+};
+
+template <typename Vertex>
+static size_t hashVertex(const Vertex& vertex)
+{
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&vertex);
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < sizeof(Vertex); ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return (size_t)hash;
+}
+
+static quint16 quantizeUnsignedNormalized16(double value)
+{
+    return (quint16)std::lround(std::max(0.0, std::min(1.0, value)) * 65535.0);
+}
+
+static qint8 quantizeSignedNormalized8(double value)
+{
+    return (qint8)std::lround(std::max(-1.0, std::min(1.0, value)) * 127.0);
+}
+
+void GlbFileWriter::appendFloatPrimitive(const dust3d::Object& object,
+    const std::vector<int>& objectBoneToJoint,
+    bool hasVertexBoneBindings,
+    int& bufferViewIndex)
+{
+    const std::vector<std::vector<dust3d::Vector3>>* triangleVertexNormals = object.triangleVertexNormals();
+    const std::vector<std::vector<dust3d::Vector2>>* triangleVertexUvs = object.triangleVertexUvs();
+    auto vertexJoint = [&](int boneIndex) -> int {
+        if (boneIndex < 0 || boneIndex >= (int)objectBoneToJoint.size())
+            return -1;
+        return objectBoneToJoint[boneIndex];
+    };
+
+    size_t triangleVertexCount = object.triangles.size() * 3;
+    size_t slotCount = 1;
+    while (slotCount < triangleVertexCount * 2)
+        slotCount <<= 1;
+    const uint32_t emptySlot = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> slots(slotCount, emptySlot);
+
+    std::vector<GlbFloatVertex> vertices;
+    vertices.reserve(triangleVertexCount / 2);
+    std::vector<uint32_t> indices(triangleVertexCount);
+    for (size_t i = 0; i < triangleVertexCount; ++i) {
+        size_t triangleIndex = i / 3;
+        size_t oldIndex = object.triangles[triangleIndex][i % 3];
+        GlbFloatVertex vertex;
+        std::memset(&vertex, 0, sizeof(vertex));
+        const auto& position = object.vertices[oldIndex];
+        for (size_t axis = 0; axis < 3; ++axis)
+            vertex.position[axis] = (float)position[axis];
+        if (m_outputNormal) {
+            const auto& normal = (*triangleVertexNormals)[triangleIndex][i % 3];
+            for (size_t axis = 0; axis < 3; ++axis)
+                vertex.normal[axis] = (float)normal[axis];
+        }
+        if (m_outputUv) {
+            const auto& uv = (*triangleVertexUvs)[triangleIndex][i % 3];
+            vertex.uv[0] = (float)uv.x();
+            vertex.uv[1] = (float)uv.y();
+        }
+        if (hasVertexBoneBindings) {
+            if (oldIndex < object.vertexBone1.size() && object.vertexBone1[oldIndex].first >= 0) {
+                if (vertexJoint(object.vertexBone1[oldIndex].first) >= 0)
+                    vertex.joints[0] = (quint16)vertexJoint(object.vertexBone1[oldIndex].first);
+                vertex.weights[0] = (float)object.vertexBone1[oldIndex].second;
+            }
+            if (oldIndex < object.vertexBone2.size() && object.vertexBone2[oldIndex].first >= 0) {
+                if (vertexJoint(object.vertexBone2[oldIndex].first) >= 0)
+                    vertex.joints[1] = (quint16)vertexJoint(object.vertexBone2[oldIndex].first);
+                vertex.weights[1] = (float)object.vertexBone2[oldIndex].second;
+            }
+        }
+
+        size_t slot = hashVertex(vertex) & (slotCount - 1);
+        while (emptySlot != slots[slot]) {
+            if (0 == std::memcmp(&vertices[slots[slot]], &vertex, sizeof(GlbFloatVertex)))
+                break;
+            slot = (slot + 1) & (slotCount - 1);
+        }
+        if (emptySlot == slots[slot]) {
+            slots[slot] = (uint32_t)vertices.size();
+            vertices.push_back(vertex);
+        }
+        indices[i] = slots[slot];
+    }
+    size_t vertexCount = vertices.size();
+
+    // Index values above 65535 do not fit UNSIGNED_SHORT, bigger meshes use UNSIGNED_INT indices
+    bool useIntIndices = vertexCount > 65535;
+    appendIndexBufferView(bufferViewIndex, indices, useIntIndices);
+    if (m_enableComment)
+        m_json["accessors"][bufferViewIndex]["__comment"] = QString("/accessors/%1: triangle indices").arg(QString::number(bufferViewIndex)).toUtf8().constData();
+    m_json["accessors"][bufferViewIndex]["bufferView"] = bufferViewIndex;
+    m_json["accessors"][bufferViewIndex]["byteOffset"] = 0;
+    m_json["accessors"][bufferViewIndex]["componentType"] = useIntIndices ? 5125 : 5123;
+    m_json["accessors"][bufferViewIndex]["count"] = triangleVertexCount;
+    m_json["accessors"][bufferViewIndex]["type"] = "SCALAR";
+    bufferViewIndex++;
+
+    std::vector<float> positions(vertexCount * 3);
+    float minPosition[3] = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+    float maxPosition[3] = { std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest() };
+    for (size_t i = 0; i < vertexCount; ++i) {
+        for (size_t axis = 0; axis < 3; ++axis) {
+            positions[i * 3 + axis] = vertices[i].position[axis];
+            minPosition[axis] = std::min(minPosition[axis], vertices[i].position[axis]);
+            maxPosition[axis] = std::max(maxPosition[axis], vertices[i].position[axis]);
+        }
+    }
+    appendVertexBufferView(bufferViewIndex, toLittleEndianByteArray(positions), 3 * sizeof(float), vertexCount);
+    if (m_enableComment)
+        m_json["accessors"][bufferViewIndex]["__comment"] = QString("/accessors/%1: xyz").arg(QString::number(bufferViewIndex)).toUtf8().constData();
+    m_json["accessors"][bufferViewIndex]["bufferView"] = bufferViewIndex;
+    m_json["accessors"][bufferViewIndex]["byteOffset"] = 0;
+    m_json["accessors"][bufferViewIndex]["componentType"] = 5126;
+    m_json["accessors"][bufferViewIndex]["count"] = vertexCount;
+    m_json["accessors"][bufferViewIndex]["type"] = "VEC3";
+    m_json["accessors"][bufferViewIndex]["max"] = { maxPosition[0], maxPosition[1], maxPosition[2] };
+    m_json["accessors"][bufferViewIndex]["min"] = { minPosition[0], minPosition[1], minPosition[2] };
+    bufferViewIndex++;
+
+    if (m_outputNormal) {
+        std::vector<float> normals(vertexCount * 3);
+        for (size_t i = 0; i < vertexCount; ++i) {
+            for (size_t axis = 0; axis < 3; ++axis)
+                normals[i * 3 + axis] = vertices[i].normal[axis];
+        }
+        appendVertexBufferView(bufferViewIndex, toLittleEndianByteArray(normals), 3 * sizeof(float), vertexCount);
+        if (m_enableComment)
+            m_json["accessors"][bufferViewIndex]["__comment"] = QString("/accessors/%1: normal").arg(QString::number(bufferViewIndex)).toUtf8().constData();
+        m_json["accessors"][bufferViewIndex]["bufferView"] = bufferViewIndex;
+        m_json["accessors"][bufferViewIndex]["byteOffset"] = 0;
+        m_json["accessors"][bufferViewIndex]["componentType"] = 5126;
+        m_json["accessors"][bufferViewIndex]["count"] = vertexCount;
+        m_json["accessors"][bufferViewIndex]["type"] = "VEC3";
+        bufferViewIndex++;
+    }
+
+    if (m_outputUv) {
+        std::vector<float> uvValues(vertexCount * 2);
+        for (size_t i = 0; i < vertexCount; ++i) {
+            uvValues[i * 2] = vertices[i].uv[0];
+            uvValues[i * 2 + 1] = vertices[i].uv[1];
+        }
+        appendVertexBufferView(bufferViewIndex, toLittleEndianByteArray(uvValues), 2 * sizeof(float), vertexCount);
+        if (m_enableComment)
+            m_json["accessors"][bufferViewIndex]["__comment"] = QString("/accessors/%1: uv").arg(QString::number(bufferViewIndex)).toUtf8().constData();
+        m_json["accessors"][bufferViewIndex]["bufferView"] = bufferViewIndex;
+        m_json["accessors"][bufferViewIndex]["byteOffset"] = 0;
+        m_json["accessors"][bufferViewIndex]["componentType"] = 5126;
+        m_json["accessors"][bufferViewIndex]["count"] = vertexCount;
+        m_json["accessors"][bufferViewIndex]["type"] = "VEC2";
+        bufferViewIndex++;
+    }
+
+    if (hasVertexBoneBindings) {
+        std::vector<quint16> joints(vertexCount * 4);
+        for (size_t i = 0; i < vertexCount; ++i) {
+            for (size_t j = 0; j < 4; ++j)
+                joints[i * 4 + j] = vertices[i].joints[j];
+        }
+        appendVertexBufferView(bufferViewIndex, toLittleEndianByteArray(joints), 4 * sizeof(quint16), vertexCount);
+        if (m_enableComment)
+            m_json["accessors"][bufferViewIndex]["__comment"] = QString("/accessors/%1: bone joints").arg(QString::number(bufferViewIndex)).toUtf8().constData();
+        m_json["accessors"][bufferViewIndex]["bufferView"] = bufferViewIndex;
+        m_json["accessors"][bufferViewIndex]["byteOffset"] = 0;
+        m_json["accessors"][bufferViewIndex]["componentType"] = 5123;
+        m_json["accessors"][bufferViewIndex]["count"] = vertexCount;
+        m_json["accessors"][bufferViewIndex]["type"] = "VEC4";
+        bufferViewIndex++;
+
+        std::vector<float> weights(vertexCount * 4);
+        for (size_t i = 0; i < vertexCount; ++i) {
+            for (size_t j = 0; j < 4; ++j)
+                weights[i * 4 + j] = vertices[i].weights[j];
+        }
+        appendVertexBufferView(bufferViewIndex, toLittleEndianByteArray(weights), 4 * sizeof(float), vertexCount);
+        if (m_enableComment)
+            m_json["accessors"][bufferViewIndex]["__comment"] = QString("/accessors/%1: bone weights").arg(QString::number(bufferViewIndex)).toUtf8().constData();
+        m_json["accessors"][bufferViewIndex]["bufferView"] = bufferViewIndex;
+        m_json["accessors"][bufferViewIndex]["byteOffset"] = 0;
+        m_json["accessors"][bufferViewIndex]["componentType"] = 5126;
+        m_json["accessors"][bufferViewIndex]["count"] = vertexCount;
+        m_json["accessors"][bufferViewIndex]["type"] = "VEC4";
+        bufferViewIndex++;
+    }
+}
+
+void GlbFileWriter::appendQuantizedPrimitive(const dust3d::Object& object,
+    const std::vector<int>& objectBoneToJoint,
+    bool hasVertexBoneBindings,
+    size_t jointCount,
+    const dust3d::Vector3& positionOffset,
+    double positionScale,
+    int& bufferViewIndex)
+{
+    const std::vector<std::vector<dust3d::Vector3>>* triangleVertexNormals = object.triangleVertexNormals();
+    const std::vector<std::vector<dust3d::Vector2>>* triangleVertexUvs = object.triangleVertexUvs();
+    auto vertexJoint = [&](int boneIndex) -> int {
+        if (boneIndex < 0 || boneIndex >= (int)objectBoneToJoint.size())
+            return -1;
+        return objectBoneToJoint[boneIndex];
+    };
+
+    // UVs outside of the unit square, from tiled materials, keep their floats
+    bool normalizedUv = true;
+    if (m_outputUv) {
+        for (const auto& uvs : (*triangleVertexUvs)) {
+            for (const auto& it : uvs) {
+                if (it.x() < 0.0 || it.x() > 1.0 || it.y() < 0.0 || it.y() > 1.0)
+                    normalizedUv = false;
+            }
+        }
+    }
+    bool byteJoints = jointCount <= 256;
+
+    size_t triangleVertexCount = object.triangles.size() * 3;
+    size_t slotCount = 1;
+    while (slotCount < triangleVertexCount * 2)
+        slotCount <<= 1;
+    const uint32_t emptySlot = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> slots(slotCount, emptySlot);
+
+    std::vector<GlbQuantizedVertex> vertices;
+    vertices.reserve(triangleVertexCount / 2);
+    std::vector<uint32_t> indices(triangleVertexCount);
+    for (size_t i = 0; i < triangleVertexCount; ++i) {
+        size_t triangleIndex = i / 3;
+        size_t oldIndex = object.triangles[triangleIndex][i % 3];
+        GlbQuantizedVertex vertex;
+        std::memset(&vertex, 0, sizeof(vertex));
+        const auto& position = object.vertices[oldIndex];
+        for (size_t axis = 0; axis < 3; ++axis)
+            vertex.position[axis] = (quint16)std::lround(std::max(0.0, std::min(65535.0, (position[axis] - positionOffset[axis]) / positionScale)));
+        if (m_outputNormal) {
+            dust3d::Vector3 normal = (*triangleVertexNormals)[triangleIndex][i % 3].normalized();
+            for (size_t axis = 0; axis < 3; ++axis)
+                vertex.normal[axis] = quantizeSignedNormalized8(normal[axis]);
+        }
+        if (m_outputUv) {
+            const auto& uv = (*triangleVertexUvs)[triangleIndex][i % 3];
+            if (normalizedUv) {
+                vertex.uv[0] = quantizeUnsignedNormalized16(uv.x());
+                vertex.uv[1] = quantizeUnsignedNormalized16(uv.y());
+            } else {
+                vertex.floatUv[0] = (float)uv.x();
+                vertex.floatUv[1] = (float)uv.y();
+            }
+        }
+        if (hasVertexBoneBindings) {
+            double weight1 = 0.0;
+            double weight2 = 0.0;
+            if (oldIndex < object.vertexBone1.size() && object.vertexBone1[oldIndex].first >= 0) {
+                if (vertexJoint(object.vertexBone1[oldIndex].first) >= 0)
+                    vertex.joints[0] = (quint16)vertexJoint(object.vertexBone1[oldIndex].first);
+                weight1 = object.vertexBone1[oldIndex].second;
+            }
+            if (oldIndex < object.vertexBone2.size() && object.vertexBone2[oldIndex].first >= 0) {
+                if (vertexJoint(object.vertexBone2[oldIndex].first) >= 0)
+                    vertex.joints[1] = (quint16)vertexJoint(object.vertexBone2[oldIndex].first);
+                weight2 = object.vertexBone2[oldIndex].second;
+            }
+            // Rounded weights are fixed up to sum to exactly 255, the heavier one taking the difference
+            int quantizedWeight1 = (int)std::lround(std::max(0.0, std::min(1.0, weight1)) * 255.0);
+            int quantizedWeight2 = (int)std::lround(std::max(0.0, std::min(1.0, weight2)) * 255.0);
+            if (weight1 + weight2 > 0.0) {
+                int difference = 255 - quantizedWeight1 - quantizedWeight2;
+                if (quantizedWeight1 >= quantizedWeight2)
+                    quantizedWeight1 += difference;
+                else
+                    quantizedWeight2 += difference;
+            }
+            vertex.weights[0] = (quint8)std::max(0, std::min(255, quantizedWeight1));
+            vertex.weights[1] = (quint8)std::max(0, std::min(255, quantizedWeight2));
+        }
+
+        size_t slot = hashVertex(vertex) & (slotCount - 1);
+        while (emptySlot != slots[slot]) {
+            if (0 == std::memcmp(&vertices[slots[slot]], &vertex, sizeof(GlbQuantizedVertex)))
+                break;
+            slot = (slot + 1) & (slotCount - 1);
+        }
+        if (emptySlot == slots[slot]) {
+            slots[slot] = (uint32_t)vertices.size();
+            vertices.push_back(vertex);
+        }
+        indices[i] = slots[slot];
+    }
+    size_t vertexCount = vertices.size();
+
+    bool useIntIndices = vertexCount > 65535;
+    appendIndexBufferView(bufferViewIndex, indices, useIntIndices);
+    if (m_enableComment)
+        m_json["accessors"][bufferViewIndex]["__comment"] = QString("/accessors/%1: triangle indices").arg(QString::number(bufferViewIndex)).toUtf8().constData();
+    m_json["accessors"][bufferViewIndex]["bufferView"] = bufferViewIndex;
+    m_json["accessors"][bufferViewIndex]["byteOffset"] = 0;
+    m_json["accessors"][bufferViewIndex]["componentType"] = useIntIndices ? 5125 : 5123;
+    m_json["accessors"][bufferViewIndex]["count"] = triangleVertexCount;
+    m_json["accessors"][bufferViewIndex]["type"] = "SCALAR";
+    bufferViewIndex++;
+
+    std::vector<quint16> positions(vertexCount * 4);
+    quint16 minPosition[3] = { 65535, 65535, 65535 };
+    quint16 maxPosition[3] = { 0, 0, 0 };
+    for (size_t i = 0; i < vertexCount; ++i) {
+        for (size_t axis = 0; axis < 4; ++axis)
+            positions[i * 4 + axis] = vertices[i].position[axis];
+        for (size_t axis = 0; axis < 3; ++axis) {
+            minPosition[axis] = std::min(minPosition[axis], vertices[i].position[axis]);
+            maxPosition[axis] = std::max(maxPosition[axis], vertices[i].position[axis]);
+        }
+    }
+    appendVertexBufferView(bufferViewIndex, toLittleEndianByteArray(positions), 4 * sizeof(quint16), vertexCount);
+    if (m_enableComment)
+        m_json["accessors"][bufferViewIndex]["__comment"] = QString("/accessors/%1: quantized xyz").arg(QString::number(bufferViewIndex)).toUtf8().constData();
+    m_json["accessors"][bufferViewIndex]["bufferView"] = bufferViewIndex;
+    m_json["accessors"][bufferViewIndex]["byteOffset"] = 0;
+    m_json["accessors"][bufferViewIndex]["componentType"] = 5123;
+    m_json["accessors"][bufferViewIndex]["count"] = vertexCount;
+    m_json["accessors"][bufferViewIndex]["type"] = "VEC3";
+    m_json["accessors"][bufferViewIndex]["max"] = { maxPosition[0], maxPosition[1], maxPosition[2] };
+    m_json["accessors"][bufferViewIndex]["min"] = { minPosition[0], minPosition[1], minPosition[2] };
+    bufferViewIndex++;
+
+    if (m_outputNormal) {
+        std::vector<qint8> normals(vertexCount * 4);
+        for (size_t i = 0; i < vertexCount; ++i) {
+            for (size_t axis = 0; axis < 4; ++axis)
+                normals[i * 4 + axis] = vertices[i].normal[axis];
+        }
+        appendVertexBufferView(bufferViewIndex, toLittleEndianByteArray(normals), 4 * sizeof(qint8), vertexCount);
+        if (m_enableComment)
+            m_json["accessors"][bufferViewIndex]["__comment"] = QString("/accessors/%1: quantized normal").arg(QString::number(bufferViewIndex)).toUtf8().constData();
+        m_json["accessors"][bufferViewIndex]["bufferView"] = bufferViewIndex;
+        m_json["accessors"][bufferViewIndex]["byteOffset"] = 0;
+        m_json["accessors"][bufferViewIndex]["componentType"] = 5120;
+        m_json["accessors"][bufferViewIndex]["normalized"] = true;
+        m_json["accessors"][bufferViewIndex]["count"] = vertexCount;
+        m_json["accessors"][bufferViewIndex]["type"] = "VEC3";
+        bufferViewIndex++;
+    }
+
+    if (m_outputUv) {
+        if (normalizedUv) {
+            std::vector<quint16> uvValues(vertexCount * 2);
+            for (size_t i = 0; i < vertexCount; ++i) {
+                uvValues[i * 2] = vertices[i].uv[0];
+                uvValues[i * 2 + 1] = vertices[i].uv[1];
+            }
+            appendVertexBufferView(bufferViewIndex, toLittleEndianByteArray(uvValues), 2 * sizeof(quint16), vertexCount);
+        } else {
+            std::vector<float> uvValues(vertexCount * 2);
+            for (size_t i = 0; i < vertexCount; ++i) {
+                uvValues[i * 2] = vertices[i].floatUv[0];
+                uvValues[i * 2 + 1] = vertices[i].floatUv[1];
+            }
+            appendVertexBufferView(bufferViewIndex, toLittleEndianByteArray(uvValues), 2 * sizeof(float), vertexCount);
+        }
+        if (m_enableComment)
+            m_json["accessors"][bufferViewIndex]["__comment"] = QString("/accessors/%1: quantized uv").arg(QString::number(bufferViewIndex)).toUtf8().constData();
+        m_json["accessors"][bufferViewIndex]["bufferView"] = bufferViewIndex;
+        m_json["accessors"][bufferViewIndex]["byteOffset"] = 0;
+        m_json["accessors"][bufferViewIndex]["componentType"] = normalizedUv ? 5123 : 5126;
+        if (normalizedUv)
+            m_json["accessors"][bufferViewIndex]["normalized"] = true;
+        m_json["accessors"][bufferViewIndex]["count"] = vertexCount;
+        m_json["accessors"][bufferViewIndex]["type"] = "VEC2";
+        bufferViewIndex++;
+    }
+
+    if (hasVertexBoneBindings) {
+        if (byteJoints) {
+            std::vector<quint8> joints(vertexCount * 4);
+            for (size_t i = 0; i < vertexCount; ++i) {
+                for (size_t j = 0; j < 4; ++j)
+                    joints[i * 4 + j] = (quint8)vertices[i].joints[j];
+            }
+            appendVertexBufferView(bufferViewIndex, toLittleEndianByteArray(joints), 4 * sizeof(quint8), vertexCount);
+        } else {
+            std::vector<quint16> joints(vertexCount * 4);
+            for (size_t i = 0; i < vertexCount; ++i) {
+                for (size_t j = 0; j < 4; ++j)
+                    joints[i * 4 + j] = vertices[i].joints[j];
+            }
+            appendVertexBufferView(bufferViewIndex, toLittleEndianByteArray(joints), 4 * sizeof(quint16), vertexCount);
+        }
+        if (m_enableComment)
+            m_json["accessors"][bufferViewIndex]["__comment"] = QString("/accessors/%1: bone joints").arg(QString::number(bufferViewIndex)).toUtf8().constData();
+        m_json["accessors"][bufferViewIndex]["bufferView"] = bufferViewIndex;
+        m_json["accessors"][bufferViewIndex]["byteOffset"] = 0;
+        m_json["accessors"][bufferViewIndex]["componentType"] = byteJoints ? 5121 : 5123;
+        m_json["accessors"][bufferViewIndex]["count"] = vertexCount;
+        m_json["accessors"][bufferViewIndex]["type"] = "VEC4";
+        bufferViewIndex++;
+
+        std::vector<quint8> weights(vertexCount * 4);
+        for (size_t i = 0; i < vertexCount; ++i) {
+            for (size_t j = 0; j < 4; ++j)
+                weights[i * 4 + j] = vertices[i].weights[j];
+        }
+        appendVertexBufferView(bufferViewIndex, toLittleEndianByteArray(weights), 4 * sizeof(quint8), vertexCount);
+        if (m_enableComment)
+            m_json["accessors"][bufferViewIndex]["__comment"] = QString("/accessors/%1: bone weights").arg(QString::number(bufferViewIndex)).toUtf8().constData();
+        m_json["accessors"][bufferViewIndex]["bufferView"] = bufferViewIndex;
+        m_json["accessors"][bufferViewIndex]["byteOffset"] = 0;
+        m_json["accessors"][bufferViewIndex]["componentType"] = 5121;
+        m_json["accessors"][bufferViewIndex]["normalized"] = true;
+        m_json["accessors"][bufferViewIndex]["count"] = vertexCount;
+        m_json["accessors"][bufferViewIndex]["type"] = "VEC4";
+        bufferViewIndex++;
+    }
+}
+
 GlbFileWriter::GlbFileWriter(dust3d::Object& object,
     const QString& filename,
     QImage* textureImage,
@@ -19,8 +536,14 @@ GlbFileWriter::GlbFileWriter(dust3d::Object& object,
     QImage* ormImage,
     const RigStructure* rigStructure,
     const std::map<std::string, dust3d::Matrix4x4>* inverseBindMatrices,
-    const std::vector<dust3d::RigAnimationClip>* animationClips)
+    const std::vector<dust3d::RigAnimationClip>* animationClips,
+    const std::vector<float>& lodRatios,
+    bool quantizeAttributes,
+    bool meshoptCompression)
     : m_filename(filename)
+    , m_lodRatios(lodRatios)
+    , m_quantizeAttributes(quantizeAttributes)
+    , m_meshoptCompression(meshoptCompression)
 {
     const std::vector<std::vector<dust3d::Vector3>>* triangleVertexNormals = object.triangleVertexNormals();
     if (m_outputNormal) {
@@ -32,26 +555,6 @@ GlbFileWriter::GlbFileWriter(dust3d::Object& object,
         m_outputUv = nullptr != triangleVertexUvs;
     }
 
-    QDataStream binStream(&m_binByteArray, QIODevice::WriteOnly);
-    binStream.setFloatingPointPrecision(QDataStream::SinglePrecision);
-    binStream.setByteOrder(QDataStream::LittleEndian);
-
-    auto alignBin = [this, &binStream] {
-        while (0 != this->m_binByteArray.size() % 4) {
-            binStream << (quint8)0;
-        }
-    };
-
-    QDataStream jsonStream(&m_jsonByteArray, QIODevice::WriteOnly);
-    jsonStream.setFloatingPointPrecision(QDataStream::SinglePrecision);
-    jsonStream.setByteOrder(QDataStream::LittleEndian);
-
-    auto alignJson = [this, &jsonStream] {
-        while (0 != this->m_jsonByteArray.size() % 4) {
-            jsonStream << (quint8)' ';
-        }
-    };
-
     int bufferViewIndex = 0;
     int bufferViewFromOffset;
 
@@ -65,7 +568,13 @@ GlbFileWriter::GlbFileWriter(dust3d::Object& object,
         for (size_t i = 0; i < rigStructure->bones.size(); ++i)
             boneNameToIndex[rigStructure->bones[i].name.toStdString()] = i;
     }
-
+    // Joint of each bone the object vertices refer to, -1 for bones missing from the rig
+    std::vector<int> objectBoneToJoint(object.boneNames.size(), -1);
+    for (size_t i = 0; i < object.boneNames.size(); ++i) {
+        auto it = boneNameToIndex.find(object.boneNames[i]);
+        if (it != boneNameToIndex.end())
+            objectBoneToJoint[i] = (int)it->second;
+    }
     auto matrixToTranslationAndRotation = [](const dust3d::Matrix4x4& mat,
                                               float& tx, float& ty, float& tz,
                                               float& qx, float& qy, float& qz, float& qw) {
@@ -131,238 +640,120 @@ GlbFileWriter::GlbFileWriter(dust3d::Object& object,
         m_json["nodes"][0]["mesh"] = 0;
     }
 
-    std::vector<dust3d::Vector3> triangleVertexPositions;
-    std::vector<size_t> triangleVertexOldIndices;
-    for (const auto& triangleIndices : object.triangles) {
-        for (size_t j = 0; j < 3; ++j) {
-            triangleVertexOldIndices.push_back(triangleIndices[j]);
-            triangleVertexPositions.push_back(object.vertices[triangleIndices[j]]);
+    // The full mesh followed by its simplified levels of detail, all of them sharing the one material
+    std::vector<std::unique_ptr<dust3d::Object>> lodObjects;
+    if (!object.triangles.empty()) {
+        for (const auto& ratio : m_lodRatios) {
+            auto lodObject = std::make_unique<dust3d::Object>();
+            dust3d::simplifyObject(object, ratio, lodObject.get());
+            lodObjects.push_back(std::move(lodObject));
         }
     }
-
-    int primitiveIndex = 0;
-    if (!triangleVertexPositions.empty()) {
-
-        m_json["meshes"][0]["primitives"][primitiveIndex]["indices"] = bufferViewIndex;
-        m_json["meshes"][0]["primitives"][primitiveIndex]["material"] = primitiveIndex;
-        int attributeIndex = 0;
-        m_json["meshes"][0]["primitives"][primitiveIndex]["attributes"]["POSITION"] = bufferViewIndex + (++attributeIndex);
-        if (m_outputNormal)
-            m_json["meshes"][0]["primitives"][primitiveIndex]["attributes"]["NORMAL"] = bufferViewIndex + (++attributeIndex);
-        if (m_outputUv)
-            m_json["meshes"][0]["primitives"][primitiveIndex]["attributes"]["TEXCOORD_0"] = bufferViewIndex + (++attributeIndex);
-        if (hasVertexBoneBindings) {
-            m_json["meshes"][0]["primitives"][primitiveIndex]["attributes"]["JOINTS_0"] = bufferViewIndex + (++attributeIndex);
-            m_json["meshes"][0]["primitives"][primitiveIndex]["attributes"]["WEIGHTS_0"] = bufferViewIndex + (++attributeIndex);
-        }
-        int textureIndex = 0;
-        m_json["materials"][primitiveIndex]["pbrMetallicRoughness"]["baseColorTexture"]["index"] = textureIndex++;
-        m_json["materials"][primitiveIndex]["pbrMetallicRoughness"]["metallicFactor"] = ModelMesh::m_defaultMetalness;
-        m_json["materials"][primitiveIndex]["pbrMetallicRoughness"]["roughnessFactor"] = ModelMesh::m_defaultRoughness;
-        if (object.alphaEnabled)
-            m_json["materials"][primitiveIndex]["alphaMode"] = "BLEND";
-        if (normalImage) {
-            m_json["materials"][primitiveIndex]["normalTexture"]["index"] = textureIndex++;
-        }
-        if (ormImage) {
-            m_json["materials"][primitiveIndex]["occlusionTexture"]["index"] = textureIndex;
-            m_json["materials"][primitiveIndex]["pbrMetallicRoughness"]["metallicRoughnessTexture"]["index"] = textureIndex;
-            m_json["materials"][primitiveIndex]["pbrMetallicRoughness"]["metallicFactor"] = 1.0;
-            m_json["materials"][primitiveIndex]["pbrMetallicRoughness"]["roughnessFactor"] = 1.0;
-            textureIndex++;
-        }
-
-        primitiveIndex++;
-
-        bufferViewFromOffset = (int)m_binByteArray.size();
-        // Vertex indices are written as UNSIGNED_SHORT (16-bit) to keep small
-        // meshes compact, but that only addresses index values up to 65535. When
-        // the de-indexed mesh has more vertices we must use UNSIGNED_INT (32-bit)
-        // indices, otherwise the (quint16) casts overflow and corrupt the mesh.
-        const bool useIntIndices = triangleVertexPositions.size() > 65536;
-        const size_t indexComponentSize = useIntIndices ? sizeof(quint32) : sizeof(quint16);
-        if (useIntIndices) {
-            for (size_t index = 0; index < triangleVertexPositions.size(); index += 3) {
-                binStream << (quint32)index << (quint32)(index + 1) << (quint32)(index + 2);
-            }
-        } else {
-            for (size_t index = 0; index < triangleVertexPositions.size(); index += 3) {
-                binStream << (quint16)index << (quint16)(index + 1) << (quint16)(index + 2);
-            }
-        }
-        m_json["bufferViews"][bufferViewIndex]["buffer"] = 0;
-        m_json["bufferViews"][bufferViewIndex]["byteOffset"] = bufferViewFromOffset;
-        m_json["bufferViews"][bufferViewIndex]["byteLength"] = (int)(triangleVertexPositions.size() * indexComponentSize);
-        m_json["bufferViews"][bufferViewIndex]["target"] = 34963;
-        Q_ASSERT((int)(triangleVertexPositions.size() * indexComponentSize) == m_binByteArray.size() - bufferViewFromOffset);
-        alignBin();
-        if (m_enableComment)
-            m_json["accessors"][bufferViewIndex]["__comment"] = QString("/accessors/%1: triangle indices").arg(QString::number(bufferViewIndex)).toUtf8().constData();
-        m_json["accessors"][bufferViewIndex]["bufferView"] = bufferViewIndex;
-        m_json["accessors"][bufferViewIndex]["byteOffset"] = 0;
-        m_json["accessors"][bufferViewIndex]["componentType"] = useIntIndices ? 5125 : 5123;
-        m_json["accessors"][bufferViewIndex]["count"] = triangleVertexPositions.size();
-        m_json["accessors"][bufferViewIndex]["type"] = "SCALAR";
-        bufferViewIndex++;
-
-        bufferViewFromOffset = (int)m_binByteArray.size();
-        m_json["bufferViews"][bufferViewIndex]["buffer"] = 0;
-        m_json["bufferViews"][bufferViewIndex]["byteOffset"] = bufferViewFromOffset;
-        float minX = 100;
-        float maxX = -100;
-        float minY = 100;
-        float maxY = -100;
-        float minZ = 100;
-        float maxZ = -100;
-        for (const auto& position : triangleVertexPositions) {
-            if (position.x() < minX)
-                minX = position.x();
-            if (position.x() > maxX)
-                maxX = position.x();
-            if (position.y() < minY)
-                minY = position.y();
-            if (position.y() > maxY)
-                maxY = position.y();
-            if (position.z() < minZ)
-                minZ = position.z();
-            if (position.z() > maxZ)
-                maxZ = position.z();
-            binStream << (float)position.x() << (float)position.y() << (float)position.z();
-        }
-        Q_ASSERT((int)triangleVertexPositions.size() * 3 * sizeof(float) == m_binByteArray.size() - bufferViewFromOffset);
-        m_json["bufferViews"][bufferViewIndex]["byteLength"] = triangleVertexPositions.size() * 3 * sizeof(float);
-        m_json["bufferViews"][bufferViewIndex]["target"] = 34962;
-        alignBin();
-        if (m_enableComment)
-            m_json["accessors"][bufferViewIndex]["__comment"] = QString("/accessors/%1: xyz").arg(QString::number(bufferViewIndex)).toUtf8().constData();
-        m_json["accessors"][bufferViewIndex]["bufferView"] = bufferViewIndex;
-        m_json["accessors"][bufferViewIndex]["byteOffset"] = 0;
-        m_json["accessors"][bufferViewIndex]["componentType"] = 5126;
-        m_json["accessors"][bufferViewIndex]["count"] = triangleVertexPositions.size();
-        m_json["accessors"][bufferViewIndex]["type"] = "VEC3";
-        m_json["accessors"][bufferViewIndex]["max"] = { maxX, maxY, maxZ };
-        m_json["accessors"][bufferViewIndex]["min"] = { minX, minY, minZ };
-        bufferViewIndex++;
-
-        if (m_outputNormal) {
-            bufferViewFromOffset = (int)m_binByteArray.size();
-            m_json["bufferViews"][bufferViewIndex]["buffer"] = 0;
-            m_json["bufferViews"][bufferViewIndex]["byteOffset"] = bufferViewFromOffset;
-            QStringList normalList;
-            for (const auto& normals : (*triangleVertexNormals)) {
-                for (const auto& it : normals) {
-                    binStream << (float)it.x() << (float)it.y() << (float)it.z();
-                    if (m_enableComment && m_outputNormal)
-                        normalList.append(QString("<%1,%2,%3>").arg(QString::number(it.x())).arg(QString::number(it.y())).arg(QString::number(it.z())));
+    std::vector<const dust3d::Object*> meshObjects = { &object };
+    for (const auto& lodObject : lodObjects)
+        meshObjects.push_back(lodObject.get());
+
+    // Quantized positions are 16-bit steps from the minimum corner of the bounding box of all the levels,
+    // mapped back by the mesh node transform, or by the inverse bind matrices when the mesh is skinned.
+    // Meshopt compression only applies to the quantized buffer views, so it turns quantization on
+    bool quantizeAttributes = (m_quantizeAttributes || m_meshoptCompression) && !object.triangles.empty();
+    dust3d::Vector3 positionOffset;
+    double positionScale = 1.0;
+    if (quantizeAttributes) {
+        dust3d::Vector3 minPosition(std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max());
+        dust3d::Vector3 maxPosition(std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest());
+        for (const auto& meshObject : meshObjects) {
+            for (const auto& position : meshObject->vertices) {
+                for (size_t axis = 0; axis < 3; ++axis) {
+                    minPosition[axis] = std::min(minPosition[axis], position[axis]);
+                    maxPosition[axis] = std::max(maxPosition[axis], position[axis]);
                 }
             }
-            Q_ASSERT((int)triangleVertexNormals->size() * 3 * 3 * sizeof(float) == m_binByteArray.size() - bufferViewFromOffset);
-            m_json["bufferViews"][bufferViewIndex]["byteLength"] = triangleVertexNormals->size() * 3 * 3 * sizeof(float);
-            m_json["bufferViews"][bufferViewIndex]["target"] = 34962;
-            alignBin();
-            if (m_enableComment)
-                m_json["accessors"][bufferViewIndex]["__comment"] = QString("/accessors/%1: normal %2").arg(QString::number(bufferViewIndex)).arg(normalList.join(" ")).toUtf8().constData();
-            m_json["accessors"][bufferViewIndex]["bufferView"] = bufferViewIndex;
-            m_json["accessors"][bufferViewIndex]["byteOffset"] = 0;
-            m_json["accessors"][bufferViewIndex]["componentType"] = 5126;
-            m_json["accessors"][bufferViewIndex]["count"] = triangleVertexNormals->size() * 3;
-            m_json["accessors"][bufferViewIndex]["type"] = "VEC3";
-            bufferViewIndex++;
         }
-
-        if (m_outputUv) {
-            bufferViewFromOffset = (int)m_binByteArray.size();
-            m_json["bufferViews"][bufferViewIndex]["buffer"] = 0;
-            m_json["bufferViews"][bufferViewIndex]["byteOffset"] = bufferViewFromOffset;
-            for (const auto& uvs : (*triangleVertexUvs)) {
-                for (const auto& it : uvs)
-                    binStream << (float)it.x() << (float)it.y();
-            }
-            m_json["bufferViews"][bufferViewIndex]["byteLength"] = m_binByteArray.size() - bufferViewFromOffset;
-            alignBin();
-            if (m_enableComment)
-                m_json["accessors"][bufferViewIndex]["__comment"] = QString("/accessors/%1: uv").arg(QString::number(bufferViewIndex)).toUtf8().constData();
-            m_json["accessors"][bufferViewIndex]["bufferView"] = bufferViewIndex;
-            m_json["accessors"][bufferViewIndex]["byteOffset"] = 0;
-            m_json["accessors"][bufferViewIndex]["componentType"] = 5126;
-            m_json["accessors"][bufferViewIndex]["count"] = triangleVertexUvs->size() * 3;
-            m_json["accessors"][bufferViewIndex]["type"] = "VEC2";
-            bufferViewIndex++;
+        double maxExtent = 0.0;
+        for (size_t axis = 0; axis < 3; ++axis)
+            maxExtent = std::max(maxExtent, maxPosition[axis] - minPosition[axis]);
+        if (maxExtent > 0.0) {
+            positionOffset = minPosition;
+            positionScale = maxExtent / 65535.0;
         }
+    }
 
-        if (hasVertexBoneBindings) {
-            bufferViewFromOffset = (int)m_binByteArray.size();
-            m_json["bufferViews"][bufferViewIndex]["buffer"] = 0;
-            m_json["bufferViews"][bufferViewIndex]["byteOffset"] = bufferViewFromOffset;
-            for (const auto& oldIndex : triangleVertexOldIndices) {
-                quint16 j0 = 0, j1 = 0;
-                if (oldIndex < object.vertexBone1.size() && !object.vertexBone1[oldIndex].first.empty()) {
-                    auto it = boneNameToIndex.find(object.vertexBone1[oldIndex].first);
-                    if (it != boneNameToIndex.end())
-                        j0 = (quint16)it->second;
-                }
-                if (oldIndex < object.vertexBone2.size() && !object.vertexBone2[oldIndex].first.empty()) {
-                    auto it = boneNameToIndex.find(object.vertexBone2[oldIndex].first);
-                    if (it != boneNameToIndex.end())
-                        j1 = (quint16)it->second;
-                }
-                binStream << j0 << j1 << (quint16)0 << (quint16)0;
+    for (size_t meshIndex = 0; meshIndex < meshObjects.size(); ++meshIndex) {
+        const dust3d::Object& meshObject = *meshObjects[meshIndex];
+        size_t triangleVertexCount = meshObject.triangles.size() * 3;
+
+        int primitiveIndex = 0;
+        if (0 != triangleVertexCount) {
+
+            m_json["meshes"][meshIndex]["primitives"][primitiveIndex]["indices"] = bufferViewIndex;
+            m_json["meshes"][meshIndex]["primitives"][primitiveIndex]["material"] = primitiveIndex;
+            int attributeIndex = 0;
+            m_json["meshes"][meshIndex]["primitives"][primitiveIndex]["attributes"]["POSITION"] = bufferViewIndex + (++attributeIndex);
+            if (m_outputNormal)
+                m_json["meshes"][meshIndex]["primitives"][primitiveIndex]["attributes"]["NORMAL"] = bufferViewIndex + (++attributeIndex);
+            if (m_outputUv)
+                m_json["meshes"][meshIndex]["primitives"][primitiveIndex]["attributes"]["TEXCOORD_0"] = bufferViewIndex + (++attributeIndex);
+            if (hasVertexBoneBindings) {
+                m_json["meshes"][meshIndex]["primitives"][primitiveIndex]["attributes"]["JOINTS_0"] = bufferViewIndex + (++attributeIndex);
+                m_json["meshes"][meshIndex]["primitives"][primitiveIndex]["attributes"]["WEIGHTS_0"] = bufferViewIndex + (++attributeIndex);
+            }
+            int textureIndex = 0;
+            m_json["materials"][primitiveIndex]["pbrMetallicRoughness"]["baseColorTexture"]["index"] = textureIndex++;
+            m_json["materials"][primitiveIndex]["pbrMetallicRoughness"]["metallicFactor"] = ModelMesh::m_defaultMetalness;
+            m_json["materials"][primitiveIndex]["pbrMetallicRoughness"]["roughnessFactor"] = ModelMesh::m_defaultRoughness;
+            if (meshObject.alphaEnabled)
+                m_json["materials"][primitiveIndex]["alphaMode"] = "BLEND";
+            if (normalImage) {
+                m_json["materials"][primitiveIndex]["normalTexture"]["index"] = textureIndex++;
+            }
+            if (ormImage) {
+                m_json["materials"][primitiveIndex]["occlusionTexture"]["index"] = textureIndex;
+                m_json["materials"][primitiveIndex]["pbrMetallicRoughness"]["metallicRoughnessTexture"]["index"] = textureIndex;
+                m_json["materials"][primitiveIndex]["pbrMetallicRoughness"]["metallicFactor"] = 1.0;
+                m_json["materials"][primitiveIndex]["pbrMetallicRoughness"]["roughnessFactor"] = 1.0;
+                textureIndex++;
             }
-            m_json["bufferViews"][bufferViewIndex]["byteLength"] = m_binByteArray.size() - bufferViewFromOffset;
-            alignBin();
-            if (m_enableComment)
-                m_json["accessors"][bufferViewIndex]["__comment"] = QString("/accessors/%1: bone joints").arg(QString::number(bufferViewIndex)).toUtf8().constData();
-            m_json["accessors"][bufferViewIndex]["bufferView"] = bufferViewIndex;
-            m_json["accessors"][bufferViewIndex]["byteOffset"] = 0;
-            m_json["accessors"][bufferViewIndex]["componentType"] = 5123;
-            m_json["accessors"][bufferViewIndex]["count"] = triangleVertexOldIndices.size();
-            m_json["accessors"][bufferViewIndex]["type"] = "VEC4";
-            bufferViewIndex++;
 
-            bufferViewFromOffset = (int)m_binByteArray.size();
-            m_json["bufferViews"][bufferViewIndex]["buffer"] = 0;
-            m_json["bufferViews"][bufferViewIndex]["byteOffset"] = bufferViewFromOffset;
-            for (const auto& oldIndex : triangleVertexOldIndices) {
-                float w0 = 0.0f, w1 = 0.0f;
-                if (oldIndex < object.vertexBone1.size() && !object.vertexBone1[oldIndex].first.empty())
-                    w0 = object.vertexBone1[oldIndex].second;
-                if (oldIndex < object.vertexBone2.size() && !object.vertexBone2[oldIndex].first.empty())
-                    w1 = object.vertexBone2[oldIndex].second;
-                binStream << w0 << w1 << (float)0.0f << (float)0.0f;
+            primitiveIndex++;
+
+            // Both paths weld the triangle corners sharing every attribute into one indexed vertex
+            if (quantizeAttributes) {
+                appendQuantizedPrimitive(meshObject, objectBoneToJoint, hasVertexBoneBindings,
+                    hasRig ? rigStructure->bones.size() : 0, positionOffset, positionScale, bufferViewIndex);
+            } else {
+                appendFloatPrimitive(meshObject, objectBoneToJoint, hasVertexBoneBindings, bufferViewIndex);
             }
-            m_json["bufferViews"][bufferViewIndex]["byteLength"] = m_binByteArray.size() - bufferViewFromOffset;
-            alignBin();
-            if (m_enableComment)
-                m_json["accessors"][bufferViewIndex]["__comment"] = QString("/accessors/%1: bone weights").arg(QString::number(bufferViewIndex)).toUtf8().constData();
-            m_json["accessors"][bufferViewIndex]["bufferView"] = bufferViewIndex;
-            m_json["accessors"][bufferViewIndex]["byteOffset"] = 0;
-            m_json["accessors"][bufferViewIndex]["componentType"] = 5126;
-            m_json["accessors"][bufferViewIndex]["count"] = triangleVertexOldIndices.size();
-            m_json["accessors"][bufferViewIndex]["type"] = "VEC4";
-            bufferViewIndex++;
         }
     }
 
     if (hasRig) {
         // Inverse bind matrices
-        bufferViewFromOffset = (int)m_binByteArray.size();
-        m_json["bufferViews"][bufferViewIndex]["buffer"] = 0;
-        m_json["bufferViews"][bufferViewIndex]["byteOffset"] = bufferViewFromOffset;
+        std::vector<float> matrixValues;
+        matrixValues.reserve(rigStructure->bones.size() * 16);
         for (const auto& bone : rigStructure->bones) {
             std::string boneName = bone.name.toStdString();
             auto invIt = inverseBindMatrices->find(boneName);
-            if (invIt != inverseBindMatrices->end()) {
-                const double* d = invIt->second.constData();
-                for (int j = 0; j < 16; ++j)
-                    binStream << (float)d[j];
-            } else {
-                for (int j = 0; j < 16; ++j)
-                    binStream << (float)(j % 5 == 0 ? 1.0 : 0.0);
+            dust3d::Matrix4x4 inverseBindMatrix;
+            if (invIt != inverseBindMatrices->end())
+                inverseBindMatrix = invIt->second;
+            if (quantizeAttributes) {
+                dust3d::Matrix4x4 dequantizeMatrix;
+                double* dequantizeData = dequantizeMatrix.data();
+                dequantizeData[dust3d::Matrix4x4::M00] = positionScale;
+                dequantizeData[dust3d::Matrix4x4::M11] = positionScale;
+                dequantizeData[dust3d::Matrix4x4::M22] = positionScale;
+                inverseBindMatrix *= dequantizeMatrix.translate(positionOffset / positionScale);
             }
+            const double* d = inverseBindMatrix.constData();
+            for (int j = 0; j < 16; ++j)
+                matrixValues.push_back((float)d[j]);
         }
-        Q_ASSERT((int)rigStructure->bones.size() * 16 * sizeof(float) == m_binByteArray.size() - bufferViewFromOffset);
-        m_json["bufferViews"][bufferViewIndex]["byteLength"] = m_binByteArray.size() - bufferViewFromOffset;
-        alignBin();
+        Q_ASSERT(rigStructure->bones.size() * 16 == matrixValues.size());
+        bufferViewFromOffset = appendBinBlock(toLittleEndianByteArray(matrixValues));
+        m_json["bufferViews"][bufferViewIndex]["buffer"] = 0;
+        m_json["bufferViews"][bufferViewIndex]["byteOffset"] = bufferViewFromOffset;
+        m_json["bufferViews"][bufferViewIndex]["byteLength"] = matrixValues.size() * sizeof(float);
         if (m_enableComment)
             m_json["accessors"][bufferViewIndex]["__comment"] = QString("/accessors/%1: inverse bind matrices").arg(QString::number(bufferViewIndex)).toUtf8().constData();
         m_json["accessors"][bufferViewIndex]["bufferView"] = bufferViewIndex;
@@ -438,6 +829,34 @@ GlbFileWriter::GlbFileWriter(dust3d::Object& object,
         }
     }
 
+    if (!lodObjects.empty()) {
+        int meshNodeIndex = hasRig ? 1 : 0;
+        int lodNodeIndex = hasRig ? skeletonNodeStartIndex + (int)rigStructure->bones.size() : 1;
+        for (size_t i = 0; i < lodObjects.size(); ++i, ++lodNodeIndex) {
+            m_json["nodes"][lodNodeIndex]["mesh"] = (int)i + 1;
+            if (hasRig)
+                m_json["nodes"][lodNodeIndex]["skin"] = 0;
+            m_json["nodes"][meshNodeIndex]["extensions"]["MSFT_lod"]["ids"].push_back(lodNodeIndex);
+        }
+        m_json["extensionsUsed"].push_back("MSFT_lod");
+    }
+
+    if (quantizeAttributes) {
+        if (!hasRig) {
+            // The full mesh is on the root node, followed by the nodes of its levels of detail
+            for (size_t nodeIndex = 0; nodeIndex < meshObjects.size(); ++nodeIndex) {
+                m_json["nodes"][nodeIndex]["translation"] = { positionOffset.x(), positionOffset.y(), positionOffset.z() };
+                m_json["nodes"][nodeIndex]["scale"] = { positionScale, positionScale, positionScale };
+            }
+        }
+        m_json["extensionsUsed"].push_back("KHR_mesh_quantization");
+        m_json["extensionsRequired"].push_back("KHR_mesh_quantization");
+        if (m_meshoptCompression) {
+            m_json["extensionsUsed"].push_back("EXT_meshopt_compression");
+            m_json["extensionsRequired"].push_back("EXT_meshopt_compression");
+        }
+    }
+
     if (hasAnimation) {
         for (int animIdx = 0; animIdx < (int)animationClips->size(); ++animIdx) {
             const auto& clip = (*animationClips)[animIdx];
@@ -445,20 +864,21 @@ GlbFileWriter::GlbFileWriter(dust3d::Object& object,
 
             // Input: keyframe timestamps
             int inputAccessorIdx = bufferViewIndex;
-            bufferViewFromOffset = (int)m_binByteArray.size();
-            m_json["bufferViews"][bufferViewIndex]["buffer"] = 0;
-            m_json["bufferViews"][bufferViewIndex]["byteOffset"] = bufferViewFromOffset;
             float minTime = clip.frames.empty() ? 0.0f : clip.frames[0].time;
             float maxTime = minTime;
+            std::vector<float> times;
+            times.reserve(clip.frames.size());
             for (const auto& frame : clip.frames) {
-                binStream << frame.time;
+                times.push_back(frame.time);
                 if (frame.time < minTime)
                     minTime = frame.time;
                 if (frame.time > maxTime)
                     maxTime = frame.time;
             }
-            m_json["bufferViews"][bufferViewIndex]["byteLength"] = m_binByteArray.size() - bufferViewFromOffset;
-            alignBin();
+            bufferViewFromOffset = appendBinBlock(toLittleEndianByteArray(times));
+            m_json["bufferViews"][bufferViewIndex]["buffer"] = 0;
+            m_json["bufferViews"][bufferViewIndex]["byteOffset"] = bufferViewFromOffset;
+            m_json["bufferViews"][bufferViewIndex]["byteLength"] = times.size() * sizeof(float);
             m_json["accessors"][bufferViewIndex]["bufferView"] = bufferViewIndex;
             m_json["accessors"][bufferViewIndex]["byteOffset"] = 0;
             m_json["accessors"][bufferViewIndex]["componentType"] = 5126;
@@ -477,10 +897,10 @@ GlbFileWriter::GlbFileWriter(dust3d::Object& object,
                 std::string parentName = bone.parent.toStdString();
                 int nodeIdx = skeletonNodeStartIndex + (int)boneIdx;
 
-                // Translation output
-                bufferViewFromOffset = (int)m_binByteArray.size();
-                m_json["bufferViews"][bufferViewIndex]["buffer"] = 0;
-                m_json["bufferViews"][bufferViewIndex]["byteOffset"] = bufferViewFromOffset;
+                std::vector<float> translations;
+                std::vector<float> rotations;
+                translations.reserve(clip.frames.size() * 3);
+                rotations.reserve(clip.frames.size() * 4);
                 for (const auto& frame : clip.frames) {
                     dust3d::Matrix4x4 worldTransform;
                     auto worldIt = frame.boneWorldTransforms.find(boneName);
@@ -489,10 +909,15 @@ GlbFileWriter::GlbFileWriter(dust3d::Object& object,
                     dust3d::Matrix4x4 localTransform = computeLocalTransform(parentName, worldTransform, frame.boneWorldTransforms);
                     float tx, ty, tz, qx, qy, qz, qw;
                     matrixToTranslationAndRotation(localTransform, tx, ty, tz, qx, qy, qz, qw);
-                    binStream << tx << ty << tz;
+                    translations.insert(translations.end(), { tx, ty, tz });
+                    rotations.insert(rotations.end(), { qx, qy, qz, qw });
                 }
-                m_json["bufferViews"][bufferViewIndex]["byteLength"] = m_binByteArray.size() - bufferViewFromOffset;
-                alignBin();
+
+                // Translation output
+                bufferViewFromOffset = appendBinBlock(toLittleEndianByteArray(translations));
+                m_json["bufferViews"][bufferViewIndex]["buffer"] = 0;
+                m_json["bufferViews"][bufferViewIndex]["byteOffset"] = bufferViewFromOffset;
+                m_json["bufferViews"][bufferViewIndex]["byteLength"] = translations.size() * sizeof(float);
                 m_json["accessors"][bufferViewIndex]["bufferView"] = bufferViewIndex;
                 m_json["accessors"][bufferViewIndex]["byteOffset"] = 0;
                 m_json["accessors"][bufferViewIndex]["componentType"] = 5126;
@@ -502,21 +927,10 @@ GlbFileWriter::GlbFileWriter(dust3d::Object& object,
                 bufferViewIndex++;
 
                 // Rotation output
-                bufferViewFromOffset = (int)m_binByteArray.size();
+                bufferViewFromOffset = appendBinBlock(toLittleEndianByteArray(rotations));
                 m_json["bufferViews"][bufferViewIndex]["buffer"] = 0;
                 m_json["bufferViews"][bufferViewIndex]["byteOffset"] = bufferViewFromOffset;
-                for (const auto& frame : clip.frames) {
-                    dust3d::Matrix4x4 worldTransform;
-                    auto worldIt = frame.boneWorldTransforms.find(boneName);
-                    if (worldIt != frame.boneWorldTransforms.end())
-                        worldTransform = worldIt->second;
-                    dust3d::Matrix4x4 localTransform = computeLocalTransform(parentName, worldTransform, frame.boneWorldTransforms);
-                    float tx, ty, tz, qx, qy, qz, qw;
-                    matrixToTranslationAndRotation(localTransform, tx, ty, tz, qx, qy, qz, qw);
-                    binStream << qx << qy << qz << qw;
-                }
-                m_json["bufferViews"][bufferViewIndex]["byteLength"] = m_binByteArray.size() - bufferViewFromOffset;
-                alignBin();
+                m_json["bufferViews"][bufferViewIndex]["byteLength"] = rotations.size() * sizeof(float);
                 m_json["accessors"][bufferViewIndex]["bufferView"] = bufferViewIndex;
                 m_json["accessors"][bufferViewIndex]["byteOffset"] = 0;
                 m_json["accessors"][bufferViewIndex]["componentType"] = 5126;
@@ -559,15 +973,13 @@ GlbFileWriter::GlbFileWriter(dust3d::Object& object,
         m_json["textures"][textureIndex]["sampler"] = 0;
         m_json["textures"][textureIndex]["source"] = imageIndex;
 
-        bufferViewFromOffset = (int)m_binByteArray.size();
-        m_json["bufferViews"][bufferViewIndex]["buffer"] = 0;
-        m_json["bufferViews"][bufferViewIndex]["byteOffset"] = bufferViewFromOffset;
         QByteArray pngByteArray;
         QBuffer buffer(&pngByteArray);
         textureImage->save(&buffer, "PNG");
-        binStream.writeRawData(pngByteArray.data(), pngByteArray.size());
-        alignBin();
-        m_json["bufferViews"][bufferViewIndex]["byteLength"] = m_binByteArray.size() - bufferViewFromOffset;
+        bufferViewFromOffset = appendBinBlock(pngByteArray);
+        m_json["bufferViews"][bufferViewIndex]["buffer"] = 0;
+        m_json["bufferViews"][bufferViewIndex]["byteOffset"] = bufferViewFromOffset;
+        m_json["bufferViews"][bufferViewIndex]["byteLength"] = alignedBinSize(pngByteArray.size());
         m_json["images"][imageIndex]["bufferView"] = bufferViewIndex;
         m_json["images"][imageIndex]["mimeType"] = "image/png";
         bufferViewIndex++;
@@ -579,15 +991,13 @@ GlbFileWriter::GlbFileWriter(dust3d::Object& object,
         m_json["textures"][textureIndex]["sampler"] = 0;
         m_json["textures"][textureIndex]["source"] = imageIndex;
 
-        bufferViewFromOffset = (int)m_binByteArray.size();
-        m_json["bufferViews"][bufferViewIndex]["buffer"] = 0;
-        m_json["bufferViews"][bufferViewIndex]["byteOffset"] = bufferViewFromOffset;
         QByteArray pngByteArray;
         QBuffer buffer(&pngByteArray);
         normalImage->save(&buffer, "PNG");
-        binStream.writeRawData(pngByteArray.data(), pngByteArray.size());
-        alignBin();
-        m_json["bufferViews"][bufferViewIndex]["byteLength"] = m_binByteArray.size() - bufferViewFromOffset;
+        bufferViewFromOffset = appendBinBlock(pngByteArray);
+        m_json["bufferViews"][bufferViewIndex]["buffer"] = 0;
+        m_json["bufferViews"][bufferViewIndex]["byteOffset"] = bufferViewFromOffset;
+        m_json["bufferViews"][bufferViewIndex]["byteLength"] = alignedBinSize(pngByteArray.size());
         m_json["images"][imageIndex]["bufferView"] = bufferViewIndex;
         m_json["images"][imageIndex]["mimeType"] = "image/png";
         bufferViewIndex++;
@@ -599,15 +1009,13 @@ GlbFileWriter::GlbFileWriter(dust3d::Object& object,
         m_json["textures"][textureIndex]["sampler"] = 0;
         m_json["textures"][textureIndex]["source"] = imageIndex;
 
-        bufferViewFromOffset = (int)m_binByteArray.size();
-        m_json["bufferViews"][bufferViewIndex]["buffer"] = 0;
-        m_json["bufferViews"][bufferViewIndex]["byteOffset"] = bufferViewFromOffset;
         QByteArray pngByteArray;
         QBuffer buffer(&pngByteArray);
         ormImage->save(&buffer, "PNG");
-        binStream.writeRawData(pngByteArray.data(), pngByteArray.size());
-        alignBin();
-        m_json["bufferViews"][bufferViewIndex]["byteLength"] = m_binByteArray.size() - bufferViewFromOffset;
+        bufferViewFromOffset = appendBinBlock(pngByteArray);
+        m_json["bufferViews"][bufferViewIndex]["buffer"] = 0;
+        m_json["bufferViews"][bufferViewIndex]["byteOffset"] = bufferViewFromOffset;
+        m_json["bufferViews"][bufferViewIndex]["byteLength"] = alignedBinSize(pngByteArray.size());
         m_json["images"][imageIndex]["bufferView"] = bufferViewIndex;
         m_json["images"][imageIndex]["mimeType"] = "image/png";
         bufferViewIndex++;
@@ -616,11 +1024,14 @@ GlbFileWriter::GlbFileWriter(dust3d::Object& object,
         textureIndex++;
     }
 
-    m_json["buffers"][0]["byteLength"] = m_binByteArray.size();
+    m_json["buffers"][0]["byteLength"] = m_binByteLength;
+    if (m_fallbackByteLength > 0) {
+        m_json["buffers"][1]["byteLength"] = m_fallbackByteLength;
+        m_json["buffers"][1]["extensions"]["EXT_meshopt_compression"]["fallback"] = true;
+    }
 
-    auto jsonString = m_enableComment ? m_json.dump(4) : m_json.dump();
-    jsonStream.writeRawData(jsonString.data(), jsonString.size());
-    alignJson();
+    m_jsonString = m_enableComment ? m_json.dump(4) : m_json.dump();
+    m_jsonString.resize(alignedBinSize((int)m_jsonString.size()), ' ');
 }
 
 bool GlbFileWriter::save(QDataStream& output)
@@ -631,10 +1042,10 @@ bool GlbFileWriter::save(QDataStream& output)
     uint32_t headerSize = 12;
     uint32_t chunk0DescriptionSize = 8;
     uint32_t chunk1DescriptionSize = 8;
-    uint32_t fileSize = headerSize + chunk0DescriptionSize + m_jsonByteArray.size() + chunk1DescriptionSize + m_binByteArray.size();
+    uint32_t fileSize = headerSize + chunk0DescriptionSize + m_jsonString.size() + chunk1DescriptionSize + m_binByteLength;
 
-    qDebug() << "Chunk 0 data size:" << m_jsonByteArray.size();
-    qDebug() << "Chunk 1 data size:" << m_binByteArray.size();
+    qDebug() << "Chunk 0 data size:" << m_jsonString.size();
+    qDebug() << "Chunk 1 data size:" << m_binByteLength;
     qDebug() << "File size:" << fileSize;
 
     //////////// Header ////////////
@@ -651,26 +1062,30 @@ bool GlbFileWriter::save(QDataStream& output)
     //////////// Chunk 0 (Json) ////////////
 
     // length
-    output << (uint32_t)m_jsonByteArray.size();
+    output << (uint32_t)m_jsonString.size();
 
     // type
     output << (uint32_t)0x4E4F534A;
 
     // data
-    output.writeRawData(m_jsonByteArray.data(), m_jsonByteArray.size());
+    output.writeRawData(m_jsonString.data(), (int)m_jsonString.size());
 
     //////////// Chunk 1 (Binary Buffer) ///
 
     // length
-    output << (uint32_t)m_binByteArray.size();
+    output << (uint32_t)m_binByteLength;
 
     // type
     output << (uint32_t)0x004E4942;
 
-    // data
-    output.writeRawData(m_binByteArray.data(), m_binByteArray.size());
+    // data, block by block straight into the output
+    const char padding[4] = { 0, 0, 0, 0 };
+    for (const auto& block : m_binBlocks) {
+        output.writeRawData(block.constData(), block.size());
+        output.writeRawData(padding, alignedBinSize(block.size()) - block.size());
+    }
 
-    return true;
+    return QDataStream::Ok == output.status();
 }
 
 bool GlbFileWriter::save()
@@ -14,6 +14,7 @@
 #include <dust3d/base/matrix4x4.h>
 #include <dust3d/base/object.h>
 #include <map>
+#include <string>
 #include <vector>
 
 class GlbFileWriter : public QObject {
@@ -26,16 +27,46 @@ public:
         QImage* ormImage = nullptr,
         const RigStructure* rigStructure = nullptr,
         const std::map<std::string, dust3d::Matrix4x4>* inverseBindMatrices = nullptr,
-        const std::vector<dust3d::RigAnimationClip>* animationClips = nullptr);
+        const std::vector<dust3d::RigAnimationClip>* animationClips = nullptr,
+        const std::vector<float>& lodRatios = std::vector<float>(),
+        bool quantizeAttributes = false,
+        bool meshoptCompression = false);
     bool save();
     bool save(QDataStream& output);
 
 private:
     QString m_filename;
+    // Triangle ratios of the simplified levels of detail written after the full mesh, through MSFT_lod
+    std::vector<float> m_lodRatios;
+    // Write welded vertices with 16-bit positions and UVs and 8-bit normals and weights, through KHR_mesh_quantization
+    bool m_quantizeAttributes = false;
+    // Compress the quantized vertex and index buffer views, through EXT_meshopt_compression
+    bool m_meshoptCompression = false;
     bool m_outputNormal = true;
     bool m_outputUv = true;
-    QByteArray m_binByteArray;
-    QByteArray m_jsonByteArray;
+    // The BIN chunk is kept as one block per buffer view and only joined while saving,
+    // each block is followed by the zero padding which keeps the next one 4-byte aligned
+    std::vector<QByteArray> m_binBlocks;
+    int m_binByteLength = 0;
+    // Byte length of the uncompressed fallback buffer the meshopt compressed buffer views refer to
+    int m_fallbackByteLength = 0;
+    std::string m_jsonString;
+
+    int appendBinBlock(const QByteArray& block);
+    void appendVertexBufferView(int bufferViewIndex, const QByteArray& block, int byteStride, size_t count);
+    void appendIndexBufferView(int bufferViewIndex, const std::vector<uint32_t>& indices, bool useIntIndices);
+    void appendMeshoptBufferView(int bufferViewIndex, const std::vector<uint8_t>& encoded, int byteLength, int byteStride, size_t count, const char* mode);
+    void appendFloatPrimitive(const dust3d::Object& object,
+        const std::vector<int>& objectBoneToJoint,
+        bool hasVertexBoneBindings,
+        int& bufferViewIndex);
+    void appendQuantizedPrimitive(const dust3d::Object& object,
+        const std::vector<int>& objectBoneToJoint,
+        bool hasVertexBoneBindings,
+        size_t jointCount,
+        const dust3d::Vector3& positionOffset,
+        double positionScale,
+        int& bufferViewIndex);
 
 private:
     nlohmann::json m_json;
@@ -1,4 +1,5 @@
 #include "glb_forever.h"
+#include "mesh_generator.h"
 #include <QMutex>
 #include <QMutexLocker>
 #include <map>
@@ -40,4 +41,5 @@ void GlbForever::remove(const dust3d::Uuid& id)
         return;
     delete findGlb->second.data;
     g_glbForeverMap.erase(id);
+    MeshGenerator::removeGlbCache(id.toString());
 }
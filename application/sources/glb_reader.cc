@@ -1,6 +1,6 @@
 #include "glb_reader.h"
-#include "json.hpp"
-#include <QDebug>
+#include <QColor>
+#include <algorithm>
 #include <cstring>
 
 using json = nlohmann::json;
@@ -54,35 +54,66 @@ static size_t componentByteSize(int componentType)
     }
 }
 
-bool GlbReader::read(const QByteArray& data, dust3d::MeshGenerator::ImportedModelData& result, QImage* textureImage)
+static bool isIndexComponentType(int componentType)
 {
-    if (data.size() < 12)
-        return false;
+    return 5121 == componentType || 5123 == componentType || 5125 == componentType;
+}
+
+// Normalized integers map to [0, 1] when unsigned and [-1, 1] when signed, as the glTF specification defines
+static double readComponent(const uint8_t* ptr, int componentType, bool normalized)
+{
+    switch (componentType) {
+    case 5120: {
+        int8_t value = (int8_t)*ptr;
+        return normalized ? std::max(value / 127.0, -1.0) : (double)value;
+    }
+    case 5121:
+        return normalized ? *ptr / 255.0 : (double)*ptr;
+    case 5122: {
+        int16_t value = readUnaligned<int16_t>(ptr);
+        return normalized ? std::max(value / 32767.0, -1.0) : (double)value;
+    }
+    case 5123: {
+        uint16_t value = readUnaligned<uint16_t>(ptr);
+        return normalized ? value / 65535.0 : (double)value;
+    }
+    case 5125:
+        return (double)readUnaligned<uint32_t>(ptr);
+    case 5126:
+        return (double)readUnaligned<float>(ptr);
+    default:
+        return 0.0;
+    }
+}
+
+GlbReader::GlbReader(const QByteArray& data)
+    : m_data(data)
+{
+    if (m_data.size() < 12)
+        return;
 
-    const uint8_t* ptr = (const uint8_t*)data.constData();
-    const size_t dataSize = (size_t)data.size();
+    const uint8_t* ptr = (const uint8_t*)m_data.constData();
+    const size_t dataSize = (size_t)m_data.size();
 
     uint32_t magic;
     memcpy(&magic, ptr, 4);
     if (magic != 0x46546C67) // "glTF"
-        return false;
+        return;
 
     uint32_t version;
     memcpy(&version, ptr + 4, 4);
     if (version != 2)
-        return false;
+        return;
 
     uint32_t totalLength;
     memcpy(&totalLength, ptr + 8, 4);
 
     if ((size_t)totalLength > dataSize)
-        return false;
+        return;
 
     // Parse chunks
     const uint8_t* jsonChunkData = nullptr;
     uint32_t jsonChunkLength = 0;
-    const uint8_t* binChunkData = nullptr;
-    uint32_t binChunkLength = 0;
 
     size_t offset = 12;
     while (offset + 8 <= totalLength) {
@@ -94,87 +125,201 @@ bool GlbReader::read(const QByteArray& data, dust3d::MeshGenerator::ImportedMode
         // Validate chunk data fits within the file
         size_t chunkDataEnd = offset + 8 + (size_t)chunkLength;
         if (chunkDataEnd < offset + 8 || chunkDataEnd > totalLength)
-            return false; // Overflow or out-of-bounds chunk
+            return; // Overflow or out-of-bounds chunk
 
         if (chunkType == 0x4E4F534A) { // "JSON"
             jsonChunkData = ptr + offset + 8;
             jsonChunkLength = chunkLength;
         } else if (chunkType == 0x004E4942) { // "BIN\0"
-            binChunkData = ptr + offset + 8;
-            binChunkLength = chunkLength;
+            m_binChunkData = ptr + offset + 8;
+            m_binChunkLength = chunkLength;
         }
         offset = chunkDataEnd;
     }
 
-    if (!jsonChunkData || !binChunkData)
-        return false;
+    if (!jsonChunkData || !m_binChunkData)
+        return;
 
-    json gltf;
     try {
-        gltf = json::parse(jsonChunkData, jsonChunkData + jsonChunkLength);
+        m_gltf = json::parse(jsonChunkData, jsonChunkData + jsonChunkLength);
     } catch (...) {
-        return false;
+        return;
     }
 
-    if (!gltf.count("accessors") || !gltf.count("bufferViews"))
-        return false;
+    if (!m_gltf.is_object() || !m_gltf.count("accessors") || !m_gltf.count("bufferViews"))
+        return;
 
-    if (!gltf.count("meshes") || gltf["meshes"].empty())
-        return false;
+    if (!m_gltf.count("meshes") || !m_gltf["meshes"].is_array() || m_gltf["meshes"].empty())
+        return;
+
+    m_isValid = true;
+}
 
-    // Safe accessor reader: validates array indices, type/componentType match, and full byte range
-    auto getAccessor = [&](int accessorIndex, int expectedComponentType, const std::string& expectedType) -> std::pair<const uint8_t*, size_t> {
-        if (accessorIndex < 0 || accessorIndex >= (int)gltf["accessors"].size())
-            return { nullptr, 0 };
+bool GlbReader::isValid() const
+{
+    return m_isValid;
+}
+
+const json* GlbReader::findElement(const char* arrayName, const json& index) const
+{
+    if (!index.is_number_integer())
+        return nullptr;
+    auto findArray = m_gltf.find(arrayName);
+    if (findArray == m_gltf.end() || !findArray->is_array())
+        return nullptr;
+    int64_t i = index.get<int64_t>();
+    if (i < 0 || i >= (int64_t)findArray->size())
+        return nullptr;
+    const json& element = (*findArray)[(size_t)i];
+    if (!element.is_object())
+        return nullptr;
+    return &element;
+}
 
-        const auto& accessor = gltf["accessors"][accessorIndex];
-        if (!accessor.count("bufferView") || !accessor.count("count") || !accessor.count("componentType") || !accessor.count("type"))
-            return { nullptr, 0 };
+bool GlbReader::resolveBufferView(const json& index, BufferView* bufferView) const
+{
+    const json* view = findElement("bufferViews", index);
+    if (nullptr == view)
+        return false;
 
-        int bufferViewIndex = accessor["bufferView"];
-        if (bufferViewIndex < 0 || bufferViewIndex >= (int)gltf["bufferViews"].size())
-            return { nullptr, 0 };
+    // Only the BIN chunk is read, buffers with an uri or compressed views have nothing in it
+    if (0 != view->value("buffer", 0) || view->count("extensions"))
+        return false;
 
-        size_t count = accessor["count"];
-        int compType = accessor["componentType"];
-        std::string type = accessor["type"];
+    size_t byteOffset = view->value("byteOffset", (size_t)0);
+    size_t byteLength = view->value("byteLength", (size_t)0);
+    if (byteOffset > m_binChunkLength || byteLength > m_binChunkLength - byteOffset)
+        return false;
 
-        if (compType != expectedComponentType || type != expectedType)
-            return { nullptr, 0 };
+    bufferView->data = m_binChunkData + byteOffset;
+    bufferView->byteLength = byteLength;
+    bufferView->byteStride = view->value("byteStride", (size_t)0);
+    return true;
+}
 
-        size_t numComponents = componentCount(type);
-        size_t compSize = componentByteSize(compType);
-        if (numComponents == 0 || compSize == 0)
-            return { nullptr, 0 };
+size_t GlbReader::accessorCount(const json& index) const
+{
+    const json* accessor = findElement("accessors", index);
+    if (nullptr == accessor)
+        return 0;
+    size_t count = accessor->value("count", (size_t)0);
+    // Accessors without a buffer view are zeros, don't let one claim more elements than the file could describe
+    if (!accessor->count("bufferView") && count > m_binChunkLength)
+        return 0;
+    return count;
+}
 
-        size_t elementSize = numComponents * compSize;
+// Calls store(elementIndex, components) for every element, converting all component types to double;
+// an element replaced by a sparse accessor is stored again with its new value
+template <typename Store>
+bool GlbReader::decodeAccessor(const json& index, size_t expectedComponentCount, Store store) const
+{
+    const json* accessor = findElement("accessors", index);
+    if (nullptr == accessor)
+        return false;
 
-        const auto& bufferView = gltf["bufferViews"][bufferViewIndex];
-        size_t byteOffset = bufferView.value("byteOffset", 0);
-        size_t accessorByteOffset = accessor.value("byteOffset", 0);
+    size_t count = accessorCount(index);
+    int componentType = accessor->value("componentType", 0);
+    size_t components = componentCount(accessor->value("type", std::string()));
+    size_t componentSize = componentByteSize(componentType);
+    if (components != expectedComponentCount || 0 == componentSize)
+        return false;
+    bool normalized = accessor->value("normalized", false);
+    size_t elementSize = components * componentSize;
+
+    double values[16] = { 0.0 };
+    if (accessor->count("bufferView")) {
+        BufferView view;
+        if (!resolveBufferView((*accessor)["bufferView"], &view))
+            return false;
+        size_t byteOffset = accessor->value("byteOffset", (size_t)0);
+        size_t stride = 0 == view.byteStride ? elementSize : view.byteStride;
+        if (stride < elementSize)
+            return false;
+        if (count > 0) {
+            if (byteOffset > view.byteLength || view.byteLength - byteOffset < elementSize)
+                return false;
+            if (count - 1 > (view.byteLength - byteOffset - elementSize) / stride)
+                return false;
+        }
+        const uint8_t* element = view.data + byteOffset;
+        if (5126 == componentType && !normalized) {
+            for (size_t i = 0; i < count; ++i, element += stride) {
+                for (size_t c = 0; c < components; ++c)
+                    values[c] = (double)readUnaligned<float>(element + c * sizeof(float));
+                store(i, values);
+            }
+        } else {
+            for (size_t i = 0; i < count; ++i, element += stride) {
+                for (size_t c = 0; c < components; ++c)
+                    values[c] = readComponent(element + c * componentSize, componentType, normalized);
+                store(i, values);
+            }
+        }
+    } else {
+        for (size_t i = 0; i < count; ++i)
+            store(i, values);
+    }
 
-        size_t startOffset = byteOffset + accessorByteOffset;
-        if (startOffset < byteOffset) // overflow check
-            return { nullptr, 0 };
+    if (accessor->count("sparse")) {
+        const json& sparse = (*accessor)["sparse"];
+        if (!sparse.is_object() || !sparse.count("indices") || !sparse.count("values"))
+            return false;
+        const json& sparseIndices = sparse["indices"];
+        const json& sparseValues = sparse["values"];
+        if (!sparseIndices.is_object() || !sparseValues.is_object())
+            return false;
+        size_t sparseCount = sparse.value("count", (size_t)0);
+        int indexComponentType = sparseIndices.value("componentType", 0);
+        if (!isIndexComponentType(indexComponentType))
+            return false;
+        size_t indexSize = componentByteSize(indexComponentType);
+
+        BufferView indexView;
+        BufferView valueView;
+        if (!sparseIndices.count("bufferView") || !resolveBufferView(sparseIndices["bufferView"], &indexView))
+            return false;
+        if (!sparseValues.count("bufferView") || !resolveBufferView(sparseValues["bufferView"], &valueView))
+            return false;
+        size_t indexOffset = sparseIndices.value("byteOffset", (size_t)0);
+        size_t valueOffset = sparseValues.value("byteOffset", (size_t)0);
+        if (indexOffset > indexView.byteLength || sparseCount > (indexView.byteLength - indexOffset) / indexSize)
+            return false;
+        if (valueOffset > valueView.byteLength || sparseCount > (valueView.byteLength - valueOffset) / elementSize)
+            return false;
+
+        const uint8_t* indexData = indexView.data + indexOffset;
+        const uint8_t* valueData = valueView.data + valueOffset;
+        for (size_t i = 0; i < sparseCount; ++i) {
+            size_t target = (size_t)readComponent(indexData + i * indexSize, indexComponentType, false);
+            if (target >= count)
+                return false;
+            for (size_t c = 0; c < components; ++c)
+                values[c] = readComponent(valueData + i * elementSize + c * componentSize, componentType, normalized);
+            store(target, values);
+        }
+    }
 
-        // Validate the full data range fits within the BIN chunk
-        size_t totalBytes = count * elementSize;
-        if (count > 0 && totalBytes / count != elementSize) // overflow check
-            return { nullptr, 0 };
-        if (startOffset + totalBytes < startOffset) // overflow check
-            return { nullptr, 0 };
-        if (startOffset + totalBytes > binChunkLength)
-            return { nullptr, 0 };
+    return true;
+}
 
-        return { binChunkData + startOffset, count };
-    };
+bool GlbReader::readMesh(dust3d::MeshGenerator::ImportedModelData& result) const
+{
+    if (!m_isValid)
+        return false;
 
-    const auto& mesh = gltf["meshes"][0];
-    if (!mesh.count("primitives") || mesh["primitives"].empty())
+    const json& mesh = m_gltf["meshes"][0];
+    if (!mesh.is_object() || !mesh.count("primitives") || !mesh["primitives"].is_array())
         return false;
 
+    // Normals are only kept when every primitive has them, or the generator could not tell which are missing
+    bool hasAllNormals = true;
     for (const auto& primitive : mesh["primitives"]) {
-        if (!primitive.count("attributes"))
+        if (!primitive.is_object() || !primitive.count("attributes") || !primitive["attributes"].is_object())
+            continue;
+
+        // Only triangle lists are imported
+        if (4 != primitive.value("mode", 4))
             continue;
 
         const auto& attributes = primitive["attributes"];
@@ -182,214 +327,149 @@ bool GlbReader::read(const QByteArray& data, dust3d::MeshGenerator::ImportedMode
         // Read positions
         if (!attributes.count("POSITION"))
             continue;
-        auto [posData, posCount] = getAccessor(attributes["POSITION"], 5126, "VEC3"); // FLOAT, VEC3
-        if (!posData || posCount == 0)
+        size_t posCount = accessorCount(attributes["POSITION"]);
+        if (0 == posCount)
             continue;
-
         size_t baseVertex = result.vertices.size();
-        for (size_t i = 0; i < posCount; ++i) {
-            float x = readUnaligned<float>(posData + i * 3 * sizeof(float));
-            float y = readUnaligned<float>(posData + i * 3 * sizeof(float) + sizeof(float));
-            float z = readUnaligned<float>(posData + i * 3 * sizeof(float) + 2 * sizeof(float));
-            result.vertices.emplace_back((double)x, (double)y, (double)z);
+        result.vertices.resize(baseVertex + posCount);
+        dust3d::Vector3* positions = result.vertices.data() + baseVertex;
+        if (!decodeAccessor(attributes["POSITION"], 3, [&](size_t i, const double* value) {
+                positions[i] = dust3d::Vector3(value[0], value[1], value[2]);
+            })) {
+            result.vertices.resize(baseVertex);
+            continue;
         }
 
         // Read normals
-        if (attributes.count("NORMAL")) {
-            auto [normData, normCount] = getAccessor(attributes["NORMAL"], 5126, "VEC3");
-            if (normData && normCount == posCount) {
-                size_t prevSize = result.vertexNormals.size();
-                result.vertexNormals.resize(prevSize + posCount);
-                for (size_t i = 0; i < posCount; ++i) {
-                    float nx = readUnaligned<float>(normData + i * 3 * sizeof(float));
-                    float ny = readUnaligned<float>(normData + i * 3 * sizeof(float) + sizeof(float));
-                    float nz = readUnaligned<float>(normData + i * 3 * sizeof(float) + 2 * sizeof(float));
-                    result.vertexNormals[prevSize + i] = dust3d::Vector3((double)nx, (double)ny, (double)nz);
-                }
-            }
+        if (hasAllNormals) {
+            result.vertexNormals.resize(baseVertex + posCount);
+            dust3d::Vector3* normals = result.vertexNormals.data() + baseVertex;
+            hasAllNormals = attributes.count("NORMAL")
+                && accessorCount(attributes["NORMAL"]) == posCount
+                && decodeAccessor(attributes["NORMAL"], 3, [&](size_t i, const double* value) {
+                       normals[i] = dust3d::Vector3(value[0], value[1], value[2]);
+                   });
         }
 
-        // Read vertex colors
-        if (attributes.count("COLOR_0")) {
-            int colorAccessorIndex = (int)attributes["COLOR_0"];
-            if (colorAccessorIndex >= 0 && colorAccessorIndex < (int)gltf["accessors"].size()) {
-                const auto& colorAccessor = gltf["accessors"][colorAccessorIndex];
-                int colorComponentType = colorAccessor.value("componentType", 0);
-                std::string colorType = colorAccessor.value("type", "");
-                size_t colorCount = colorAccessor.value("count", (size_t)0);
-
-                if (colorAccessor.count("bufferView") && colorCount == posCount) {
-                    int colorBufView = colorAccessor["bufferView"];
-                    if (colorBufView >= 0 && colorBufView < (int)gltf["bufferViews"].size()) {
-                        const auto& colorBufViewObj = gltf["bufferViews"][colorBufView];
-                        size_t colorByteOffset = colorBufViewObj.value("byteOffset", 0) + colorAccessor.value("byteOffset", 0);
-
-                        int stride = (colorType == "VEC4") ? 4 : 3;
-                        size_t colorCompSize = componentByteSize(colorComponentType);
-                        size_t colorElementSize = stride * colorCompSize;
-                        size_t colorTotalBytes = posCount * colorElementSize;
-
-                        // Validate full color data range
-                        if (colorCompSize > 0
-                            && colorByteOffset >= (size_t)colorBufViewObj.value("byteOffset", 0) // no overflow
-                            && (posCount == 0 || colorTotalBytes / posCount == colorElementSize) // no overflow
-                            && colorByteOffset + colorTotalBytes >= colorByteOffset // no overflow
-                            && colorByteOffset + colorTotalBytes <= binChunkLength) {
-
-                            const uint8_t* colorData = binChunkData + colorByteOffset;
-
-                            size_t prevSize = result.vertexColors.size();
-                            result.vertexColors.resize(prevSize + posCount, dust3d::Color(1.0, 1.0, 1.0));
-
-                            if (colorComponentType == 5126 && (colorType == "VEC3" || colorType == "VEC4")) {
-                                for (size_t i = 0; i < posCount; ++i) {
-                                    float cr = readUnaligned<float>(colorData + i * stride * sizeof(float));
-                                    float cg = readUnaligned<float>(colorData + i * stride * sizeof(float) + sizeof(float));
-                                    float cb = readUnaligned<float>(colorData + i * stride * sizeof(float) + 2 * sizeof(float));
-                                    result.vertexColors[prevSize + i] = dust3d::Color(cr, cg, cb);
-                                }
-                            } else if (colorComponentType == 5121 && (colorType == "VEC3" || colorType == "VEC4")) {
-                                for (size_t i = 0; i < posCount; ++i) {
-                                    result.vertexColors[prevSize + i] = dust3d::Color(
-                                        colorData[i * stride] / 255.0,
-                                        colorData[i * stride + 1] / 255.0,
-                                        colorData[i * stride + 2] / 255.0);
-                                }
-                            }
-                        }
-                    }
-                }
+        // Read vertex colors, which may come with or without alpha
+        if (attributes.count("COLOR_0") && accessorCount(attributes["COLOR_0"]) == posCount) {
+            size_t prevSize = result.vertexColors.size();
+            result.vertexColors.resize(baseVertex + posCount, dust3d::Color(1.0, 1.0, 1.0));
+            dust3d::Color* colors = result.vertexColors.data() + baseVertex;
+            auto storeColor = [&](size_t i, const double* value) {
+                colors[i] = dust3d::Color(value[0], value[1], value[2]);
+            };
+            if (!decodeAccessor(attributes["COLOR_0"], 3, storeColor)
+                && !decodeAccessor(attributes["COLOR_0"], 4, storeColor)) {
+                result.vertexColors.resize(prevSize);
             }
         }
 
         // Read UVs
         std::vector<dust3d::Vector2> uvs;
-        if (attributes.count("TEXCOORD_0")) {
-            auto [uvData, uvCount] = getAccessor(attributes["TEXCOORD_0"], 5126, "VEC2");
-            if (uvData && uvCount == posCount) {
-                uvs.resize(uvCount);
-                for (size_t i = 0; i < uvCount; ++i) {
-                    float u = readUnaligned<float>(uvData + i * 2 * sizeof(float));
-                    float v = readUnaligned<float>(uvData + i * 2 * sizeof(float) + sizeof(float));
-                    uvs[i] = dust3d::Vector2(u, v);
-                }
-            }
+        if (attributes.count("TEXCOORD_0") && accessorCount(attributes["TEXCOORD_0"]) == posCount) {
+            uvs.resize(posCount);
+            if (!decodeAccessor(attributes["TEXCOORD_0"], 2, [&](size_t i, const double* value) {
+                    uvs[i] = dust3d::Vector2(value[0], value[1]);
+                }))
+                uvs.clear();
         }
 
         // Read indices
+        size_t baseTriangle = result.triangles.size();
         if (primitive.count("indices")) {
-            int indicesAccessorIndex = primitive["indices"];
-            if (indicesAccessorIndex >= 0 && indicesAccessorIndex < (int)gltf["accessors"].size()) {
-                const auto& accessor = gltf["accessors"][indicesAccessorIndex];
-                int compType = accessor.value("componentType", 0);
-                size_t count = accessor.value("count", (size_t)0);
-
-                if (accessor.count("bufferView")) {
-                    int bufferViewIndex = accessor["bufferView"];
-                    if (bufferViewIndex >= 0 && bufferViewIndex < (int)gltf["bufferViews"].size()) {
-                        const auto& bufferView = gltf["bufferViews"][bufferViewIndex];
-                        size_t byteOffset = bufferView.value("byteOffset", 0);
-                        size_t accessorByteOffset = accessor.value("byteOffset", 0);
-                        size_t startOffset = byteOffset + accessorByteOffset;
-
-                        // Determine element size and validate full range
-                        size_t indexSize = componentByteSize(compType);
-                        if (indexSize > 0 && startOffset >= byteOffset) {
-                            size_t totalBytes = count * indexSize;
-                            if (count == 0 || totalBytes / count == indexSize) {
-                                if (startOffset + totalBytes >= startOffset && startOffset + totalBytes <= binChunkLength) {
-                                    const uint8_t* indexData = binChunkData + startOffset;
-
-                                    for (size_t i = 0; i + 2 < count; i += 3) {
-                                        size_t i0, i1, i2;
-                                        if (compType == 5123) { // UNSIGNED_SHORT
-                                            i0 = readUnaligned<uint16_t>(indexData + i * sizeof(uint16_t));
-                                            i1 = readUnaligned<uint16_t>(indexData + (i + 1) * sizeof(uint16_t));
-                                            i2 = readUnaligned<uint16_t>(indexData + (i + 2) * sizeof(uint16_t));
-                                        } else if (compType == 5125) { // UNSIGNED_INT
-                                            i0 = readUnaligned<uint32_t>(indexData + i * sizeof(uint32_t));
-                                            i1 = readUnaligned<uint32_t>(indexData + (i + 1) * sizeof(uint32_t));
-                                            i2 = readUnaligned<uint32_t>(indexData + (i + 2) * sizeof(uint32_t));
-                                        } else {
-                                            continue;
-                                        }
-
-                                        // Validate indices are within vertex bounds
-                                        if (i0 >= posCount || i1 >= posCount || i2 >= posCount)
-                                            continue;
-
-                                        result.faces.push_back({ baseVertex + i0, baseVertex + i1, baseVertex + i2 });
-
-                                        if (!uvs.empty()) {
-                                            dust3d::PositionKey pk0(result.vertices[baseVertex + i0]);
-                                            dust3d::PositionKey pk1(result.vertices[baseVertex + i1]);
-                                            dust3d::PositionKey pk2(result.vertices[baseVertex + i2]);
-                                            result.triangleUvs[{ pk0, pk1, pk2 }] = { uvs[i0], uvs[i1], uvs[i2] };
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
+            const json* indicesAccessor = findElement("accessors", primitive["indices"]);
+            if (nullptr == indicesAccessor || !isIndexComponentType(indicesAccessor->value("componentType", 0)))
+                continue;
+            size_t triangleCount = accessorCount(primitive["indices"]) / 3;
+            result.triangles.resize(baseTriangle + triangleCount);
+            std::array<size_t, 3>* triangles = result.triangles.data() + baseTriangle;
+            if (!decodeAccessor(primitive["indices"], 1, [&](size_t i, const double* value) {
+                    if (i / 3 < triangleCount)
+                        triangles[i / 3][i % 3] = (size_t)value[0];
+                })) {
+                result.triangles.resize(baseTriangle);
+                continue;
             }
         } else {
             // Non-indexed geometry
-            for (size_t i = 0; i + 2 < posCount; i += 3) {
-                result.faces.push_back({ baseVertex + i, baseVertex + i + 1, baseVertex + i + 2 });
-                if (!uvs.empty()) {
-                    dust3d::PositionKey pk0(result.vertices[baseVertex + i]);
-                    dust3d::PositionKey pk1(result.vertices[baseVertex + i + 1]);
-                    dust3d::PositionKey pk2(result.vertices[baseVertex + i + 2]);
-                    result.triangleUvs[{ pk0, pk1, pk2 }] = { uvs[i], uvs[i + 1], uvs[i + 2] };
-                }
+            size_t triangleCount = posCount / 3;
+            result.triangles.resize(baseTriangle + triangleCount);
+            for (size_t i = 0; i < triangleCount; ++i)
+                result.triangles[baseTriangle + i] = { i * 3, i * 3 + 1, i * 3 + 2 };
+        }
+
+        // Drop triangles referring to vertices out of bounds, and store the UVs of the rest per corner
+        if (!uvs.empty())
+            result.triangleVertexUvs.resize(baseTriangle * 3);
+        size_t keptTriangle = baseTriangle;
+        for (size_t t = baseTriangle; t < result.triangles.size(); ++t) {
+            const auto& triangle = result.triangles[t];
+            if (triangle[0] >= posCount || triangle[1] >= posCount || triangle[2] >= posCount)
+                continue;
+            if (!uvs.empty()) {
+                for (size_t corner = 0; corner < 3; ++corner)
+                    result.triangleVertexUvs.push_back(uvs[triangle[corner]]);
             }
+            result.triangles[keptTriangle++] = { baseVertex + triangle[0], baseVertex + triangle[1], baseVertex + triangle[2] };
         }
+        result.triangles.resize(keptTriangle);
     }
 
+    if (!hasAllNormals)
+        result.vertexNormals.clear();
+    if (!result.vertexColors.empty())
+        result.vertexColors.resize(result.vertices.size(), dust3d::Color(1.0, 1.0, 1.0));
+    if (!result.triangleVertexUvs.empty())
+        result.triangleVertexUvs.resize(result.triangles.size() * 3);
+
+    return !result.vertices.empty() && !result.triangles.empty();
+}
+
+bool GlbReader::readTexture(QImage* image, QByteArray* pngByteArray) const
+{
+    if (!m_isValid)
+        return false;
+
     // Extract texture image or base color from the first material
-    if (textureImage && gltf.count("materials") && !gltf["materials"].empty()) {
-        const auto& material = gltf["materials"][0];
-        if (material.count("pbrMetallicRoughness")) {
-            const auto& pbr = material["pbrMetallicRoughness"];
-            if (pbr.count("baseColorTexture")) {
-                int textureIndex = pbr["baseColorTexture"]["index"];
-                if (gltf.count("textures") && textureIndex >= 0 && textureIndex < (int)gltf["textures"].size()) {
-                    const auto& texture = gltf["textures"][textureIndex];
-                    if (texture.count("source")) {
-                        int imageIndex = texture["source"];
-                        if (gltf.count("images") && imageIndex >= 0 && imageIndex < (int)gltf["images"].size()) {
-                            const auto& image = gltf["images"][imageIndex];
-                            if (image.count("bufferView")) {
-                                int imgBufView = image["bufferView"];
-                                if (imgBufView >= 0 && imgBufView < (int)gltf["bufferViews"].size()) {
-                                    const auto& bufView = gltf["bufferViews"][imgBufView];
-                                    size_t imgOffset = bufView.value("byteOffset", 0);
-                                    size_t imgLength = bufView.value("byteLength", (size_t)0);
-                                    if (imgLength > 0
-                                        && imgOffset + imgLength >= imgOffset // overflow check
-                                        && imgOffset + imgLength <= binChunkLength) {
-                                        *textureImage = QImage::fromData(binChunkData + imgOffset, (int)imgLength);
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-            if (textureImage->isNull() && pbr.count("baseColorFactor")) {
-                const auto& factor = pbr["baseColorFactor"];
-                if (factor.size() >= 3) {
-                    int r = (int)(factor[0].get<float>() * 255);
-                    int g = (int)(factor[1].get<float>() * 255);
-                    int b = (int)(factor[2].get<float>() * 255);
-                    int a = factor.size() >= 4 ? (int)(factor[3].get<float>() * 255) : 255;
-                    *textureImage = QImage(2, 2, QImage::Format_ARGB32);
-                    textureImage->fill(QColor(r, g, b, a));
+    const json* material = findElement("materials", json(0));
+    if (nullptr == material || !material->count("pbrMetallicRoughness"))
+        return false;
+    const auto& pbr = (*material)["pbrMetallicRoughness"];
+    if (!pbr.is_object())
+        return false;
+
+    if (pbr.count("baseColorTexture") && pbr["baseColorTexture"].is_object() && pbr["baseColorTexture"].count("index")) {
+        const json* texture = findElement("textures", pbr["baseColorTexture"]["index"]);
+        if (nullptr != texture && texture->count("source")) {
+            const json* textureImage = findElement("images", (*texture)["source"]);
+            BufferView view;
+            if (nullptr != textureImage && textureImage->count("bufferView")
+                && resolveBufferView((*textureImage)["bufferView"], &view)
+                && view.byteLength > 0) {
+                *image = QImage::fromData(view.data, (int)view.byteLength);
+                static const uint8_t s_pngSignature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+                if (nullptr != pngByteArray && !image->isNull()
+                    && view.byteLength >= sizeof(s_pngSignature)
+                    && 0 == memcmp(view.data, s_pngSignature, sizeof(s_pngSignature))) {
+                    *pngByteArray = QByteArray((const char*)view.data, (qsizetype)view.byteLength);
                 }
             }
         }
     }
 
-    return !result.vertices.empty() && !result.faces.empty();
+    if (image->isNull() && pbr.count("baseColorFactor")) {
+        const auto& factor = pbr["baseColorFactor"];
+        // Anything but numbers would throw on the generation thread
+        if (factor.is_array() && factor.size() >= 3 && std::all_of(factor.begin(), factor.end(), [](const nlohmann::json& value) { return value.is_number(); })) {
+            int r = (int)(factor[0].get<float>() * 255);
+            int g = (int)(factor[1].get<float>() * 255);
+            int b = (int)(factor[2].get<float>() * 255);
+            int a = factor.size() >= 4 ? (int)(factor[3].get<float>() * 255) : 255;
+            *image = QImage(2, 2, QImage::Format_ARGB32);
+            image->fill(QColor(r, g, b, a));
+        }
+    }
+
+    return !image->isNull();
 }
@@ -1,16 +1,42 @@
 #ifndef DUST3D_APPLICATION_GLB_READER_H_
 #define DUST3D_APPLICATION_GLB_READER_H_
 
+#include "json.hpp"
 #include <QByteArray>
 #include <QImage>
-#include <dust3d/base/vector2.h>
-#include <dust3d/base/vector3.h>
+#include <cstdint>
 #include <dust3d/mesh/mesh_generator.h>
-#include <vector>
 
+// Reads the first mesh of a glTF binary. The header and JSON chunk are parsed on construction,
+// the mesh and the base color texture are decoded on request, straight from the BIN chunk,
+// so the two can be decoded at the same time, and a texture nobody asks for is never decoded.
 class GlbReader {
 public:
-    static bool read(const QByteArray& data, dust3d::MeshGenerator::ImportedModelData& result, QImage* textureImage = nullptr);
+    GlbReader(const QByteArray& data);
+    bool isValid() const;
+    bool readMesh(dust3d::MeshGenerator::ImportedModelData& result) const;
+    // Decodes the base color texture of the first material, or fills a small image with its base color factor.
+    // An embedded PNG is also returned as stored, so it does not have to be encoded again to be saved.
+    bool readTexture(QImage* image, QByteArray* pngByteArray = nullptr) const;
+
+private:
+    struct BufferView {
+        const uint8_t* data = nullptr;
+        size_t byteLength = 0;
+        size_t byteStride = 0;
+    };
+
+    QByteArray m_data;
+    nlohmann::json m_gltf;
+    const uint8_t* m_binChunkData = nullptr;
+    size_t m_binChunkLength = 0;
+    bool m_isValid = false;
+
+    const nlohmann::json* findElement(const char* arrayName, const nlohmann::json& index) const;
+    bool resolveBufferView(const nlohmann::json& index, BufferView* bufferView) const;
+    size_t accessorCount(const nlohmann::json& index) const;
+    template <typename Store>
+    bool decodeAccessor(const nlohmann::json& index, size_t expectedComponentCount, Store store) const;
 };
 
 #endif
@@ -1,58 +1,376 @@
 #include "image_forever.h"
+#include <QFile>
+#include <QHash>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QTemporaryDir>
 #include <QtCore/qbuffer.h>
+#include <atomic>
+#include <list>
 #include <map>
+#include <vector>
+
+struct ImageForeverContent {
+    size_t hash = 0;
+    std::shared_ptr<const QImage> image;
+    QByteArray pngByteArray;
+    QString spilledPath;
+    size_t idCount = 0;
+    qint64 residentBytes = 0;
+};
+typedef std::list<ImageForeverContent>::iterator ImageForeverContentIterator;
+
+// A cold content on its way to disk, encoded and written without the map lock
+struct ImageForeverSpill {
+    size_t hash = 0;
+    std::shared_ptr<const QImage> image;
+    QByteArray pngByteArray;
+    QString path;
+};
 
 struct ImageForeverItem {
-    QImage* image;
-    dust3d::Uuid id;
-    QByteArray* imageByteArray;
+    ImageForeverContentIterator content;
+    size_t referenceCount = 0;
+    size_t ownerCount = 0;
+    bool isHeldBefore = false;
 };
+
+// Contents are kept in most recently used first order
+static std::list<ImageForeverContent> g_contents;
+static std::multimap<size_t, ImageForeverContentIterator> g_contentHashMap;
 static std::map<dust3d::Uuid, ImageForeverItem> g_foreverMap;
+static qint64 g_residentBytes = 0;
+static qint64 g_memoryBudget = 512 * 1024 * 1024;
+static std::atomic<size_t> g_spilledFileCount { 0 };
 static QMutex g_mapMutex;
 
-const QImage* ImageForever::get(const dust3d::Uuid& id)
+static QTemporaryDir* spillDirectory()
 {
-    QMutexLocker locker(&g_mapMutex);
-    auto findResult = g_foreverMap.find(id);
-    if (findResult == g_foreverMap.end())
-        return nullptr;
-    return findResult->second.image;
+    static std::unique_ptr<QTemporaryDir> s_directory = std::make_unique<QTemporaryDir>();
+    return s_directory->isValid() ? s_directory.get() : nullptr;
 }
 
-void ImageForever::copy(const dust3d::Uuid& id, QImage& image)
+static size_t hashImage(const QImage& image)
+{
+    size_t seed = qHash(image.width()) ^ (qHash(image.height()) << 1) ^ (qHash((int)image.format()) << 2);
+    return qHashBits(image.constBits(), (size_t)image.sizeInBytes(), (uint)seed);
+}
+
+static void updateResidentBytes(ImageForeverContent& content)
+{
+    g_residentBytes -= content.residentBytes;
+    content.residentBytes = (nullptr != content.image ? content.image->sizeInBytes() : 0) + content.pngByteArray.size();
+    g_residentBytes += content.residentBytes;
+}
+
+static void touch(ImageForeverContentIterator content)
+{
+    g_contents.splice(g_contents.begin(), g_contents, content);
+}
+
+static QByteArray encodePng(const QImage& image)
+{
+    QByteArray pngByteArray;
+    QBuffer pngBuffer(&pngByteArray);
+    pngBuffer.open(QIODevice::WriteOnly);
+    image.save(&pngBuffer, "PNG");
+    return pngByteArray;
+}
+
+static ImageForeverContentIterator findContent(size_t hash, const std::shared_ptr<const QImage>& image)
+{
+    auto range = g_contentHashMap.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second->image == image)
+            return it->second;
+    }
+    return g_contents.end();
+}
+
+static QByteArray loadSpilledPngByteArray(const QString& spilledPath)
 {
+    QFile file(spilledPath);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+    return file.readAll();
+}
+
+static void ensureImage(ImageForeverContent& content)
+{
+    if (nullptr != content.image)
+        return;
+    QByteArray pngByteArray = content.pngByteArray.isEmpty() ? loadSpilledPngByteArray(content.spilledPath) : content.pngByteArray;
+    content.image = std::make_shared<const QImage>(QImage::fromData(pngByteArray, "PNG"));
+    updateResidentBytes(content);
+}
+
+static void dropImage(ImageForeverContent& content)
+{
+    content.image.reset();
+    content.pngByteArray.clear();
+    updateResidentBytes(content);
+}
+
+// Called with the map locked. Contents already on disk are dropped right away,
+// the others are returned to be encoded and written once the lock is released.
+static std::vector<ImageForeverSpill> takeSpills()
+{
+    std::vector<ImageForeverSpill> spills;
+    qint64 residentBytes = g_residentBytes;
+    for (auto it = g_contents.rbegin(); it != g_contents.rend() && residentBytes > g_memoryBudget; ++it) {
+        if (0 == it->residentBytes)
+            continue;
+        // Images still held by a caller would not free any memory
+        if (nullptr != it->image && it->image.use_count() > 1)
+            continue;
+        residentBytes -= it->residentBytes;
+        if (!it->spilledPath.isEmpty() || nullptr == it->image) {
+            dropImage(*it);
+            continue;
+        }
+        ImageForeverSpill spill;
+        spill.hash = it->hash;
+        spill.image = it->image;
+        spill.pngByteArray = it->pngByteArray;
+        spills.push_back(std::move(spill));
+    }
+    return spills;
+}
+
+static void writeSpills(std::vector<ImageForeverSpill>& spills)
+{
+    QTemporaryDir* directory = spillDirectory();
+    if (nullptr == directory)
+        return;
+    for (auto& spill : spills) {
+        if (spill.pngByteArray.isEmpty())
+            spill.pngByteArray = encodePng(*spill.image);
+        QString path = directory->filePath(QString::number(g_spilledFileCount++) + ".png");
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly))
+            continue;
+        if (file.write(spill.pngByteArray) != spill.pngByteArray.size()) {
+            file.close();
+            QFile::remove(path);
+            continue;
+        }
+        spill.path = path;
+    }
+}
+
+static void commitSpills(const std::vector<ImageForeverSpill>& spills)
+{
+    for (const auto& spill : spills) {
+        if (spill.path.isEmpty())
+            continue;
+        auto content = findContent(spill.hash, spill.image);
+        // Removed, reloaded or picked up by a caller while the lock was released
+        if (content == g_contents.end() || !content->spilledPath.isEmpty() || content->image.use_count() > 2) {
+            QFile::remove(spill.path);
+            continue;
+        }
+        content->spilledPath = spill.path;
+        dropImage(*content);
+    }
+}
+
+// Called with the map unlocked, PNG encoding and file writes do not block other callers
+static void enforceMemoryBudget()
+{
+    std::vector<ImageForeverSpill> spills;
+    {
+        QMutexLocker locker(&g_mapMutex);
+        if (g_residentBytes <= g_memoryBudget)
+            return;
+        spills = takeSpills();
+    }
+    if (spills.empty())
+        return;
+    writeSpills(spills);
     QMutexLocker locker(&g_mapMutex);
-    auto findResult = g_foreverMap.find(id);
-    if (findResult == g_foreverMap.end())
+    commitSpills(spills);
+}
+
+static void releaseContent(ImageForeverContentIterator content)
+{
+    if (--content->idCount > 0)
         return;
-    image = *findResult->second.image;
+    auto range = g_contentHashMap.equal_range(content->hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == content) {
+            g_contentHashMap.erase(it);
+            break;
+        }
+    }
+    if (!content->spilledPath.isEmpty())
+        QFile::remove(content->spilledPath);
+    g_residentBytes -= content->residentBytes;
+    g_contents.erase(content);
 }
 
-const QByteArray* ImageForever::getPngByteArray(const dust3d::Uuid& id)
+static void removeItem(std::map<dust3d::Uuid, ImageForeverItem>::iterator item)
+{
+    releaseContent(item->second.content);
+    g_foreverMap.erase(item);
+}
+
+ImageForever::References::References(const std::set<dust3d::Uuid>& imageIds)
+    : m_imageIds(imageIds)
 {
     QMutexLocker locker(&g_mapMutex);
-    auto findResult = g_foreverMap.find(id);
-    if (findResult == g_foreverMap.end())
-        return nullptr;
-    return findResult->second.imageByteArray;
+    for (const auto& imageId : m_imageIds) {
+        auto findResult = g_foreverMap.find(imageId);
+        if (findResult == g_foreverMap.end())
+            continue;
+        ++findResult->second.referenceCount;
+        findResult->second.isHeldBefore = true;
+    }
 }
 
-dust3d::Uuid ImageForever::add(const QImage* image, dust3d::Uuid toId)
+ImageForever::References::~References()
 {
     QMutexLocker locker(&g_mapMutex);
+    for (const auto& imageId : m_imageIds) {
+        auto findResult = g_foreverMap.find(imageId);
+        if (findResult == g_foreverMap.end())
+            continue;
+        if (findResult->second.referenceCount > 0)
+            --findResult->second.referenceCount;
+    }
+}
+
+std::shared_ptr<const QImage> ImageForever::get(const dust3d::Uuid& id)
+{
+    std::shared_ptr<const QImage> image;
+    bool isLoaded = false;
+    {
+        QMutexLocker locker(&g_mapMutex);
+        auto findResult = g_foreverMap.find(id);
+        if (findResult == g_foreverMap.end())
+            return nullptr;
+        auto content = findResult->second.content;
+        touch(content);
+        if (nullptr == content->image) {
+            ensureImage(*content);
+            isLoaded = true;
+        }
+        image = content->image;
+    }
+    if (isLoaded)
+        enforceMemoryBudget();
+    return image;
+}
+
+void ImageForever::copy(const dust3d::Uuid& id, QImage& image)
+{
+    auto foreverImage = get(id);
+    if (nullptr == foreverImage)
+        return;
+    image = *foreverImage;
+}
+
+QByteArray ImageForever::getPngByteArray(const dust3d::Uuid& id)
+{
+    size_t hash = 0;
+    std::shared_ptr<const QImage> image;
+    {
+        QMutexLocker locker(&g_mapMutex);
+        auto findResult = g_foreverMap.find(id);
+        if (findResult == g_foreverMap.end())
+            return QByteArray();
+        auto& content = *findResult->second.content;
+        if (!content.pngByteArray.isEmpty())
+            return content.pngByteArray;
+        if (nullptr == content.image)
+            return loadSpilledPngByteArray(content.spilledPath);
+        hash = content.hash;
+        image = content.image;
+    }
+    QByteArray pngByteArray = encodePng(*image);
+    {
+        QMutexLocker locker(&g_mapMutex);
+        auto content = findContent(hash, image);
+        if (content != g_contents.end() && content->pngByteArray.isEmpty()) {
+            content->pngByteArray = pngByteArray;
+            updateResidentBytes(*content);
+        }
+    }
+    image.reset();
+    enforceMemoryBudget();
+    return pngByteArray;
+}
+
+dust3d::Uuid ImageForever::add(const QImage* image, dust3d::Uuid toId)
+{
+    return add(image, QByteArray(), toId);
+}
+
+dust3d::Uuid ImageForever::add(const QImage* image, const QByteArray& pngByteArray, dust3d::Uuid toId)
+{
     if (nullptr == image)
         return dust3d::Uuid();
+    size_t hash = hashImage(*image);
+    // Spilled candidates are decoded with the map unlocked, then matched again under the lock
+    std::map<QString, QImage> decodedSpills;
+    QMutexLocker locker(&g_mapMutex);
     dust3d::Uuid newId = toId.isNull() ? dust3d::Uuid::createUuid() : toId;
-    if (g_foreverMap.find(newId) != g_foreverMap.end())
-        return newId;
-    QImage* newImage = new QImage(*image);
-    QByteArray* imageByteArray = new QByteArray();
-    QBuffer pngBuffer(imageByteArray);
-    pngBuffer.open(QIODevice::WriteOnly);
-    newImage->save(&pngBuffer, "PNG");
-    g_foreverMap[newId] = { newImage, newId, imageByteArray };
+    ImageForeverContentIterator content = g_contents.end();
+    for (;;) {
+        if (g_foreverMap.find(newId) != g_foreverMap.end())
+            return newId;
+        std::vector<QString> pendingPaths;
+        auto range = g_contentHashMap.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            auto& candidate = *it->second;
+            if (nullptr != candidate.image) {
+                if (*candidate.image == *image) {
+                    content = it->second;
+                    break;
+                }
+                continue;
+            }
+            auto decoded = decodedSpills.find(candidate.spilledPath);
+            if (decoded == decodedSpills.end()) {
+                pendingPaths.push_back(candidate.spilledPath);
+                continue;
+            }
+            if (decoded->second == *image) {
+                candidate.image = std::make_shared<const QImage>(decoded->second);
+                updateResidentBytes(candidate);
+                content = it->second;
+                break;
+            }
+        }
+        if (content != g_contents.end() || pendingPaths.empty())
+            break;
+        locker.unlock();
+        for (const auto& path : pendingPaths)
+            decodedSpills[path] = QImage::fromData(loadSpilledPngByteArray(path), "PNG");
+        locker.relock();
+    }
+    if (content == g_contents.end()) {
+        g_contents.push_front(ImageForeverContent());
+        content = g_contents.begin();
+        content->hash = hash;
+        content->image = std::make_shared<const QImage>(*image);
+        content->pngByteArray = pngByteArray;
+        updateResidentBytes(*content);
+        g_contentHashMap.insert({ hash, content });
+    } else {
+        touch(content);
+        if (content->pngByteArray.isEmpty() && !pngByteArray.isEmpty()) {
+            content->pngByteArray = pngByteArray;
+            updateResidentBytes(*content);
+        }
+    }
+    ++content->idCount;
+
+    ImageForeverItem item;
+    item.content = content;
+    g_foreverMap[newId] = item;
+
+    locker.unlock();
+    enforceMemoryBudget();
     return newId;
 }
 
@@ -62,7 +380,53 @@ void ImageForever::remove(const dust3d::Uuid& id)
     auto findImage = g_foreverMap.find(id);
     if (findImage == g_foreverMap.end())
         return;
-    delete findImage->second.image;
-    delete findImage->second.imageByteArray;
-    g_foreverMap.erase(id);
+    removeItem(findImage);
+}
+
+void ImageForever::retain(const dust3d::Uuid& id)
+{
+    QMutexLocker locker(&g_mapMutex);
+    auto findImage = g_foreverMap.find(id);
+    if (findImage == g_foreverMap.end())
+        return;
+    ++findImage->second.ownerCount;
+    findImage->second.isHeldBefore = true;
+}
+
+void ImageForever::release(const dust3d::Uuid& id)
+{
+    QMutexLocker locker(&g_mapMutex);
+    auto findImage = g_foreverMap.find(id);
+    if (findImage == g_foreverMap.end())
+        return;
+    if (findImage->second.ownerCount > 0)
+        --findImage->second.ownerCount;
+}
+
+void ImageForever::collect()
+{
+    QMutexLocker locker(&g_mapMutex);
+    for (auto it = g_foreverMap.begin(); it != g_foreverMap.end();) {
+        auto current = it++;
+        auto& item = current->second;
+        if (0 != item.referenceCount || 0 != item.ownerCount)
+            continue;
+        if (!item.isHeldBefore) {
+            // Give a fresh id the time to be picked up by a snapshot
+            item.isHeldBefore = true;
+            continue;
+        }
+        removeItem(current);
+    }
+    locker.unlock();
+    enforceMemoryBudget();
+}
+
+void ImageForever::setMemoryBudget(qint64 bytes)
+{
+    {
+        QMutexLocker locker(&g_mapMutex);
+        g_memoryBudget = bytes;
+    }
+    enforceMemoryBudget();
 }
@@ -4,14 +4,37 @@
 #include <QByteArray>
 #include <QImage>
 #include <dust3d/base/uuid.h>
+#include <memory>
+#include <set>
 
+// Process wide image store.
+// Identical images added under different ids share one content entry, PNG bytes
+// are only encoded when a save asks for them, and the decoded images of cold
+// entries are spilled to a temporary directory once the memory budget is exceeded.
+// Every id is held by snapshot references and by explicit owners (retain/release).
+// collect() reclaims ids nothing holds; an id which was never held survives one
+// collect() pass, so an image added for an edit lives until the edit is recorded.
 class ImageForever {
 public:
-    static const QImage* get(const dust3d::Uuid& id);
+    class References {
+    public:
+        References(const std::set<dust3d::Uuid>& imageIds);
+        ~References();
+
+    private:
+        std::set<dust3d::Uuid> m_imageIds;
+    };
+
+    static std::shared_ptr<const QImage> get(const dust3d::Uuid& id);
     static void copy(const dust3d::Uuid& id, QImage& image);
-    static const QByteArray* getPngByteArray(const dust3d::Uuid& id);
+    static QByteArray getPngByteArray(const dust3d::Uuid& id);
     static dust3d::Uuid add(const QImage* image, dust3d::Uuid toId = dust3d::Uuid());
+    static dust3d::Uuid add(const QImage* image, const QByteArray& pngByteArray, dust3d::Uuid toId = dust3d::Uuid());
     static void remove(const dust3d::Uuid& id);
+    static void retain(const dust3d::Uuid& id);
+    static void release(const dust3d::Uuid& id);
+    static void collect();
+    static void setMemoryBudget(qint64 bytes);
 };
 
 #endif
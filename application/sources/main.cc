@@ -1,5 +1,7 @@
 #include "document.h"
 #include "document_window.h"
+#include "generation_server.h"
+#include "preferences.h"
 #include "theme.h"
 #include "version.h"
 #include <QApplication>
@@ -47,12 +49,14 @@ int main(int argc, char* argv[])
     QCoreApplication::setOrganizationName(APP_COMPANY);
     QCoreApplication::setOrganizationDomain(APP_HOMEPAGE_URL);
 
-    DocumentWindow* firstWindow = DocumentWindow::createDocumentWindow();
-
+    bool runServer = false;
     bool toggleColor = false;
     for (int i = 1; i < argc; ++i) {
         if ('-' == argv[i][0]) {
-            if (0 == strcmp(argv[i], "-output") || 0 == strcmp(argv[i], "-o")) {
+            if (0 == strcmp(argv[i], "-server")) {
+                runServer = true;
+                continue;
+            } else if (0 == strcmp(argv[i], "-output") || 0 == strcmp(argv[i], "-o")) {
                 ++i;
                 if (i < argc)
                     g_waitingExportList.append(argv[i]);
@@ -62,6 +66,11 @@ int main(int argc, char* argv[])
                 if (i < argc)
                     g_pasteXmlFile = argv[i];
                 continue;
+            } else if (0 == strcmp(argv[i], "-cache-dir")) {
+                ++i;
+                if (i < argc)
+                    Preferences::instance().overrideGenerationCacheDirectory(QString::fromLocal8Bit(argv[i]));
+                continue;
             } else if (0 == strcmp(argv[i], "-toggle-color")) {
                 ++i;
                 if (i < argc)
@@ -78,6 +87,18 @@ int main(int argc, char* argv[])
         }
     }
 
+    // The generation server runs without any window
+    if (runServer) {
+        GenerationServer server;
+        QObject::connect(&server, &GenerationServer::finished, g_app, []() {
+            g_app->exit(0);
+        });
+        server.start();
+        return g_app->exec();
+    }
+
+    DocumentWindow* firstWindow = DocumentWindow::createDocumentWindow();
+
     if (!g_openFileList.empty()) {
         g_windowList.push_back(firstWindow);
         for (int i = 1; i < g_openFileList.size(); ++i) {
@@ -5,6 +5,9 @@
 #include "image_forever.h"
 #include <QDebug>
 #include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <dust3d/base/string.h>
 #include <dust3d/mesh/smooth_normal.h>
 #include <dust3d/mesh/trim_vertices.h>
 
@@ -13,6 +16,11 @@ MeshGenerator::MeshGenerator(dust3d::Snapshot* snapshot)
 {
 }
 
+MeshGenerator::MeshGenerator(std::shared_ptr<const dust3d::Snapshot> sourceSnapshot)
+    : dust3d::MeshGenerator(std::move(sourceSnapshot))
+{
+}
+
 MeshGenerator::~MeshGenerator()
 {
 }
@@ -37,7 +45,61 @@ void MeshGenerator::addPendingGlbData(const std::string& glbIdString, QByteArray
     m_pendingGlbData[glbIdString] = { std::move(data), componentIdString };
 }
 
-std::map<std::string, std::pair<dust3d::MeshGenerator::ImportedModelData, dust3d::Uuid>> MeshGenerator::s_glbCache;
+std::list<MeshGenerator::GlbCacheItem> MeshGenerator::s_glbCache;
+const size_t MeshGenerator::s_glbCacheMaxSize = 8;
+static QMutex g_glbCacheMutex;
+
+void MeshGenerator::removeGlbCache(const std::string& glbIdString)
+{
+    QMutexLocker locker(&g_glbCacheMutex);
+    s_glbCache.remove_if([&](const GlbCacheItem& item) {
+        if (item.glbIdString != glbIdString)
+            return false;
+        ImageForever::release(item.textureId);
+        return true;
+    });
+}
+
+bool MeshGenerator::findGlbCache(const std::string& glbIdString, GlbCacheItem* cacheItem)
+{
+    QMutexLocker locker(&g_glbCacheMutex);
+    auto cacheIt = std::find_if(s_glbCache.begin(), s_glbCache.end(), [&](const GlbCacheItem& item) {
+        return item.glbIdString == glbIdString;
+    });
+    if (cacheIt == s_glbCache.end())
+        return false;
+    s_glbCache.splice(s_glbCache.begin(), s_glbCache, cacheIt);
+    *cacheItem = *cacheIt;
+    return true;
+}
+
+void MeshGenerator::addGlbCache(GlbCacheItem* cacheItem)
+{
+    QMutexLocker locker(&g_glbCacheMutex);
+    auto cacheIt = std::find_if(s_glbCache.begin(), s_glbCache.end(), [&](const GlbCacheItem& item) {
+        return item.glbIdString == cacheItem->glbIdString;
+    });
+    if (cacheIt != s_glbCache.end()) {
+        s_glbCache.splice(s_glbCache.begin(), s_glbCache, cacheIt);
+        if (cacheIt->textureId.isNull() && !cacheItem->textureId.isNull()) {
+            // Cached by a generation which had no use for the texture
+            ImageForever::retain(cacheItem->textureId);
+            cacheIt->textureId = cacheItem->textureId;
+            return;
+        }
+        // Another generation parsed the same data meanwhile, share its result
+        if (cacheIt->textureId != cacheItem->textureId)
+            ImageForever::remove(cacheItem->textureId);
+        *cacheItem = *cacheIt;
+        return;
+    }
+    ImageForever::retain(cacheItem->textureId);
+    s_glbCache.push_front(*cacheItem);
+    while (s_glbCache.size() > s_glbCacheMaxSize) {
+        ImageForever::release(s_glbCache.back().textureId);
+        s_glbCache.pop_back();
+    }
+}
 
 void MeshGenerator::parseImportedModelData()
 {
@@ -45,40 +107,45 @@ void MeshGenerator::parseImportedModelData()
     if (m_pendingGlbData.empty())
         return;
 
-    std::map<std::string, dust3d::MeshGenerator::ImportedModelData> importedModelData;
+    // The cache is only locked around lookups and inserts, so parsing does not block other generations
+    std::map<std::string, std::shared_ptr<const dust3d::MeshGenerator::ImportedModelData>> importedModelData;
     for (auto& [glbIdString, pending] : m_pendingGlbData) {
-        auto cacheIt = s_glbCache.find(glbIdString);
-        if (cacheIt != s_glbCache.end()) {
-            importedModelData[glbIdString] = cacheIt->second.first;
-            dust3d::Uuid textureId = cacheIt->second.second;
-            if (!textureId.isNull() && !pending.componentIdString.empty()) {
-                auto snapshotCompIt = snapshot()->components.find(pending.componentIdString);
-                if (snapshotCompIt != snapshot()->components.end())
-                    snapshotCompIt->second["colorImageId"] = textureId.toString();
-                emit importedModelTextureReady(dust3d::Uuid(pending.componentIdString), textureId);
+        // The texture is only decoded for a component which has no color image yet
+        const std::map<std::string, std::string>* component = nullptr;
+        if (!pending.componentIdString.empty())
+            component = findComponent(pending.componentIdString);
+        bool isTextureWanted = nullptr != component && dust3d::String::valueOrEmpty(*component, "colorImageId").empty();
+
+        GlbCacheItem cacheItem;
+        bool isCached = findGlbCache(glbIdString, &cacheItem);
+        if (isCached && (!isTextureWanted || !cacheItem.textureId.isNull())) {
+            importedModelData[glbIdString] = cacheItem.importedModelData;
+        } else {
+            GlbReader glbReader(pending.data);
+            if (!isCached) {
+                auto modelData = std::make_shared<dust3d::MeshGenerator::ImportedModelData>();
+                if (!glbReader.readMesh(*modelData))
+                    continue;
+                cacheItem.glbIdString = glbIdString;
+                cacheItem.importedModelData = std::move(modelData);
             }
-            continue;
-        }
-        dust3d::MeshGenerator::ImportedModelData modelData;
-        QImage textureImage;
-        if (GlbReader::read(pending.data, modelData, &textureImage)) {
-            dust3d::Uuid textureId;
-            if (!textureImage.isNull()) {
-                textureId = ImageForever::add(&textureImage);
-                if (!textureId.isNull() && !pending.componentIdString.empty()) {
-                    auto snapshotCompIt = snapshot()->components.find(pending.componentIdString);
-                    if (snapshotCompIt != snapshot()->components.end())
-                        snapshotCompIt->second["colorImageId"] = textureId.toString();
-                    emit importedModelTextureReady(dust3d::Uuid(pending.componentIdString), textureId);
-                }
+            importedModelData[glbIdString] = cacheItem.importedModelData;
+            if (isTextureWanted) {
+                QImage textureImage;
+                QByteArray texturePngByteArray;
+                if (glbReader.readTexture(&textureImage, &texturePngByteArray))
+                    cacheItem.textureId = ImageForever::add(&textureImage, texturePngByteArray);
             }
-            s_glbCache[glbIdString] = { modelData, textureId };
-            importedModelData[glbIdString] = std::move(modelData);
+            addGlbCache(&cacheItem);
+        }
+        if (isTextureWanted && !cacheItem.textureId.isNull()) {
+            overlayComponent(pending.componentIdString)["colorImageId"] = cacheItem.textureId.toString();
+            emit importedModelTextureReady(dust3d::Uuid(pending.componentIdString), cacheItem.textureId);
         }
     }
     m_pendingGlbData.clear();
     if (!importedModelData.empty())
-        setImportedModelData(std::move(importedModelData));
+        setImportedModelData(importedModelData);
 }
 
 void MeshGenerator::process()
@@ -89,8 +156,17 @@ void MeshGenerator::process()
     parseImportedModelData();
     generate();
 
-    if (nullptr != m_object)
+    if (isCancelled()) {
+        qDebug() << "The mesh generation was cancelled after" << countTimeConsumed.elapsed() << "milliseconds";
+        emit finished();
+        return;
+    }
+
+    // Meshes are packed for drawing here, so handing them to the views stays cheap
+    if (nullptr != m_object) {
         m_resultMesh = std::make_unique<ModelMesh>(*m_object);
+        m_resultMesh->packTriangleVertices();
+    }
 
     m_componentPreviewImages = std::make_unique<std::map<dust3d::Uuid, std::unique_ptr<QImage>>>();
 
@@ -144,6 +220,7 @@ void MeshGenerator::process()
             it->second.roughness,
             it->second.vertexProperties.empty() ? nullptr : &it->second.vertexProperties,
             triangleUvs.empty() ? nullptr : &triangleUvs);
+        (*m_componentPreviewMeshes)[componentId]->packTriangleVertices();
     }
 
     if (nullptr != m_object)
@@ -7,12 +7,14 @@
 #include <QImage>
 #include <QObject>
 #include <dust3d/mesh/mesh_generator.h>
+#include <list>
 #include <memory>
 
 class MeshGenerator : public QObject, public dust3d::MeshGenerator {
     Q_OBJECT
 public:
     MeshGenerator(dust3d::Snapshot* snapshot);
+    MeshGenerator(std::shared_ptr<const dust3d::Snapshot> sourceSnapshot);
     ~MeshGenerator();
     ModelMesh* takeResultMesh();
     std::map<dust3d::Uuid, std::unique_ptr<ModelMesh>>* takeComponentPreviewMeshes();
@@ -24,6 +26,7 @@ public:
         std::string componentIdString;
     };
     void addPendingGlbData(const std::string& glbIdString, QByteArray data, const std::string& componentIdString);
+    static void removeGlbCache(const std::string& glbIdString);
 
 public slots:
     void process();
@@ -32,13 +35,24 @@ signals:
     void importedModelTextureReady(dust3d::Uuid componentId, dust3d::Uuid textureId);
 
 private:
-    void parseImportedModelData();
     std::unique_ptr<ModelMesh> m_resultMesh;
     std::unique_ptr<std::map<dust3d::Uuid, std::unique_ptr<ModelMesh>>> m_componentPreviewMeshes;
     std::unique_ptr<std::map<dust3d::Uuid, std::unique_ptr<QImage>>> m_componentPreviewImages;
     std::unique_ptr<MonochromeMesh> m_wireframeMesh;
     std::map<std::string, PendingGlbData> m_pendingGlbData;
-    static std::map<std::string, std::pair<dust3d::MeshGenerator::ImportedModelData, dust3d::Uuid>> s_glbCache;
+
+    // Parsed GLB data shared by all generations, most recently used first
+    struct GlbCacheItem {
+        std::string glbIdString;
+        std::shared_ptr<const dust3d::MeshGenerator::ImportedModelData> importedModelData;
+        dust3d::Uuid textureId;
+    };
+    static std::list<GlbCacheItem> s_glbCache;
+    static const size_t s_glbCacheMaxSize;
+
+    void parseImportedModelData();
+    static bool findGlbCache(const std::string& glbIdString, GlbCacheItem* cacheItem);
+    static void addGlbCache(GlbCacheItem* cacheItem);
 };
 
 #endif
@@ -1,22 +1,21 @@
 #include "model_mesh.h"
-#include "version.h"
-#include <QFile>
-#include <QTextStream>
+#include <algorithm>
 #include <assert.h>
 #include <cmath>
+#include <cstring>
+#include <limits>
 
 float ModelMesh::m_defaultMetalness = 0.0;
 float ModelMesh::m_defaultRoughness = 1.0;
 
 ModelMesh::ModelMesh(const ModelMesh& mesh)
     : m_triangleVertices(nullptr)
-    , m_triangleVertexCount(0)
+    , m_triangleVertexCount(mesh.m_triangleVertexCount)
     , m_textureImage(nullptr)
     , m_skeletonVertexCount(mesh.m_skeletonVertexCount)
 {
     if (nullptr != mesh.m_triangleVertices && mesh.m_triangleVertexCount > 0) {
         this->m_triangleVertices = new ModelOpenGLVertex[mesh.m_triangleVertexCount];
-        this->m_triangleVertexCount = mesh.m_triangleVertexCount;
         for (int i = 0; i < mesh.m_triangleVertexCount; i++)
             this->m_triangleVertices[i] = mesh.m_triangleVertices[i];
     }
@@ -32,9 +31,8 @@ ModelMesh::ModelMesh(const ModelMesh& mesh)
         this->m_hasRoughnessInImage = mesh.m_hasRoughnessInImage;
         this->m_hasAmbientOcclusionInImage = mesh.m_hasAmbientOcclusionInImage;
     }
-    this->m_vertices = mesh.m_vertices;
-    this->m_faces = mesh.m_faces;
     this->m_triangulatedVertices = mesh.m_triangulatedVertices;
+    this->m_packedMesh = mesh.m_packedMesh;
     this->m_meshId = mesh.meshId();
     this->m_skeletonVertexCount = mesh.m_skeletonVertexCount;
 }
@@ -69,8 +67,9 @@ void ModelMesh::removeColor()
     this->m_hasRoughnessInImage = false;
     this->m_hasAmbientOcclusionInImage = false;
 
+    ModelOpenGLVertex* vertices = triangleVertices();
     for (int i = 0; i < this->m_triangleVertexCount; ++i) {
-        auto& vertex = this->m_triangleVertices[i];
+        auto& vertex = vertices[i];
         // Warm paper-white
         vertex.colorR = 0.96;
         vertex.colorG = 0.94;
@@ -145,8 +144,6 @@ ModelMesh::ModelMesh(dust3d::Object& object)
     , m_textureImage(nullptr)
 {
     m_meshId = object.meshId;
-    m_vertices = object.vertices;
-    m_faces = object.triangleAndQuads;
 
     m_triangleVertexCount = (int)object.triangles.size() * 3;
     m_triangleVertices = new ModelOpenGLVertex[m_triangleVertexCount];
@@ -216,24 +213,138 @@ ModelMesh::~ModelMesh()
     delete m_metalnessRoughnessAmbientOcclusionMapImage;
 }
 
-const std::vector<dust3d::Vector3>& ModelMesh::vertices()
+const std::vector<dust3d::Vector3>& ModelMesh::triangulatedVertices()
 {
-    return m_vertices;
+    return m_triangulatedVertices;
 }
 
-const std::vector<std::vector<size_t>>& ModelMesh::faces()
+ModelOpenGLVertex* ModelMesh::triangleVertices()
 {
-    return m_faces;
+    unpackTriangleVertices();
+    m_packedMesh.reset();
+    return m_triangleVertices;
 }
 
-const std::vector<dust3d::Vector3>& ModelMesh::triangulatedVertices()
+const ModelOpenGLVertex* ModelMesh::triangleVertices() const
 {
-    return m_triangulatedVertices;
+    unpackTriangleVertices();
+    return m_triangleVertices;
 }
 
-ModelOpenGLVertex* ModelMesh::triangleVertices()
+static GLshort packSignedNormalized(GLfloat value)
 {
-    return m_triangleVertices;
+    return (GLshort)std::lround(std::max(-1.0f, std::min(1.0f, value)) * 32767.0f);
+}
+
+static GLubyte packUnsignedNormalized(GLfloat value)
+{
+    return (GLubyte)std::lround(std::max(0.0f, std::min(1.0f, value)) * 255.0f);
+}
+
+static size_t hashPackedVertex(const ModelOpenGLPackedVertex& vertex)
+{
+    // FNV-1a, paddings are always zero so the raw bytes identify the vertex
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&vertex);
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < sizeof(ModelOpenGLPackedVertex); ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return (size_t)hash;
+}
+
+void ModelMesh::packTriangleVertices()
+{
+    if (nullptr != m_packedMesh)
+        return;
+    auto packedMesh = std::make_shared<ModelOpenGLPackedMesh>();
+    if (nullptr == m_triangleVertices || m_triangleVertexCount <= 0) {
+        m_packedMesh = std::move(packedMesh);
+        return;
+    }
+
+    // Open addressing table of indices into the packed vertices, at most half full
+    size_t slotCount = 1;
+    while (slotCount < (size_t)m_triangleVertexCount * 2)
+        slotCount <<= 1;
+    const GLuint emptySlot = std::numeric_limits<GLuint>::max();
+    std::vector<GLuint> slots(slotCount, emptySlot);
+
+    packedMesh->vertices.reserve(m_triangleVertexCount / 2);
+    packedMesh->indices.resize(m_triangleVertexCount);
+    for (int i = 0; i < m_triangleVertexCount; ++i) {
+        const ModelOpenGLVertex& source = m_triangleVertices[i];
+        ModelOpenGLPackedVertex packed;
+        packed.posX = source.posX;
+        packed.posY = source.posY;
+        packed.posZ = source.posZ;
+        packed.normX = packSignedNormalized(source.normX);
+        packed.normY = packSignedNormalized(source.normY);
+        packed.normZ = packSignedNormalized(source.normZ);
+        packed.tangentX = packSignedNormalized(source.tangentX);
+        packed.tangentY = packSignedNormalized(source.tangentY);
+        packed.tangentZ = packSignedNormalized(source.tangentZ);
+        packed.texU = source.texU;
+        packed.texV = source.texV;
+        packed.colorR = packUnsignedNormalized(source.colorR);
+        packed.colorG = packUnsignedNormalized(source.colorG);
+        packed.colorB = packUnsignedNormalized(source.colorB);
+        packed.alpha = packUnsignedNormalized(source.alpha);
+        packed.metalness = packUnsignedNormalized(source.metalness);
+        packed.roughness = packUnsignedNormalized(source.roughness);
+
+        size_t slot = hashPackedVertex(packed) & (slotCount - 1);
+        while (emptySlot != slots[slot]) {
+            if (0 == std::memcmp(&packedMesh->vertices[slots[slot]], &packed, sizeof(ModelOpenGLPackedVertex)))
+                break;
+            slot = (slot + 1) & (slotCount - 1);
+        }
+        if (emptySlot == slots[slot]) {
+            slots[slot] = (GLuint)packedMesh->vertices.size();
+            packedMesh->vertices.push_back(packed);
+        }
+        packedMesh->indices[i] = slots[slot];
+    }
+    packedMesh->vertices.shrink_to_fit();
+    m_packedMesh = std::move(packedMesh);
+
+    delete[] m_triangleVertices;
+    m_triangleVertices = nullptr;
+}
+
+void ModelMesh::unpackTriangleVertices() const
+{
+    if (nullptr != m_triangleVertices || nullptr == m_packedMesh || m_triangleVertexCount <= 0)
+        return;
+
+    m_triangleVertices = new ModelOpenGLVertex[m_triangleVertexCount];
+    for (int i = 0; i < m_triangleVertexCount; ++i) {
+        const ModelOpenGLPackedVertex& source = m_packedMesh->vertices[m_packedMesh->indices[i]];
+        ModelOpenGLVertex& dest = m_triangleVertices[i];
+        dest.posX = source.posX;
+        dest.posY = source.posY;
+        dest.posZ = source.posZ;
+        dest.normX = source.normX / 32767.0f;
+        dest.normY = source.normY / 32767.0f;
+        dest.normZ = source.normZ / 32767.0f;
+        dest.tangentX = source.tangentX / 32767.0f;
+        dest.tangentY = source.tangentY / 32767.0f;
+        dest.tangentZ = source.tangentZ / 32767.0f;
+        dest.texU = source.texU;
+        dest.texV = source.texV;
+        dest.colorR = source.colorR / 255.0f;
+        dest.colorG = source.colorG / 255.0f;
+        dest.colorB = source.colorB / 255.0f;
+        dest.alpha = source.alpha / 255.0f;
+        dest.metalness = source.metalness / 255.0f;
+        dest.roughness = source.roughness / 255.0f;
+    }
+}
+
+std::shared_ptr<const ModelOpenGLPackedMesh> ModelMesh::packedMesh()
+{
+    packTriangleVertices();
+    return m_packedMesh;
 }
 
 void ModelMesh::setTextureImage(QImage* textureImage)
@@ -317,37 +428,12 @@ void ModelMesh::setHasAmbientOcclusionInImage(bool hasInImage)
     m_hasAmbientOcclusionInImage = hasInImage;
 }
 
-void ModelMesh::exportAsObj(QTextStream* textStream)
-{
-    auto& stream = *textStream;
-    stream << "# " << APP_NAME << " " << APP_HUMAN_VER << "\n";
-    stream << "# " << APP_HOMEPAGE_URL << "\n";
-    for (std::vector<dust3d::Vector3>::const_iterator it = vertices().begin(); it != vertices().end(); ++it) {
-        stream << "v " << QString::number((*it).x()) << " " << QString::number((*it).y()) << " " << QString::number((*it).z()) << "\n";
-    }
-    for (std::vector<std::vector<size_t>>::const_iterator it = faces().begin(); it != faces().end(); ++it) {
-        stream << "f";
-        for (std::vector<size_t>::const_iterator subIt = (*it).begin(); subIt != (*it).end(); ++subIt) {
-            stream << " " << QString::number((1 + *subIt));
-        }
-        stream << "\n";
-    }
-}
-
-void ModelMesh::exportAsObj(const QString& filename)
-{
-    QFile file(filename);
-    if (file.open(QIODevice::WriteOnly)) {
-        QTextStream stream(&file);
-        exportAsObj(&stream);
-    }
-}
-
 void ModelMesh::updateTriangleVertices(ModelOpenGLVertex* triangleVertices, int triangleVertexCount)
 {
     delete[] m_triangleVertices;
     m_triangleVertices = 0;
     m_triangleVertexCount = 0;
+    m_packedMesh.reset();
 
     m_triangleVertices = triangleVertices;
     m_triangleVertexCount = triangleVertexCount;
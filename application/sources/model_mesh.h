@@ -12,6 +12,7 @@
 #include <dust3d/base/vector2.h>
 #include <dust3d/base/vector3.h>
 #include <map>
+#include <memory>
 #include <tuple>
 #include <vector>
 
@@ -30,10 +31,16 @@ public:
     ModelMesh(const ModelMesh& mesh);
     ModelMesh();
     ~ModelMesh();
+    // Packed meshes unpack their triangle vertices again on access,
+    // writable access drops the packed vertices, which are packed again on request
     ModelOpenGLVertex* triangleVertices();
+    const ModelOpenGLVertex* triangleVertices() const;
     int triangleVertexCount() const;
-    const std::vector<dust3d::Vector3>& vertices();
-    const std::vector<std::vector<size_t>>& faces();
+    // Packing welds and quantizes the triangle vertices for drawing, so the thread building the mesh
+    // can do it ahead of time, copies of the mesh share the result.
+    // The unpacked triangle vertices are released once packed
+    void packTriangleVertices();
+    std::shared_ptr<const ModelOpenGLPackedMesh> packedMesh();
     const std::vector<dust3d::Vector3>& triangulatedVertices();
     void setTextureImage(QImage* textureImage);
     const QImage* textureImage();
@@ -54,18 +61,15 @@ public:
     void setSkeletonVertexCount(int count);
     static float m_defaultMetalness;
     static float m_defaultRoughness;
-    void exportAsObj(const QString& filename);
-    void exportAsObj(QTextStream* textStream);
     void updateTriangleVertices(ModelOpenGLVertex* triangleVertices, int triangleVertexCount);
     quint64 meshId() const;
     void setMeshId(quint64 id);
     void removeColor();
 
 private:
-    ModelOpenGLVertex* m_triangleVertices = nullptr;
+    mutable ModelOpenGLVertex* m_triangleVertices = nullptr;
     int m_triangleVertexCount = 0;
-    std::vector<dust3d::Vector3> m_vertices;
-    std::vector<std::vector<size_t>> m_faces;
+    std::shared_ptr<const ModelOpenGLPackedMesh> m_packedMesh;
     std::vector<dust3d::Vector3> m_triangulatedVertices;
     QImage* m_textureImage = nullptr;
     QImage* m_normalMapImage = nullptr;
@@ -75,6 +79,7 @@ private:
     bool m_hasAmbientOcclusionInImage = false;
     int m_skeletonVertexCount = 0;
     quint64 m_meshId = 0;
+    void unpackTriangleVertices() const;
 };
 
 #endif
@@ -1,28 +1,142 @@
 #include "model_opengl_object.h"
 #include <QOpenGLContext>
 #include <QOpenGLFunctions>
+#include <QThreadPool>
+#include <cstddef>
 #include <dust3d/base/debug.h>
+#include <dust3d/mesh/simplify_mesh.h>
+#include <limits>
 
-void ModelOpenGLObject::update(std::unique_ptr<ModelMesh> mesh)
+// Below this, drawing the full mesh while orbiting is fast enough on any hardware
+static const size_t g_levelOfDetailMinTriangleCount = 200000;
+static const float g_levelOfDetailRatio = 0.25f;
+
+void ModelOpenGLObject::setLevelOfDetailEnabled(bool enabled)
+{
+    m_levelOfDetailEnabled = enabled;
+}
+
+void ModelOpenGLObject::update(std::unique_ptr<ModelMesh> mesh, bool levelOfDetail)
 {
+    std::shared_ptr<const ModelOpenGLPackedMesh> packedMesh;
+    if (mesh)
+        packedMesh = mesh->packedMesh();
+    mesh.reset();
+
+    uint64_t serial = ++m_meshSerial;
+    if (m_levelOfDetailEnabled)
+        buildLevelOfDetail(levelOfDetail ? packedMesh : nullptr, serial);
+
     QMutexLocker lock(&m_meshMutex);
-    m_mesh = std::move(mesh);
+    m_mesh = std::move(packedMesh);
+    m_pendingMeshSerial = serial;
     m_meshIsDirty = true;
 }
 
-void ModelOpenGLObject::draw()
+void ModelOpenGLObject::buildLevelOfDetail(std::shared_ptr<const ModelOpenGLPackedMesh> mesh, uint64_t serial)
+{
+    if (nullptr != mesh && mesh->indices.size() / 3 < g_levelOfDetailMinTriangleCount)
+        mesh.reset();
+    std::shared_ptr<LevelOfDetail> levelOfDetail = m_levelOfDetail;
+    {
+        QMutexLocker lock(&levelOfDetail->mutex);
+        levelOfDetail->serial = nullptr != mesh ? serial : 0;
+        levelOfDetail->indices.clear();
+        levelOfDetail->isDirty = false;
+        levelOfDetail->pendingMesh = mesh;
+        if (nullptr == mesh || levelOfDetail->isBuilding)
+            return;
+        levelOfDetail->isBuilding = true;
+    }
+
+    // Vertices split by normal, color or UV seams are borders to the simplifier and stay in place
+    QThreadPool::globalInstance()->start([levelOfDetail]() {
+        for (;;) {
+            std::shared_ptr<const ModelOpenGLPackedMesh> mesh;
+            uint64_t serial = 0;
+            {
+                QMutexLocker lock(&levelOfDetail->mutex);
+                if (nullptr == levelOfDetail->pendingMesh) {
+                    levelOfDetail->isBuilding = false;
+                    return;
+                }
+                mesh = std::move(levelOfDetail->pendingMesh);
+                serial = levelOfDetail->serial;
+            }
+            std::vector<dust3d::Vector3> vertices;
+            vertices.reserve(mesh->vertices.size());
+            for (const auto& vertex : mesh->vertices)
+                vertices.emplace_back(vertex.posX, vertex.posY, vertex.posZ);
+            std::vector<std::vector<size_t>> triangles;
+            triangles.reserve(mesh->indices.size() / 3);
+            for (size_t i = 0; i + 2 < mesh->indices.size(); i += 3)
+                triangles.push_back({ mesh->indices[i], mesh->indices[i + 1], mesh->indices[i + 2] });
+            std::vector<std::vector<size_t>> simplifiedTriangles;
+            dust3d::simplifyTriangles(vertices, triangles, (size_t)(triangles.size() * g_levelOfDetailRatio), &simplifiedTriangles);
+            std::vector<GLuint> indices;
+            indices.reserve(simplifiedTriangles.size() * 3);
+            for (const auto& triangle : simplifiedTriangles) {
+                for (const auto& index : triangle)
+                    indices.push_back((GLuint)index);
+            }
+            QMutexLocker lock(&levelOfDetail->mutex);
+            if (serial != levelOfDetail->serial)
+                continue;
+            levelOfDetail->indices = std::move(indices);
+            levelOfDetail->isDirty = true;
+        }
+    });
+}
+
+void ModelOpenGLObject::draw(bool levelOfDetail)
 {
     copyMeshToOpenGL();
-    if (0 == m_meshTriangleVertexCount)
+    if (0 == m_meshIndexCount)
         return;
     QOpenGLFunctions* f = QOpenGLContext::currentContext()->functions();
     QOpenGLVertexArrayObject::Binder binder(&m_vertexArrayObject);
-    f->glDrawArrays(GL_TRIANGLES, 0, m_meshTriangleVertexCount);
+    // Rebinding is a no-op with a working vertex array object and required without one
+    if (levelOfDetail && m_levelOfDetailIndexCount > 0) {
+        m_levelOfDetailIndexBuffer.bind();
+        f->glDrawElements(GL_TRIANGLES, m_levelOfDetailIndexCount, m_meshIndexType, nullptr);
+        return;
+    }
+    m_indexBuffer.bind();
+    f->glDrawElements(GL_TRIANGLES, m_meshIndexCount, m_meshIndexType, nullptr);
+}
+
+void ModelOpenGLObject::copyLevelOfDetailToOpenGL()
+{
+    std::vector<GLuint> indices;
+    {
+        QMutexLocker lock(&m_levelOfDetail->mutex);
+        // Only once the vertices it indexes into are uploaded
+        if (!m_levelOfDetail->isDirty || m_levelOfDetail->serial != m_uploadedMeshSerial)
+            return;
+        m_levelOfDetail->isDirty = false;
+        indices = std::move(m_levelOfDetail->indices);
+    }
+    m_levelOfDetailIndexCount = 0;
+    if (indices.empty())
+        return;
+    QOpenGLVertexArrayObject::Binder binder(&m_vertexArrayObject);
+    if (m_levelOfDetailIndexBuffer.isCreated())
+        m_levelOfDetailIndexBuffer.destroy();
+    m_levelOfDetailIndexBuffer.create();
+    m_levelOfDetailIndexBuffer.bind();
+    if (GL_UNSIGNED_SHORT == m_meshIndexType) {
+        std::vector<GLushort> shortIndices(indices.begin(), indices.end());
+        m_levelOfDetailIndexBuffer.allocate(shortIndices.data(), (int)(shortIndices.size() * sizeof(GLushort)));
+    } else {
+        m_levelOfDetailIndexBuffer.allocate(indices.data(), (int)(indices.size() * sizeof(GLuint)));
+    }
+    m_levelOfDetailIndexCount = (int)indices.size();
 }
 
 void ModelOpenGLObject::copyMeshToOpenGL()
 {
-    std::unique_ptr<ModelMesh> mesh;
+    std::shared_ptr<const ModelOpenGLPackedMesh> mesh;
+    uint64_t meshSerial = 0;
     bool meshChanged = false;
     if (m_meshIsDirty) {
         QMutexLocker lock(&m_meshMutex);
@@ -30,19 +144,39 @@ void ModelOpenGLObject::copyMeshToOpenGL()
             m_meshIsDirty = false;
             meshChanged = true;
             mesh = std::move(m_mesh);
+            meshSerial = m_pendingMeshSerial;
         }
     }
-    if (!meshChanged)
+    if (!meshChanged) {
+        copyLevelOfDetailToOpenGL();
         return;
-    m_meshTriangleVertexCount = 0;
-    if (mesh) {
+    }
+    m_meshIndexCount = 0;
+    m_levelOfDetailIndexCount = 0;
+    m_uploadedMeshSerial = mesh ? meshSerial : 0;
+    if (mesh && !mesh->indices.empty()) {
         QOpenGLVertexArrayObject::Binder binder(&m_vertexArrayObject);
         if (m_buffer.isCreated())
             m_buffer.destroy();
         m_buffer.create();
         m_buffer.bind();
-        m_buffer.allocate(mesh->triangleVertices(), mesh->triangleVertexCount() * sizeof(ModelOpenGLVertex));
-        m_meshTriangleVertexCount = mesh->triangleVertexCount();
+        m_buffer.allocate(mesh->vertices.data(), (int)(mesh->vertices.size() * sizeof(ModelOpenGLPackedVertex)));
+
+        if (m_indexBuffer.isCreated())
+            m_indexBuffer.destroy();
+        m_indexBuffer.create();
+        m_indexBuffer.bind();
+        // 16-bit indices whenever they fit, which is also all that OpenGL ES 2 guarantees
+        if (mesh->vertices.size() <= std::numeric_limits<GLushort>::max() + 1) {
+            std::vector<GLushort> shortIndices(mesh->indices.begin(), mesh->indices.end());
+            m_indexBuffer.allocate(shortIndices.data(), (int)(shortIndices.size() * sizeof(GLushort)));
+            m_meshIndexType = GL_UNSIGNED_SHORT;
+        } else {
+            m_indexBuffer.allocate(mesh->indices.data(), (int)(mesh->indices.size() * sizeof(GLuint)));
+            m_meshIndexType = GL_UNSIGNED_INT;
+        }
+        m_meshIndexCount = (int)mesh->indices.size();
+
         QOpenGLFunctions* f = QOpenGLContext::currentContext()->functions();
         f->glEnableVertexAttribArray(0);
         f->glEnableVertexAttribArray(1);
@@ -52,14 +186,15 @@ void ModelOpenGLObject::copyMeshToOpenGL()
         f->glEnableVertexAttribArray(5);
         f->glEnableVertexAttribArray(6);
         f->glEnableVertexAttribArray(7);
-        f->glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(ModelOpenGLVertex), 0);
-        f->glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(ModelOpenGLVertex), reinterpret_cast<void*>(3 * sizeof(GLfloat)));
-        f->glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(ModelOpenGLVertex), reinterpret_cast<void*>(6 * sizeof(GLfloat)));
-        f->glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(ModelOpenGLVertex), reinterpret_cast<void*>(9 * sizeof(GLfloat)));
-        f->glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(ModelOpenGLVertex), reinterpret_cast<void*>(11 * sizeof(GLfloat)));
-        f->glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, sizeof(ModelOpenGLVertex), reinterpret_cast<void*>(12 * sizeof(GLfloat)));
-        f->glVertexAttribPointer(6, 3, GL_FLOAT, GL_FALSE, sizeof(ModelOpenGLVertex), reinterpret_cast<void*>(13 * sizeof(GLfloat)));
-        f->glVertexAttribPointer(7, 1, GL_FLOAT, GL_FALSE, sizeof(ModelOpenGLVertex), reinterpret_cast<void*>(16 * sizeof(GLfloat)));
+        f->glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(ModelOpenGLPackedVertex), reinterpret_cast<void*>(offsetof(ModelOpenGLPackedVertex, posX)));
+        f->glVertexAttribPointer(1, 3, GL_SHORT, GL_TRUE, sizeof(ModelOpenGLPackedVertex), reinterpret_cast<void*>(offsetof(ModelOpenGLPackedVertex, normX)));
+        f->glVertexAttribPointer(2, 3, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ModelOpenGLPackedVertex), reinterpret_cast<void*>(offsetof(ModelOpenGLPackedVertex, colorR)));
+        f->glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(ModelOpenGLPackedVertex), reinterpret_cast<void*>(offsetof(ModelOpenGLPackedVertex, texU)));
+        f->glVertexAttribPointer(4, 1, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ModelOpenGLPackedVertex), reinterpret_cast<void*>(offsetof(ModelOpenGLPackedVertex, metalness)));
+        f->glVertexAttribPointer(5, 1, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ModelOpenGLPackedVertex), reinterpret_cast<void*>(offsetof(ModelOpenGLPackedVertex, roughness)));
+        f->glVertexAttribPointer(6, 3, GL_SHORT, GL_TRUE, sizeof(ModelOpenGLPackedVertex), reinterpret_cast<void*>(offsetof(ModelOpenGLPackedVertex, tangentX)));
+        f->glVertexAttribPointer(7, 1, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ModelOpenGLPackedVertex), reinterpret_cast<void*>(offsetof(ModelOpenGLPackedVertex, alpha)));
         m_buffer.release();
     }
+    copyLevelOfDetailToOpenGL();
 }
\ No newline at end of file
@@ -6,20 +6,50 @@
 #include <QOpenGLBuffer>
 #include <QOpenGLVertexArrayObject>
 #include <memory>
+#include <vector>
 
+// Mesh handed to update() is drawn from its welded, packed vertices, which the worker building the mesh
+// usually packed already, so update() only swaps them in and the triangle soup is never uploaded.
+// With level of detail enabled, large meshes also get a simplified index list built in the background,
+// which draw() uses over the same vertices when asked to, such as while the view is being orbited.
+// Only one simplification runs at a time, and it always picks up the latest mesh, so a burst of updates
+// does not queue a job per mesh. Meshes replaced every frame, such as animation frames, should skip it.
 class ModelOpenGLObject {
 public:
-    void update(std::unique_ptr<ModelMesh> mesh);
-    void draw();
+    void setLevelOfDetailEnabled(bool enabled);
+    void update(std::unique_ptr<ModelMesh> mesh, bool levelOfDetail = true);
+    void draw(bool levelOfDetail = false);
 
 private:
+    // Shared with the background simplification, which may outlive this object
+    struct LevelOfDetail {
+        QMutex mutex;
+        uint64_t serial = 0;
+        std::vector<GLuint> indices;
+        bool isDirty = false;
+        // Latest mesh waiting for the running simplification to pick it up
+        std::shared_ptr<const ModelOpenGLPackedMesh> pendingMesh;
+        bool isBuilding = false;
+    };
+
+    void buildLevelOfDetail(std::shared_ptr<const ModelOpenGLPackedMesh> mesh, uint64_t serial);
+    void copyLevelOfDetailToOpenGL();
     void copyMeshToOpenGL();
     QOpenGLVertexArrayObject m_vertexArrayObject;
     QOpenGLBuffer m_buffer;
-    std::unique_ptr<ModelMesh> m_mesh;
+    QOpenGLBuffer m_indexBuffer = QOpenGLBuffer(QOpenGLBuffer::IndexBuffer);
+    std::shared_ptr<const ModelOpenGLPackedMesh> m_mesh;
+    uint64_t m_pendingMeshSerial = 0;
     bool m_meshIsDirty = false;
     QMutex m_meshMutex;
-    int m_meshTriangleVertexCount = 0;
+    int m_meshIndexCount = 0;
+    GLenum m_meshIndexType = GL_UNSIGNED_SHORT;
+    uint64_t m_meshSerial = 0;
+    uint64_t m_uploadedMeshSerial = 0;
+    bool m_levelOfDetailEnabled = false;
+    std::shared_ptr<LevelOfDetail> m_levelOfDetail = std::make_shared<LevelOfDetail>();
+    QOpenGLBuffer m_levelOfDetailIndexBuffer = QOpenGLBuffer(QOpenGLBuffer::IndexBuffer);
+    int m_levelOfDetailIndexCount = 0;
 };
 
 #endif
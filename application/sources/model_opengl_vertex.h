@@ -2,6 +2,7 @@
 #define DUST3D_APPLICATION_MODEL_OPENGL_VERTEX_H_
 
 #include <QOpenGLFunctions>
+#include <vector>
 
 #pragma pack(push)
 #pragma pack(1)
@@ -24,6 +25,39 @@ struct ModelOpenGLVertex {
     GLfloat tangentZ;
     GLfloat alpha = 1.0f;
 };
+
+// Welded, quantized form of ModelOpenGLVertex uploaded for drawing.
+// Normals and tangents are normalized shorts, color, alpha and material are normalized bytes,
+// so the shaders read the same attributes as from ModelOpenGLVertex.
+// Paddings keep every attribute 4-byte aligned.
+struct ModelOpenGLPackedVertex {
+    GLfloat posX;
+    GLfloat posY;
+    GLfloat posZ;
+    GLshort normX;
+    GLshort normY;
+    GLshort normZ;
+    GLshort normPadding = 0;
+    GLshort tangentX;
+    GLshort tangentY;
+    GLshort tangentZ;
+    GLshort tangentPadding = 0;
+    GLfloat texU;
+    GLfloat texV;
+    GLubyte colorR;
+    GLubyte colorG;
+    GLubyte colorB;
+    GLubyte alpha;
+    GLubyte metalness;
+    GLubyte roughness;
+    GLubyte materialPadding[2] = { 0, 0 };
+};
 #pragma pack(pop)
 
+// Triangle vertices welded into unique packed vertices and an index list
+struct ModelOpenGLPackedMesh {
+    std::vector<ModelOpenGLPackedVertex> vertices;
+    std::vector<GLuint> indices;
+};
+
 #endif
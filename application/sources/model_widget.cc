@@ -227,6 +227,7 @@ bool ModelWidget::inputMouseReleaseEventFromOtherWidget(QMouseEvent* event)
     Q_UNUSED(event);
     if (m_moveStarted) {
         m_moveStarted = false;
+        update();
         return true;
     }
     if (event->button() == Qt::LeftButton) {
@@ -375,8 +376,10 @@ void ModelWidget::updateMesh(ModelMesh* mesh)
         mesh && mesh->hasRoughnessInImage(),
         mesh && mesh->hasAmbientOcclusionInImage());
 
-    if (!m_modelOpenGLObject)
+    if (!m_modelOpenGLObject) {
         m_modelOpenGLObject = std::make_unique<ModelOpenGLObject>();
+        m_modelOpenGLObject->setLevelOfDetailEnabled(true);
+    }
     m_modelOpenGLObject->update(std::unique_ptr<ModelMesh>(mesh));
 
     emit renderParametersChanged();
@@ -549,8 +552,9 @@ void ModelWidget::drawModel()
 
     m_modelOpenGLProgram->bindMaps();
 
+    // Large models are drawn simplified while being orbited, and in full again once released
     if (m_modelOpenGLObject)
-        m_modelOpenGLObject->draw();
+        m_modelOpenGLObject->draw(m_moveStarted);
 
     m_modelOpenGLProgram->releaseMaps();
 
@@ -57,6 +57,84 @@ void Preferences::clearRecentFileList()
     m_settings.remove("recentFileList");
 }
 
+QString Preferences::generationCacheDirectory() const
+{
+    if (!m_generationCacheDirectoryOverride.isEmpty())
+        return m_generationCacheDirectoryOverride;
+    return m_settings.value("generationCacheDirectory").toString();
+}
+
+void Preferences::setGenerationCacheDirectory(const QString& directory)
+{
+    m_settings.setValue("generationCacheDirectory", directory);
+}
+
+// Used for the current process only, such as a batch export given a cache directory on the command line
+void Preferences::overrideGenerationCacheDirectory(const QString& directory)
+{
+    m_generationCacheDirectoryOverride = directory;
+}
+
+bool Preferences::exportLodChain() const
+{
+    return m_settings.value("exportLodChain", false).toBool();
+}
+
+void Preferences::setExportLodChain(bool enabled)
+{
+    if (exportLodChain() == enabled)
+        return;
+    m_settings.setValue("exportLodChain", enabled);
+    emit exportLodChainChanged();
+}
+
+// Triangle ratios of the simplified meshes exported after the full one
+std::vector<float> Preferences::exportLodRatios() const
+{
+    if (!exportLodChain())
+        return std::vector<float>();
+    return { 0.5f, 0.25f, 0.1f };
+}
+
+bool Preferences::exportQuantizedGlb() const
+{
+    return m_settings.value("exportQuantizedGlb", false).toBool();
+}
+
+void Preferences::setExportQuantizedGlb(bool enabled)
+{
+    if (exportQuantizedGlb() == enabled)
+        return;
+    m_settings.setValue("exportQuantizedGlb", enabled);
+    emit exportQuantizedGlbChanged();
+}
+
+bool Preferences::exportMeshoptGlb() const
+{
+    return m_settings.value("exportMeshoptGlb", false).toBool();
+}
+
+void Preferences::setExportMeshoptGlb(bool enabled)
+{
+    if (exportMeshoptGlb() == enabled)
+        return;
+    m_settings.setValue("exportMeshoptGlb", enabled);
+    emit exportMeshoptGlbChanged();
+}
+
+bool Preferences::bakeAmbientOcclusion() const
+{
+    return m_settings.value("bakeAmbientOcclusion", false).toBool();
+}
+
+void Preferences::setBakeAmbientOcclusion(bool enabled)
+{
+    if (bakeAmbientOcclusion() == enabled)
+        return;
+    m_settings.setValue("bakeAmbientOcclusion", enabled);
+    emit bakeAmbientOcclusionChanged();
+}
+
 void Preferences::reset()
 {
     auto files = m_settings.value("recentFileList").toStringList();
@@ -64,4 +142,8 @@ void Preferences::reset()
     m_settings.setValue("recentFileList", files);
 
     loadDefault();
+    emit exportLodChainChanged();
+    emit exportQuantizedGlbChanged();
+    emit exportMeshoptGlbChanged();
+    emit bakeAmbientOcclusionChanged();
 }
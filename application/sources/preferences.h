@@ -4,6 +4,7 @@
 #include <QSettings>
 #include <QSize>
 #include <QStringList>
+#include <vector>
 
 class Preferences : public QObject {
     Q_OBJECT
@@ -15,12 +16,30 @@ public:
     QStringList recentFileList() const;
     int maxRecentFiles() const;
     void clearRecentFileList();
+    QString generationCacheDirectory() const;
+    void setGenerationCacheDirectory(const QString& directory);
+    void overrideGenerationCacheDirectory(const QString& directory);
+    bool exportLodChain() const;
+    std::vector<float> exportLodRatios() const;
+    bool exportQuantizedGlb() const;
+    bool exportMeshoptGlb() const;
+    bool bakeAmbientOcclusion() const;
+signals:
+    void exportLodChainChanged();
+    void exportQuantizedGlbChanged();
+    void exportMeshoptGlbChanged();
+    void bakeAmbientOcclusionChanged();
 public slots:
+    void setExportLodChain(bool enabled);
+    void setExportQuantizedGlb(bool enabled);
+    void setExportMeshoptGlb(bool enabled);
+    void setBakeAmbientOcclusion(bool enabled);
     void setCurrentFile(const QString& fileName);
     void reset();
 
 private:
     QSettings m_settings;
+    QString m_generationCacheDirectoryOverride;
     void loadDefault();
 };
 
@@ -97,6 +97,7 @@ void RigSkeletonMeshWorker::process()
             const dust3d::Vector3 defaultNormal(0, 0, 1);
             std::string weightBoneStd = m_weightBoneName.toStdString();
             bool hasBindings = !m_rigObject->vertexBone1.empty();
+            int weightBone = m_rigObject->findBoneName(weightBoneStd);
 
             qDebug() << "m_weightBoneName:" << m_weightBoneName << "hasBindings:" << hasBindings;
 
@@ -126,14 +127,14 @@ void RigSkeletonMeshWorker::process()
                     dest->roughness = 1.0;
 
                     float weight = 0.0f;
-                    if (hasBindings && !weightBoneStd.empty() && (size_t)vi < m_rigObject->vertexBone1.size()) {
+                    if (hasBindings && -1 != weightBone && (size_t)vi < m_rigObject->vertexBone1.size()) {
                         const auto& b1 = m_rigObject->vertexBone1[vi];
-                        if (b1.first == weightBoneStd) {
+                        if (b1.first == weightBone) {
                             weight += b1.second;
                         }
                         if ((size_t)vi < m_rigObject->vertexBone2.size()) {
                             const auto& b2 = m_rigObject->vertexBone2[vi];
-                            if (b2.first == weightBoneStd) {
+                            if (b2.first == weightBone) {
                                 weight += b2.second;
                             }
                         }
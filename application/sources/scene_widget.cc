@@ -982,8 +982,10 @@ void SceneWidget::updateMesh(ModelMesh* mesh)
     m_modelHasRoughnessInImage = mesh && mesh->hasRoughnessInImage();
     m_modelHasAmbientOcclusionInImage = mesh && mesh->hasAmbientOcclusionInImage();
 
-    if (!m_modelOpenGLObject)
+    if (!m_modelOpenGLObject) {
         m_modelOpenGLObject = std::make_unique<ModelOpenGLObject>();
+        m_modelOpenGLObject->setLevelOfDetailEnabled(true);
+    }
     m_modelOpenGLObject->update(std::unique_ptr<ModelMesh>(mesh));
 
     emit renderParametersChanged();
@@ -1528,7 +1530,7 @@ void SceneWidget::drawShadowPass()
         m_shadowOpenGLProgram->getUniformLocationByName("modelMatrix"), m_world);
 
     if (m_modelOpenGLObject)
-        m_modelOpenGLObject->draw();
+        m_modelOpenGLObject->draw(m_moveStarted);
     for (const auto& previewObject : m_previewOpenGLObjects) {
         if (previewObject)
             previewObject->draw();
@@ -1567,7 +1569,7 @@ void SceneWidget::drawWorldModel()
             m_modelHasRoughnessInImage,
             m_modelHasAmbientOcclusionInImage);
         m_worldOpenGLProgram->bindMaps(m_shadowDepthTexture);
-        m_modelOpenGLObject->draw();
+        m_modelOpenGLObject->draw(m_moveStarted);
         m_worldOpenGLProgram->releaseMaps();
     }
 
@@ -1671,7 +1673,7 @@ void SceneWidget::drawOutline()
         m_outlineOpenGLProgram->getUniformLocationByName("outlineWidth"), 0.003f);
 
     if (m_modelOpenGLObject)
-        m_modelOpenGLObject->draw();
+        m_modelOpenGLObject->draw(m_moveStarted);
     for (const auto& previewObject : m_previewOpenGLObjects) {
         if (previewObject)
             previewObject->draw();
@@ -1808,6 +1810,9 @@ void SceneWidget::wheelEvent(QWheelEvent* event)
 void SceneWidget::mouseReleaseEvent(QMouseEvent* event)
 {
     Q_UNUSED(event);
-    if (m_moveStarted)
+    if (m_moveStarted) {
         m_moveStarted = false;
+        // Back to the full mesh, which is only drawn simplified while orbiting
+        update();
+    }
 }
@@ -0,0 +1,143 @@
+#include "skeleton_graphics_item_index.h"
+#include <algorithm>
+#include <cmath>
+
+SkeletonGraphicsItemIndex::CellRange SkeletonGraphicsItemIndex::cellRange(const QRectF& rect)
+{
+    CellRange range;
+    range.left = (int)std::floor(rect.left() / m_cellSize);
+    range.top = (int)std::floor(rect.top() / m_cellSize);
+    range.right = (int)std::floor(rect.right() / m_cellSize);
+    range.bottom = (int)std::floor(rect.bottom() / m_cellSize);
+    return range;
+}
+
+uint64_t SkeletonGraphicsItemIndex::cellKey(int x, int y)
+{
+    return ((uint64_t)(uint32_t)x << 32) | (uint64_t)(uint32_t)y;
+}
+
+void SkeletonGraphicsItemIndex::insertIntoCells(QGraphicsItem* item, const IndexedItem& indexedItem)
+{
+    if (indexedItem.isOversized) {
+        m_oversizedItems.insert(item);
+        return;
+    }
+    for (int x = indexedItem.cells.left; x <= indexedItem.cells.right; ++x) {
+        for (int y = indexedItem.cells.top; y <= indexedItem.cells.bottom; ++y)
+            m_cells[cellKey(x, y)].push_back(item);
+    }
+}
+
+void SkeletonGraphicsItemIndex::removeFromCells(QGraphicsItem* item, const IndexedItem& indexedItem)
+{
+    if (indexedItem.isOversized) {
+        m_oversizedItems.erase(item);
+        return;
+    }
+    for (int x = indexedItem.cells.left; x <= indexedItem.cells.right; ++x) {
+        for (int y = indexedItem.cells.top; y <= indexedItem.cells.bottom; ++y) {
+            auto findCell = m_cells.find(cellKey(x, y));
+            if (findCell == m_cells.end())
+                continue;
+            auto& cellItems = findCell->second;
+            auto findItem = std::find(cellItems.begin(), cellItems.end(), item);
+            if (findItem != cellItems.end()) {
+                *findItem = cellItems.back();
+                cellItems.pop_back();
+            }
+            if (cellItems.empty())
+                m_cells.erase(findCell);
+        }
+    }
+}
+
+void SkeletonGraphicsItemIndex::update(QGraphicsItem* item)
+{
+    CellRange range = cellRange(item->sceneBoundingRect());
+    bool isOversized = (int64_t)(range.right - range.left + 1) * (range.bottom - range.top + 1) > m_maxCellCount;
+
+    auto findItem = m_indexedItems.find(item);
+    if (findItem != m_indexedItems.end()) {
+        // Most moves stay within the same cells
+        if (findItem->second.cells == range && findItem->second.isOversized == isOversized)
+            return;
+        removeFromCells(item, findItem->second);
+    } else {
+        findItem = m_indexedItems.insert({ item, IndexedItem() }).first;
+        findItem->second.order = m_nextOrder++;
+    }
+    findItem->second.cells = range;
+    findItem->second.isOversized = isOversized;
+    insertIntoCells(item, findItem->second);
+}
+
+void SkeletonGraphicsItemIndex::remove(QGraphicsItem* item)
+{
+    auto findItem = m_indexedItems.find(item);
+    if (findItem == m_indexedItems.end())
+        return;
+    removeFromCells(item, findItem->second);
+    m_indexedItems.erase(findItem);
+}
+
+void SkeletonGraphicsItemIndex::clear()
+{
+    m_indexedItems.clear();
+    m_cells.clear();
+    m_oversizedItems.clear();
+}
+
+std::vector<QGraphicsItem*> SkeletonGraphicsItemIndex::candidates(const CellRange& range) const
+{
+    std::vector<QGraphicsItem*> result(m_oversizedItems.begin(), m_oversizedItems.end());
+    int64_t rangeCellCount = (int64_t)(range.right - range.left + 1) * (range.bottom - range.top + 1);
+    if (rangeCellCount > (int64_t)m_cells.size()) {
+        // A range larger than the occupied cells is cheaper to test against them
+        for (const auto& it : m_cells) {
+            int x = (int32_t)(uint32_t)(it.first >> 32);
+            int y = (int32_t)(uint32_t)(it.first & 0xffffffff);
+            if (x >= range.left && x <= range.right && y >= range.top && y <= range.bottom)
+                result.insert(result.end(), it.second.begin(), it.second.end());
+        }
+    } else {
+        for (int x = range.left; x <= range.right; ++x) {
+            for (int y = range.top; y <= range.bottom; ++y) {
+                auto findCell = m_cells.find(cellKey(x, y));
+                if (findCell == m_cells.end())
+                    continue;
+                result.insert(result.end(), findCell->second.begin(), findCell->second.end());
+            }
+        }
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+std::vector<QGraphicsItem*> SkeletonGraphicsItemIndex::items(const QPointF& scenePos) const
+{
+    std::vector<QGraphicsItem*> result;
+    for (const auto& item : candidates(cellRange(QRectF(scenePos, scenePos)))) {
+        if (item->isVisible() && item->contains(item->mapFromScene(scenePos)))
+            result.push_back(item);
+    }
+    // Items added later are drawn on top
+    std::sort(result.begin(), result.end(), [&](QGraphicsItem* first, QGraphicsItem* second) {
+        return m_indexedItems.at(first).order > m_indexedItems.at(second).order;
+    });
+    return result;
+}
+
+std::vector<QGraphicsItem*> SkeletonGraphicsItemIndex::items(const QPainterPath& scenePath) const
+{
+    std::vector<QGraphicsItem*> result;
+    for (const auto& item : candidates(cellRange(scenePath.boundingRect()))) {
+        if (item->isVisible() && item->collidesWithPath(item->mapFromScene(scenePath), Qt::IntersectsItemShape))
+            result.push_back(item);
+    }
+    std::sort(result.begin(), result.end(), [&](QGraphicsItem* first, QGraphicsItem* second) {
+        return m_indexedItems.at(first).order > m_indexedItems.at(second).order;
+    });
+    return result;
+}
@@ -0,0 +1,59 @@
+#ifndef DUST3D_APPLICATION_SKELETON_GRAPHICS_ITEM_INDEX_H_
+#define DUST3D_APPLICATION_SKELETON_GRAPHICS_ITEM_INDEX_H_
+
+#include <QGraphicsItem>
+#include <QPainterPath>
+#include <QPointF>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Uniform grid over the scene bounding rectangles of the node and edge items,
+// so hit testing only looks at the items around the queried point or shape.
+// The owner calls update after changing the geometry of an item, and remove before deleting it.
+// Query results are ordered topmost first, the way QGraphicsScene returns them.
+class SkeletonGraphicsItemIndex {
+public:
+    void update(QGraphicsItem* item);
+    void remove(QGraphicsItem* item);
+    void clear();
+    // Visible items whose shape contains the point
+    std::vector<QGraphicsItem*> items(const QPointF& scenePos) const;
+    // Visible items whose shape intersects the path
+    std::vector<QGraphicsItem*> items(const QPainterPath& scenePath) const;
+
+private:
+    struct CellRange {
+        int left = 0;
+        int top = 0;
+        int right = -1;
+        int bottom = -1;
+        bool operator==(const CellRange& other) const
+        {
+            return left == other.left && top == other.top && right == other.right && bottom == other.bottom;
+        }
+    };
+    struct IndexedItem {
+        CellRange cells;
+        bool isOversized = false;
+        uint64_t order = 0;
+    };
+
+    static constexpr double m_cellSize = 64.0;
+    // Items covering more cells than this, such as long edges, are kept aside and always tested
+    static constexpr int m_maxCellCount = 64;
+
+    std::unordered_map<QGraphicsItem*, IndexedItem> m_indexedItems;
+    std::unordered_map<uint64_t, std::vector<QGraphicsItem*>> m_cells;
+    std::unordered_set<QGraphicsItem*> m_oversizedItems;
+    uint64_t m_nextOrder = 0;
+
+    static CellRange cellRange(const QRectF& rect);
+    static uint64_t cellKey(int x, int y);
+    void insertIntoCells(QGraphicsItem* item, const IndexedItem& indexedItem);
+    void removeFromCells(QGraphicsItem* item, const IndexedItem& indexedItem);
+    std::vector<QGraphicsItem*> candidates(const CellRange& range) const;
+};
+
+#endif
@@ -930,7 +930,7 @@ bool SkeletonGraphicsWidget::mouseMove(QMouseEvent* event)
         SkeletonGraphicsEdgeItem* newHoverEdgeItem = nullptr;
         SkeletonGraphicsOriginItem* newHoverOriginItem = nullptr;
         QPointF scenePos = mouseEventScenePos(event);
-        QList<QGraphicsItem*> items = scene()->items(scenePos);
+        std::vector<QGraphicsItem*> items = m_itemIndex.items(scenePos);
         std::vector<std::pair<QGraphicsItem*, float>> itemDistance2MapWithMouse;
         for (auto it = items.begin(); it != items.end(); it++) {
             QGraphicsItem* item = *it;
@@ -952,10 +952,13 @@ bool SkeletonGraphicsWidget::mouseMove(QMouseEvent* event)
                     float distance2 = pow(origin.x() - scenePos.x(), 2) + pow(origin.y() - scenePos.y(), 2);
                     itemDistance2MapWithMouse.push_back(std::make_pair(item, distance2));
                 }
-            } else if (item->data(0) == "origin") {
-                newHoverOriginItem = (SkeletonGraphicsOriginItem*)item;
             }
         }
+        // The origin items are not indexed, there are only two of them
+        for (auto originItem : { m_sideOriginItem, m_mainOriginItem }) {
+            if (originItem->isVisible() && originItem->contains(originItem->mapFromScene(scenePos)))
+                newHoverOriginItem = originItem;
+        }
         if (!itemDistance2MapWithMouse.empty()) {
             std::sort(itemDistance2MapWithMouse.begin(), itemDistance2MapWithMouse.end(),
                 [](const std::pair<QGraphicsItem*, float>& a, const std::pair<QGraphicsItem*, float>& b) {
@@ -1642,6 +1645,7 @@ bool SkeletonGraphicsWidget::mouseRelease(QMouseEvent* event)
             m_lastRot = 0;
             if (m_moveHappened)
                 emit groupOperationAdded();
+            emit interactiveMoveEnd();
         }
         if (m_rangeSelectionStarted) {
             m_selectionItem->hide();
@@ -1728,6 +1732,7 @@ bool SkeletonGraphicsWidget::mousePress(QMouseEvent* event)
                     m_lastScenePos = mouseEventScenePos(event);
                     m_moveHappened = false;
                     processed = true;
+                    emit interactiveMoveBegin();
                 }
             } else {
                 if ((nullptr == m_hoveredNodeItem || m_rangeSelectionSet.find(m_hoveredNodeItem) == m_rangeSelectionSet.end()) && (nullptr == m_hoveredEdgeItem || m_rangeSelectionSet.find(m_hoveredEdgeItem) == m_rangeSelectionSet.end())) {
@@ -1756,6 +1761,7 @@ bool SkeletonGraphicsWidget::mousePress(QMouseEvent* event)
                             m_lastScenePos = mouseEventScenePos(event);
                             m_moveHappened = false;
                             processed = true;
+                            emit interactiveMoveBegin();
                         }
                     }
                 }
@@ -2346,6 +2352,8 @@ void SkeletonGraphicsWidget::nodeAdded(dust3d::Uuid nodeId)
     sideProfileItem->setId(nodeId);
     scene()->addItem(mainProfileItem);
     scene()->addItem(sideProfileItem);
+    m_itemIndex.update(mainProfileItem);
+    m_itemIndex.update(sideProfileItem);
     nodeItemMap[nodeId] = std::make_pair(mainProfileItem, sideProfileItem);
 
     if (nullptr == m_addFromNodeItem) {
@@ -2377,6 +2385,8 @@ void SkeletonGraphicsWidget::edgeReversed(dust3d::Uuid edgeId)
     }
     edgeItemIt->second.first->reverse();
     edgeItemIt->second.second->reverse();
+    m_itemIndex.update(edgeItemIt->second.first);
+    m_itemIndex.update(edgeItemIt->second.second);
 }
 
 void SkeletonGraphicsWidget::edgeNodeChanged(const dust3d::Uuid& edgeId)
@@ -2409,6 +2419,8 @@ void SkeletonGraphicsWidget::edgeNodeChanged(const dust3d::Uuid& edgeId)
     }
     edgeIt->second.first->setEndpoints(fromIt->second.first, toIt->second.first);
     edgeIt->second.second->setEndpoints(fromIt->second.second, toIt->second.second);
+    m_itemIndex.update(edgeIt->second.first);
+    m_itemIndex.update(edgeIt->second.second);
 }
 
 void SkeletonGraphicsWidget::edgeAdded(dust3d::Uuid edgeId)
@@ -2448,6 +2460,8 @@ void SkeletonGraphicsWidget::edgeAdded(dust3d::Uuid edgeId)
     sideProfileEdgeItem->setEndpoints(fromIt->second.second, toIt->second.second);
     scene()->addItem(mainProfileEdgeItem);
     scene()->addItem(sideProfileEdgeItem);
+    m_itemIndex.update(mainProfileEdgeItem);
+    m_itemIndex.update(sideProfileEdgeItem);
     edgeItemMap[edgeId] = std::make_pair(mainProfileEdgeItem, sideProfileEdgeItem);
 }
 
@@ -2461,6 +2475,7 @@ void SkeletonGraphicsWidget::removeItem(QGraphicsItem* item)
         m_hoveredEdgeItem = nullptr;
     if (m_rangeSelectionSet.erase(item) > 0)
         emit skeletonSelectionChanged();
+    m_itemIndex.remove(item);
     scene()->removeItem(item);
 }
 
@@ -2510,6 +2525,8 @@ void SkeletonGraphicsWidget::nodeRadiusChanged(dust3d::Uuid nodeId)
     float sceneRadius = sceneRadiusFromUnified(node->radius);
     it->second.first->setRadius(sceneRadius);
     it->second.second->setRadius(sceneRadius);
+    m_itemIndex.update(it->second.first);
+    m_itemIndex.update(it->second.second);
 }
 
 void SkeletonGraphicsWidget::nodeOriginChanged(dust3d::Uuid nodeId)
@@ -2532,6 +2549,8 @@ void SkeletonGraphicsWidget::nodeOriginChanged(dust3d::Uuid nodeId)
     it->second.second->setOrigin(sidePos);
     it->second.second->setRotated(m_rotated);
     it->second.second->updateAppearance();
+    m_itemIndex.update(it->second.first);
+    m_itemIndex.update(it->second.second);
     for (auto edgeIt = node->edgeIds.begin(); edgeIt != node->edgeIds.end(); edgeIt++) {
         auto edgeItemIt = edgeItemMap.find(*edgeIt);
         if (edgeItemIt == edgeItemMap.end()) {
@@ -2542,6 +2561,8 @@ void SkeletonGraphicsWidget::nodeOriginChanged(dust3d::Uuid nodeId)
         edgeItemIt->second.first->updateAppearance();
         edgeItemIt->second.second->setRotated(m_rotated);
         edgeItemIt->second.second->updateAppearance();
+        m_itemIndex.update(edgeItemIt->second.first);
+        m_itemIndex.update(edgeItemIt->second.second);
     }
 }
 
@@ -2672,7 +2693,7 @@ void SkeletonGraphicsWidget::checkRangeSelection()
         choosenProfile = readSkeletonItemProfile(*it);
     }
     if (m_selectionItem->isVisible()) {
-        QList<QGraphicsItem*> items = scene()->items(m_selectionItem->selectionShape(), Qt::IntersectsItemShape);
+        std::vector<QGraphicsItem*> items = m_itemIndex.items(m_selectionItem->selectionShape());
         for (auto it = items.begin(); it != items.end(); it++) {
             QGraphicsItem* item = *it;
             if (QGuiApplication::queryKeyboardModifiers().testFlag(Qt::AltModifier)) {
@@ -3107,6 +3128,7 @@ void SkeletonGraphicsWidget::removeAllContent()
 {
     nodeItemMap.clear();
     edgeItemMap.clear();
+    m_itemIndex.clear();
     m_rangeSelectionSet.clear();
     m_hoveredEdgeItem = nullptr;
     m_hoveredNodeItem = nullptr;
@@ -3,6 +3,7 @@
 
 #include "document.h"
 #include "model_widget.h"
+#include "skeleton_graphics_item_index.h"
 #include "skeleton_ik_mover.h"
 #include "theme.h"
 #include "turnaround_loader.h"
@@ -49,6 +50,8 @@ signals:
     void droppedDs3File(const QString& filename);
     void batchChangeBegin();
     void batchChangeEnd();
+    void interactiveMoveBegin();
+    void interactiveMoveEnd();
     void open();
     void exportResult();
     void breakEdge(dust3d::Uuid edgeId);
@@ -299,6 +302,7 @@ private:
     QVector3D m_ikMoveTarget;
     dust3d::Uuid m_ikMoveEndEffectorId;
     std::set<QGraphicsItem*> m_rangeSelectionSet;
+    SkeletonGraphicsItemIndex m_itemIndex;
     QPoint m_lastGlobalPos;
     QPointF m_lastScenePos;
     QPointF m_rangeSelectionStartPos;
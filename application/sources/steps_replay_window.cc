@@ -107,6 +107,14 @@ StepsReplayWindow::StepsReplayWindow(Document* sourceDocument, QWidget* parent)
     m_demoDocument->setOriginY(m_sourceDocument->getOriginY());
     m_demoDocument->setOriginZ(m_sourceDocument->getOriginZ());
 
+    // Steps set the color images of the source document, which may drop them from its history while replaying
+    std::set<dust3d::Uuid> imageIds;
+    for (const auto& it : m_sourceDocument->componentMap) {
+        if (!it.second.colorImageId.isNull())
+            imageIds.insert(it.second.colorImageId);
+    }
+    m_imageReferences = std::make_unique<ImageForever::References>(imageIds);
+
     buildSteps();
 
     // Auto-execute background image setup steps so the overlay is already hidden
@@ -1,6 +1,7 @@
 #ifndef DUST3D_APPLICATION_STEPS_REPLAY_WINDOW_H_
 #define DUST3D_APPLICATION_STEPS_REPLAY_WINDOW_H_
 
+#include "image_forever.h"
 #include <QLabel>
 #include <QPushButton>
 #include <QSlider>
@@ -8,6 +9,7 @@
 #include <QWidget>
 #include <dust3d/base/uuid.h>
 #include <functional>
+#include <memory>
 #include <vector>
 
 class Document;
@@ -60,6 +62,7 @@ private:
 
     std::vector<ReplayStep> m_steps;
     int m_currentStep = -1;
+    std::unique_ptr<ImageForever::References> m_imageReferences;
 };
 
 #endif
@@ -4,12 +4,16 @@
 #include <QTransform>
 #include <cmath>
 #include <dust3d/base/part_target.h>
+#include <dust3d/mesh/resolve_triangle_tangent.h>
+#include <dust3d/uv/texture_baker.h>
 #include <dust3d/uv/uv_map_packer.h>
 #include <map>
 #include <queue>
 #include <unordered_set>
 
 size_t UvMapGenerator::m_textureSize = 4096;
+size_t UvMapGenerator::m_bakedTextureSize = 512;
+size_t UvMapGenerator::m_ambientOcclusionSampleCount = 16;
 
 UvMapGenerator::UvMapGenerator(std::unique_ptr<dust3d::Object> object, std::unique_ptr<dust3d::Snapshot> snapshot)
     : m_object(std::move(object))
@@ -23,6 +27,11 @@ void UvMapGenerator::process()
     emit finished();
 }
 
+void UvMapGenerator::setAmbientOcclusionBaked(bool baked)
+{
+    m_isAmbientOcclusionBaked = baked;
+}
+
 std::unique_ptr<QImage> UvMapGenerator::takeResultTextureColorImage()
 {
     return std::move(m_textureColorImage);
@@ -164,7 +173,10 @@ void UvMapGenerator::packUvs()
                 gradientImage.setPixelColor(x, y, QColor(r, g, b, a));
             }
         }
+        // Held until painted, a collect() from the document thread would drop an unowned id
         dust3d::Uuid gradientId = ImageForever::add(&gradientImage);
+        ImageForever::retain(gradientId);
+        m_seamGradientImageIds.push_back(gradientId);
 
         dust3d::UvMapPacker::Part seamPart;
         seamPart.id = gradientId;
@@ -219,7 +231,7 @@ void UvMapGenerator::packUvs()
         }
         return total;
     };
-    auto componentColorImage = [&](const std::map<std::string, std::string>& component) -> const QImage* {
+    auto componentColorImage = [&](const std::map<std::string, std::string>& component) -> std::shared_ptr<const QImage> {
         const auto& colorImageIdIt = component.find("colorImageId");
         if (colorImageIdIt == component.end())
             return nullptr;
@@ -261,7 +273,7 @@ void UvMapGenerator::packUvs()
         if (colorIt != componentIt->second.end()) {
             color = dust3d::Color(colorIt->second);
         }
-        const QImage* image = componentColorImage(componentIt->second);
+        auto image = componentColorImage(componentIt->second);
         if (nullptr != image) {
             const auto& colorImageIdIt = componentIt->second.find("colorImageId");
             imageId = dust3d::Uuid(colorImageIdIt->second);
@@ -339,7 +351,7 @@ void UvMapGenerator::generateTextureColorImage()
             brushPixmap = QPixmap(chartW + bleedPixels * 2, chartH + bleedPixels * 2);
             brushPixmap.fill(QColor(QString::fromStdString(layout.color.toString())));
         } else {
-            const QImage* image = ImageForever::get(layout.id);
+            auto image = ImageForever::get(layout.id);
             if (nullptr == image) {
                 dust3dDebug << "Find image failed:" << layout.id.toString();
                 continue;
@@ -468,6 +480,43 @@ void UvMapGenerator::generateUvCoords()
     m_object->setTriangleVertexUvs(triangleUvs);
 }
 
+void UvMapGenerator::bakeAmbientOcclusionImage()
+{
+    if (nullptr == m_object->triangleTangents()) {
+        std::vector<dust3d::Vector3> triangleTangents;
+        dust3d::resolveTriangleTangent(*m_object, triangleTangents);
+        m_object->setTriangleTangents(triangleTangents);
+    }
+
+    dust3d::TextureBaker textureBaker(m_object.get());
+    textureBaker.setTextureSize(UvMapGenerator::m_bakedTextureSize);
+    textureBaker.setAmbientOcclusionSampleCount(UvMapGenerator::m_ambientOcclusionSampleCount);
+    if (!textureBaker.bake())
+        return;
+
+    const int size = (int)textureBaker.textureSize();
+    const QRgb emptyPixel = qRgba(0, 255, 0, 0);
+    const auto& texelCoverage = textureBaker.texelCoverage();
+    const auto& ambientOcclusionMap = textureBaker.ambientOcclusionMap();
+
+    m_textureAmbientOcclusionImage = std::make_unique<QImage>(size, size, QImage::Format_ARGB32);
+    for (int y = 0; y < size; ++y) {
+        QRgb* ambientOcclusionLine = (QRgb*)m_textureAmbientOcclusionImage->scanLine(y);
+        for (int x = 0; x < size; ++x) {
+            size_t texelIndex = (size_t)y * size + x;
+            if (!texelCoverage[texelIndex]) {
+                ambientOcclusionLine[x] = emptyPixel;
+                continue;
+            }
+            int gray = qBound(0, (int)std::round(ambientOcclusionMap[texelIndex] * 255.0f), 255);
+            ambientOcclusionLine[x] = qRgb(gray, gray, gray);
+        }
+    }
+
+    // Bleed the baked texels across chart borders the same way as the color atlas
+    dilateTexture(m_textureAmbientOcclusionImage.get());
+}
+
 void UvMapGenerator::generate()
 {
     if (nullptr == m_object)
@@ -478,8 +527,21 @@ void UvMapGenerator::generate()
 
     packUvs();
     generateTextureColorImage();
+    for (const auto& imageId : m_seamGradientImageIds)
+        ImageForever::release(imageId);
+    m_seamGradientImageIds.clear();
     generateUvCoords();
+    // Tracing occlusion rays takes far longer than the rest of the texture, so only final results pay for it
+    if (m_isAmbientOcclusionBaked)
+        bakeAmbientOcclusionImage();
 
     m_mesh = std::make_unique<ModelMesh>(*m_object);
+    m_mesh->packTriangleVertices();
     m_mesh->setTextureImage(new QImage(*m_textureColorImage));
+    if (nullptr != m_textureAmbientOcclusionImage) {
+        m_mesh->setMetalnessRoughnessAmbientOcclusionMapImage(combineMetalnessRoughnessAmbientOcclusionImages(nullptr,
+            nullptr,
+            m_textureAmbientOcclusionImage.get()));
+        m_mesh->setHasAmbientOcclusionInImage(true);
+    }
 }
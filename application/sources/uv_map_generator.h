@@ -13,6 +13,7 @@ class UvMapGenerator : public QObject {
     Q_OBJECT
 public:
     UvMapGenerator(std::unique_ptr<dust3d::Object> object, std::unique_ptr<dust3d::Snapshot> snapshot);
+    void setAmbientOcclusionBaked(bool baked);
     void generate();
     std::unique_ptr<QImage> takeResultTextureColorImage();
     std::unique_ptr<QImage> takeResultTextureNormalImage();
@@ -40,11 +41,16 @@ private:
     std::unique_ptr<QImage> m_textureMetalnessImage;
     std::unique_ptr<QImage> m_textureAmbientOcclusionImage;
     std::unique_ptr<ModelMesh> m_mesh;
+    std::vector<dust3d::Uuid> m_seamGradientImageIds;
     bool m_hasTransparencySettings = false;
+    bool m_isAmbientOcclusionBaked = false;
     static size_t m_textureSize;
+    static size_t m_bakedTextureSize;
+    static size_t m_ambientOcclusionSampleCount;
     void packUvs();
     void generateTextureColorImage();
     void generateUvCoords();
+    void bakeAmbientOcclusionImage();
     static void dilateTexture(QImage* image);
 };
 
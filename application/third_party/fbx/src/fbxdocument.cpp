@@ -108,6 +108,15 @@ namespace {
 }
 
 void FBXDocument::write(std::ofstream &output)
+{
+    beginWrite(output);
+    for(const FBXNode &node : nodes) {
+        writeNode(output, node);
+    }
+    endWrite(output);
+}
+
+void FBXDocument::beginWrite(std::ofstream &output)
 {
     Writer writer(&output);
     writer.write("Kaydara FBX Binary  ");
@@ -116,12 +125,19 @@ void FBXDocument::write(std::ofstream &output)
     writer.write((uint8_t) 0);
     writer.write(version);
 
-    uint32_t offset = 27; // magic: 21+2, version: 4
-    for(FBXNode node : nodes) {
-        offset += node.write(output, offset);
-    }
+    writeOffset = 27; // magic: 21+2, version: 4
+}
+
+void FBXDocument::writeNode(std::ofstream &output, const FBXNode &node)
+{
+    writeOffset += node.write(output, writeOffset);
+}
+
+void FBXDocument::endWrite(std::ofstream &output)
+{
+    Writer writer(&output);
     FBXNode nullNode;
-    offset += nullNode.write(output, offset);
+    writeOffset += nullNode.write(output, writeOffset);
     writerFooter(writer);
 }
 
@@ -289,7 +305,7 @@ void FBXDocument::print()
     cout << "  \"version\": " << getVersion() << ",\n";
     cout << "  \"children\": [\n";
     bool hasPrev = false;
-    for(auto node : nodes) {
+    for(auto &node : nodes) {
         if(hasPrev) cout << ",\n";
         node.print("    ");
         hasPrev = true;
@@ -14,6 +14,12 @@ public:
     void write(std::string fname);
     void write(std::ofstream &output);
 
+    // Change to stream nodes in Dust3D project,
+    // the header, then any number of top level nodes, one by one, then the footer
+    void beginWrite(std::ofstream &output);
+    void writeNode(std::ofstream &output, const FBXNode &node);
+    void endWrite(std::ofstream &output);
+
     void createBasicStructure();
 
     std::vector<FBXNode> nodes;
@@ -23,6 +29,7 @@ public:
 
 private:
     std::uint32_t version;
+    std::uint32_t writeOffset = 0;
 };
 
 } // namespace fbx
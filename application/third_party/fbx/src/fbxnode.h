@@ -12,9 +12,9 @@ public:
     FBXNode(std::string name);
 
     std::uint32_t read(std::ifstream &input, uint32_t start_offset);
-    std::uint32_t write(std::ofstream &output, uint32_t start_offset);
+    std::uint32_t write(std::ofstream &output, uint32_t start_offset) const;
     void print(std::string prefix="");
-    bool isNull();
+    bool isNull() const;
 
     void addProperty(int16_t);
     void addProperty(bool);
@@ -22,12 +22,12 @@ public:
     void addProperty(float);
     void addProperty(double);
     void addProperty(int64_t);
-    void addProperty(const std::vector<bool>);
-    void addProperty(const std::vector<int32_t>);
-    void addProperty(const std::vector<float>);
-    void addProperty(const std::vector<double>);
-    void addProperty(const std::vector<int64_t>);
-    void addProperty(const std::vector<uint8_t>, uint8_t type);
+    void addProperty(const std::vector<bool> &);
+    void addProperty(const std::vector<int32_t> &);
+    void addProperty(const std::vector<float> &);
+    void addProperty(const std::vector<double> &);
+    void addProperty(const std::vector<int64_t> &);
+    void addProperty(const std::vector<uint8_t> &, uint8_t type);
     void addProperty(const std::string);
     void addProperty(const char*);
     void addProperty(FBXProperty);
@@ -38,17 +38,19 @@ public:
     void addPropertyNode(const std::string name, float);
     void addPropertyNode(const std::string name, double);
     void addPropertyNode(const std::string name, int64_t);
-    void addPropertyNode(const std::string name, const std::vector<bool>);
-    void addPropertyNode(const std::string name, const std::vector<int32_t>);
-    void addPropertyNode(const std::string name, const std::vector<float>);
-    void addPropertyNode(const std::string name, const std::vector<double>);
-    void addPropertyNode(const std::string name, const std::vector<int64_t>);
-    void addPropertyNode(const std::string name, const std::vector<uint8_t>, uint8_t type);
+    void addPropertyNode(const std::string name, const std::vector<bool> &);
+    void addPropertyNode(const std::string name, const std::vector<int32_t> &);
+    void addPropertyNode(const std::string name, const std::vector<float> &);
+    void addPropertyNode(const std::string name, const std::vector<double> &);
+    void addPropertyNode(const std::string name, const std::vector<int64_t> &);
+    void addPropertyNode(const std::string name, const std::vector<uint8_t> &, uint8_t type);
     void addPropertyNode(const std::string name, const std::string);
     void addPropertyNode(const std::string name, const char*);
 
     void addChild(FBXNode child);
-    uint32_t getBytes();
+    uint32_t getBytes() const;
+    // Change to zlib encode arrays in Dust3D project, gathers the array properties of the whole subtree
+    void collectArrayProperties(std::vector<FBXProperty*> *arrayProperties);
 
     const std::vector<FBXNode> getChildren();
     const std::string getName();
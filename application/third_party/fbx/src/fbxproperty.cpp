@@ -1,5 +1,6 @@
 #include "fbxproperty.h"
 #include "fbxutil.h"
+#include <cstring>
 #include <functional>
 // Change to miniz in Dust3D project
 #include <miniz.h>
@@ -62,16 +63,25 @@ namespace { // helpers for reading properties
         }
     };
 
-    class BufferAutoFree
+    std::vector<uint8_t> inflateArray(const std::vector<uint8_t> &compressed, uint64_t uncompressedLength)
     {
-    public:
-        uint8_t *buffer;
-        BufferAutoFree(uint8_t *buf):buffer(buf) {}
+        std::vector<uint8_t> decompressed(uncompressedLength);
+
+        mz_ulong destLen = uncompressedLength;
+        mz_ulong srcLen = compressed.size();
+        mz_uncompress(decompressed.data(), &destLen, compressed.data(), srcLen);
+
+        if(srcLen != compressed.size()) throw std::string("compressedLength does not match data");
+        if(destLen != uncompressedLength) throw std::string("uncompressedLength does not match data");
+        return decompressed;
+    }
 
-        ~BufferAutoFree() {
-            free(buffer);
+    void appendLittleEndian(std::vector<uint8_t> &bytes, uint64_t bits, int size)
+    {
+        for(int i = 0; i < size; i++) {
+            bytes.push_back((uint8_t)(bits >> (i * 8)));
         }
-    };
+    }
 }
 
 FBXProperty::FBXProperty(std::ifstream &input)
@@ -88,41 +98,16 @@ FBXProperty::FBXProperty(std::ifstream &input)
     } else if(type < 'Z') { // primitive types
         value = readPrimitiveValue(reader, type);
     } else {
-        uint32_t arrayLength = reader.readUint32(); // number of elements in array
-        uint32_t encoding = reader.readUint32(); // 0 .. uncompressed, 1 .. zlib-compressed
+        // array elements are kept as they are stored, and only decoded when printed
+        arrayLength = reader.readUint32(); // number of elements in array
+        encoding = reader.readUint32(); // 0 .. uncompressed, 1 .. zlib-compressed
         uint32_t compressedLength = reader.readUint32();
-        if(encoding) {
-            uint64_t uncompressedLength = arrayElementSize(type - ('a'-'A')) * arrayLength;
-
-            uint8_t *decompressedBuffer = (uint8_t*) malloc(uncompressedLength);
-            if(decompressedBuffer == NULL) throw std::string("Malloc failed");
-            BufferAutoFree baf(decompressedBuffer);
-
-            std::vector<uint8_t> compressedBufferVector(compressedLength);
-            uint8_t *compressedBuffer = compressedBufferVector.data();
-            reader.read((char*)compressedBuffer, compressedLength);
-
-            mz_ulong destLen = uncompressedLength;
-            mz_ulong srcLen = compressedLength;
-            mz_uncompress(decompressedBuffer, &destLen, compressedBuffer, srcLen);
-
-            if(srcLen != compressedLength) throw std::string("compressedLength does not match data");
-            if(destLen != uncompressedLength) throw std::string("uncompressedLength does not match data");
-
-            Reader r((char*)decompressedBuffer);
-
-            for(uint32_t i = 0; i < arrayLength; i++) {
-                values.push_back(readPrimitiveValue(r, type - ('a'-'A')));
-            }
-        } else {
-            for(uint32_t i = 0; i < arrayLength; i++) {
-                values.push_back(readPrimitiveValue(reader, type - ('a'-'A')));
-            }
-        }
+        raw.resize(compressedLength);
+        if(compressedLength) reader.read((char*)raw.data(), compressedLength);
     }
 }
 
-void FBXProperty::write(std::ofstream &output)
+void FBXProperty::write(std::ofstream &output) const
 {
     Writer writer(&output);
 
@@ -141,32 +126,30 @@ void FBXProperty::write(std::ofstream &output)
         writer.write(value.i64);
     } else if(type == 'R' || type == 'S') {
         writer.write((uint32_t)raw.size());
-        for(char c : raw) {
-            writer.write((uint8_t)c);
-        }
+        writer.write((const char*)raw.data(), raw.size());
+    } else if(is_array()) {
+        writer.write(arrayLength);
+        writer.write(encoding);
+        writer.write((uint32_t)raw.size()); // compressedLength
+        writer.write((const char*)raw.data(), raw.size());
     } else {
-        writer.write((uint32_t) values.size()); // arrayLength
-        writer.write((uint32_t) 0); // encoding // TODO: support compression
-        uint32_t compressedLength = 0;
-        if(type == 'f') compressedLength = values.size() * 4;
-        else if(type == 'd') compressedLength = values.size() * 8;
-        else if(type == 'l') compressedLength = values.size() * 8;
-        else if(type == 'i') compressedLength = values.size() * 4;
-        else if(type == 'b') compressedLength = values.size() * 1;
-        else throw std::string("Invalid property");
-        writer.write(compressedLength);
-
-        for(auto e : values) {
-            if(type == 'f') writer.write(e.f32);
-            else if(type == 'd') writer.write(e.f64);
-            else if(type == 'l') writer.write((int64_t)(e.i64));
-            else if(type == 'i') writer.write(e.i32);
-            else if(type == 'b') writer.write((uint8_t)(e.boolean ? 1 : 0));
-            else throw std::string("Invalid property");
-        }
+        throw std::string("Invalid property");
     }
 }
 
+void FBXProperty::deflateArray(uint32_t minBytes)
+{
+    if(!is_array() || encoding || raw.size() < minBytes) return;
+    mz_ulong compressedLength = mz_compressBound(raw.size());
+    std::vector<uint8_t> compressed(compressedLength);
+    if(mz_compress2(compressed.data(), &compressedLength, raw.data(), raw.size(), MZ_DEFAULT_LEVEL) != MZ_OK) return;
+    if(compressedLength >= raw.size()) return;
+    compressed.resize(compressedLength);
+    compressed.shrink_to_fit();
+    raw.swap(compressed);
+    encoding = 1;
+}
+
 // primitive values
 FBXProperty::FBXProperty(int16_t a) { type = 'Y'; value.i16 = a; }
 FBXProperty::FBXProperty(bool a) { type = 'C'; value.boolean = a; }
@@ -174,54 +157,50 @@ FBXProperty::FBXProperty(int32_t a) { type = 'I'; value.i32 = a; }
 FBXProperty::FBXProperty(float a) { type = 'F'; value.f32 = a; }
 FBXProperty::FBXProperty(double a) { type = 'D'; value.f64 = a; }
 FBXProperty::FBXProperty(int64_t a) { type = 'L'; value.i64 = a; }
-// arrays
-FBXProperty::FBXProperty(const std::vector<bool> a) : type('b') {
-    for(auto el : a) {
-        FBXPropertyValue v;
-        v.boolean = el;
-        values.push_back(v);
+// arrays, packed as the little endian bytes they are written as
+FBXProperty::FBXProperty(const std::vector<bool> &a) : type('b'), arrayLength(a.size()) {
+    raw.reserve(a.size());
+    for(bool el : a) {
+        raw.push_back(el ? 1 : 0);
     }
 }
-FBXProperty::FBXProperty(const std::vector<int32_t> a) : type('i') {
-    for(auto el : a) {
-        FBXPropertyValue v;
-        v.i32 = el;
-        values.push_back(v);
+FBXProperty::FBXProperty(const std::vector<int32_t> &a) : type('i'), arrayLength(a.size()) {
+    raw.reserve(a.size() * 4);
+    for(int32_t el : a) {
+        appendLittleEndian(raw, (uint32_t)el, 4);
     }
 }
-FBXProperty::FBXProperty(const std::vector<float> a) : type('f') {
-    for(auto el : a) {
-        FBXPropertyValue v;
-        v.f32 = el;
-        values.push_back(v);
+FBXProperty::FBXProperty(const std::vector<float> &a) : type('f'), arrayLength(a.size()) {
+    raw.reserve(a.size() * 4);
+    for(float el : a) {
+        uint32_t bits;
+        memcpy(&bits, &el, 4);
+        appendLittleEndian(raw, bits, 4);
     }
 }
-FBXProperty::FBXProperty(const std::vector<double> a) : type('d') {
-    for(auto el : a) {
-        FBXPropertyValue v;
-        v.f64 = el;
-        values.push_back(v);
+FBXProperty::FBXProperty(const std::vector<double> &a) : type('d'), arrayLength(a.size()) {
+    raw.reserve(a.size() * 8);
+    for(double el : a) {
+        uint64_t bits;
+        memcpy(&bits, &el, 8);
+        appendLittleEndian(raw, bits, 8);
     }
 }
-FBXProperty::FBXProperty(const std::vector<int64_t> a) : type('l') {
-    for(auto el : a) {
-        FBXPropertyValue v;
-        v.i64 = el;
-        values.push_back(v);
+FBXProperty::FBXProperty(const std::vector<int64_t> &a) : type('l'), arrayLength(a.size()) {
+    raw.reserve(a.size() * 8);
+    for(int64_t el : a) {
+        appendLittleEndian(raw, (uint64_t)el, 8);
     }
 }
 // raw / string
-FBXProperty::FBXProperty(const std::vector<uint8_t> a, uint8_t type): raw(a) {
+FBXProperty::FBXProperty(const std::vector<uint8_t> &a, uint8_t type): raw(a) {
     if(type != 'R' && type != 'S') {
         throw std::string("Bad argument to FBXProperty constructor");
     }
     this->type = type;
 }
 // string
-FBXProperty::FBXProperty(const std::string a){
-    for(uint8_t v : a) {
-        raw.push_back(v);
-    }
+FBXProperty::FBXProperty(const std::string &a): raw(a.begin(), a.end()) {
     this->type = 'S';
 }
 FBXProperty::FBXProperty(const char *a){
@@ -247,6 +226,11 @@ char FBXProperty::getType()
     return type;
 }
 
+bool FBXProperty::is_array() const
+{
+    return type == 'b' || type == 'i' || type == 'f' || type == 'd' || type == 'l';
+}
+
 string FBXProperty::to_string()
 {
     if(type == 'Y') return std::to_string(value.i16);
@@ -270,9 +254,13 @@ string FBXProperty::to_string()
         }
         return s + "\"";
     } else {
+        uint32_t elementSize = arrayElementSize(type - ('a'-'A'));
+        std::vector<uint8_t> bytes = encoding ? inflateArray(raw, (uint64_t)elementSize * arrayLength) : raw;
+        Reader r((char*)bytes.data());
         string s("[");
         bool hasPrev = false;
-        for(auto e : values) {
+        for(uint32_t i = 0; i < arrayLength; i++) {
+            FBXPropertyValue e = readPrimitiveValue(r, type - ('a'-'A'));
             if(hasPrev) s += ", ";
             if(type == 'f') s += std::to_string(e.f32);
             else if(type == 'd') s += std::to_string(e.f64);
@@ -286,7 +274,7 @@ string FBXProperty::to_string()
     throw std::string("Invalid property");
 }
 
-uint32_t FBXProperty::getBytes()
+uint32_t FBXProperty::getBytes() const
 {
     if(type == 'Y') return 2 + 1; // 2 for int16, 1 for type spec
     else if(type == 'C') return 1 + 1;
@@ -296,11 +284,7 @@ uint32_t FBXProperty::getBytes()
     else if(type == 'L') return 8 + 1;
     else if(type == 'R') return raw.size() + 5;
     else if(type == 'S') return raw.size() + 5;
-    else if(type == 'f') return values.size() * 4 + 13;
-    else if(type == 'd') return values.size() * 8 + 13;
-    else if(type == 'l') return values.size() * 8 + 13;
-    else if(type == 'i') return values.size() * 4 + 13;
-    else if(type == 'b') return values.size() * 1 + 13;
+    else if(is_array()) return raw.size() + 13;
     throw std::string("Invalid property");
 }
 
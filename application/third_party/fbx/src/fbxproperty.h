@@ -32,28 +32,34 @@ public:
     FBXProperty(double);
     FBXProperty(int64_t);
     // arrays
-    FBXProperty(const std::vector<bool>);
-    FBXProperty(const std::vector<int32_t>);
-    FBXProperty(const std::vector<float>);
-    FBXProperty(const std::vector<double>);
-    FBXProperty(const std::vector<int64_t>);
+    FBXProperty(const std::vector<bool> &);
+    FBXProperty(const std::vector<int32_t> &);
+    FBXProperty(const std::vector<float> &);
+    FBXProperty(const std::vector<double> &);
+    FBXProperty(const std::vector<int64_t> &);
     // raw / string
-    FBXProperty(const std::vector<uint8_t>, uint8_t type);
-    FBXProperty(const std::string);
+    FBXProperty(const std::vector<uint8_t> &, uint8_t type);
+    FBXProperty(const std::string &);
     FBXProperty(const char *);
 
-    void write(std::ofstream &output);
+    void write(std::ofstream &output) const;
+
+    // Change to zlib encode arrays in Dust3D project,
+    // arrays of at least minBytes are replaced by their deflated bytes, which is what gets written
+    void deflateArray(uint32_t minBytes = 128);
 
     std::string to_string();
     char getType();
 
-    bool is_array();
-    uint32_t getBytes();
+    bool is_array() const;
+    uint32_t getBytes() const;
 private:
     uint8_t type;
     FBXPropertyValue value;
+    // String and raw data, or the little endian array elements, deflated when encoding is 1
     std::vector<uint8_t> raw;
-    std::vector<FBXPropertyValue> values;
+    uint32_t arrayLength = 0;
+    uint32_t encoding = 0;
 };
 
 } // namespace fbx
@@ -169,7 +169,12 @@ Writer::Writer(std::ofstream *output):ofstream(output){}
 
 void Writer::putc(uint8_t c)
 {
-    (*ofstream) << c;
+    ofstream->put((char)c);
+}
+
+void Writer::write(const char *data, size_t length)
+{
+    ofstream->write(data, length);
 }
 
 void Writer::write(std::uint8_t a)
@@ -51,6 +51,7 @@ namespace fbx {
         void write(std::string);
         void write(float);
         void write(double);
+        void write(const char*, size_t);
     private:
         void putc(uint8_t);
         std::ofstream *ofstream;
@@ -0,0 +1,290 @@
+// Round trip of the dust3d EXT_meshopt_compression encoders through the reference meshoptimizer decoders.
+// Built and run by test_meshopt_codec.py, which fetches the reference sources.
+
+#include "meshoptimizer.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <dust3d/mesh/encode_meshopt_buffer.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+int g_failed = 0;
+int g_passed = 0;
+
+uint32_t g_randomState = 0x9e3779b9u;
+
+uint32_t nextRandom()
+{
+    g_randomState = g_randomState * 1664525u + 1013904223u;
+    return g_randomState >> 8;
+}
+
+void report(bool isSuccessful, const std::string& name, const char* reason)
+{
+    if (isSuccessful) {
+        ++g_passed;
+        return;
+    }
+    ++g_failed;
+    std::printf("FAILED %s: %s\n", name.c_str(), reason);
+}
+
+enum class VertexPattern {
+    Zero,
+    Random,
+    Smooth,
+    Sparse
+};
+
+const char* vertexPatternName(VertexPattern pattern)
+{
+    switch (pattern) {
+    case VertexPattern::Zero:
+        return "zero";
+    case VertexPattern::Random:
+        return "random";
+    case VertexPattern::Smooth:
+        return "smooth";
+    case VertexPattern::Sparse:
+        return "sparse";
+    }
+    return "";
+}
+
+std::vector<uint8_t> makeVertices(size_t vertexCount, size_t vertexSize, VertexPattern pattern)
+{
+    std::vector<uint8_t> vertices(vertexCount * vertexSize, 0);
+    for (size_t i = 0; i < vertexCount; ++i) {
+        uint8_t* vertex = &vertices[i * vertexSize];
+        for (size_t k = 0; k < vertexSize; k += 4) {
+            uint32_t value = 0;
+            switch (pattern) {
+            case VertexPattern::Zero:
+                break;
+            case VertexPattern::Random:
+                value = nextRandom() ^ (nextRandom() << 16);
+                break;
+            case VertexPattern::Smooth: {
+                // Positions along a curve, the kind of floats a generated mesh has
+                float component = (float)(i * 0.01 + k * 0.5) + (float)(nextRandom() % 16) * 0.0001f;
+                std::memcpy(&value, &component, sizeof(value));
+                break;
+            }
+            case VertexPattern::Sparse:
+                value = 0 == nextRandom() % 7 ? nextRandom() % 300 : 0;
+                break;
+            }
+            std::memcpy(vertex + k, &value, sizeof(value));
+        }
+    }
+    return vertices;
+}
+
+void checkVertexBuffer(size_t vertexCount, size_t vertexSize, VertexPattern pattern)
+{
+    std::string name = "vertices " + std::to_string(vertexCount) + "x" + std::to_string(vertexSize) + " " + vertexPatternName(pattern);
+    std::vector<uint8_t> vertices = makeVertices(vertexCount, vertexSize, pattern);
+
+    std::vector<uint8_t> encoded;
+    dust3d::encodeMeshoptVertexBuffer(vertices.data(), vertexCount, vertexSize, &encoded);
+
+    // One extra vertex catches decoders writing past the count
+    std::vector<uint8_t> decoded((vertexCount + 1) * vertexSize, 0xcd);
+    int result = meshopt_decodeVertexBuffer(decoded.data(), vertexCount, vertexSize, encoded.data(), encoded.size());
+    if (0 != result) {
+        report(false, name, ("decoder returned " + std::to_string(result)).c_str());
+        return;
+    }
+    if (0 != std::memcmp(decoded.data(), vertices.data(), vertices.size())) {
+        report(false, name, "decoded vertices differ");
+        return;
+    }
+    if (encoded.size() > meshopt_encodeVertexBufferBound(vertexCount, vertexSize)) {
+        report(false, name, "encoded size exceeds the reference bound");
+        return;
+    }
+    report(true, name, "");
+}
+
+// The codec may rotate the corners of a triangle, it keeps the winding
+template <class Index>
+bool isSameTriangleList(const std::vector<uint32_t>& indices, const std::vector<Index>& decoded)
+{
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        bool isSame = false;
+        for (size_t rotation = 0; rotation < 3 && !isSame; ++rotation) {
+            isSame = decoded[i + rotation] == indices[i]
+                && decoded[i + (rotation + 1) % 3] == indices[i + 1]
+                && decoded[i + (rotation + 2) % 3] == indices[i + 2];
+        }
+        if (!isSame)
+            return false;
+    }
+    return true;
+}
+
+void checkIndexBuffer(const std::string& name, const std::vector<uint32_t>& indices)
+{
+    std::vector<uint8_t> encoded;
+    dust3d::encodeMeshoptIndexBuffer(indices, &encoded);
+
+    uint32_t maxIndex = 0;
+    for (const auto& index : indices)
+        maxIndex = std::max(maxIndex, index);
+    size_t vertexCount = indices.empty() ? 0 : (size_t)maxIndex + 1;
+    if (encoded.size() > meshopt_encodeIndexBufferBound(indices.size(), vertexCount)) {
+        report(false, name, "encoded size exceeds the reference bound");
+        return;
+    }
+
+    std::vector<uint32_t> decoded(indices.size() + 1, 0xcdcdcdcdu);
+    int result = meshopt_decodeIndexBuffer(decoded.data(), indices.size(), sizeof(uint32_t), encoded.data(), encoded.size());
+    if (0 != result) {
+        report(false, name + " 32-bit", ("decoder returned " + std::to_string(result)).c_str());
+        return;
+    }
+    if (!isSameTriangleList(indices, decoded)) {
+        report(false, name + " 32-bit", "decoded indices differ");
+        return;
+    }
+    report(true, name + " 32-bit", "");
+
+    if (maxIndex > 0xffff)
+        return;
+    std::vector<uint16_t> decodedShort(indices.size() + 1, 0xcdcd);
+    result = meshopt_decodeIndexBuffer(decodedShort.data(), indices.size(), sizeof(uint16_t), encoded.data(), encoded.size());
+    if (0 != result) {
+        report(false, name + " 16-bit", ("decoder returned " + std::to_string(result)).c_str());
+        return;
+    }
+    if (!isSameTriangleList(indices, decodedShort)) {
+        report(false, name + " 16-bit", "decoded indices differ");
+        return;
+    }
+    report(true, name + " 16-bit", "");
+}
+
+// Two triangles per quad, row by row, the order generated meshes mostly come in
+std::vector<uint32_t> makeGrid(uint32_t width, uint32_t height, uint32_t base)
+{
+    std::vector<uint32_t> indices;
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            uint32_t v0 = base + y * (width + 1) + x;
+            uint32_t v1 = v0 + 1;
+            uint32_t v2 = v0 + width + 1;
+            uint32_t v3 = v2 + 1;
+            indices.insert(indices.end(), { v0, v1, v2, v2, v1, v3 });
+        }
+    }
+    return indices;
+}
+
+// Vertices renumbered in first use order, as the GLB writer does before encoding
+std::vector<uint32_t> renumberInUseOrder(const std::vector<uint32_t>& indices)
+{
+    std::vector<uint32_t> remap;
+    std::vector<uint32_t> result(indices.size());
+    uint32_t next = 0;
+    for (size_t i = 0; i < indices.size(); ++i) {
+        if (indices[i] >= remap.size())
+            remap.resize(indices[i] + 1, (uint32_t)-1);
+        if ((uint32_t)-1 == remap[indices[i]])
+            remap[indices[i]] = next++;
+        result[i] = remap[indices[i]];
+    }
+    return result;
+}
+
+void checkIndexBuffers()
+{
+    checkIndexBuffer("indices empty", {});
+    checkIndexBuffer("indices single triangle", { 0, 1, 2 });
+    checkIndexBuffer("indices single rotated triangle", { 2, 0, 1 });
+    checkIndexBuffer("indices grid", makeGrid(40, 30, 0));
+    checkIndexBuffer("indices grid in use order", renumberInUseOrder(makeGrid(40, 30, 0)));
+    checkIndexBuffer("indices grid above 16-bit", makeGrid(20, 20, 70000));
+
+    std::vector<uint32_t> fan;
+    for (uint32_t i = 1; i + 1 < 200; ++i)
+        fan.insert(fan.end(), { 0, i, i + 1 });
+    checkIndexBuffer("indices fan", fan);
+
+    std::vector<uint32_t> strip;
+    for (uint32_t i = 0; i + 2 < 300; ++i) {
+        if (0 == i % 2)
+            strip.insert(strip.end(), { i, i + 1, i + 2 });
+        else
+            strip.insert(strip.end(), { i + 1, i, i + 2 });
+    }
+    checkIndexBuffer("indices strip", strip);
+
+    // Neighbouring indices one apart backwards and forwards
+    std::vector<uint32_t> steps;
+    for (uint32_t i = 0; i < 100; ++i)
+        steps.insert(steps.end(), { 500 + i, 1000 - i, 501 + i, 501 + i, 1000 - i, 999 - i });
+    checkIndexBuffer("indices stepping", steps);
+
+    std::vector<uint32_t> degenerate = { 0, 0, 1, 1, 1, 1, 2, 3, 2, 3, 2, 2, 4, 5, 6, 4, 5, 6, 6, 5, 4, 7, 7, 7, 0, 1, 2 };
+    checkIndexBuffer("indices degenerate", degenerate);
+
+    std::vector<uint32_t> degenerateGrid = makeGrid(12, 12, 0);
+    for (size_t i = 0; i < degenerateGrid.size(); i += 9)
+        degenerateGrid[i + 1] = degenerateGrid[i];
+    checkIndexBuffer("indices grid with degenerate triangles", degenerateGrid);
+
+    // Meshes concatenated with their own numbering restart at 0 1 2
+    std::vector<uint32_t> restarts;
+    for (int part = 0; part < 4; ++part) {
+        auto grid = renumberInUseOrder(makeGrid(8 + part, 5, 0));
+        restarts.insert(restarts.end(), grid.begin(), grid.end());
+    }
+    checkIndexBuffer("indices restarts", restarts);
+
+    std::vector<uint32_t> restartAfterDegenerate = { 0, 1, 2, 2, 1, 3, 0, 0, 0, 0, 1, 2, 0, 1, 2, 3, 4, 5 };
+    checkIndexBuffer("indices restarts around degenerate triangles", restartAfterDegenerate);
+
+    // Parts offset into one shared vertex range, jumping back and forth between them
+    std::vector<uint32_t> interleaved;
+    auto first = makeGrid(10, 10, 0);
+    auto second = makeGrid(10, 10, 121);
+    for (size_t i = 0; i < first.size(); i += 6) {
+        interleaved.insert(interleaved.end(), first.begin() + i, first.begin() + i + 6);
+        interleaved.insert(interleaved.end(), second.begin() + i, second.begin() + i + 6);
+    }
+    checkIndexBuffer("indices interleaved parts", interleaved);
+
+    std::vector<uint32_t> random;
+    for (int i = 0; i < 3000; ++i)
+        random.push_back(nextRandom() % 5000);
+    checkIndexBuffer("indices random", random);
+
+    std::vector<uint32_t> randomWide;
+    for (int i = 0; i < 3000; ++i)
+        randomWide.push_back(nextRandom() % (1u << 22));
+    checkIndexBuffer("indices random wide", randomWide);
+}
+
+}
+
+int main()
+{
+    const size_t vertexSizes[] = { 4, 8, 12, 16, 20, 32, 44, 64, 128, 252, 256 };
+    const size_t vertexCounts[] = { 0, 1, 2, 15, 16, 17, 100, 255, 256, 257, 511, 1000, 3000 };
+    const VertexPattern patterns[] = { VertexPattern::Zero, VertexPattern::Random, VertexPattern::Smooth, VertexPattern::Sparse };
+    for (const auto& vertexSize : vertexSizes) {
+        for (const auto& vertexCount : vertexCounts) {
+            for (const auto& pattern : patterns)
+                checkVertexBuffer(vertexCount, vertexSize, pattern);
+        }
+    }
+
+    checkIndexBuffers();
+
+    std::printf("%d passed, %d failed\n", g_passed, g_failed);
+    return 0 == g_failed ? 0 : 1;
+}
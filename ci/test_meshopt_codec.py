@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+"""
+Round trip check of dust3d's EXT_meshopt_compression encoders.
+Downloads the reference meshoptimizer decoders, builds test_meshopt_codec.cc against
+dust3d/mesh/encode_meshopt_buffer.cc and runs it over several vertex strides and index patterns.
+
+Requirements: Python 3 (stdlib only) and a C++17 compiler
+
+Usage:
+    python test_meshopt_codec.py [--cxx c++] [--output-dir test_output/meshopt]
+"""
+
+import argparse
+import shutil
+import subprocess
+import sys
+import urllib.request
+from pathlib import Path
+
+
+MESHOPTIMIZER_VERSION = "v0.21"
+MESHOPTIMIZER_RAW_URL = f"https://raw.githubusercontent.com/zeux/meshoptimizer/{MESHOPTIMIZER_VERSION}/src"
+MESHOPTIMIZER_SOURCES = ["meshoptimizer.h", "vertexcodec.cpp", "indexcodec.cpp"]
+
+
+def download_file(url, dest):
+    dest.parent.mkdir(parents=True, exist_ok=True)
+    req = urllib.request.Request(url, headers={"User-Agent": "dust3d-test"})
+    with urllib.request.urlopen(req, timeout=60) as resp, open(dest, "wb") as f:
+        shutil.copyfileobj(resp, f)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Dust3D meshopt codec round trip check")
+    parser.add_argument("--cxx", default="c++", help="C++ compiler")
+    parser.add_argument("--output-dir", default="test_output/meshopt", help="Output directory")
+    parser.add_argument("--meshoptimizer-dir", default=None, help="Pre-downloaded meshoptimizer src directory (skip download)")
+    args = parser.parse_args()
+
+    repo_dir = Path(__file__).resolve().parent.parent
+    output_dir = Path(args.output_dir).resolve()
+    output_dir.mkdir(parents=True, exist_ok=True)
+
+    if args.meshoptimizer_dir:
+        reference_dir = Path(args.meshoptimizer_dir).resolve()
+    else:
+        reference_dir = output_dir / "meshoptimizer"
+        print(f"Downloading meshoptimizer {MESHOPTIMIZER_VERSION} decoders...")
+        for source in MESHOPTIMIZER_SOURCES:
+            download_file(f"{MESHOPTIMIZER_RAW_URL}/{source}", reference_dir / source)
+
+    binary = output_dir / "test_meshopt_codec"
+    cmd = [
+        args.cxx, "-std=c++17", "-O1", "-g",
+        "-I", str(repo_dir),
+        "-I", str(reference_dir),
+        str(repo_dir / "ci" / "test_meshopt_codec.cc"),
+        str(repo_dir / "dust3d" / "mesh" / "encode_meshopt_buffer.cc"),
+        str(reference_dir / "vertexcodec.cpp"),
+        str(reference_dir / "indexcodec.cpp"),
+        "-o", str(binary),
+    ]
+    print(f"Running: {' '.join(cmd)}")
+    result = subprocess.run(cmd)
+    if result.returncode != 0:
+        print("Build failed")
+        sys.exit(1)
+
+    result = subprocess.run([str(binary)])
+    sys.exit(result.returncode)
+
+
+if __name__ == "__main__":
+    main()
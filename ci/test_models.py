@@ -76,6 +76,45 @@ def export_glb(dust3d_bin, ds3_path, glb_path, timeout=120):
     return glb_path.exists()
 
 
+def export_glb_through_server(dust3d_bin, ds3_path, glb_path, timeout=180):
+    """Runs the model through the -server protocol, every stdout line must be a JSON response."""
+    env = os.environ.copy()
+    if platform.system() == "Linux":
+        env.setdefault("QT_QPA_PLATFORM", "offscreen")
+
+    requests = [
+        {"id": 1, "command": "open", "document": "model", "path": str(ds3_path)},
+        {"id": 2, "command": "generate", "document": "model"},
+        {"id": 3, "command": "exportGlb", "document": "model", "path": str(glb_path)},
+        {"id": 4, "command": "close", "document": "model"},
+    ]
+    stdin = "".join(json.dumps(request) + "\n" for request in requests)
+    cmd = [str(dust3d_bin), "-server"]
+    print(f"  Running: {' '.join(cmd)}")
+    result = subprocess.run(cmd, env=env, timeout=timeout, capture_output=True, input=stdin.encode())
+    if result.returncode != 0:
+        return f"Server exited with {result.returncode}"
+
+    responses = {}
+    for line in result.stdout.decode(errors="replace").splitlines():
+        try:
+            response = json.loads(line)
+        except ValueError:
+            return f"Server wrote a line which is not JSON: {line[:200]}"
+        if not isinstance(response, dict) or "id" not in response:
+            return f"Server wrote a response without id: {line[:200]}"
+        responses[response["id"]] = response
+    for request in requests:
+        response = responses.get(request["id"])
+        if response is None:
+            return f"No response to {request['command']}"
+        if not response.get("ok"):
+            return f"{request['command']} failed: {response.get('error', '')}"
+    if not glb_path.exists():
+        return "Server export wrote no file"
+    return None
+
+
 def parse_glb_animations(glb_path):
     with open(glb_path, "rb") as f:
         magic, version, length = struct.unpack("<III", f.read(12))
@@ -385,6 +424,17 @@ def main():
             results.append({"model": model_name, "success": False, "error": "Export failed", "animations": []})
             continue
 
+        # Rigged models print rig diagnostics while exporting, which must stay out of the response stream
+        server_glb_path = glb_dir / f"{Path(ds3_rel).stem}.server.glb"
+        try:
+            server_error = export_glb_through_server(dust3d_bin, ds3_path, server_glb_path)
+        except subprocess.TimeoutExpired:
+            server_error = "Server export timeout"
+        if server_error:
+            print(f"  SERVER FAILED: {server_error}")
+            results.append({"model": model_name, "success": False, "error": server_error, "animations": []})
+            continue
+
         animations = parse_glb_animations(glb_path)
         print(f"  Exported OK, {len(animations)} animation(s)")
         for a in animations:
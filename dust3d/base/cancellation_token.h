@@ -0,0 +1,55 @@
+/*
+ *  Copyright (c) 2016-2026 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef DUST3D_BASE_CANCELLATION_TOKEN_H_
+#define DUST3D_BASE_CANCELLATION_TOKEN_H_
+
+#include <atomic>
+
+namespace dust3d {
+
+// Shared between the thread requesting a cancellation and the worker polling
+// it at its own checkpoints, nothing is interrupted forcibly.
+class CancellationToken {
+public:
+    void cancel()
+    {
+        m_cancelled.store(true, std::memory_order_relaxed);
+    }
+
+    bool isCancelled() const
+    {
+        return m_cancelled.load(std::memory_order_relaxed);
+    }
+
+    static bool isCancelled(const CancellationToken* token)
+    {
+        return nullptr != token && token->isCancelled();
+    }
+
+private:
+    std::atomic<bool> m_cancelled { false };
+};
+
+}
+
+#endif
@@ -84,8 +84,7 @@ Ds3FileReader::Ds3FileReader(const std::uint8_t* fileData, size_t fileSize)
         if (nullptr == rootNode)
             return;
         m_headerIsGood = true;
-        m_fileContent = std::vector<std::uint8_t>(fileSize);
-        std::memcpy(m_fileContent.data(), fileData, fileSize);
+        m_fileData = fileData;
         for (rapidxml::xml_node<>* node = rootNode->first_node(); nullptr != node; node = node->next_sibling()) {
             Ds3ReaderItem readerItem;
             rapidxml::xml_attribute<>* attribute;
@@ -116,19 +115,24 @@ Ds3FileReader::Ds3FileReader(const std::uint8_t* fileData, size_t fileSize)
     }
 }
 
-void Ds3FileReader::loadItem(const std::string& name, std::vector<std::uint8_t>* byteArray)
+Ds3ReaderSpan Ds3FileReader::itemSpan(const std::string& name) const
 {
-    byteArray->clear();
+    Ds3ReaderSpan span;
     if (!m_headerIsGood)
-        return;
-    if (m_itemsMap.find(name) == m_itemsMap.end()) {
-        return;
-    }
-    Ds3ReaderItem readerItem = m_itemsMap[name];
-    byteArray->resize(readerItem.size, 0);
-    std::memcpy((char*)byteArray->data(),
-        m_fileContent.data() + m_binaryOffset + readerItem.offset,
-        byteArray->size());
+        return span;
+    auto findItem = m_itemsMap.find(name);
+    if (findItem == m_itemsMap.end())
+        return span;
+    const Ds3ReaderItem& readerItem = findItem->second;
+    span.data = m_fileData + m_binaryOffset + readerItem.offset;
+    span.size = (size_t)readerItem.size;
+    return span;
+}
+
+void Ds3FileReader::loadItem(const std::string& name, std::vector<std::uint8_t>* byteArray) const
+{
+    Ds3ReaderSpan span = itemSpan(name);
+    byteArray->assign(span.data, span.data + span.size);
 }
 
 const std::vector<Ds3ReaderItem>& Ds3FileReader::items() const
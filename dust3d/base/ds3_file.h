@@ -23,6 +23,7 @@
 #ifndef DUST3D_BASE_DS3_FILE_H_
 #define DUST3D_BASE_DS3_FILE_H_
 
+#include <cstdint>
 #include <map>
 #include <string>
 #include <vector>
@@ -37,10 +38,24 @@ public:
     long long size;
 };
 
+class Ds3ReaderSpan {
+public:
+    const std::uint8_t* data = nullptr;
+    size_t size = 0;
+
+    bool empty() const
+    {
+        return 0 == size;
+    }
+};
+
+// The reader borrows fileData, which could be a memory mapped file, instead of
+// copying it, so the buffer must outlive the reader and every span it returns.
 class Ds3FileReader {
 public:
     Ds3FileReader(const std::uint8_t* fileData, size_t fileSize);
-    void loadItem(const std::string& name, std::vector<std::uint8_t>* byteArray);
+    void loadItem(const std::string& name, std::vector<std::uint8_t>* byteArray) const;
+    Ds3ReaderSpan itemSpan(const std::string& name) const;
     const std::vector<Ds3ReaderItem>& items() const;
     static std::string m_applicationName;
     static std::string m_magicApplicationName;
@@ -50,7 +65,7 @@ public:
 private:
     std::map<std::string, Ds3ReaderItem> m_itemsMap;
     std::vector<Ds3ReaderItem> m_items;
-    std::vector<std::uint8_t> m_fileContent;
+    const std::uint8_t* m_fileData = nullptr;
 
 private:
     static std::string readFirstLine(const std::uint8_t* data, size_t size);
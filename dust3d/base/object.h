@@ -32,6 +32,7 @@
 #include <dust3d/base/vector3.h>
 #include <map>
 #include <set>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -44,6 +45,8 @@ struct ObjectNode {
     //float radius = 0.0;
     Color color;
     float smoothCutoffDegrees = 0.0;
+    // The component generating the node, mirrored parts have the mirror component
+    Uuid componentId;
     //float metalness = 0.0;
     //float roughness = 1.0;
     //Uuid materialId;
@@ -67,16 +70,48 @@ public:
     std::vector<float> vertexSmoothCutoffDegrees;
     std::map<std::array<PositionKey, 3>, Uuid> brokenTrianglesToComponentIdMap;
 
+    // Source node of each vertex, as an index into vertexSourceNodeIds, -1 if the vertex has no source node
+    // Indexed parallel to vertices, filled by the mesh generator
+    std::vector<int> vertexSourceNodes;
+    std::vector<Uuid> vertexSourceNodeIds;
+
     // Bone binding data: each vertex can be bound to at most 2 bones with interpolation weights
-    // Indexed parallel to vertices; bone names and weights stored in pairs
-    // vertexBone1[i] = {primary bone name, weight1}
-    // vertexBone2[i] = {secondary bone name, weight2}  (second string empty if unused)
-    std::vector<std::pair<std::string, float>> vertexBone1;
-    std::vector<std::pair<std::string, float>> vertexBone2;
+    // Indexed parallel to vertices; bone indices and weights stored in pairs, bones index into boneNames
+    // vertexBone1[i] = {primary bone index, weight1}
+    // vertexBone2[i] = {secondary bone index, weight2}  (bone index -1 if unused)
+    std::vector<std::string> boneNames;
+    std::vector<std::pair<int, float>> vertexBone1;
+    std::vector<std::pair<int, float>> vertexBone2;
 
     bool alphaEnabled = false;
     uint64_t meshId = 0;
 
+    int findBoneName(const std::string& boneName) const
+    {
+        for (size_t i = 0; i < boneNames.size(); ++i) {
+            if (boneNames[i] == boneName)
+                return (int)i;
+        }
+        return -1;
+    }
+    int addBoneName(const std::string& boneName)
+    {
+        if (boneName.empty())
+            return -1;
+        int boneIndex = findBoneName(boneName);
+        if (-1 != boneIndex)
+            return boneIndex;
+        boneNames.push_back(boneName);
+        return (int)boneNames.size() - 1;
+    }
+    const std::string& vertexBoneName(int boneIndex) const
+    {
+        static const std::string emptyName;
+        if (boneIndex < 0 || boneIndex >= (int)boneNames.size())
+            return emptyName;
+        return boneNames[boneIndex];
+    }
+
     const std::vector<std::pair<Uuid, Uuid>>* triangleSourceNodes() const
     {
         if (!m_hasTriangleSourceNodes)
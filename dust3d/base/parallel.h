@@ -0,0 +1,75 @@
+/*
+ *  Copyright (c) 2016-2026 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef DUST3D_BASE_PARALLEL_H_
+#define DUST3D_BASE_PARALLEL_H_
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace dust3d {
+
+// Split [0, count) into contiguous blocks of at least grainSize items and
+// run function(begin, end) for each block on its own thread.
+// Blocks never overlap, so a function writing only to its own range of an
+// output array produces the same result regardless of scheduling.
+// A parallelFor called from a block of another one which already spread over
+// several threads runs serially, so nesting never goes beyond one thread per core.
+inline bool& isInParallelBlock()
+{
+    static thread_local bool s_isInParallelBlock = false;
+    return s_isInParallelBlock;
+}
+
+template <typename Function>
+void parallelFor(size_t count, size_t grainSize, Function function)
+{
+    if (0 == count)
+        return;
+    size_t threadCount = isInParallelBlock() ? 1 : std::max<size_t>(1, std::thread::hardware_concurrency());
+    size_t blockSize = std::max<size_t>(std::max<size_t>(1, grainSize), (count + threadCount - 1) / threadCount);
+    size_t blockCount = (count + blockSize - 1) / blockSize;
+    if (blockCount <= 1) {
+        function((size_t)0, count);
+        return;
+    }
+    std::vector<std::thread> threads;
+    threads.reserve(blockCount - 1);
+    for (size_t block = 1; block < blockCount; ++block) {
+        size_t begin = block * blockSize;
+        size_t end = std::min(count, begin + blockSize);
+        threads.emplace_back([=, &function]() {
+            isInParallelBlock() = true;
+            function(begin, end);
+        });
+    }
+    isInParallelBlock() = true;
+    function((size_t)0, std::min(count, blockSize));
+    isInParallelBlock() = false;
+    for (auto& thread : threads)
+        thread.join();
+}
+
+}
+
+#endif
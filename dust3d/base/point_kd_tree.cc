@@ -0,0 +1,92 @@
+/*
+ *  Copyright (c) 2016-2026 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <algorithm>
+#include <dust3d/base/point_kd_tree.h>
+#include <limits>
+
+namespace dust3d {
+
+PointKdTree::PointKdTree(const std::vector<Vector3>& points)
+    : m_points(points)
+{
+    std::vector<size_t> pointIndices(m_points.size());
+    for (size_t i = 0; i < pointIndices.size(); ++i)
+        pointIndices[i] = i;
+    m_nodes.reserve(m_points.size());
+    m_root = build(pointIndices, 0, pointIndices.size(), 0);
+}
+
+bool PointKdTree::isEmpty() const
+{
+    return m_points.empty();
+}
+
+int PointKdTree::build(std::vector<size_t>& pointIndices, size_t begin, size_t end, int depth)
+{
+    if (begin >= end)
+        return -1;
+    int axis = depth % 3;
+    size_t middle = begin + (end - begin) / 2;
+    std::nth_element(pointIndices.begin() + begin, pointIndices.begin() + middle, pointIndices.begin() + end,
+        [&](size_t a, size_t b) {
+            return m_points[a][axis] < m_points[b][axis];
+        });
+    int nodeIndex = (int)m_nodes.size();
+    m_nodes.push_back(Node());
+    m_nodes[nodeIndex].pointIndex = pointIndices[middle];
+    m_nodes[nodeIndex].axis = axis;
+    int left = build(pointIndices, begin, middle, depth + 1);
+    int right = build(pointIndices, middle + 1, end, depth + 1);
+    m_nodes[nodeIndex].left = left;
+    m_nodes[nodeIndex].right = right;
+    return nodeIndex;
+}
+
+void PointKdTree::search(int nodeIndex, const Vector3& position, size_t* bestIndex, double* bestDistance2) const
+{
+    if (-1 == nodeIndex)
+        return;
+    const Node& node = m_nodes[nodeIndex];
+    double distance2 = (position - m_points[node.pointIndex]).lengthSquared();
+    if (distance2 < *bestDistance2 || (distance2 == *bestDistance2 && node.pointIndex < *bestIndex)) {
+        *bestDistance2 = distance2;
+        *bestIndex = node.pointIndex;
+    }
+    double offset = position[node.axis] - m_points[node.pointIndex][node.axis];
+    int nearSide = offset < 0 ? node.left : node.right;
+    int farSide = offset < 0 ? node.right : node.left;
+    search(nearSide, position, bestIndex, bestDistance2);
+    // Points at exactly the splitting distance may still win a tie on their index
+    if (offset * offset <= *bestDistance2)
+        search(farSide, position, bestIndex, bestDistance2);
+}
+
+size_t PointKdTree::nearest(const Vector3& position) const
+{
+    size_t bestIndex = std::numeric_limits<size_t>::max();
+    double bestDistance2 = std::numeric_limits<double>::max();
+    search(m_root, position, &bestIndex, &bestDistance2);
+    return bestIndex;
+}
+
+}
@@ -0,0 +1,59 @@
+/*
+ *  Copyright (c) 2016-2026 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef DUST3D_BASE_POINT_KD_TREE_H_
+#define DUST3D_BASE_POINT_KD_TREE_H_
+
+#include <dust3d/base/vector3.h>
+#include <vector>
+
+namespace dust3d {
+
+// Static k-d tree over a set of points for nearest point queries.
+// When several points are equally near, the one with the lowest index wins,
+// which matches a linear scan keeping the first strictly nearer point.
+// Queries do not modify the tree, so they can run from many threads at once.
+class PointKdTree {
+public:
+    PointKdTree(const std::vector<Vector3>& points);
+    bool isEmpty() const;
+    size_t nearest(const Vector3& position) const;
+
+private:
+    struct Node {
+        size_t pointIndex = 0;
+        int axis = 0;
+        int left = -1;
+        int right = -1;
+    };
+
+    std::vector<Vector3> m_points;
+    std::vector<Node> m_nodes;
+    int m_root = -1;
+
+    int build(std::vector<size_t>& pointIndices, size_t begin, size_t end, int depth);
+    void search(int nodeIndex, const Vector3& position, size_t* bestIndex, double* bestDistance2) const;
+};
+
+}
+
+#endif
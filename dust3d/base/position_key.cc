@@ -38,6 +38,30 @@ PositionKey::PositionKey(double x, double y, double z)
     m_intZ = (long)(z * m_toIntFactor);
 }
 
+PositionKey PositionKey::fromIntegers(long intX, long intY, long intZ)
+{
+    PositionKey positionKey;
+    positionKey.m_intX = intX;
+    positionKey.m_intY = intY;
+    positionKey.m_intZ = intZ;
+    return positionKey;
+}
+
+long PositionKey::intX() const
+{
+    return m_intX;
+}
+
+long PositionKey::intY() const
+{
+    return m_intY;
+}
+
+long PositionKey::intZ() const
+{
+    return m_intZ;
+}
+
 bool PositionKey::operator<(const PositionKey& right) const
 {
     if (m_intX < right.m_intX)
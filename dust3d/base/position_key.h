@@ -31,13 +31,18 @@ class PositionKey {
 public:
     PositionKey(const Vector3& v);
     PositionKey(double x, double y, double z);
+    PositionKey() = default;
+    static PositionKey fromIntegers(long intX, long intY, long intZ);
+    long intX() const;
+    long intY() const;
+    long intZ() const;
     bool operator<(const PositionKey& right) const;
     bool operator==(const PositionKey& right) const;
 
 private:
-    long m_intX;
-    long m_intY;
-    long m_intZ;
+    long m_intX = 0;
+    long m_intY = 0;
+    long m_intZ = 0;
 
     static long m_toIntFactor;
 };
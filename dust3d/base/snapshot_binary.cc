@@ -0,0 +1,476 @@
+/*
+ *  Copyright (c) 2016-2026 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <dust3d/base/snapshot_binary.h>
+#include <dust3d/base/string.h>
+#include <unordered_map>
+
+namespace dust3d {
+
+static const char g_snapshotBinaryMagic[8] = { 'D', 'S', '3', 'S', 'N', 'A', 'P', '\0' };
+static const std::uint32_t g_snapshotBinaryVersion = 1;
+static const std::uint32_t g_noneIndex = 0xffffffff;
+
+enum NodeColumnMask : std::uint8_t {
+    NodeColumnX = 1 << 0,
+    NodeColumnY = 1 << 1,
+    NodeColumnZ = 1 << 2,
+    NodeColumnRadius = 1 << 3,
+};
+
+class SnapshotBinaryWriter {
+public:
+    SnapshotBinaryWriter(std::vector<std::uint8_t>& byteArray)
+        : m_byteArray(byteArray)
+    {
+    }
+
+    void writeBytes(const void* data, size_t size)
+    {
+        const std::uint8_t* bytes = (const std::uint8_t*)data;
+        m_byteArray.insert(m_byteArray.end(), bytes, bytes + size);
+    }
+
+    void writeUint32(std::uint32_t value)
+    {
+        std::uint8_t bytes[4] = {
+            (std::uint8_t)(value & 0xff),
+            (std::uint8_t)((value >> 8) & 0xff),
+            (std::uint8_t)((value >> 16) & 0xff),
+            (std::uint8_t)((value >> 24) & 0xff)
+        };
+        writeBytes(bytes, sizeof(bytes));
+    }
+
+    void writeFloat(float value)
+    {
+        std::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        writeUint32(bits);
+    }
+
+private:
+    std::vector<std::uint8_t>& m_byteArray;
+};
+
+class SnapshotBinaryReader {
+public:
+    SnapshotBinaryReader(const std::uint8_t* data, size_t size)
+        : m_data(data)
+        , m_size(size)
+    {
+    }
+
+    bool readBytes(void* data, size_t size)
+    {
+        if (m_size - m_offset < size)
+            return false;
+        std::memcpy(data, m_data + m_offset, size);
+        m_offset += size;
+        return true;
+    }
+
+    bool readUint32(std::uint32_t* value)
+    {
+        if (m_size - m_offset < 4)
+            return false;
+        const std::uint8_t* bytes = m_data + m_offset;
+        *value = (std::uint32_t)bytes[0]
+            | ((std::uint32_t)bytes[1] << 8)
+            | ((std::uint32_t)bytes[2] << 16)
+            | ((std::uint32_t)bytes[3] << 24);
+        m_offset += 4;
+        return true;
+    }
+
+    bool readFloat(float* value)
+    {
+        std::uint32_t bits;
+        if (!readUint32(&bits))
+            return false;
+        std::memcpy(value, &bits, sizeof(bits));
+        return true;
+    }
+
+    bool readString(std::string* string, size_t length)
+    {
+        if (m_size - m_offset < length)
+            return false;
+        string->assign((const char*)m_data + m_offset, length);
+        m_offset += length;
+        return true;
+    }
+
+    // Each element takes at least one byte, a count larger than the remaining
+    // bytes can only come from a corrupted file
+    bool isCountPlausible(std::uint32_t count) const
+    {
+        return count <= m_size - m_offset;
+    }
+
+private:
+    const std::uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+    size_t m_offset = 0;
+};
+
+class SnapshotStringTable {
+public:
+    std::uint32_t intern(const std::string& string)
+    {
+        auto insertResult = m_indexMap.insert({ string, (std::uint32_t)m_strings.size() });
+        if (insertResult.second)
+            m_strings.push_back(&insertResult.first->first);
+        return insertResult.first->second;
+    }
+
+    void write(SnapshotBinaryWriter& writer) const
+    {
+        writer.writeUint32((std::uint32_t)m_strings.size());
+        for (const auto& string : m_strings) {
+            writer.writeUint32((std::uint32_t)string->size());
+            writer.writeBytes(string->data(), string->size());
+        }
+    }
+
+private:
+    std::unordered_map<std::string, std::uint32_t> m_indexMap;
+    std::vector<const std::string*> m_strings;
+};
+
+// Only values which would be written back as the same text are stored as floats
+static bool toExactFloat(const std::string& string, float* value)
+{
+    if (string.empty())
+        return false;
+    char* end = nullptr;
+    *value = std::strtof(string.c_str(), &end);
+    if (end != string.c_str() + string.size())
+        return false;
+    return std::to_string(*value) == string;
+}
+
+typedef std::vector<std::pair<std::uint32_t, std::uint32_t>> SnapshotAttributeList;
+
+static void collectAttributes(SnapshotStringTable& stringTable,
+    const std::map<std::string, std::string>& attributes,
+    SnapshotAttributeList& attributeList,
+    bool skipInternalAttributes,
+    const char* skipKeys[] = nullptr)
+{
+    for (const auto& attribute : attributes) {
+        if (skipInternalAttributes && String::startsWith(attribute.first, "__"))
+            continue;
+        bool skipped = false;
+        for (size_t i = 0; nullptr != skipKeys && nullptr != skipKeys[i]; ++i) {
+            if (attribute.first == skipKeys[i]) {
+                skipped = true;
+                break;
+            }
+        }
+        if (skipped)
+            continue;
+        attributeList.push_back({ stringTable.intern(attribute.first), stringTable.intern(attribute.second) });
+    }
+}
+
+static void writeAttributes(SnapshotBinaryWriter& writer, const SnapshotAttributeList& attributeList)
+{
+    writer.writeUint32((std::uint32_t)attributeList.size());
+    for (const auto& it : attributeList) {
+        writer.writeUint32(it.first);
+        writer.writeUint32(it.second);
+    }
+}
+
+static void collectEntities(SnapshotStringTable& stringTable,
+    const std::map<std::string, std::map<std::string, std::string>>& entities,
+    bool skipInternalAttributes,
+    std::vector<std::pair<std::uint32_t, SnapshotAttributeList>>& records)
+{
+    records.reserve(entities.size());
+    for (const auto& entity : entities) {
+        records.push_back({ stringTable.intern(entity.first), SnapshotAttributeList() });
+        collectAttributes(stringTable, entity.second, records.back().second, skipInternalAttributes);
+    }
+}
+
+static void writeEntities(SnapshotBinaryWriter& writer,
+    const std::vector<std::pair<std::uint32_t, SnapshotAttributeList>>& records)
+{
+    writer.writeUint32((std::uint32_t)records.size());
+    for (const auto& record : records) {
+        writer.writeUint32(record.first);
+        writeAttributes(writer, record.second);
+    }
+}
+
+void saveSnapshotToBinary(const Snapshot& snapshot, std::vector<std::uint8_t>& byteArray)
+{
+    SnapshotStringTable stringTable;
+
+    SnapshotAttributeList canvasAttributes;
+    collectAttributes(stringTable, snapshot.canvas, canvasAttributes, false);
+    SnapshotAttributeList rootComponentAttributes;
+    collectAttributes(stringTable, snapshot.rootComponent, rootComponentAttributes, false);
+
+    size_t nodeCount = snapshot.nodes.size();
+    std::vector<std::uint32_t> nodeIds(nodeCount);
+    std::vector<std::uint8_t> nodeMasks(nodeCount, 0);
+    std::vector<float> nodeColumns[4] = {
+        std::vector<float>(nodeCount, 0.0f),
+        std::vector<float>(nodeCount, 0.0f),
+        std::vector<float>(nodeCount, 0.0f),
+        std::vector<float>(nodeCount, 0.0f)
+    };
+    static const char* nodeColumnKeys[] = { "x", "y", "z", "radius" };
+    std::vector<SnapshotAttributeList> nodeAttributes(nodeCount);
+    size_t nodeIndex = 0;
+    for (const auto& node : snapshot.nodes) {
+        nodeIds[nodeIndex] = stringTable.intern(node.first);
+        const char* skipKeys[5] = { nullptr };
+        size_t skipKeyCount = 0;
+        for (size_t column = 0; column < 4; ++column) {
+            auto findValue = node.second.find(nodeColumnKeys[column]);
+            if (findValue == node.second.end())
+                continue;
+            if (!toExactFloat(findValue->second, &nodeColumns[column][nodeIndex]))
+                continue;
+            nodeMasks[nodeIndex] |= (std::uint8_t)(1 << column);
+            skipKeys[skipKeyCount++] = nodeColumnKeys[column];
+        }
+        collectAttributes(stringTable, node.second, nodeAttributes[nodeIndex], false, skipKeys);
+        ++nodeIndex;
+    }
+
+    size_t edgeCount = snapshot.edges.size();
+    std::vector<std::uint32_t> edgeIds(edgeCount);
+    std::vector<std::uint32_t> edgeFromIds(edgeCount, g_noneIndex);
+    std::vector<std::uint32_t> edgeToIds(edgeCount, g_noneIndex);
+    std::vector<SnapshotAttributeList> edgeAttributes(edgeCount);
+    static const char* edgeColumnKeys[] = { "from", "to", nullptr };
+    size_t edgeIndex = 0;
+    for (const auto& edge : snapshot.edges) {
+        edgeIds[edgeIndex] = stringTable.intern(edge.first);
+        auto findFrom = edge.second.find("from");
+        if (findFrom != edge.second.end())
+            edgeFromIds[edgeIndex] = stringTable.intern(findFrom->second);
+        auto findTo = edge.second.find("to");
+        if (findTo != edge.second.end())
+            edgeToIds[edgeIndex] = stringTable.intern(findTo->second);
+        collectAttributes(stringTable, edge.second, edgeAttributes[edgeIndex], false, edgeColumnKeys);
+        ++edgeIndex;
+    }
+
+    std::vector<std::pair<std::uint32_t, SnapshotAttributeList>> partRecords;
+    collectEntities(stringTable, snapshot.parts, true, partRecords);
+    std::vector<std::pair<std::uint32_t, SnapshotAttributeList>> componentRecords;
+    collectEntities(stringTable, snapshot.components, true, componentRecords);
+    std::vector<std::pair<std::uint32_t, SnapshotAttributeList>> animationRecords;
+    collectEntities(stringTable, snapshot.animations, false, animationRecords);
+
+    SnapshotBinaryWriter writer(byteArray);
+    writer.writeBytes(g_snapshotBinaryMagic, sizeof(g_snapshotBinaryMagic));
+    writer.writeUint32(g_snapshotBinaryVersion);
+    stringTable.write(writer);
+
+    writeAttributes(writer, canvasAttributes);
+    writeAttributes(writer, rootComponentAttributes);
+
+    writer.writeUint32((std::uint32_t)nodeCount);
+    for (const auto& it : nodeIds)
+        writer.writeUint32(it);
+    writer.writeBytes(nodeMasks.data(), nodeMasks.size());
+    for (size_t column = 0; column < 4; ++column) {
+        for (const auto& it : nodeColumns[column])
+            writer.writeFloat(it);
+    }
+    for (const auto& it : nodeAttributes)
+        writeAttributes(writer, it);
+
+    writer.writeUint32((std::uint32_t)edgeCount);
+    for (const auto& it : edgeIds)
+        writer.writeUint32(it);
+    for (const auto& it : edgeFromIds)
+        writer.writeUint32(it);
+    for (const auto& it : edgeToIds)
+        writer.writeUint32(it);
+    for (const auto& it : edgeAttributes)
+        writeAttributes(writer, it);
+
+    writeEntities(writer, partRecords);
+    writeEntities(writer, componentRecords);
+    writeEntities(writer, animationRecords);
+}
+
+static bool readAttributes(SnapshotBinaryReader& reader,
+    const std::vector<std::string>& strings,
+    std::map<std::string, std::string>& attributes)
+{
+    std::uint32_t count = 0;
+    if (!reader.readUint32(&count) || !reader.isCountPlausible(count))
+        return false;
+    for (std::uint32_t i = 0; i < count; ++i) {
+        std::uint32_t key = 0;
+        std::uint32_t value = 0;
+        if (!reader.readUint32(&key) || !reader.readUint32(&value))
+            return false;
+        if (key >= strings.size() || value >= strings.size())
+            return false;
+        attributes[strings[key]] = strings[value];
+    }
+    return true;
+}
+
+static bool readIndexColumn(SnapshotBinaryReader& reader,
+    const std::vector<std::string>& strings,
+    std::vector<std::uint32_t>& column,
+    bool allowNone)
+{
+    for (auto& it : column) {
+        if (!reader.readUint32(&it))
+            return false;
+        if (allowNone && g_noneIndex == it)
+            continue;
+        if (it >= strings.size())
+            return false;
+    }
+    return true;
+}
+
+static bool readEntities(SnapshotBinaryReader& reader,
+    const std::vector<std::string>& strings,
+    std::map<std::string, std::map<std::string, std::string>>& entities)
+{
+    std::uint32_t count = 0;
+    if (!reader.readUint32(&count) || !reader.isCountPlausible(count))
+        return false;
+    for (std::uint32_t i = 0; i < count; ++i) {
+        std::uint32_t id = 0;
+        if (!reader.readUint32(&id) || id >= strings.size())
+            return false;
+        if (!readAttributes(reader, strings, entities[strings[id]]))
+            return false;
+    }
+    return true;
+}
+
+static bool loadSnapshotFromReader(Snapshot* snapshot, SnapshotBinaryReader& reader)
+{
+    char magic[sizeof(g_snapshotBinaryMagic)];
+    if (!reader.readBytes(magic, sizeof(magic)))
+        return false;
+    if (0 != std::memcmp(magic, g_snapshotBinaryMagic, sizeof(magic)))
+        return false;
+    std::uint32_t version = 0;
+    if (!reader.readUint32(&version) || version != g_snapshotBinaryVersion)
+        return false;
+
+    std::uint32_t stringCount = 0;
+    if (!reader.readUint32(&stringCount) || !reader.isCountPlausible(stringCount))
+        return false;
+    std::vector<std::string> strings(stringCount);
+    for (auto& it : strings) {
+        std::uint32_t length = 0;
+        if (!reader.readUint32(&length) || !reader.readString(&it, length))
+            return false;
+    }
+
+    if (!readAttributes(reader, strings, snapshot->canvas))
+        return false;
+    if (!readAttributes(reader, strings, snapshot->rootComponent))
+        return false;
+
+    std::uint32_t nodeCount = 0;
+    if (!reader.readUint32(&nodeCount) || !reader.isCountPlausible(nodeCount))
+        return false;
+    std::vector<std::uint32_t> nodeIds(nodeCount);
+    if (!readIndexColumn(reader, strings, nodeIds, false))
+        return false;
+    std::vector<std::uint8_t> nodeMasks(nodeCount);
+    if (!reader.readBytes(nodeMasks.data(), nodeMasks.size()))
+        return false;
+    static const char* nodeColumnKeys[] = { "x", "y", "z", "radius" };
+    std::vector<std::map<std::string, std::string>*> nodes(nodeCount);
+    for (std::uint32_t i = 0; i < nodeCount; ++i)
+        nodes[i] = &snapshot->nodes[strings[nodeIds[i]]];
+    for (size_t column = 0; column < 4; ++column) {
+        for (std::uint32_t i = 0; i < nodeCount; ++i) {
+            float value = 0.0f;
+            if (!reader.readFloat(&value))
+                return false;
+            if (nodeMasks[i] & (1 << column))
+                (*nodes[i])[nodeColumnKeys[column]] = std::to_string(value);
+        }
+    }
+    for (std::uint32_t i = 0; i < nodeCount; ++i) {
+        if (!readAttributes(reader, strings, *nodes[i]))
+            return false;
+    }
+
+    std::uint32_t edgeCount = 0;
+    if (!reader.readUint32(&edgeCount) || !reader.isCountPlausible(edgeCount))
+        return false;
+    std::vector<std::uint32_t> edgeIds(edgeCount);
+    if (!readIndexColumn(reader, strings, edgeIds, false))
+        return false;
+    std::vector<std::uint32_t> edgeFromIds(edgeCount);
+    if (!readIndexColumn(reader, strings, edgeFromIds, true))
+        return false;
+    std::vector<std::uint32_t> edgeToIds(edgeCount);
+    if (!readIndexColumn(reader, strings, edgeToIds, true))
+        return false;
+    for (std::uint32_t i = 0; i < edgeCount; ++i) {
+        auto& edge = snapshot->edges[strings[edgeIds[i]]];
+        if (g_noneIndex != edgeFromIds[i])
+            edge["from"] = strings[edgeFromIds[i]];
+        if (g_noneIndex != edgeToIds[i])
+            edge["to"] = strings[edgeToIds[i]];
+        if (!readAttributes(reader, strings, edge))
+            return false;
+    }
+
+    if (!readEntities(reader, strings, snapshot->parts))
+        return false;
+    if (!readEntities(reader, strings, snapshot->components))
+        return false;
+    if (!readEntities(reader, strings, snapshot->animations))
+        return false;
+
+    return true;
+}
+
+bool loadSnapshotFromBinary(Snapshot* snapshot, const std::uint8_t* data, size_t size)
+{
+    if (nullptr == data)
+        return false;
+    SnapshotBinaryReader reader(data, size);
+    if (!loadSnapshotFromReader(snapshot, reader)) {
+        *snapshot = Snapshot();
+        return false;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,43 @@
+/*
+ *  Copyright (c) 2016-2026 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef DUST3D_BASE_SNAPSHOT_BINARY_H_
+#define DUST3D_BASE_SNAPSHOT_BINARY_H_
+
+#include <cstdint>
+#include <dust3d/base/snapshot.h>
+#include <vector>
+
+namespace dust3d {
+
+// Compact binary form of a snapshot stored next to model.xml in .ds3 files.
+// All keys and values are interned into one string table, node positions and
+// radii are stored as float columns and edge ends as string table indices, so
+// loading skips the xml text parsing. Values which would not survive the float
+// round trip unchanged stay in the string attributes, so the snapshot loaded
+// back is identical to the one saved.
+void saveSnapshotToBinary(const Snapshot& snapshot, std::vector<std::uint8_t>& byteArray);
+bool loadSnapshotFromBinary(Snapshot* snapshot, const std::uint8_t* data, size_t size);
+
+}
+
+#endif
@@ -0,0 +1,367 @@
+/*
+ *  Copyright (c) 2016-2026 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <dust3d/mesh/encode_meshopt_buffer.h>
+
+namespace dust3d {
+
+namespace {
+
+    const uint8_t g_vertexHeader = 0xa0;
+    const size_t g_vertexBlockSizeBytes = 8192;
+    const size_t g_vertexBlockMaxSize = 256;
+    const size_t g_byteGroupSize = 16;
+    const size_t g_vertexTailMinSize = 32;
+
+    const uint8_t g_indexHeader = 0xe0;
+    const int g_indexVersion = 1;
+
+    // Frequent (feb << 4 | fec) pairs, written to the end of the stream where decoders read it back
+    const uint8_t g_codeAuxTable[16] = {
+        0x00, 0x76, 0x87, 0x56, 0x67, 0x78, 0xa9, 0x86, 0x65, 0x89, 0x68, 0x98, 0x01, 0x69,
+        0x00, 0x00
+    };
+
+    const int g_triangleIndexOrder[3][3] = {
+        { 0, 1, 2 },
+        { 1, 2, 0 },
+        { 2, 0, 1 }
+    };
+
+    uint8_t zigzag8(uint8_t value)
+    {
+        return (uint8_t)(((signed char)value >> 7) ^ (value << 1));
+    }
+
+    size_t measureByteGroup(const uint8_t* group, int bits)
+    {
+        if (1 == bits) {
+            for (size_t i = 0; i < g_byteGroupSize; ++i) {
+                if (0 != group[i])
+                    return (size_t)-1;
+            }
+            return 0;
+        }
+        if (8 == bits)
+            return g_byteGroupSize;
+        size_t size = g_byteGroupSize * bits / 8;
+        uint8_t sentinel = (uint8_t)((1 << bits) - 1);
+        for (size_t i = 0; i < g_byteGroupSize; ++i) {
+            if (group[i] >= sentinel)
+                ++size;
+        }
+        return size;
+    }
+
+    void encodeByteGroup(const uint8_t* group, int bits, std::vector<uint8_t>* encoded)
+    {
+        if (1 == bits)
+            return;
+        if (8 == bits) {
+            encoded->insert(encoded->end(), group, group + g_byteGroupSize);
+            return;
+        }
+        // Fixed width values with the all ones value standing for a full byte following the group
+        size_t valuesPerByte = 8 / bits;
+        uint8_t sentinel = (uint8_t)((1 << bits) - 1);
+        for (size_t i = 0; i < g_byteGroupSize; i += valuesPerByte) {
+            uint8_t byte = 0;
+            for (size_t k = 0; k < valuesPerByte; ++k) {
+                byte = (uint8_t)(byte << bits);
+                byte |= std::min(group[i + k], sentinel);
+            }
+            encoded->push_back(byte);
+        }
+        for (size_t i = 0; i < g_byteGroupSize; ++i) {
+            if (group[i] >= sentinel)
+                encoded->push_back(group[i]);
+        }
+    }
+
+    void encodeBytes(const uint8_t* bytes, size_t byteCount, std::vector<uint8_t>* encoded)
+    {
+        // Two bits per group choose between all zero, 2 bit, 4 bit and raw groups
+        size_t headerOffset = encoded->size();
+        size_t groupCount = byteCount / g_byteGroupSize;
+        encoded->resize(encoded->size() + (groupCount + 3) / 4, 0);
+        for (size_t group = 0; group < groupCount; ++group) {
+            const uint8_t* groupBytes = bytes + group * g_byteGroupSize;
+            int bestBits = 8;
+            size_t bestSize = measureByteGroup(groupBytes, 8);
+            for (int bits = 1; bits < 8; bits *= 2) {
+                size_t size = measureByteGroup(groupBytes, bits);
+                if (size < bestSize) {
+                    bestBits = bits;
+                    bestSize = size;
+                }
+            }
+            int bitsLog2 = 1 == bestBits ? 0 : (2 == bestBits ? 1 : (4 == bestBits ? 2 : 3));
+            (*encoded)[headerOffset + group / 4] |= (uint8_t)(bitsLog2 << ((group % 4) * 2));
+            encodeByteGroup(groupBytes, bestBits, encoded);
+        }
+    }
+
+    void encodeVertexBlock(const uint8_t* vertices, size_t vertexCount, size_t vertexSize,
+        uint8_t* lastVertex, std::vector<uint8_t>* encoded)
+    {
+        uint8_t buffer[g_vertexBlockMaxSize];
+        size_t alignedVertexCount = (vertexCount + g_byteGroupSize - 1) & ~(g_byteGroupSize - 1);
+        for (size_t k = 0; k < vertexSize; ++k) {
+            uint8_t previous = lastVertex[k];
+            for (size_t i = 0; i < vertexCount; ++i) {
+                uint8_t current = vertices[i * vertexSize + k];
+                buffer[i] = zigzag8((uint8_t)(current - previous));
+                previous = current;
+            }
+            for (size_t i = vertexCount; i < alignedVertexCount; ++i)
+                buffer[i] = buffer[vertexCount - 1];
+            encodeBytes(buffer, alignedVertexCount, encoded);
+        }
+        std::memcpy(lastVertex, vertices + (vertexCount - 1) * vertexSize, vertexSize);
+    }
+
+    void encodeVByte(uint32_t value, std::vector<uint8_t>* encoded)
+    {
+        do {
+            encoded->push_back((uint8_t)((value & 127) | (value > 127 ? 128 : 0)));
+            value >>= 7;
+        } while (0 != value);
+    }
+
+    void encodeIndex(uint32_t index, uint32_t last, std::vector<uint8_t>* encoded)
+    {
+        uint32_t delta = index - last;
+        encodeVByte((delta << 1) ^ (uint32_t)((int32_t)delta >> 31), encoded);
+    }
+
+    class IndexFifos {
+    public:
+        IndexFifos()
+        {
+            resetVertices();
+            for (auto& edge : m_edges)
+                edge[0] = edge[1] = (uint32_t)-1;
+        }
+
+        void resetVertices()
+        {
+            for (auto& vertex : m_vertices)
+                vertex = (uint32_t)-1;
+        }
+
+        int findEdge(uint32_t a, uint32_t b, uint32_t c) const
+        {
+            for (int i = 0; i < 16; ++i) {
+                const auto& edge = m_edges[(m_edgeOffset - 1 - i) & 15];
+                if (edge[0] == a && edge[1] == b)
+                    return (i << 2) | 0;
+                if (edge[0] == b && edge[1] == c)
+                    return (i << 2) | 1;
+                if (edge[0] == c && edge[1] == a)
+                    return (i << 2) | 2;
+            }
+            return -1;
+        }
+
+        void pushEdge(uint32_t a, uint32_t b)
+        {
+            m_edges[m_edgeOffset][0] = a;
+            m_edges[m_edgeOffset][1] = b;
+            m_edgeOffset = (m_edgeOffset + 1) & 15;
+        }
+
+        int findVertex(uint32_t v) const
+        {
+            for (int i = 0; i < 16; ++i) {
+                if (m_vertices[(m_vertexOffset - 1 - i) & 15] == v)
+                    return i;
+            }
+            return -1;
+        }
+
+        void pushVertex(uint32_t v)
+        {
+            m_vertices[m_vertexOffset] = v;
+            m_vertexOffset = (m_vertexOffset + 1) & 15;
+        }
+
+    private:
+        uint32_t m_edges[16][2];
+        uint32_t m_vertices[16];
+        size_t m_edgeOffset = 0;
+        size_t m_vertexOffset = 0;
+    };
+
+    int findCodeAux(uint8_t codeAux)
+    {
+        for (int i = 0; i < 16; ++i) {
+            if (g_codeAuxTable[i] == codeAux)
+                return i;
+        }
+        return -1;
+    }
+
+}
+
+void encodeMeshoptVertexBuffer(const uint8_t* vertices, size_t vertexCount, size_t vertexSize, std::vector<uint8_t>* encoded)
+{
+    encoded->clear();
+    encoded->push_back(g_vertexHeader);
+
+    uint8_t firstVertex[256] = {};
+    if (vertexCount > 0)
+        std::memcpy(firstVertex, vertices, vertexSize);
+    uint8_t lastVertex[256] = {};
+    std::memcpy(lastVertex, firstVertex, vertexSize);
+
+    size_t blockSize = std::min(g_vertexBlockMaxSize, (g_vertexBlockSizeBytes / vertexSize) & ~(g_byteGroupSize - 1));
+    for (size_t offset = 0; offset < vertexCount; offset += blockSize) {
+        encodeVertexBlock(vertices + offset * vertexSize, std::min(blockSize, vertexCount - offset), vertexSize,
+            lastVertex, encoded);
+    }
+
+    // The first vertex closes the stream, padded so decoders can read ahead without bounds checks
+    if (vertexSize < g_vertexTailMinSize)
+        encoded->resize(encoded->size() + g_vertexTailMinSize - vertexSize, 0);
+    encoded->insert(encoded->end(), firstVertex, firstVertex + vertexSize);
+}
+
+void encodeMeshoptIndexBuffer(const std::vector<uint32_t>& indices, std::vector<uint8_t>* encoded)
+{
+    size_t triangleCount = indices.size() / 3;
+    encoded->clear();
+    encoded->push_back((uint8_t)(g_indexHeader | g_indexVersion));
+    // One code byte per triangle up front, everything else following them
+    encoded->resize(1 + triangleCount, 0);
+    std::vector<uint8_t>& data = *encoded;
+
+    IndexFifos fifos;
+    uint32_t next = 0;
+    uint32_t last = 0;
+    const int fecMax = 13;
+    for (size_t t = 0; t < triangleCount; ++t) {
+        const uint32_t* triangle = &indices[t * 3];
+        uint8_t& code = data[1 + t];
+        int fer = fifos.findEdge(triangle[0], triangle[1], triangle[2]);
+        if (fer >= 0 && (fer >> 2) < 15) {
+            // Rotated so that a and b form the edge found
+            const int* order = g_triangleIndexOrder[fer & 3];
+            uint32_t a = triangle[order[0]];
+            uint32_t b = triangle[order[1]];
+            uint32_t c = triangle[order[2]];
+            int fe = fer >> 2;
+            int fc = fifos.findVertex(c);
+            int fec = 15;
+            if (fc >= 1 && fc < fecMax) {
+                fec = fc;
+            } else if (c == next) {
+                fec = 0;
+                ++next;
+            } else if (c + 1 == last) {
+                fec = 13;
+                last = c;
+            } else if (c == last + 1) {
+                fec = 14;
+                last = c;
+            }
+            code = (uint8_t)((fe << 4) | fec);
+            if (15 == fec) {
+                encodeIndex(c, last, &data);
+                last = c;
+            }
+            if (0 == fec || fec >= fecMax)
+                fifos.pushVertex(c);
+            fifos.pushEdge(c, b);
+            fifos.pushEdge(a, c);
+        } else {
+            int rotation = triangle[1] == next ? 1 : (triangle[2] == next ? 2 : 0);
+            const int* order = g_triangleIndexOrder[rotation];
+            uint32_t a = triangle[order[0]];
+            uint32_t b = triangle[order[1]];
+            uint32_t c = triangle[order[2]];
+            // 0 1 2 after the start restarts the numbering, so concatenated meshes code as well as separate ones
+            bool reset = false;
+            if (0 == a && 1 == b && 2 == c && next > 0) {
+                reset = true;
+                next = 0;
+                fifos.resetVertices();
+            }
+            int fb = fifos.findVertex(b);
+            int fc = fifos.findVertex(c);
+            int fea = 15;
+            if (a == next) {
+                fea = 0;
+                ++next;
+            }
+            int feb = 15;
+            if (fb >= 0 && fb < 14) {
+                feb = fb + 1;
+            } else if (b == next) {
+                feb = 0;
+                ++next;
+            }
+            int fec = 15;
+            if (fc >= 0 && fc < 14) {
+                fec = fc + 1;
+            } else if (c == next) {
+                fec = 0;
+                ++next;
+            }
+            uint8_t codeAux = (uint8_t)((feb << 4) | fec);
+            int codeAuxIndex = findCodeAux(codeAux);
+            if (0 == fea && codeAuxIndex >= 0 && codeAuxIndex < 14 && !reset) {
+                code = (uint8_t)((15 << 4) | codeAuxIndex);
+            } else {
+                code = (uint8_t)((15 << 4) | 14 | fea);
+                data.push_back(codeAux);
+            }
+            if (15 == fea) {
+                encodeIndex(a, last, &data);
+                last = a;
+            }
+            if (15 == feb) {
+                encodeIndex(b, last, &data);
+                last = b;
+            }
+            if (15 == fec) {
+                encodeIndex(c, last, &data);
+                last = c;
+            }
+            if (0 == fea || 15 == fea)
+                fifos.pushVertex(a);
+            if (0 == feb || 15 == feb)
+                fifos.pushVertex(b);
+            if (0 == fec || 15 == fec)
+                fifos.pushVertex(c);
+            fifos.pushEdge(b, a);
+            fifos.pushEdge(c, b);
+            fifos.pushEdge(a, c);
+        }
+    }
+
+    // The table doubles as the padding decoders rely on to read a whole triangle without bounds checks
+    data.insert(data.end(), g_codeAuxTable, g_codeAuxTable + 16);
+}
+
+}
@@ -0,0 +1,43 @@
+/*
+ *  Copyright (c) 2016-2026 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef DUST3D_MESH_ENCODE_MESHOPT_BUFFER_H_
+#define DUST3D_MESH_ENCODE_MESHOPT_BUFFER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dust3d {
+
+// Encoders of the EXT_meshopt_compression bitstreams, readable by any glTF loader supporting the extension.
+// The attribute codec (mode ATTRIBUTES, version 0) delta codes each byte of a vertex against the previous vertex
+// and bit packs the deltas in groups of 16; vertexSize must be a multiple of 4 and at most 256.
+void encodeMeshoptVertexBuffer(const uint8_t* vertices, size_t vertexCount, size_t vertexSize, std::vector<uint8_t>* encoded);
+
+// The triangle codec (mode TRIANGLES, version 1) codes each triangle against FIFOs of recent edges and vertices,
+// so it pays off on cache optimized triangle orders with vertices numbered in first use order.
+void encodeMeshoptIndexBuffer(const std::vector<uint32_t>& indices, std::vector<uint8_t>* encoded);
+
+}
+
+#endif
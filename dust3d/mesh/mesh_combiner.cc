@@ -69,12 +69,14 @@ bool MeshCombiner::Mesh::isNull() const
 }
 
 MeshCombiner::Mesh* MeshCombiner::combine(const Mesh& firstMesh, const Mesh& secondMesh, Method method,
-    std::vector<std::pair<Source, size_t>>* combinedVerticesComeFrom)
+    std::vector<std::pair<Source, size_t>>* combinedVerticesComeFrom,
+    const CancellationToken* cancellationToken)
 {
     if (firstMesh.isNull() || secondMesh.isNull())
         return nullptr;
 
     SolidMeshBooleanOperation booleanOperation(firstMesh.m_solidMesh.get(), secondMesh.m_solidMesh.get());
+    booleanOperation.setCancellationToken(cancellationToken);
     if (!booleanOperation.combine())
         return nullptr;
 
@@ -23,6 +23,7 @@
 #ifndef DUST3D_MESH_MESH_COMBINER_H_
 #define DUST3D_MESH_MESH_COMBINER_H_
 
+#include <dust3d/base/cancellation_token.h>
 #include <dust3d/base/vector3.h>
 #include <dust3d/mesh/solid_mesh.h>
 #include <memory>
@@ -61,7 +62,8 @@ public:
     };
 
     static Mesh* combine(const Mesh& firstMesh, const Mesh& secondMesh, Method method,
-        std::vector<std::pair<Source, size_t>>* combinedVerticesComeFrom = nullptr);
+        std::vector<std::pair<Source, size_t>>* combinedVerticesComeFrom = nullptr,
+        const CancellationToken* cancellationToken = nullptr);
 };
 
 }
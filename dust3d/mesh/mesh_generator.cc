@@ -22,11 +22,15 @@
 
 #include <cmath>
 #include <dust3d/base/cut_face.h>
+#include <dust3d/base/parallel.h>
 #include <dust3d/base/part_target.h>
+#include <dust3d/base/point_kd_tree.h>
 #include <dust3d/base/snapshot_xml.h>
 #include <dust3d/base/string.h>
 #include <dust3d/mesh/mesh_generator.h>
+#include <dust3d/mesh/mesh_generator_disk_cache.h>
 #include <dust3d/mesh/mesh_recombiner.h>
+#include <dust3d/mesh/optimize_triangle_order.h>
 #include <dust3d/mesh/rope_mesh.h>
 #include <dust3d/mesh/smooth_normal.h>
 #include <dust3d/mesh/spine_deformer.h>
@@ -39,19 +43,27 @@
 #include <functional>
 #include <limits>
 #include <memory>
+#include <unordered_map>
 
 namespace dust3d {
 
 double MeshGenerator::m_minimalRadius = 0.001;
+const size_t MeshGenerator::m_draftMaxCutFacePoints = 6;
 
 MeshGenerator::MeshGenerator(Snapshot* snapshot)
     : m_snapshot(snapshot)
+    , m_ownedSnapshot(snapshot)
+{
+}
+
+MeshGenerator::MeshGenerator(std::shared_ptr<const Snapshot> sourceSnapshot)
+    : m_snapshot(sourceSnapshot.get())
+    , m_sourceSnapshot(std::move(sourceSnapshot))
 {
 }
 
 MeshGenerator::~MeshGenerator()
 {
-    delete m_snapshot;
     delete m_object;
 }
 
@@ -65,9 +77,51 @@ uint64_t MeshGenerator::id()
     return m_id;
 }
 
-void MeshGenerator::setImportedModelData(std::map<std::string, ImportedModelData>&& importedModelData)
+void MeshGenerator::setImportedModelData(const std::map<std::string, std::shared_ptr<const ImportedModelData>>& importedModelData)
+{
+    m_importedModelData = importedModelData;
+}
+
+void MeshGenerator::setCancellationToken(std::shared_ptr<const CancellationToken> cancellationToken)
+{
+    m_cancellationToken = cancellationToken;
+}
+
+bool MeshGenerator::isCancelled()
+{
+    return m_isCancelled;
+}
+
+const std::set<std::string>& MeshGenerator::unfinishedComponentIds()
 {
-    m_importedModelData = std::move(importedModelData);
+    return m_unfinishedComponentIds;
+}
+
+void MeshGenerator::setDraftMode(bool draftMode)
+{
+    m_draftMode = draftMode;
+}
+
+bool MeshGenerator::isDraftMode()
+{
+    return m_draftMode;
+}
+
+void MeshGenerator::setChangeSet(std::unique_ptr<ChangeSet> changeSet)
+{
+    m_changeSet = std::move(changeSet);
+}
+
+void MeshGenerator::setDiskCache(std::shared_ptr<MeshGeneratorDiskCache> diskCache)
+{
+    m_diskCache = diskCache;
+}
+
+bool MeshGenerator::checkCancellation()
+{
+    if (!m_isCancelled && CancellationToken::isCancelled(m_cancellationToken.get()))
+        m_isCancelled = true;
+    return m_isCancelled;
 }
 
 bool MeshGenerator::isSuccessful()
@@ -89,9 +143,116 @@ Object* MeshGenerator::takeObject()
 
 Snapshot* MeshGenerator::takeSnapshot()
 {
-    Snapshot* snapshot = m_snapshot;
+    std::unique_ptr<Snapshot> snapshot = std::move(m_ownedSnapshot);
+    if (nullptr == snapshot) {
+        if (nullptr == m_sourceSnapshot)
+            return nullptr;
+        snapshot = std::make_unique<Snapshot>(*m_sourceSnapshot);
+        m_sourceSnapshot.reset();
+    }
     m_snapshot = nullptr;
-    return snapshot;
+    applySnapshotOverlay(snapshot.get(), m_overlay);
+    return snapshot.release();
+}
+
+std::shared_ptr<const Snapshot> MeshGenerator::takeSourceSnapshot()
+{
+    if (nullptr != m_sourceSnapshot)
+        m_snapshot = nullptr;
+    return std::move(m_sourceSnapshot);
+}
+
+std::unique_ptr<MeshGenerator::SnapshotOverlay> MeshGenerator::takeSnapshotOverlay()
+{
+    return std::make_unique<SnapshotOverlay>(std::move(m_overlay));
+}
+
+void MeshGenerator::applySnapshotOverlay(Snapshot* snapshot, const SnapshotOverlay& overlay)
+{
+    for (const auto& edgeIdString : overlay.removedEdgeIds)
+        snapshot->edges.erase(edgeIdString);
+    for (const auto& it : overlay.records.nodes)
+        snapshot->nodes[it.first] = it.second;
+    for (const auto& it : overlay.records.edges)
+        snapshot->edges[it.first] = it.second;
+    for (const auto& it : overlay.records.parts)
+        snapshot->parts[it.first] = it.second;
+    for (const auto& it : overlay.records.components)
+        snapshot->components[it.first] = it.second;
+    if (!overlay.records.rootComponent.empty())
+        snapshot->rootComponent = overlay.records.rootComponent;
+}
+
+typedef std::map<std::string, std::map<std::string, std::string>> SnapshotRecords;
+
+// The overlay is looked up first, the source only for records the overlay neither has nor removed
+static const std::map<std::string, std::string>* findSnapshotRecord(const SnapshotRecords& overlay,
+    const SnapshotRecords& source,
+    const std::string& idString,
+    const std::set<std::string>* removedIds = nullptr)
+{
+    auto findOverlay = overlay.find(idString);
+    if (findOverlay != overlay.end())
+        return &findOverlay->second;
+    if (nullptr != removedIds && removedIds->find(idString) != removedIds->end())
+        return nullptr;
+    auto findSource = source.find(idString);
+    if (findSource == source.end())
+        return nullptr;
+    return &findSource->second;
+}
+
+template <typename F>
+static void forEachSnapshotRecord(const SnapshotRecords& overlay,
+    const SnapshotRecords& source,
+    const std::set<std::string>* removedIds,
+    F handleRecord)
+{
+    for (const auto& it : source) {
+        if (overlay.find(it.first) != overlay.end())
+            continue;
+        if (nullptr != removedIds && removedIds->find(it.first) != removedIds->end())
+            continue;
+        handleRecord(it.first, it.second);
+    }
+    for (const auto& it : overlay)
+        handleRecord(it.first, it.second);
+}
+
+// Copies the source record into the overlay the first time it gets rewritten
+static std::map<std::string, std::string>& overlaySnapshotRecord(SnapshotRecords& overlay,
+    const SnapshotRecords& source,
+    const std::string& idString)
+{
+    auto findOverlay = overlay.find(idString);
+    if (findOverlay != overlay.end())
+        return findOverlay->second;
+    auto findSource = source.find(idString);
+    if (findSource == source.end())
+        return overlay[idString];
+    return overlay.emplace(idString, findSource->second).first->second;
+}
+
+const std::map<std::string, std::string>* MeshGenerator::findPart(const std::string& partIdString)
+{
+    return findSnapshotRecord(m_overlay.records.parts, m_snapshot->parts, partIdString);
+}
+
+const std::map<std::string, std::string>* MeshGenerator::findNode(const std::string& nodeIdString)
+{
+    return findSnapshotRecord(m_overlay.records.nodes, m_snapshot->nodes, nodeIdString);
+}
+
+const std::map<std::string, std::string>* MeshGenerator::findEdge(const std::string& edgeIdString)
+{
+    return findSnapshotRecord(m_overlay.records.edges, m_snapshot->edges, edgeIdString, &m_overlay.removedEdgeIds);
+}
+
+const std::map<std::string, std::string>& MeshGenerator::rootComponent()
+{
+    if (!m_overlay.records.rootComponent.empty())
+        return m_overlay.records.rootComponent;
+    return m_snapshot->rootComponent;
 }
 
 void MeshGenerator::chamferFace(std::vector<Vector2>* face)
@@ -117,6 +278,16 @@ void MeshGenerator::subdivideFace(std::vector<Vector2>* face)
     }
 }
 
+void MeshGenerator::decimateFace(std::vector<Vector2>* face, size_t maxPoints)
+{
+    if (face->size() <= maxPoints)
+        return;
+    auto oldFace = *face;
+    face->resize(maxPoints);
+    for (size_t i = 0; i < maxPoints; ++i)
+        (*face)[i] = oldFace[i * oldFace.size() / maxPoints];
+}
+
 void MeshGenerator::recoverQuads(const std::vector<Vector3>& vertices, const std::vector<std::vector<size_t>>& triangles, const std::set<std::pair<PositionKey, PositionKey>>& sharedQuadEdges, std::vector<std::vector<size_t>>& triangleAndQuads)
 {
     std::vector<PositionKey> verticesPositionKeys;
@@ -165,47 +336,49 @@ void MeshGenerator::recoverQuads(const std::vector<Vector3>& vertices, const std
 
 void MeshGenerator::collectParts()
 {
-    for (const auto& node : m_snapshot->nodes) {
-        std::string partId = String::valueOrEmpty(node.second, "partId");
+    forEachSnapshotRecord(m_overlay.records.nodes, m_snapshot->nodes, nullptr, [&](const std::string& nodeIdString, const std::map<std::string, std::string>& node) {
+        std::string partId = String::valueOrEmpty(node, "partId");
         if (partId.empty())
-            continue;
-        m_partNodeIds[partId].insert(node.first);
-    }
-    for (const auto& edge : m_snapshot->edges) {
-        std::string partId = String::valueOrEmpty(edge.second, "partId");
+            return;
+        m_partNodeIds[partId].insert(nodeIdString);
+    });
+    forEachSnapshotRecord(m_overlay.records.edges, m_snapshot->edges, &m_overlay.removedEdgeIds, [&](const std::string& edgeIdString, const std::map<std::string, std::string>& edge) {
+        std::string partId = String::valueOrEmpty(edge, "partId");
         if (partId.empty())
-            continue;
-        m_partEdgeIds[partId].insert(edge.first);
-    }
+            return;
+        m_partEdgeIds[partId].insert(edgeIdString);
+    });
 }
 
 bool MeshGenerator::checkIsPartDirty(const std::string& partIdString)
 {
-    auto findPart = m_snapshot->parts.find(partIdString);
-    if (findPart == m_snapshot->parts.end()) {
+    if (nullptr != m_changeSet)
+        return m_changeSet->changedPartIds.find(partIdString) != m_changeSet->changedPartIds.end();
+    const std::map<std::string, std::string>* part = findPart(partIdString);
+    if (nullptr == part) {
         return false;
     }
-    return String::isTrue(String::valueOrEmpty(findPart->second, "__dirty"));
+    return String::isTrue(String::valueOrEmpty(*part, "__dirty"));
 }
 
 bool MeshGenerator::checkIsPartDependencyDirty(const std::string& partIdString)
 {
-    auto findPart = m_snapshot->parts.find(partIdString);
-    if (findPart == m_snapshot->parts.end()) {
+    const std::map<std::string, std::string>* part = findPart(partIdString);
+    if (nullptr == part) {
         return false;
     }
-    std::string cutFaceString = String::valueOrEmpty(findPart->second, "cutFace");
+    std::string cutFaceString = String::valueOrEmpty(*part, "cutFace");
     Uuid cutFaceLinkedPartId = Uuid(cutFaceString);
     if (!cutFaceLinkedPartId.isNull()) {
         if (checkIsPartDirty(cutFaceString))
             return true;
     }
     for (const auto& nodeIdString : m_partNodeIds[partIdString]) {
-        auto findNode = m_snapshot->nodes.find(nodeIdString);
-        if (findNode == m_snapshot->nodes.end()) {
+        const std::map<std::string, std::string>* node = findNode(nodeIdString);
+        if (nullptr == node) {
             continue;
         }
-        std::string cutFaceString = String::valueOrEmpty(findNode->second, "cutFace");
+        std::string cutFaceString = String::valueOrEmpty(*node, "cutFace");
         Uuid cutFaceLinkedPartId = Uuid(cutFaceString);
         if (!cutFaceLinkedPartId.isNull()) {
             if (checkIsPartDirty(cutFaceString))
@@ -219,16 +392,14 @@ bool MeshGenerator::checkIsComponentDirty(const std::string& componentIdString)
 {
     bool isDirty = false;
 
-    const std::map<std::string, std::string>* component = &m_snapshot->rootComponent;
-    if (componentIdString != to_string(Uuid())) {
-        auto findComponent = m_snapshot->components.find(componentIdString);
-        if (findComponent == m_snapshot->components.end()) {
-            return isDirty;
-        }
-        component = &findComponent->second;
-    }
+    const std::map<std::string, std::string>* component = findComponent(componentIdString);
+    if (nullptr == component)
+        return isDirty;
 
-    if (String::isTrue(String::valueOrEmpty(*component, "__dirty"))) {
+    if (nullptr != m_changeSet) {
+        if (m_changeSet->changedComponentIds.find(componentIdString) != m_changeSet->changedComponentIds.end())
+            isDirty = true;
+    } else if (String::isTrue(String::valueOrEmpty(*component, "__dirty"))) {
         isDirty = true;
     }
 
@@ -265,22 +436,189 @@ void MeshGenerator::checkDirtyFlags()
     checkIsComponentDirty(to_string(Uuid()));
 }
 
+bool MeshGenerator::needCachePruning()
+{
+    if (nullptr == m_changeSet)
+        return true;
+    if (!m_changeSet->removedPartIds.empty() || !m_changeSet->removedComponentIds.empty())
+        return true;
+    // A part which stopped being mirrored leaves its mirror behind in the cache
+    for (const auto& partIdString : m_changeSet->changedPartIds) {
+        std::string mirroredPartIdString = reverseUuid(partIdString);
+        if (m_cacheContext->parts.find(mirroredPartIdString) != m_cacheContext->parts.end()
+            && nullptr == findPart(mirroredPartIdString))
+            return true;
+    }
+    return false;
+}
+
+void MeshGenerator::pruneCache()
+{
+    for (auto it = m_cacheContext->parts.begin(); it != m_cacheContext->parts.end();) {
+        if (nullptr == findPart(it->first)) {
+            auto mirrorFrom = m_cacheContext->partMirrorIdMap.find(it->first);
+            if (mirrorFrom != m_cacheContext->partMirrorIdMap.end()) {
+                if (nullptr != findPart(mirrorFrom->second)) {
+                    it++;
+                    continue;
+                }
+                m_cacheContext->partMirrorIdMap.erase(mirrorFrom);
+            }
+            it = m_cacheContext->parts.erase(it);
+            continue;
+        }
+        it++;
+    }
+    for (auto it = m_cacheContext->components.begin(); it != m_cacheContext->components.end();) {
+        if (nullptr == findComponent(it->first)) {
+            for (auto combinationIt = m_cacheContext->cachedCombination.begin(); combinationIt != m_cacheContext->cachedCombination.end();) {
+                if (std::string::npos != combinationIt->first.find(it->first)) {
+                    combinationIt = m_cacheContext->cachedCombination.erase(combinationIt);
+                    continue;
+                }
+                combinationIt++;
+            }
+            it = m_cacheContext->components.erase(it);
+            continue;
+        }
+        it++;
+    }
+}
+
+std::string MeshGenerator::partDiskCacheKey(const std::string& partIdString)
+{
+    MeshGeneratorDiskCache::KeyBuilder keyBuilder;
+    const std::map<std::string, std::string>* part = findPart(partIdString);
+    if (nullptr == part)
+        return keyBuilder.key();
+    keyBuilder.addAttributes(*part);
+    for (const auto& nodeIdString : m_partNodeIds[partIdString]) {
+        const std::map<std::string, std::string>* node = findNode(nodeIdString);
+        if (nullptr != node)
+            keyBuilder.addAttributes(*node);
+    }
+    for (const auto& edgeIdString : m_partEdgeIds[partIdString]) {
+        const std::map<std::string, std::string>* edge = findEdge(edgeIdString);
+        if (nullptr != edge)
+            keyBuilder.addAttributes(*edge);
+    }
+    return keyBuilder.key();
+}
+
+const std::string& MeshGenerator::componentDiskCacheKey(const std::string& componentIdString)
+{
+    auto findKey = m_componentDiskCacheKeys.find(componentIdString);
+    if (findKey != m_componentDiskCacheKeys.end())
+        return findKey->second;
+
+    MeshGeneratorDiskCache::KeyBuilder keyBuilder;
+    keyBuilder.addAttributes(m_snapshot->canvas);
+    keyBuilder.addString(m_defaultPartColor.toString());
+    keyBuilder.addString(componentIdString);
+    const std::map<std::string, std::string>* component = findComponent(componentIdString);
+    if (nullptr != component) {
+        keyBuilder.addAttributes(*component);
+        if ("partId" == String::valueOrEmpty(*component, "linkDataType")) {
+            // The part is generated from its own nodes, and from those of the parts it mirrors or takes cut faces from
+            std::string partIdString = String::valueOrEmpty(*component, "linkData");
+            std::set<std::string> dependencyPartIds;
+            const std::map<std::string, std::string>* part = findPart(partIdString);
+            if (nullptr != part) {
+                dependencyPartIds.insert(String::valueOrEmpty(*part, "__mirrorFromPartId"));
+                dependencyPartIds.insert(String::valueOrEmpty(*part, "cutFace"));
+            }
+            for (const auto& nodeIdString : m_partNodeIds[partIdString]) {
+                const std::map<std::string, std::string>* node = findNode(nodeIdString);
+                if (nullptr != node)
+                    dependencyPartIds.insert(String::valueOrEmpty(*node, "cutFace"));
+            }
+            keyBuilder.addString(partDiskCacheKey(partIdString));
+            for (const auto& dependencyPartId : dependencyPartIds) {
+                if (Uuid(dependencyPartId).isNull())
+                    continue;
+                keyBuilder.addString(partDiskCacheKey(dependencyPartId));
+            }
+        }
+        for (const auto& childId : String::split(String::valueOrEmpty(*component, "children"), ',')) {
+            if (childId.empty())
+                continue;
+            keyBuilder.addString(componentDiskCacheKey(childId));
+        }
+    }
+    return m_componentDiskCacheKeys.insert({ componentIdString, keyBuilder.key() }).first->second;
+}
+
+bool MeshGenerator::restoreComponentFromDiskCache(const std::string& componentIdString)
+{
+    const std::map<std::string, std::string>* component = findComponent(componentIdString);
+    if (nullptr == component)
+        return false;
+
+    auto& componentCache = m_cacheContext->components[componentIdString];
+    GeneratedPart part;
+    bool hasPart = false;
+    std::map<Uuid, ComponentPreview> previews;
+    if (!m_diskCache->load(componentDiskCacheKey(componentIdString), &componentCache, &part, &hasPart, &previews)) {
+        componentCache.reset();
+        return false;
+    }
+    if (hasPart)
+        m_cacheContext->parts[String::valueOrEmpty(*component, "linkData")] = std::move(part);
+    // These previews are already stored in this entry, the one of a parent being generated should not repeat them
+    m_collectingPreviewComponentIds.push_back({});
+    for (auto& it : previews)
+        addComponentPreview(it.first, std::move(it.second));
+    m_collectingPreviewComponentIds.pop_back();
+    m_finishedComponentIds.insert(componentIdString);
+
+    // Children are restored as well, for their previews, and so that a later edit of one child
+    // finds its siblings in the memory cache. A child which is not on disk is generated when needed.
+    for (const auto& childId : String::split(String::valueOrEmpty(*component, "children"), ',')) {
+        if (childId.empty())
+            continue;
+        if (m_cacheContext->components.find(childId) != m_cacheContext->components.end())
+            continue;
+        restoreComponentFromDiskCache(childId);
+    }
+    return true;
+}
+
+void MeshGenerator::storeComponentToDiskCache(const std::string& componentIdString)
+{
+    const std::map<std::string, std::string>* component = findComponent(componentIdString);
+    if (nullptr == component)
+        return;
+
+    const GeneratedPart* part = nullptr;
+    if ("partId" == String::valueOrEmpty(*component, "linkDataType")) {
+        auto findPart = m_cacheContext->parts.find(String::valueOrEmpty(*component, "linkData"));
+        if (findPart != m_cacheContext->parts.end())
+            part = &findPart->second;
+    }
+    std::map<Uuid, const ComponentPreview*> previews;
+    for (const auto& componentId : m_collectingPreviewComponentIds.back()) {
+        auto findPreview = m_generatedComponentPreviews.find(componentId);
+        if (findPreview != m_generatedComponentPreviews.end())
+            previews.insert({ componentId, &findPreview->second });
+    }
+    m_diskCache->save(componentDiskCacheKey(componentIdString), m_cacheContext->components[componentIdString], part, previews);
+}
+
 void MeshGenerator::cutFaceStringToCutTemplate(const std::string& cutFaceString, std::vector<Vector2>& cutTemplate)
 {
     Uuid cutFaceLinkedPartId = Uuid(cutFaceString);
     if (!cutFaceLinkedPartId.isNull()) {
         std::map<std::string, std::tuple<float, float, float>> cutFaceNodeMap;
-        auto findCutFaceLinkedPart = m_snapshot->parts.find(cutFaceString);
-        if (findCutFaceLinkedPart == m_snapshot->parts.end()) {
+        if (nullptr == findPart(cutFaceString)) {
             // void
         } else {
             // Build node info map
             for (const auto& nodeIdString : m_partNodeIds[cutFaceString]) {
-                auto findNode = m_snapshot->nodes.find(nodeIdString);
-                if (findNode == m_snapshot->nodes.end()) {
+                const std::map<std::string, std::string>* nodeRecord = findNode(nodeIdString);
+                if (nullptr == nodeRecord) {
                     continue;
                 }
-                auto& node = findNode->second;
+                auto& node = *nodeRecord;
                 float radius = String::toFloat(String::valueOrEmpty(node, "radius"));
                 float x = (String::toFloat(String::valueOrEmpty(node, "x")) - m_mainProfileMiddleX);
                 float y = (m_mainProfileMiddleY - String::toFloat(String::valueOrEmpty(node, "y")));
@@ -289,11 +627,11 @@ void MeshGenerator::cutFaceStringToCutTemplate(const std::string& cutFaceString,
             // Build edge link
             std::map<std::string, std::vector<std::string>> cutFaceNodeLinkMap;
             for (const auto& edgeIdString : m_partEdgeIds[cutFaceString]) {
-                auto findEdge = m_snapshot->edges.find(edgeIdString);
-                if (findEdge == m_snapshot->edges.end()) {
+                const std::map<std::string, std::string>* edgeRecord = findEdge(edgeIdString);
+                if (nullptr == edgeRecord) {
                     continue;
                 }
-                auto& edge = findEdge->second;
+                auto& edge = *edgeRecord;
                 std::string fromNodeIdString = String::valueOrEmpty(edge, "from");
                 std::string toNodeIdString = String::valueOrEmpty(edge, "to");
                 cutFaceNodeLinkMap[fromNodeIdString].push_back(toNodeIdString);
@@ -423,11 +761,11 @@ bool MeshGenerator::fetchPartOrderedNodes(const std::string& partIdString, bool
     std::vector<MeshNode> builderNodes;
     std::map<std::string, size_t> builderNodeIdStringToIndexMap;
     for (const auto& nodeIdString : m_partNodeIds[partIdString]) {
-        auto findNode = m_snapshot->nodes.find(nodeIdString);
-        if (findNode == m_snapshot->nodes.end()) {
+        const std::map<std::string, std::string>* nodeRecord = findNode(nodeIdString);
+        if (nullptr == nodeRecord) {
             continue;
         }
-        auto& node = findNode->second;
+        auto& node = *nodeRecord;
 
         float radius = String::toFloat(String::valueOrEmpty(node, "radius"));
         float x = (String::toFloat(String::valueOrEmpty(node, "x")) - m_mainProfileMiddleX);
@@ -446,11 +784,11 @@ bool MeshGenerator::fetchPartOrderedNodes(const std::string& partIdString, bool
 
     std::map<size_t, size_t> builderNodeLinks;
     for (const auto& edgeIdString : m_partEdgeIds[partIdString]) {
-        auto findEdge = m_snapshot->edges.find(edgeIdString);
-        if (findEdge == m_snapshot->edges.end()) {
+        const std::map<std::string, std::string>* edgeRecord = findEdge(edgeIdString);
+        if (nullptr == edgeRecord) {
             continue;
         }
-        auto& edge = findEdge->second;
+        auto& edge = *edgeRecord;
 
         std::string fromNodeIdString = String::valueOrEmpty(edge, "from");
         std::string toNodeIdString = String::valueOrEmpty(edge, "to");
@@ -488,6 +826,9 @@ std::unique_ptr<MeshState> MeshGenerator::combineStitchingMesh(const std::string
     float smoothCutoffDegrees,
     GeneratedComponent& componentCache)
 {
+    if (checkCancellation())
+        return nullptr;
+
     std::vector<StitchMeshBuilder::Spline> splines;
     splines.reserve(partIdStrings.size());
     std::vector<Uuid> componentIds(componentIdStrings.size());
@@ -496,9 +837,9 @@ std::unique_ptr<MeshState> MeshGenerator::combineStitchingMesh(const std::string
     std::map<Uuid, Color> splineColors;
     for (size_t partIndex = 0; partIndex < partIdStrings.size(); ++partIndex) {
         const auto& partIdString = partIdStrings[partIndex];
-        auto findPart = m_snapshot->parts.find(partIdString);
-        if (findPart != m_snapshot->parts.end()) {
-            if (String::isTrue(String::valueOrEmpty(findPart->second, "disabled")))
+        const std::map<std::string, std::string>* part = findPart(partIdString);
+        if (nullptr != part) {
+            if (String::isTrue(String::valueOrEmpty(*part, "disabled")))
                 continue;
         }
         bool isCircle = false;
@@ -511,12 +852,12 @@ std::unique_ptr<MeshState> MeshGenerator::combineStitchingMesh(const std::string
             continue;
         for (const auto& meshNode : orderedBuilderNodes) {
             componentCache.nodeMap.emplace(std::make_pair(meshNode.sourceId,
-                ObjectNode { meshNode.origin, color, smoothCutoffDegrees }));
+                ObjectNode { meshNode.origin, color, smoothCutoffDegrees, Uuid(componentIdString) }));
         }
         Color splineColor = color;
-        auto findComponent = m_snapshot->components.find(componentIdStrings[partIndex]);
-        if (findComponent != m_snapshot->components.end()) {
-            std::string componentColorString = String::valueOrEmpty(findComponent->second, "color");
+        const std::map<std::string, std::string>* component = findComponent(componentIdStrings[partIndex]);
+        if (nullptr != component) {
+            std::string componentColorString = String::valueOrEmpty(*component, "color");
             if (!componentColorString.empty())
                 splineColor = Color(componentColorString);
         }
@@ -633,6 +974,9 @@ std::unique_ptr<MeshState> MeshGenerator::combineStitchingLoopMesh(const std::st
     float smoothCutoffDegrees,
     GeneratedComponent& componentCache)
 {
+    if (checkCancellation())
+        return nullptr;
+
     std::vector<StitchLoopMeshBuilder::Loop> loops;
     loops.reserve(partIdStrings.size());
     std::vector<Uuid> componentIds(componentIdStrings.size());
@@ -641,12 +985,12 @@ std::unique_ptr<MeshState> MeshGenerator::combineStitchingLoopMesh(const std::st
     std::map<Uuid, Color> loopPartColors;
     for (size_t partIndex = 0; partIndex < partIdStrings.size(); ++partIndex) {
         const auto& partIdString = partIdStrings[partIndex];
-        auto findPart = m_snapshot->parts.find(partIdString);
+        const std::map<std::string, std::string>* part = findPart(partIdString);
         Color partColor = color;
-        if (findPart != m_snapshot->parts.end()) {
-            if (String::isTrue(String::valueOrEmpty(findPart->second, "disabled")))
+        if (nullptr != part) {
+            if (String::isTrue(String::valueOrEmpty(*part, "disabled")))
                 continue;
-            std::string partColorString = String::valueOrEmpty(findPart->second, "color");
+            std::string partColorString = String::valueOrEmpty(*part, "color");
             if (!partColorString.empty())
                 partColor = Color(partColorString);
         }
@@ -658,12 +1002,12 @@ std::unique_ptr<MeshState> MeshGenerator::combineStitchingLoopMesh(const std::st
             continue;
         for (const auto& meshNode : orderedBuilderNodes) {
             componentCache.nodeMap.emplace(std::make_pair(meshNode.sourceId,
-                ObjectNode { meshNode.origin, partColor, smoothCutoffDegrees }));
+                ObjectNode { meshNode.origin, partColor, smoothCutoffDegrees, Uuid(componentIdString) }));
         }
         Color loopColor = color;
-        auto findComponent = m_snapshot->components.find(componentIdStrings[partIndex]);
-        if (findComponent != m_snapshot->components.end()) {
-            std::string componentColorString = String::valueOrEmpty(findComponent->second, "color");
+        const std::map<std::string, std::string>* component = findComponent(componentIdStrings[partIndex]);
+        if (nullptr != component) {
+            std::string componentColorString = String::valueOrEmpty(*component, "color");
             if (!componentColorString.empty())
                 loopColor = Color(componentColorString);
         }
@@ -672,8 +1016,8 @@ std::unique_ptr<MeshState> MeshGenerator::combineStitchingLoopMesh(const std::st
         loop.nodes = std::move(orderedBuilderNodes);
         loop.sourceId = componentIds[partIndex];
         loop.closed = isCircle;
-        if (findPart != m_snapshot->parts.end())
-            loop.fillInterior = String::isTrue(String::valueOrEmpty(findPart->second, "fillLoopInterior"));
+        if (nullptr != part)
+            loop.fillInterior = String::isTrue(String::valueOrEmpty(*part, "fillLoopInterior"));
         loops.emplace_back(std::move(loop));
     }
 
@@ -703,9 +1047,9 @@ std::unique_ptr<MeshState> MeshGenerator::combineStitchingLoopMesh(const std::st
     //         (or its own colorImageId if configured), painted as a solid fill or textured tile.
     bool componentHasImage = false;
     {
-        auto findComp = m_snapshot->components.find(componentIdString);
-        if (findComp != m_snapshot->components.end())
-            componentHasImage = !String::valueOrEmpty(findComp->second, "colorImageId").empty();
+        const std::map<std::string, std::string>* component = findComponent(componentIdString);
+        if (nullptr != component)
+            componentHasImage = !String::valueOrEmpty(*component, "colorImageId").empty();
     }
 
     auto insertTriangleUv = [&](std::map<std::array<PositionKey, 3>, std::array<Vector2, 3>>& uvMap,
@@ -797,12 +1141,15 @@ std::unique_ptr<MeshState> MeshGenerator::combinePartMesh(const std::string& par
     float smoothCutoffDegrees,
     bool* hasError)
 {
-    auto findPart = m_snapshot->parts.find(partIdString);
-    if (findPart == m_snapshot->parts.end()) {
+    if (checkCancellation())
+        return nullptr;
+
+    const std::map<std::string, std::string>* partRecord = findPart(partIdString);
+    if (nullptr == partRecord) {
         return nullptr;
     }
 
-    auto& part = findPart->second;
+    auto& part = *partRecord;
 
     bool isDisabled = String::isTrue(String::valueOrEmpty(part, "disabled"));
     std::string __mirroredByPartId = String::valueOrEmpty(part, "__mirroredByPartId");
@@ -820,10 +1167,14 @@ std::unique_ptr<MeshState> MeshGenerator::combinePartMesh(const std::string& par
     std::string cutFaceString = String::valueOrEmpty(part, "cutFace");
     std::vector<Vector2> cutTemplate;
     cutFaceStringToCutTemplate(cutFaceString, cutTemplate);
-    if (chamfered)
-        chamferFace(&cutTemplate);
-    if (subdived)
-        subdivideFace(&cutTemplate);
+    if (m_draftMode) {
+        decimateFace(&cutTemplate, m_draftMaxCutFacePoints);
+    } else {
+        if (chamfered)
+            chamferFace(&cutTemplate);
+        if (subdived)
+            subdivideFace(&cutTemplate);
+    }
 
     std::string cutRotationString = String::valueOrEmpty(part, "cutRotation");
     if (!cutRotationString.empty()) {
@@ -870,11 +1221,21 @@ std::unique_ptr<MeshState> MeshGenerator::combinePartMesh(const std::string& par
     {
         for (const auto& meshNode : meshNodes) {
             partCache.nodeMap.emplace(std::make_pair(meshNode.sourceId,
-                ObjectNode { meshNode.origin, color, smoothCutoffDegrees }));
+                ObjectNode { meshNode.origin, color, smoothCutoffDegrees, Uuid(componentIdString) }));
         }
     }
 
-    if (PartTarget::Model == target) {
+    // A mirrored part is the reflection of its source part, which has been built earlier in this generation or is still clean
+    const GeneratedPart* mirrorSourcePartCache = nullptr;
+    if (!__mirrorFromPartId.empty() && (PartTarget::Model == target || PartTarget::ImportedModel == target)) {
+        auto findSourcePartCache = m_cacheContext->parts.find(__mirrorFromPartId);
+        if (findSourcePartCache != m_cacheContext->parts.end() && findSourcePartCache->second.isSuccessful)
+            mirrorSourcePartCache = &findSourcePartCache->second;
+    }
+
+    if (nullptr != mirrorSourcePartCache) {
+        reflectGeneratedPart(*mirrorSourcePartCache, &partCache);
+    } else if (PartTarget::Model == target) {
         std::unique_ptr<TubeMeshBuilder> tubeMeshBuilder;
         TubeMeshBuilder::BuildParameters buildParameters;
         buildParameters.deformThickness = deformThickness;
@@ -883,6 +1244,7 @@ std::unique_ptr<MeshState> MeshGenerator::combinePartMesh(const std::string& par
         buildParameters.baseNormalRotation = cutRotation * Math::Pi;
         buildParameters.cutFace = cutTemplate;
         buildParameters.frontEndRounded = buildParameters.backEndRounded = rounded;
+        buildParameters.interpolationEnabled = !m_draftMode;
         tubeMeshBuilder = std::make_unique<TubeMeshBuilder>(buildParameters, std::move(meshNodes), isCircle);
         tubeMeshBuilder->build();
         partCache.vertices = tubeMeshBuilder->generatedVertices();
@@ -920,9 +1282,9 @@ std::unique_ptr<MeshState> MeshGenerator::combinePartMesh(const std::string& par
     } else if (PartTarget::ImportedModel == target) {
         std::string importedModelIdString = String::valueOrEmpty(part, "importedModelId");
         auto findImportedModel = m_importedModelData.find(importedModelIdString);
-        if (findImportedModel != m_importedModelData.end()) {
-            const auto& importedData = findImportedModel->second;
-            if (!importedData.vertices.empty() && !importedData.faces.empty()) {
+        if (findImportedModel != m_importedModelData.end() && nullptr != findImportedModel->second) {
+            const auto& importedData = *findImportedModel->second;
+            if (!importedData.vertices.empty() && !importedData.triangles.empty()) {
                 // Compute imported mesh bounding box
                 Vector3 importedMin = importedData.vertices[0];
                 Vector3 importedMax = importedData.vertices[0];
@@ -941,45 +1303,39 @@ std::unique_ptr<MeshState> MeshGenerator::combinePartMesh(const std::string& par
                     deformWidth, deformThickness, cutRotation);
 
                 partCache.vertices.resize(importedData.vertices.size());
-                for (size_t vi = 0; vi < importedData.vertices.size(); ++vi) {
-                    partCache.vertices[vi] = spineDeformer.deformVertex(importedData.vertices[vi]);
-                }
+                parallelFor(importedData.vertices.size(), 4096, [&](size_t begin, size_t end) {
+                    for (size_t vi = begin; vi < end; ++vi)
+                        partCache.vertices[vi] = spineDeformer.deformVertex(importedData.vertices[vi]);
+                });
 
                 if (!__mirrorFromPartId.empty()) {
                     for (auto& it : partCache.vertices)
                         it.setX(-it.x());
                 }
 
-                partCache.faces = importedData.faces;
-                if (!__mirrorFromPartId.empty()) {
-                    for (auto& it : partCache.faces)
-                        std::reverse(it.begin(), it.end());
+                bool isMirrored = !__mirrorFromPartId.empty();
+                partCache.faces.resize(importedData.triangles.size());
+                for (size_t t = 0; t < importedData.triangles.size(); ++t) {
+                    const auto& triangle = importedData.triangles[t];
+                    if (isMirrored)
+                        partCache.faces[t] = { triangle[2], triangle[1], triangle[0] };
+                    else
+                        partCache.faces[t] = { triangle[0], triangle[1], triangle[2] };
                 }
 
-                // Build triangleUvs using deformed vertex positions as keys.
-                // importedData.triangleUvs uses pre-deformation position keys,
-                // but the packer/renderer looks up by deformed position keys.
-                if (!importedData.triangleUvs.empty()) {
-                    std::vector<Vector2> perVertexUv(importedData.vertices.size(), Vector2(0, 0));
-                    for (const auto& face : importedData.faces) {
-                        if (face.size() < 3)
-                            continue;
-                        auto findUv = importedData.triangleUvs.find({ PositionKey(importedData.vertices[face[0]]),
-                            PositionKey(importedData.vertices[face[1]]),
-                            PositionKey(importedData.vertices[face[2]]) });
-                        if (findUv != importedData.triangleUvs.end()) {
-                            perVertexUv[face[0]] = findUv->second[0];
-                            perVertexUv[face[1]] = findUv->second[1];
-                            perVertexUv[face[2]] = findUv->second[2];
-                        }
-                    }
-                    for (const auto& face : partCache.faces) {
-                        if (face.size() < 3)
-                            continue;
+                // Key the per-corner UVs by deformed vertex positions,
+                // the packer/renderer looks them up by those.
+                if (importedData.triangleVertexUvs.size() == importedData.triangles.size() * 3) {
+                    for (size_t t = 0; t < partCache.faces.size(); ++t) {
+                        const auto& face = partCache.faces[t];
+                        const Vector2* uvs = &importedData.triangleVertexUvs[t * 3];
+                        std::array<Vector2, 3> cornerUvs = { uvs[0], uvs[1], uvs[2] };
+                        if (isMirrored)
+                            std::swap(cornerUvs[0], cornerUvs[2]);
                         partCache.triangleUvs.insert({ { PositionKey(partCache.vertices[face[0]]),
                                                            PositionKey(partCache.vertices[face[1]]),
                                                            PositionKey(partCache.vertices[face[2]]) },
-                            { perVertexUv[face[0]], perVertexUv[face[1]], perVertexUv[face[2]] } });
+                            cornerUvs });
                     }
                 }
 
@@ -1023,17 +1379,20 @@ std::unique_ptr<MeshState> MeshGenerator::combinePartMesh(const std::string& par
                     }
                 }
 
+                // Map each vertex to the nearest node for source tracking
+                std::vector<Vector3> nodeOrigins(meshNodes.size());
+                for (size_t k = 0; k < meshNodes.size(); ++k)
+                    nodeOrigins[k] = meshNodes[k].origin;
+                PointKdTree nodeTree(nodeOrigins);
+                std::vector<size_t> nearestNodes(partCache.vertices.size(), std::numeric_limits<size_t>::max());
+                if (!nodeTree.isEmpty()) {
+                    parallelFor(partCache.vertices.size(), 4096, [&](size_t begin, size_t end) {
+                        for (size_t i = begin; i < end; ++i)
+                            nearestNodes[i] = nodeTree.nearest(partCache.vertices[i]);
+                    });
+                }
                 for (size_t i = 0; i < partCache.vertices.size(); ++i) {
-                    // Map each vertex to the nearest node for source tracking
-                    double bestDist = std::numeric_limits<double>::max();
-                    Uuid bestNodeId;
-                    for (const auto& mn : meshNodes) {
-                        double d = (partCache.vertices[i] - mn.origin).lengthSquared();
-                        if (d < bestDist) {
-                            bestDist = d;
-                            bestNodeId = mn.sourceId;
-                        }
-                    }
+                    Uuid bestNodeId = nearestNodes[i] < meshNodes.size() ? meshNodes[nearestNodes[i]].sourceId : Uuid();
                     partCache.positionToNodeIdMap.emplace(std::make_pair(PositionKey(partCache.vertices[i]), bestNodeId));
                 }
             }
@@ -1080,15 +1439,14 @@ std::unique_ptr<MeshState> MeshGenerator::combinePartMesh(const std::string& par
 
 const std::map<std::string, std::string>* MeshGenerator::findComponent(const std::string& componentIdString)
 {
-    const std::map<std::string, std::string>* component = &m_snapshot->rootComponent;
-    if (componentIdString != to_string(Uuid())) {
-        auto findComponent = m_snapshot->components.find(componentIdString);
-        if (findComponent == m_snapshot->components.end()) {
-            return nullptr;
-        }
-        return &findComponent->second;
-    }
-    return component;
+    if (componentIdString != to_string(Uuid()))
+        return findSnapshotRecord(m_overlay.records.components, m_snapshot->components, componentIdString);
+    return &rootComponent();
+}
+
+std::map<std::string, std::string>& MeshGenerator::overlayComponent(const std::string& componentIdString)
+{
+    return overlaySnapshotRecord(m_overlay.records.components, m_snapshot->components, componentIdString);
 }
 
 CombineMode MeshGenerator::componentCombineMode(const std::map<std::string, std::string>* component)
@@ -1108,15 +1466,11 @@ std::unique_ptr<MeshState> MeshGenerator::combineComponentMesh(const std::string
     std::unique_ptr<MeshState> mesh;
 
     Uuid componentId;
-    const std::map<std::string, std::string>* component = &m_snapshot->rootComponent;
-    if (componentIdString != to_string(Uuid())) {
+    if (componentIdString != to_string(Uuid()))
         componentId = Uuid(componentIdString);
-        auto findComponent = m_snapshot->components.find(componentIdString);
-        if (findComponent == m_snapshot->components.end()) {
-            return nullptr;
-        }
-        component = &findComponent->second;
-    }
+    const std::map<std::string, std::string>* component = findComponent(componentIdString);
+    if (nullptr == component)
+        return nullptr;
 
     *combineMode = componentCombineMode(component);
 
@@ -1143,7 +1497,21 @@ std::unique_ptr<MeshState> MeshGenerator::combineComponentMesh(const std::string
         }
     }
 
+    // A cancelled generation leaves this component as it was, the next generation finds it dirty again
+    if (checkCancellation())
+        return nullptr;
+
+    // Drafts are never stored, their meshes are not what the snapshot describes
+    bool diskCacheEnabled = nullptr != m_diskCache && !m_draftMode;
+    if (diskCacheEnabled && restoreComponentFromDiskCache(componentIdString)) {
+        if (nullptr == componentCache.mesh || componentCache.mesh->isNull())
+            return nullptr;
+        return std::make_unique<MeshState>(*componentCache.mesh);
+    }
+
     componentCache.reset();
+    if (diskCacheEnabled)
+        m_collectingPreviewComponentIds.push_back({});
 
     std::string linkDataType = String::valueOrEmpty(*component, "linkDataType");
     if ("partId" == linkDataType) {
@@ -1188,14 +1556,14 @@ std::unique_ptr<MeshState> MeshGenerator::combineComponentMesh(const std::string
                 continue;
             if ("partId" == String::valueOrEmpty(*child, "linkDataType")) {
                 auto partIdString = String::valueOrEmpty(*child, "linkData");
-                auto findPart = m_snapshot->parts.find(partIdString);
-                if (findPart != m_snapshot->parts.end()) {
-                    if ("StitchingLine" == String::valueOrEmpty(findPart->second, "target")) {
+                const std::map<std::string, std::string>* part = findPart(partIdString);
+                if (nullptr != part) {
+                    if ("StitchingLine" == String::valueOrEmpty(*part, "target")) {
                         stitchingParts.emplace_back(partIdString);
                         stitchingComponents.emplace_back(childIdString);
                         continue;
                     }
-                    if ("StitchingLoop" == String::valueOrEmpty(findPart->second, "target")) {
+                    if ("StitchingLoop" == String::valueOrEmpty(*part, "target")) {
                         stitchingLoopParts.emplace_back(partIdString);
                         stitchingLoopComponents.emplace_back(childIdString);
                         continue;
@@ -1275,8 +1643,24 @@ std::unique_ptr<MeshState> MeshGenerator::combineComponentMesh(const std::string
         addComponentPreview(componentId, std::move(preview));
     }
 
+    // Children may have been skipped, so nothing partial is kept in the cache
+    if (checkCancellation()) {
+        if (diskCacheEnabled)
+            m_collectingPreviewComponentIds.pop_back();
+        componentCache.reset();
+        return nullptr;
+    }
+
     if (nullptr != mesh)
         componentCache.mesh = std::make_unique<MeshState>(*mesh);
+    m_finishedComponentIds.insert(componentIdString);
+
+    if (diskCacheEnabled) {
+        // Results of a failed generation may be incomplete, they are generated again next time
+        if (m_isSuccessful)
+            storeComponentToDiskCache(componentIdString);
+        m_collectingPreviewComponentIds.pop_back();
+    }
 
     if (nullptr != mesh && mesh->isNull()) {
         mesh.reset();
@@ -1288,6 +1672,18 @@ std::unique_ptr<MeshState> MeshGenerator::combineComponentMesh(const std::string
 std::unique_ptr<MeshState> MeshGenerator::combineMultipleMeshes(std::vector<std::tuple<std::unique_ptr<MeshState>, CombineMode, std::string>>&& multipleMeshes,
     std::set<std::array<PositionKey, 3>>* brokenTriangles)
 {
+    if (m_draftMode) {
+        // Overlapping meshes are good enough for a draft, inversions are left out,
+        // even a leading one, which would otherwise be drawn as a solid
+        std::vector<const MeshState*> draftMeshes;
+        for (const auto& it : multipleMeshes) {
+            if (CombineMode::Inversion == std::get<1>(it))
+                continue;
+            draftMeshes.push_back(std::get<0>(it).get());
+        }
+        return MeshState::merge(draftMeshes);
+    }
+
     std::unique_ptr<MeshState> mesh;
     std::string meshIdStrings;
     for (auto& it : multipleMeshes) {
@@ -1302,6 +1698,8 @@ std::unique_ptr<MeshState> MeshGenerator::combineMultipleMeshes(std::vector<std:
             meshIdStrings = subMeshIdString;
             continue;
         }
+        if (checkCancellation())
+            return nullptr;
         auto combinerMethod = childCombineMode == CombineMode::Inversion ? MeshCombiner::Method::Diff : MeshCombiner::Method::Union;
         auto combinerMethodString = combinerMethod == MeshCombiner::Method::Union ? "+" : "-";
         meshIdStrings += combinerMethodString + subMeshIdString;
@@ -1314,7 +1712,11 @@ std::unique_ptr<MeshState> MeshGenerator::combineMultipleMeshes(std::vector<std:
         } else {
             newMesh = MeshState::combine(*mesh,
                 *subMesh,
-                combinerMethod);
+                combinerMethod,
+                m_cancellationToken.get());
+            // An aborted combination is not a failed one, so it must not be cached
+            if (checkCancellation())
+                return nullptr;
             if (nullptr != newMesh)
                 m_cacheContext->cachedCombination.insert({ meshIdStrings, std::make_unique<MeshState>(*newMesh) });
             else
@@ -1411,17 +1813,30 @@ void MeshGenerator::postprocessObject(Object* object)
 
     object->triangleNormals = combinedFacesNormals;
 
+    // Source nodes are looked up by position once here, later passes such as rig binding go by index
     object->vertexColors.resize(object->vertices.size(), Color::createWhite());
     object->vertexSmoothCutoffDegrees.resize(object->vertices.size(), 0.0f);
+    object->vertexSourceNodes.assign(object->vertices.size(), -1);
+    object->vertexSourceNodeIds.clear();
+    std::unordered_map<Uuid, int> sourceNodeIndices;
+    std::vector<const ObjectNode*> sourceObjectNodes;
     for (size_t i = 0; i < object->vertices.size(); ++i) {
         auto findSourceNode = object->positionToNodeIdMap.find(object->vertices[i]);
         if (findSourceNode == object->positionToNodeIdMap.end())
             continue;
-        auto findObjectNode = object->nodeMap.find(findSourceNode->second);
-        if (findObjectNode == object->nodeMap.end())
+        auto insertResult = sourceNodeIndices.insert({ findSourceNode->second, (int)object->vertexSourceNodeIds.size() });
+        if (insertResult.second) {
+            object->vertexSourceNodeIds.push_back(findSourceNode->second);
+            auto findObjectNode = object->nodeMap.find(findSourceNode->second);
+            sourceObjectNodes.push_back(findObjectNode == object->nodeMap.end() ? nullptr : &findObjectNode->second);
+        }
+        int sourceNodeIndex = insertResult.first->second;
+        object->vertexSourceNodes[i] = sourceNodeIndex;
+        const ObjectNode* objectNode = sourceObjectNodes[sourceNodeIndex];
+        if (nullptr == objectNode)
             continue;
-        object->vertexColors[i] = findObjectNode->second.color;
-        object->vertexSmoothCutoffDegrees[i] = findObjectNode->second.smoothCutoffDegrees;
+        object->vertexColors[i] = objectNode->color;
+        object->vertexSmoothCutoffDegrees[i] = objectNode->smoothCutoffDegrees;
     }
 
     std::vector<std::vector<Vector3>> triangleVertexNormals;
@@ -1556,34 +1971,31 @@ void MeshGenerator::interpolateEdgesAroundJoints()
 {
     // Build part-to-edges mapping from snapshot
     std::map<std::string, std::set<std::string>> partEdgeIds;
-    for (const auto& edge : m_snapshot->edges) {
-        std::string partId = String::valueOrEmpty(edge.second, "partId");
+    forEachSnapshotRecord(m_overlay.records.edges, m_snapshot->edges, &m_overlay.removedEdgeIds, [&](const std::string& edgeIdString, const std::map<std::string, std::string>& edge) {
+        std::string partId = String::valueOrEmpty(edge, "partId");
         if (!partId.empty())
-            partEdgeIds[partId].insert(edge.first);
-    }
+            partEdgeIds[partId].insert(edgeIdString);
+    });
 
     for (auto& partEntry : partEdgeIds) {
         const std::string& partIdString = partEntry.first;
-        auto findPart = m_snapshot->parts.find(partIdString);
-        if (findPart == m_snapshot->parts.end())
+        const std::map<std::string, std::string>* part = findPart(partIdString);
+        if (nullptr == part)
             continue;
-        auto target = PartTargetFromString(String::valueOrEmpty(findPart->second, "target").c_str());
+        auto target = PartTargetFromString(String::valueOrEmpty(*part, "target").c_str());
         if (PartTarget::Model != target && PartTarget::ImportedModel != target)
             continue;
         std::vector<std::string> edgesToInterpolate;
         for (const auto& edgeIdString : partEntry.second) {
-            auto findEdge = m_snapshot->edges.find(edgeIdString);
-            if (findEdge == m_snapshot->edges.end())
+            const std::map<std::string, std::string>* edge = findEdge(edgeIdString);
+            if (nullptr == edge)
                 continue;
-            auto& edge = findEdge->second;
-            std::string fromNodeId = String::valueOrEmpty(edge, "from");
-            std::string toNodeId = String::valueOrEmpty(edge, "to");
-            auto findFromNode = m_snapshot->nodes.find(fromNodeId);
-            auto findToNode = m_snapshot->nodes.find(toNodeId);
-            if (findFromNode == m_snapshot->nodes.end() || findToNode == m_snapshot->nodes.end())
+            const std::map<std::string, std::string>* fromNodeRecord = findNode(String::valueOrEmpty(*edge, "from"));
+            const std::map<std::string, std::string>* toNodeRecord = findNode(String::valueOrEmpty(*edge, "to"));
+            if (nullptr == fromNodeRecord || nullptr == toNodeRecord)
                 continue;
-            auto& fromNode = findFromNode->second;
-            auto& toNode = findToNode->second;
+            auto& fromNode = *fromNodeRecord;
+            auto& toNode = *toNodeRecord;
             float fromX = String::toFloat(String::valueOrEmpty(fromNode, "x"));
             float fromY = String::toFloat(String::valueOrEmpty(fromNode, "y"));
             float fromZ = String::toFloat(String::valueOrEmpty(fromNode, "z"));
@@ -1601,12 +2013,12 @@ void MeshGenerator::interpolateEdgesAroundJoints()
             edgesToInterpolate.push_back(edgeIdString);
         }
         for (const auto& edgeIdString : edgesToInterpolate) {
-            auto& edge = m_snapshot->edges[edgeIdString];
+            const std::map<std::string, std::string>& edge = *findEdge(edgeIdString);
             std::string fromNodeId = String::valueOrEmpty(edge, "from");
             std::string toNodeId = String::valueOrEmpty(edge, "to");
             std::string boneName = String::valueOrEmpty(edge, "boneName");
-            auto& fromNode = m_snapshot->nodes[fromNodeId];
-            auto& toNode = m_snapshot->nodes[toNodeId];
+            const std::map<std::string, std::string>& fromNode = *findNode(fromNodeId);
+            const std::map<std::string, std::string>& toNode = *findNode(toNodeId);
             float fromX = String::toFloat(String::valueOrEmpty(fromNode, "x"));
             float fromY = String::toFloat(String::valueOrEmpty(fromNode, "y"));
             float fromZ = String::toFloat(String::valueOrEmpty(fromNode, "z"));
@@ -1672,8 +2084,8 @@ void MeshGenerator::interpolateEdgesAroundJoints()
             node2["z"] = std::to_string(a2z);
             node2["radius"] = std::to_string(a2Radius);
             node2["partId"] = partIdString;
-            m_snapshot->nodes[newNodeId1] = node1;
-            m_snapshot->nodes[newNodeId2] = node2;
+            m_overlay.records.nodes[newNodeId1] = node1;
+            m_overlay.records.nodes[newNodeId2] = node2;
             auto createEdge = [&](const std::string& id, const std::string& from, const std::string& to) {
                 std::map<std::string, std::string> e;
                 e["id"] = id;
@@ -1684,35 +2096,111 @@ void MeshGenerator::interpolateEdgesAroundJoints()
                     e["boneName"] = boneName;
                 return e;
             };
-            m_snapshot->edges[newEdgeId1] = createEdge(newEdgeId1, fromNodeId, newNodeId1);
-            m_snapshot->edges[newEdgeId2] = createEdge(newEdgeId2, newNodeId1, newNodeId2);
-            m_snapshot->edges[newEdgeId3] = createEdge(newEdgeId3, newNodeId2, toNodeId);
-            m_snapshot->edges.erase(edgeIdString);
+            m_overlay.records.edges[newEdgeId1] = createEdge(newEdgeId1, fromNodeId, newNodeId1);
+            m_overlay.records.edges[newEdgeId2] = createEdge(newEdgeId2, newNodeId1, newNodeId2);
+            m_overlay.records.edges[newEdgeId3] = createEdge(newEdgeId3, newNodeId2, toNodeId);
+            m_overlay.records.edges.erase(edgeIdString);
+            m_overlay.removedEdgeIds.insert(edgeIdString);
         }
     }
 }
 
+template <typename T, typename F>
+static void reflectTriangleAttributes(const std::vector<std::vector<size_t>>& sourceFaces,
+    const std::vector<Vector3>& sourceVertices,
+    const std::vector<Vector3>& targetVertices,
+    const std::map<std::array<PositionKey, 3>, std::array<T, 3>>& sourceAttributes,
+    std::map<std::array<PositionKey, 3>, std::array<T, 3>>* targetAttributes,
+    F reflectAttribute)
+{
+    // Triangles are keyed as (0, 1, 2) and, for quads, (2, 3, 0), the same as when the part is built
+    static const std::array<std::array<size_t, 3>, 2> s_triangleCorners = { { { 0, 1, 2 }, { 2, 3, 0 } } };
+    std::vector<T> cornerAttributes;
+    std::vector<bool> cornerFound;
+    for (const auto& face : sourceFaces) {
+        if (face.size() < 3 || face.size() > 4)
+            continue;
+        cornerAttributes.assign(face.size(), T());
+        cornerFound.assign(face.size(), false);
+        for (size_t t = 0; t + 2 < face.size(); ++t) {
+            const auto& corners = s_triangleCorners[t];
+            auto findAttributes = sourceAttributes.find({ PositionKey(sourceVertices[face[corners[0]]]),
+                PositionKey(sourceVertices[face[corners[1]]]),
+                PositionKey(sourceVertices[face[corners[2]]]) });
+            if (findAttributes == sourceAttributes.end())
+                continue;
+            for (size_t k = 0; k < 3; ++k) {
+                cornerAttributes[corners[k]] = reflectAttribute(findAttributes->second[k]);
+                cornerFound[corners[k]] = true;
+            }
+        }
+        // Corner k of the reflected face comes from corner (n - 1 - k) of the source face
+        size_t n = face.size();
+        for (size_t t = 0; t + 2 < n; ++t) {
+            const auto& corners = s_triangleCorners[t];
+            if (!cornerFound[n - 1 - corners[0]] || !cornerFound[n - 1 - corners[1]] || !cornerFound[n - 1 - corners[2]])
+                continue;
+            targetAttributes->insert({ { PositionKey(targetVertices[face[n - 1 - corners[0]]]),
+                                           PositionKey(targetVertices[face[n - 1 - corners[1]]]),
+                                           PositionKey(targetVertices[face[n - 1 - corners[2]]]) },
+                { cornerAttributes[n - 1 - corners[0]], cornerAttributes[n - 1 - corners[1]], cornerAttributes[n - 1 - corners[2]] } });
+        }
+    }
+}
+
+void MeshGenerator::reflectGeneratedPart(const GeneratedPart& source, GeneratedPart* target)
+{
+    target->vertices.resize(source.vertices.size());
+    for (size_t i = 0; i < source.vertices.size(); ++i) {
+        const auto& vertex = source.vertices[i];
+        target->vertices[i] = Vector3(-vertex.x(), vertex.y(), vertex.z());
+    }
+
+    target->faces.resize(source.faces.size());
+    for (size_t i = 0; i < source.faces.size(); ++i)
+        target->faces[i].assign(source.faces[i].rbegin(), source.faces[i].rend());
+
+    reflectTriangleAttributes(source.faces, source.vertices, target->vertices,
+        source.triangleUvs, &target->triangleUvs,
+        [](const Vector2& uv) { return uv; });
+    reflectTriangleAttributes(source.faces, source.vertices, target->vertices,
+        source.importedTriangleNormals, &target->importedTriangleNormals,
+        [](const Vector3& normal) { return Vector3(-normal.x(), normal.y(), normal.z()); });
+
+    for (size_t i = 0; i < source.vertices.size(); ++i) {
+        PositionKey sourceKey(source.vertices[i]);
+        auto findNodeId = source.positionToNodeIdMap.find(sourceKey);
+        if (findNodeId != source.positionToNodeIdMap.end())
+            target->positionToNodeIdMap.emplace(std::make_pair(PositionKey(target->vertices[i]), Uuid(reverseUuid(to_string(findNodeId->second)))));
+        auto findColor = source.importedVertexColorMap.find(sourceKey);
+        if (findColor != source.importedVertexColorMap.end())
+            target->importedVertexColorMap.emplace(std::make_pair(PositionKey(target->vertices[i]), findColor->second));
+    }
+}
+
 void MeshGenerator::preprocessMirror()
 {
     std::vector<std::map<std::string, std::string>> newParts;
     std::map<std::string, std::string> partOldToNewMap;
-    for (auto& partIt : m_snapshot->parts) {
-        bool xMirrored = String::isTrue(String::valueOrEmpty(partIt.second, "xMirrored"));
+    forEachSnapshotRecord(m_overlay.records.parts, m_snapshot->parts, nullptr, [&](const std::string& partIdString, const std::map<std::string, std::string>& part) {
+        bool xMirrored = String::isTrue(String::valueOrEmpty(part, "xMirrored"));
         if (!xMirrored)
-            continue;
-        std::map<std::string, std::string> mirroredPart = partIt.second;
+            return;
+        std::map<std::string, std::string> mirroredPart = part;
 
         std::string newPartIdString = reverseUuid(mirroredPart["id"]);
         partOldToNewMap.insert({ mirroredPart["id"], newPartIdString });
 
         mirroredPart["__mirrorFromPartId"] = mirroredPart["id"];
         mirroredPart["id"] = newPartIdString;
-        mirroredPart["__dirty"] = "true";
+        // The mirror is reflected from its source part, so it is dirty only when the source is
+        if (nullptr != m_changeSet && m_changeSet->changedPartIds.find(partIdString) != m_changeSet->changedPartIds.end())
+            m_changeSet->changedPartIds.insert(newPartIdString);
         newParts.push_back(mirroredPart);
-    }
+    });
 
     for (const auto& it : partOldToNewMap)
-        m_snapshot->parts[it.second]["__mirroredByPartId"] = it.first;
+        overlaySnapshotRecord(m_overlay.records.parts, m_snapshot->parts, it.second)["__mirroredByPartId"] = it.first;
 
     // Create mirrored nodes and edges for mirrored parts
     std::map<std::string, std::string> nodeOldToNewMap;
@@ -1720,34 +2208,34 @@ void MeshGenerator::preprocessMirror()
     std::vector<std::map<std::string, std::string>> newEdges;
 
     // Find all nodes that belong to mirrored parts and create mirrored versions
-    for (const auto& nodeIt : m_snapshot->nodes) {
-        std::string nodePartId = String::valueOrEmpty(nodeIt.second, "partId");
+    forEachSnapshotRecord(m_overlay.records.nodes, m_snapshot->nodes, nullptr, [&](const std::string& nodeIdString, const std::map<std::string, std::string>& node) {
+        std::string nodePartId = String::valueOrEmpty(node, "partId");
         auto findMirroredPart = partOldToNewMap.find(nodePartId);
         if (findMirroredPart == partOldToNewMap.end())
-            continue;
+            return;
 
         // Create mirrored node with flipped X coordinate
-        std::map<std::string, std::string> mirroredNode = nodeIt.second;
-        std::string newNodeIdString = reverseUuid(nodeIt.first);
-        nodeOldToNewMap.insert({ nodeIt.first, newNodeIdString });
+        std::map<std::string, std::string> mirroredNode = node;
+        std::string newNodeIdString = reverseUuid(nodeIdString);
+        nodeOldToNewMap.insert({ nodeIdString, newNodeIdString });
 
         // Update partId to point to the new mirrored part
         mirroredNode["partId"] = findMirroredPart->second;
         mirroredNode["id"] = newNodeIdString;
-        mirroredNode["__mirrorFromNodeId"] = nodeIt.first;
+        mirroredNode["__mirrorFromNodeId"] = nodeIdString;
         newNodes.push_back(mirroredNode);
-    }
+    });
 
     // Find all edges that belong to mirrored parts and create mirrored versions
-    for (const auto& edgeIt : m_snapshot->edges) {
-        std::string edgePartId = String::valueOrEmpty(edgeIt.second, "partId");
+    forEachSnapshotRecord(m_overlay.records.edges, m_snapshot->edges, &m_overlay.removedEdgeIds, [&](const std::string& edgeIdString, const std::map<std::string, std::string>& edge) {
+        std::string edgePartId = String::valueOrEmpty(edge, "partId");
         auto findMirroredPart = partOldToNewMap.find(edgePartId);
         if (findMirroredPart == partOldToNewMap.end())
-            continue;
+            return;
 
         // Create mirrored edge
-        std::map<std::string, std::string> mirroredEdge = edgeIt.second;
-        std::string newEdgeIdString = reverseUuid(edgeIt.first);
+        std::map<std::string, std::string> mirroredEdge = edge;
+        std::string newEdgeIdString = reverseUuid(edgeIdString);
 
         // Update edge endpoints to use new mirrored nodes
         std::string fromNodeId = String::valueOrEmpty(mirroredEdge, "from");
@@ -1764,7 +2252,7 @@ void MeshGenerator::preprocessMirror()
         // Update partId to point to the new mirrored part
         mirroredEdge["partId"] = findMirroredPart->second;
         mirroredEdge["id"] = newEdgeIdString;
-        mirroredEdge["__mirrorFromEdgeId"] = edgeIt.first;
+        mirroredEdge["__mirrorFromEdgeId"] = edgeIdString;
 
         auto swapBoneNameLeftRight = [](const std::string& value) {
             std::string swapped;
@@ -1793,69 +2281,78 @@ void MeshGenerator::preprocessMirror()
         }
 
         newEdges.push_back(mirroredEdge);
-    }
+    });
 
-    // Add new mirrored nodes and edges to snapshot
+    // Add new mirrored nodes and edges to the overlay
     for (const auto& node : newNodes)
-        m_snapshot->nodes[String::valueOrEmpty(node, "id")] = node;
+        m_overlay.records.nodes[String::valueOrEmpty(node, "id")] = node;
     for (const auto& edge : newEdges)
-        m_snapshot->edges[String::valueOrEmpty(edge, "id")] = edge;
+        m_overlay.records.edges[String::valueOrEmpty(edge, "id")] = edge;
 
     // Mark original nodes with mirror references
     for (const auto& it : nodeOldToNewMap)
-        m_snapshot->nodes[it.first]["__mirroredByNodeId"] = it.second;
+        overlaySnapshotRecord(m_overlay.records.nodes, m_snapshot->nodes, it.first)["__mirroredByNodeId"] = it.second;
 
     std::map<std::string, std::string> parentMap;
-    for (auto& componentIt : m_snapshot->components) {
-        for (const auto& childId : String::split(String::valueOrEmpty(componentIt.second, "children"), ',')) {
+    forEachSnapshotRecord(m_overlay.records.components, m_snapshot->components, nullptr, [&](const std::string& componentIdString, const std::map<std::string, std::string>& component) {
+        for (const auto& childId : String::split(String::valueOrEmpty(component, "children"), ',')) {
             if (childId.empty())
                 continue;
-            parentMap[childId] = componentIt.first;
+            parentMap[childId] = componentIdString;
         }
-    }
-    for (const auto& childId : String::split(String::valueOrEmpty(m_snapshot->rootComponent, "children"), ',')) {
+    });
+    for (const auto& childId : String::split(String::valueOrEmpty(rootComponent(), "children"), ',')) {
         if (childId.empty())
             continue;
         parentMap[childId] = std::string();
     }
 
     std::vector<std::map<std::string, std::string>> newComponents;
-    for (auto& componentIt : m_snapshot->components) {
-        std::string linkDataType = String::valueOrEmpty(componentIt.second, "linkDataType");
+    forEachSnapshotRecord(m_overlay.records.components, m_snapshot->components, nullptr, [&](const std::string& componentIdString, const std::map<std::string, std::string>& component) {
+        std::string linkDataType = String::valueOrEmpty(component, "linkDataType");
         if ("partId" != linkDataType)
-            continue;
-        std::string partIdString = String::valueOrEmpty(componentIt.second, "linkData");
+            return;
+        std::string partIdString = String::valueOrEmpty(component, "linkData");
         auto findPart = partOldToNewMap.find(partIdString);
         if (findPart == partOldToNewMap.end())
-            continue;
-        std::map<std::string, std::string> mirroredComponent = componentIt.second;
+            return;
+        std::map<std::string, std::string> mirroredComponent = component;
         std::string newComponentIdString = reverseUuid(mirroredComponent["id"]);
         mirroredComponent["linkData"] = findPart->second;
         mirroredComponent["id"] = newComponentIdString;
-        mirroredComponent["__dirty"] = "true";
-        parentMap[newComponentIdString] = parentMap[String::valueOrEmpty(componentIt.second, "id")];
+        mirroredComponent["__mirrorFromComponentId"] = componentIdString;
+        if (nullptr != m_changeSet && m_changeSet->changedComponentIds.find(componentIdString) != m_changeSet->changedComponentIds.end())
+            m_changeSet->changedComponentIds.insert(newComponentIdString);
+        parentMap[newComponentIdString] = parentMap[String::valueOrEmpty(component, "id")];
         newComponents.push_back(mirroredComponent);
-    }
+    });
 
     for (const auto& it : newParts) {
-        m_snapshot->parts[String::valueOrEmpty(it, "id")] = it;
+        m_overlay.records.parts[String::valueOrEmpty(it, "id")] = it;
     }
     for (const auto& it : newComponents) {
         std::string idString = String::valueOrEmpty(it, "id");
         std::string parentIdString = parentMap[idString];
-        m_snapshot->components[idString] = it;
+        m_overlay.records.components[idString] = it;
         if (parentIdString.empty()) {
-            m_snapshot->rootComponent["children"] += "," + idString;
+            if (m_overlay.records.rootComponent.empty())
+                m_overlay.records.rootComponent = m_snapshot->rootComponent;
+            m_overlay.records.rootComponent["children"] += "," + idString;
         } else {
-            m_snapshot->components[parentIdString]["children"] += "," + idString;
+            overlaySnapshotRecord(m_overlay.records.components, m_snapshot->components, parentIdString)["children"] += "," + idString;
         }
     }
 }
 
 void MeshGenerator::addComponentPreview(const Uuid& componentId, ComponentPreview&& preview)
 {
+    // Previews are kept from the last full quality generation
+    if (m_draftMode)
+        return;
     m_generatedPreviewComponentIds.insert(componentId);
     m_generatedComponentPreviews[componentId] = std::move(preview);
+    if (!m_collectingPreviewComponentIds.empty())
+        m_collectingPreviewComponentIds.back().insert(componentId);
 }
 
 void MeshGenerator::generate()
@@ -1869,7 +2366,8 @@ void MeshGenerator::generate()
     m_mainProfileMiddleY = String::toFloat(String::valueOrEmpty(m_snapshot->canvas, "originY"));
     m_sideProfileMiddleX = String::toFloat(String::valueOrEmpty(m_snapshot->canvas, "originZ"));
 
-    interpolateEdgesAroundJoints();
+    if (!m_draftMode)
+        interpolateEdgesAroundJoints();
     preprocessMirror();
 
     m_object = new Object;
@@ -1881,35 +2379,8 @@ void MeshGenerator::generate()
         needDeleteCacheContext = true;
     } else {
         m_cacheEnabled = true;
-        for (auto it = m_cacheContext->parts.begin(); it != m_cacheContext->parts.end();) {
-            if (m_snapshot->parts.find(it->first) == m_snapshot->parts.end()) {
-                auto mirrorFrom = m_cacheContext->partMirrorIdMap.find(it->first);
-                if (mirrorFrom != m_cacheContext->partMirrorIdMap.end()) {
-                    if (m_snapshot->parts.find(mirrorFrom->second) != m_snapshot->parts.end()) {
-                        it++;
-                        continue;
-                    }
-                    m_cacheContext->partMirrorIdMap.erase(mirrorFrom);
-                }
-                it = m_cacheContext->parts.erase(it);
-                continue;
-            }
-            it++;
-        }
-        for (auto it = m_cacheContext->components.begin(); it != m_cacheContext->components.end();) {
-            if (m_snapshot->components.find(it->first) == m_snapshot->components.end()) {
-                for (auto combinationIt = m_cacheContext->cachedCombination.begin(); combinationIt != m_cacheContext->cachedCombination.end();) {
-                    if (std::string::npos != combinationIt->first.find(it->first)) {
-                        combinationIt = m_cacheContext->cachedCombination.erase(combinationIt);
-                        continue;
-                    }
-                    combinationIt++;
-                }
-                it = m_cacheContext->components.erase(it);
-                continue;
-            }
-            it++;
-        }
+        if (needCachePruning())
+            pruneCache();
     }
 
     collectParts();
@@ -1930,6 +2401,31 @@ void MeshGenerator::generate()
     CombineMode combineMode;
     auto combinedMesh = combineComponentMesh(to_string(Uuid()), &combineMode);
 
+    if (checkCancellation()) {
+        for (const auto& componentIdString : m_dirtyComponentIds) {
+            if (m_finishedComponentIds.find(componentIdString) != m_finishedComponentIds.end())
+                continue;
+            // A mirror only exists in this generation, its source is what gets dirtied again
+            const std::map<std::string, std::string>* component = findComponent(componentIdString);
+            if (nullptr != component) {
+                std::string mirrorFromComponentId = String::valueOrEmpty(*component, "__mirrorFromComponentId");
+                if (!mirrorFromComponentId.empty()) {
+                    m_unfinishedComponentIds.insert(mirrorFromComponentId);
+                    continue;
+                }
+            }
+            m_unfinishedComponentIds.insert(componentIdString);
+        }
+        m_isSuccessful = false;
+        delete m_object;
+        m_object = nullptr;
+        if (needDeleteCacheContext) {
+            delete m_cacheContext;
+            m_cacheContext = nullptr;
+        }
+        return;
+    }
+
     const auto& componentCache = m_cacheContext->components[to_string(Uuid())];
 
     m_object->positionToNodeIdMap = componentCache.positionToNodeIdMap;
@@ -1986,6 +2482,10 @@ void MeshGenerator::generate()
         }
     }
 
+    // Everything downstream, from the viewport to the exporters, draws triangles in this order
+    if (!m_draftMode)
+        optimizeTriangleOrder(m_object);
+
     if (needDeleteCacheContext) {
         delete m_cacheContext;
         m_cacheContext = nullptr;
@@ -23,6 +23,7 @@
 #ifndef DUST3D_MESH_MESH_GENERATOR_H_
 #define DUST3D_MESH_MESH_GENERATOR_H_
 
+#include <dust3d/base/cancellation_token.h>
 #include <dust3d/base/combine_mode.h>
 #include <dust3d/base/object.h>
 #include <dust3d/base/position_key.h>
@@ -31,6 +32,7 @@
 #include <dust3d/mesh/mesh_combiner.h>
 #include <dust3d/mesh/mesh_node.h>
 #include <dust3d/mesh/mesh_state.h>
+#include <memory>
 #include <set>
 #include <tuple>
 #include <unordered_map>
@@ -38,6 +40,8 @@
 
 namespace dust3d {
 
+class MeshGeneratorDiskCache;
+
 class MeshGenerator {
 public:
     static double m_minimalRadius;
@@ -103,6 +107,15 @@ public:
         std::map<std::string, std::unique_ptr<MeshState>> cachedCombination;
     };
 
+    // Parts and components which were modified, added or removed since the previous generation,
+    // when set, dirtiness is taken from here instead of the "__dirty" attributes of the snapshot
+    struct ChangeSet {
+        std::set<std::string> changedPartIds;
+        std::set<std::string> changedComponentIds;
+        std::set<std::string> removedPartIds;
+        std::set<std::string> removedComponentIds;
+    };
+
     struct ComponentPreview {
         std::vector<Vector3> vertices;
         std::vector<std::vector<size_t>> triangles;
@@ -117,35 +130,62 @@ public:
     struct ImportedModelData {
         std::vector<Vector3> vertices;
         std::vector<Vector3> vertexNormals;
-        std::vector<std::vector<size_t>> faces;
-        std::map<std::array<PositionKey, 3>, std::array<Vector2, 3>> triangleUvs;
+        std::vector<std::array<size_t, 3>> triangles;
+        // Three per triangle in corner order, or empty when the model has no UVs
+        std::vector<Vector2> triangleVertexUvs;
         std::vector<Color> vertexColors;
     };
 
+    // Records a generation added or rewrote on top of its source snapshot, such as mirrored parts
+    // and interpolated edges, the source snapshot itself is only read
+    struct SnapshotOverlay {
+        Snapshot records;
+        std::set<std::string> removedEdgeIds;
+    };
+
     MeshGenerator(Snapshot* snapshot);
+    // The snapshot stays shared with the caller, who gets it back from takeSourceSnapshot()
+    MeshGenerator(std::shared_ptr<const Snapshot> sourceSnapshot);
     ~MeshGenerator();
     bool isSuccessful();
     const std::set<Uuid>& generatedPreviewComponentIds();
     const std::map<Uuid, ComponentPreview>& generatedComponentPreviews();
     Object* takeObject();
+    // The source snapshot with the overlay applied
     Snapshot* takeSnapshot();
+    std::shared_ptr<const Snapshot> takeSourceSnapshot();
+    std::unique_ptr<SnapshotOverlay> takeSnapshotOverlay();
+    static void applySnapshotOverlay(Snapshot* snapshot, const SnapshotOverlay& overlay);
     virtual void generate();
     void setGeneratedCacheContext(GeneratedCacheContext* cacheContext);
     void setSmoothShadingThresholdAngleDegrees(float degrees);
     void setDefaultPartColor(const Color& color);
     void setId(uint64_t id);
     uint64_t id();
-    void setImportedModelData(std::map<std::string, ImportedModelData>&& importedModelData);
+    void setImportedModelData(const std::map<std::string, std::shared_ptr<const ImportedModelData>>& importedModelData);
+    void setCancellationToken(std::shared_ptr<const CancellationToken> cancellationToken);
+    bool isCancelled();
+    void setDraftMode(bool draftMode);
+    void setChangeSet(std::unique_ptr<ChangeSet> changeSet);
+    void setDiskCache(std::shared_ptr<MeshGeneratorDiskCache> diskCache);
+    bool isDraftMode();
+    // Components a cancelled generation did not finish, mirrors are reported by their source component
+    const std::set<std::string>& unfinishedComponentIds();
 
 protected:
-    Snapshot* snapshot() { return m_snapshot; }
+    const std::map<std::string, std::string>* findComponent(const std::string& componentIdString);
+    // The component record as rewritten by this generation, the source snapshot is left untouched
+    std::map<std::string, std::string>& overlayComponent(const std::string& componentIdString);
     std::set<Uuid> m_generatedPreviewComponentIds;
     std::map<Uuid, ComponentPreview> m_generatedComponentPreviews;
     Object* m_object = nullptr;
 
 private:
     Color m_defaultPartColor = Color::createWhite();
-    Snapshot* m_snapshot = nullptr;
+    const Snapshot* m_snapshot = nullptr;
+    std::unique_ptr<Snapshot> m_ownedSnapshot;
+    std::shared_ptr<const Snapshot> m_sourceSnapshot;
+    SnapshotOverlay m_overlay;
     GeneratedCacheContext* m_cacheContext = nullptr;
     std::set<std::string> m_dirtyComponentIds;
     std::set<std::string> m_dirtyPartIds;
@@ -158,8 +198,19 @@ private:
     bool m_cacheEnabled = false;
     float m_smoothShadingThresholdAngleDegrees = 60;
     uint64_t m_id = 0;
-    std::map<std::string, ImportedModelData> m_importedModelData;
+    std::map<std::string, std::shared_ptr<const ImportedModelData>> m_importedModelData;
+    std::shared_ptr<const CancellationToken> m_cancellationToken;
+    bool m_isCancelled = false;
+    std::set<std::string> m_finishedComponentIds;
+    std::set<std::string> m_unfinishedComponentIds;
+    bool m_draftMode = false;
+    std::unique_ptr<ChangeSet> m_changeSet;
+    std::shared_ptr<MeshGeneratorDiskCache> m_diskCache;
+    std::map<std::string, std::string> m_componentDiskCacheKeys;
+    std::vector<std::set<Uuid>> m_collectingPreviewComponentIds;
+    static const size_t m_draftMaxCutFacePoints;
 
+    bool checkCancellation();
     void collectParts();
     void interpolateEdgesAroundJoints();
     void collectIncombinableMesh(const MeshState* mesh, const GeneratedComponent& componentCache);
@@ -167,6 +218,12 @@ private:
     bool checkIsPartDirty(const std::string& partIdString);
     bool checkIsPartDependencyDirty(const std::string& partIdString);
     void checkDirtyFlags();
+    bool needCachePruning();
+    void pruneCache();
+    std::string partDiskCacheKey(const std::string& partIdString);
+    const std::string& componentDiskCacheKey(const std::string& componentIdString);
+    bool restoreComponentFromDiskCache(const std::string& componentIdString);
+    void storeComponentToDiskCache(const std::string& componentIdString);
     std::unique_ptr<MeshState> combinePartMesh(const std::string& partIdString,
         const std::string& componentIdString,
         Color color,
@@ -175,7 +232,10 @@ private:
     std::unique_ptr<MeshState> combineComponentMesh(const std::string& componentIdString, CombineMode* combineMode);
     void collectSharedQuadEdges(const std::vector<Vector3>& vertices, const std::vector<std::vector<size_t>>& faces,
         std::set<std::pair<PositionKey, PositionKey>>* sharedQuadEdges);
-    const std::map<std::string, std::string>* findComponent(const std::string& componentIdString);
+    const std::map<std::string, std::string>* findPart(const std::string& partIdString);
+    const std::map<std::string, std::string>* findNode(const std::string& nodeIdString);
+    const std::map<std::string, std::string>* findEdge(const std::string& edgeIdString);
+    const std::map<std::string, std::string>& rootComponent();
     CombineMode componentCombineMode(const std::map<std::string, std::string>* component);
     std::unique_ptr<MeshState> combineComponentChildGroupMesh(const std::vector<std::string>& componentIdStrings,
         GeneratedComponent& componentCache,
@@ -207,6 +267,7 @@ private:
     void cutFaceStringToCutTemplate(const std::string& cutFaceString, std::vector<Vector2>& cutTemplate);
     void postprocessObject(Object* object);
     void preprocessMirror();
+    void reflectGeneratedPart(const GeneratedPart& source, GeneratedPart* target);
     std::string reverseUuid(const std::string& uuidString);
     void recoverQuads(const std::vector<Vector3>& vertices, const std::vector<std::vector<size_t>>& triangles, const std::set<std::pair<PositionKey, PositionKey>>& sharedQuadEdges, std::vector<std::vector<size_t>>& triangleAndQuads);
     void addComponentPreview(const Uuid& componentId, ComponentPreview&& preview);
@@ -214,6 +275,7 @@ private:
 
     static void chamferFace(std::vector<Vector2>* face);
     static void subdivideFace(std::vector<Vector2>* face);
+    static void decimateFace(std::vector<Vector2>* face, size_t maxPoints);
     static void flattenLinks(const std::map<size_t, size_t>& links,
         std::vector<size_t>* array,
         bool* isCircle);
@@ -0,0 +1,743 @@
+/*
+ *  Copyright (c) 2016-2026 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <dust3d/mesh/mesh_generator_disk_cache.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+
+namespace dust3d {
+
+const std::uint32_t MeshGeneratorDiskCache::m_version = 2;
+const std::uint64_t MeshGeneratorDiskCache::m_defaultSizeLimit = 1024ull * 1024 * 1024;
+
+static const char g_diskCacheMagic[8] = { 'D', 'S', '3', 'C', 'A', 'C', 'H', 'E' };
+static const char g_diskCacheExtension[] = ".ds3cache";
+static const std::uint64_t g_fnvPrime = 0x100000001b3ull;
+
+// Two FNV-1a hashes with different offset bases are combined into a 128 bit key
+MeshGeneratorDiskCache::KeyBuilder::KeyBuilder()
+    : m_hashes { 0xcbf29ce484222325ull, 0x84222325cbf29ce4ull }
+{
+    addString(std::to_string(m_version));
+}
+
+void MeshGeneratorDiskCache::KeyBuilder::addString(const std::string& string)
+{
+    // The length goes first, so consecutive strings can not be confused with their concatenation
+    std::string length = std::to_string(string.size()) + ":";
+    for (auto& hash : m_hashes) {
+        for (const auto& character : length)
+            hash = (hash ^ (std::uint8_t)character) * g_fnvPrime;
+        for (const auto& character : string)
+            hash = (hash ^ (std::uint8_t)character) * g_fnvPrime;
+    }
+}
+
+void MeshGeneratorDiskCache::KeyBuilder::addAttributes(const std::map<std::string, std::string>& attributes)
+{
+    addString(std::to_string(attributes.size()));
+    for (const auto& it : attributes) {
+        // Dirty flags only tell what changed since the last generation
+        if ("__dirty" == it.first)
+            continue;
+        addString(it.first);
+        addString(it.second);
+    }
+}
+
+std::string MeshGeneratorDiskCache::KeyBuilder::key() const
+{
+    char buffer[33];
+    snprintf(buffer, sizeof(buffer), "%016llx%016llx", (unsigned long long)m_hashes[0], (unsigned long long)m_hashes[1]);
+    return std::string(buffer);
+}
+
+class DiskCacheWriter {
+public:
+    DiskCacheWriter(std::vector<std::uint8_t>& byteArray)
+        : m_byteArray(byteArray)
+    {
+    }
+
+    void writeBytes(const void* data, size_t size)
+    {
+        const std::uint8_t* bytes = (const std::uint8_t*)data;
+        m_byteArray.insert(m_byteArray.end(), bytes, bytes + size);
+    }
+
+    void writeUint64(std::uint64_t value)
+    {
+        std::uint8_t bytes[8];
+        for (size_t i = 0; i < 8; ++i)
+            bytes[i] = (std::uint8_t)((value >> (i * 8)) & 0xff);
+        writeBytes(bytes, sizeof(bytes));
+    }
+
+    void write(bool value)
+    {
+        std::uint8_t byte = value ? 1 : 0;
+        writeBytes(&byte, 1);
+    }
+
+    void write(double value)
+    {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        writeUint64(bits);
+    }
+
+    void write(float value)
+    {
+        write((double)value);
+    }
+
+    // Sizes are written as 64 bit whatever their width is on this platform
+    void write(unsigned long value)
+    {
+        writeUint64(value);
+    }
+
+    void write(unsigned long long value)
+    {
+        writeUint64(value);
+    }
+
+    void write(const std::string& value)
+    {
+        writeUint64(value.size());
+        writeBytes(value.data(), value.size());
+    }
+
+    void write(const Uuid& value)
+    {
+        write(to_string(value));
+    }
+
+    void write(const Vector2& value)
+    {
+        write(value.x());
+        write(value.y());
+    }
+
+    void write(const Vector3& value)
+    {
+        write(value.x());
+        write(value.y());
+        write(value.z());
+    }
+
+    void write(const Color& value)
+    {
+        write(value.r());
+        write(value.g());
+        write(value.b());
+        write(value.alpha());
+    }
+
+    void write(const PositionKey& value)
+    {
+        writeUint64((std::uint64_t)(std::int64_t)value.intX());
+        writeUint64((std::uint64_t)(std::int64_t)value.intY());
+        writeUint64((std::uint64_t)(std::int64_t)value.intZ());
+    }
+
+    void write(const ObjectNode& value)
+    {
+        write(value.origin);
+        write(value.color);
+        write(value.smoothCutoffDegrees);
+        write(value.componentId);
+    }
+
+    template <typename T, size_t N>
+    void write(const std::array<T, N>& value)
+    {
+        for (const auto& it : value)
+            write(it);
+    }
+
+    template <typename A, typename B>
+    void write(const std::pair<A, B>& value)
+    {
+        write(value.first);
+        write(value.second);
+    }
+
+    template <typename A, typename B, typename C>
+    void write(const std::tuple<A, B, C>& value)
+    {
+        write(std::get<0>(value));
+        write(std::get<1>(value));
+        write(std::get<2>(value));
+    }
+
+    template <typename Container>
+    void writeContainer(const Container& value)
+    {
+        writeUint64(value.size());
+        for (const auto& it : value)
+            write(it);
+    }
+
+    template <typename T>
+    void write(const std::vector<T>& value)
+    {
+        writeContainer(value);
+    }
+
+    template <typename T>
+    void write(const std::set<T>& value)
+    {
+        writeContainer(value);
+    }
+
+    template <typename K, typename V>
+    void write(const std::map<K, V>& value)
+    {
+        writeContainer(value);
+    }
+
+    template <typename K, typename V>
+    void write(const std::unordered_map<K, V>& value)
+    {
+        writeContainer(value);
+    }
+
+private:
+    std::vector<std::uint8_t>& m_byteArray;
+};
+
+class DiskCacheReader {
+public:
+    DiskCacheReader(const std::uint8_t* data, size_t size)
+        : m_data(data)
+        , m_size(size)
+    {
+    }
+
+    bool readBytes(void* data, size_t size)
+    {
+        if (m_size - m_offset < size)
+            return false;
+        std::memcpy(data, m_data + m_offset, size);
+        m_offset += size;
+        return true;
+    }
+
+    bool readUint64(std::uint64_t* value)
+    {
+        std::uint8_t bytes[8];
+        if (!readBytes(bytes, sizeof(bytes)))
+            return false;
+        *value = 0;
+        for (size_t i = 0; i < 8; ++i)
+            *value |= (std::uint64_t)bytes[i] << (i * 8);
+        return true;
+    }
+
+    bool read(bool* value)
+    {
+        std::uint8_t byte;
+        if (!readBytes(&byte, 1))
+            return false;
+        *value = 0 != byte;
+        return true;
+    }
+
+    bool read(double* value)
+    {
+        std::uint64_t bits;
+        if (!readUint64(&bits))
+            return false;
+        std::memcpy(value, &bits, sizeof(bits));
+        return true;
+    }
+
+    bool read(float* value)
+    {
+        double doubleValue;
+        if (!read(&doubleValue))
+            return false;
+        *value = (float)doubleValue;
+        return true;
+    }
+
+    bool read(unsigned long* value)
+    {
+        std::uint64_t longValue;
+        if (!readUint64(&longValue))
+            return false;
+        *value = (unsigned long)longValue;
+        return true;
+    }
+
+    bool read(unsigned long long* value)
+    {
+        std::uint64_t longValue;
+        if (!readUint64(&longValue))
+            return false;
+        *value = (unsigned long long)longValue;
+        return true;
+    }
+
+    bool read(std::string* value)
+    {
+        std::uint64_t length;
+        if (!readUint64(&length) || m_size - m_offset < length)
+            return false;
+        value->assign((const char*)m_data + m_offset, (size_t)length);
+        m_offset += (size_t)length;
+        return true;
+    }
+
+    bool read(Uuid* value)
+    {
+        std::string string;
+        if (!read(&string))
+            return false;
+        *value = Uuid(string);
+        return true;
+    }
+
+    bool read(Vector2* value)
+    {
+        double x, y;
+        if (!read(&x) || !read(&y))
+            return false;
+        *value = Vector2(x, y);
+        return true;
+    }
+
+    bool read(Vector3* value)
+    {
+        double x, y, z;
+        if (!read(&x) || !read(&y) || !read(&z))
+            return false;
+        *value = Vector3(x, y, z);
+        return true;
+    }
+
+    bool read(Color* value)
+    {
+        double r, g, b, alpha;
+        if (!read(&r) || !read(&g) || !read(&b) || !read(&alpha))
+            return false;
+        *value = Color(r, g, b, alpha);
+        return true;
+    }
+
+    bool read(PositionKey* value)
+    {
+        std::uint64_t x, y, z;
+        if (!readUint64(&x) || !readUint64(&y) || !readUint64(&z))
+            return false;
+        *value = PositionKey::fromIntegers((long)(std::int64_t)x, (long)(std::int64_t)y, (long)(std::int64_t)z);
+        return true;
+    }
+
+    bool read(ObjectNode* value)
+    {
+        return read(&value->origin) && read(&value->color) && read(&value->smoothCutoffDegrees)
+            && read(&value->componentId);
+    }
+
+    template <typename T, size_t N>
+    bool read(std::array<T, N>* value)
+    {
+        for (auto& it : *value) {
+            if (!read(&it))
+                return false;
+        }
+        return true;
+    }
+
+    template <typename A, typename B>
+    bool read(std::pair<A, B>* value)
+    {
+        return read(&value->first) && read(&value->second);
+    }
+
+    template <typename A, typename B, typename C>
+    bool read(std::tuple<A, B, C>* value)
+    {
+        return read(&std::get<0>(*value)) && read(&std::get<1>(*value)) && read(&std::get<2>(*value));
+    }
+
+    template <typename T>
+    bool read(std::vector<T>* value)
+    {
+        std::uint64_t count;
+        if (!readUint64(&count) || !isCountPlausible(count))
+            return false;
+        value->resize((size_t)count);
+        for (auto& it : *value) {
+            if (!read(&it))
+                return false;
+        }
+        return true;
+    }
+
+    // Sorted containers were written in order, so every element is inserted at the end
+    template <typename T>
+    bool read(std::set<T>* value)
+    {
+        std::uint64_t count;
+        if (!readUint64(&count) || !isCountPlausible(count))
+            return false;
+        value->clear();
+        for (std::uint64_t i = 0; i < count; ++i) {
+            T element;
+            if (!read(&element))
+                return false;
+            value->emplace_hint(value->end(), std::move(element));
+        }
+        return true;
+    }
+
+    template <typename K, typename V>
+    bool read(std::map<K, V>* value)
+    {
+        std::uint64_t count;
+        if (!readUint64(&count) || !isCountPlausible(count))
+            return false;
+        value->clear();
+        for (std::uint64_t i = 0; i < count; ++i) {
+            std::pair<K, V> element;
+            if (!read(&element))
+                return false;
+            value->emplace_hint(value->end(), std::move(element));
+        }
+        return true;
+    }
+
+    template <typename K, typename V>
+    bool read(std::unordered_map<K, V>* value)
+    {
+        std::uint64_t count;
+        if (!readUint64(&count) || !isCountPlausible(count))
+            return false;
+        value->clear();
+        value->reserve((size_t)count);
+        for (std::uint64_t i = 0; i < count; ++i) {
+            std::pair<K, V> element;
+            if (!read(&element))
+                return false;
+            value->emplace(std::move(element));
+        }
+        return true;
+    }
+
+private:
+    const std::uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+    size_t m_offset = 0;
+
+    // Each element takes at least one byte, a count larger than the remaining
+    // bytes can only come from a corrupted file
+    bool isCountPlausible(std::uint64_t count) const
+    {
+        return count <= m_size - m_offset;
+    }
+};
+
+static void writeMeshState(DiskCacheWriter& writer, const MeshState* meshState)
+{
+    writer.write(nullptr != meshState);
+    if (nullptr == meshState)
+        return;
+    std::vector<Vector3> vertices;
+    std::vector<std::vector<size_t>> triangles;
+    meshState->fetch(vertices, triangles);
+    writer.write(nullptr != meshState->mesh);
+    writer.write(vertices);
+    writer.write(triangles);
+    writer.write(meshState->seamTriangleUvs);
+}
+
+static bool readMeshState(DiskCacheReader& reader, std::unique_ptr<MeshState>* meshState)
+{
+    bool hasMeshState = false;
+    if (!reader.read(&hasMeshState))
+        return false;
+    if (!hasMeshState) {
+        meshState->reset();
+        return true;
+    }
+    bool hasMesh = false;
+    std::vector<Vector3> vertices;
+    std::vector<std::vector<size_t>> triangles;
+    if (!reader.read(&hasMesh) || !reader.read(&vertices) || !reader.read(&triangles))
+        return false;
+    *meshState = hasMesh ? std::make_unique<MeshState>(vertices, triangles) : std::make_unique<MeshState>();
+    return reader.read(&(*meshState)->seamTriangleUvs);
+}
+
+static void writePart(DiskCacheWriter& writer, const MeshGenerator::GeneratedPart& part)
+{
+    writer.write(part.vertices);
+    writer.write(part.positionToNodeIdMap);
+    writer.write(part.nodeMap);
+    writer.write(part.faces);
+    writer.write(part.triangleUvs);
+    writer.write(part.color);
+    writer.write(part.metalness);
+    writer.write(part.roughness);
+    writer.write(part.isSuccessful);
+    writer.write(part.joined);
+    writer.write(part.importedVertexColorMap);
+    writer.write(part.importedTriangleNormals);
+}
+
+static bool readPart(DiskCacheReader& reader, MeshGenerator::GeneratedPart* part)
+{
+    return reader.read(&part->vertices)
+        && reader.read(&part->positionToNodeIdMap)
+        && reader.read(&part->nodeMap)
+        && reader.read(&part->faces)
+        && reader.read(&part->triangleUvs)
+        && reader.read(&part->color)
+        && reader.read(&part->metalness)
+        && reader.read(&part->roughness)
+        && reader.read(&part->isSuccessful)
+        && reader.read(&part->joined)
+        && reader.read(&part->importedVertexColorMap)
+        && reader.read(&part->importedTriangleNormals);
+}
+
+static void writeComponent(DiskCacheWriter& writer, const MeshGenerator::GeneratedComponent& component)
+{
+    writeMeshState(writer, component.mesh.get());
+    writer.write(component.sharedQuadEdges);
+    writer.write(component.componentTriangleUvs);
+    writer.write(component.brokenTriangles);
+    writer.write(component.noneSeamVertices);
+    writer.write(component.positionToNodeIdMap);
+    writer.write(component.nodeMap);
+    writer.write(component.importedVertexColorMap);
+    writer.write(component.importedTriangleNormals);
+}
+
+static bool readComponent(DiskCacheReader& reader, MeshGenerator::GeneratedComponent* component)
+{
+    return readMeshState(reader, &component->mesh)
+        && reader.read(&component->sharedQuadEdges)
+        && reader.read(&component->componentTriangleUvs)
+        && reader.read(&component->brokenTriangles)
+        && reader.read(&component->noneSeamVertices)
+        && reader.read(&component->positionToNodeIdMap)
+        && reader.read(&component->nodeMap)
+        && reader.read(&component->importedVertexColorMap)
+        && reader.read(&component->importedTriangleNormals);
+}
+
+static void writePreview(DiskCacheWriter& writer, const MeshGenerator::ComponentPreview& preview)
+{
+    writer.write(preview.vertices);
+    writer.write(preview.triangles);
+    writer.write(preview.triangleUvs);
+    writer.write(preview.color);
+    writer.write(preview.metalness);
+    writer.write(preview.roughness);
+    writer.write(preview.vertexProperties);
+    writer.write(preview.cutFaceTemplate);
+}
+
+static bool readPreview(DiskCacheReader& reader, MeshGenerator::ComponentPreview* preview)
+{
+    return reader.read(&preview->vertices)
+        && reader.read(&preview->triangles)
+        && reader.read(&preview->triangleUvs)
+        && reader.read(&preview->color)
+        && reader.read(&preview->metalness)
+        && reader.read(&preview->roughness)
+        && reader.read(&preview->vertexProperties)
+        && reader.read(&preview->cutFaceTemplate);
+}
+
+MeshGeneratorDiskCache::MeshGeneratorDiskCache(const std::string& directory, std::uint64_t sizeLimit)
+    : m_directory(directory)
+    , m_sizeLimit(sizeLimit)
+{
+}
+
+std::string MeshGeneratorDiskCache::entryPath(const std::string& key) const
+{
+    return m_directory + "/" + key + g_diskCacheExtension;
+}
+
+// The directory is only scanned when an entry is written, or when it had been
+// written past the limit, so loading alone never walks the directory
+void MeshGeneratorDiskCache::addEntrySize(std::uint64_t entrySize)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sizeMutex);
+        if (m_isSizeKnown) {
+            m_size += entrySize;
+            if (m_size <= m_sizeLimit)
+                return;
+        }
+    }
+    prune();
+}
+
+void MeshGeneratorDiskCache::prune()
+{
+    struct Entry {
+        std::filesystem::path path;
+        std::filesystem::file_time_type accessTime;
+        std::uint64_t size = 0;
+    };
+    std::vector<Entry> entries;
+    std::uint64_t totalSize = 0;
+    std::error_code error;
+    for (std::filesystem::directory_iterator it(m_directory, error), end; !error && it != end; it.increment(error)) {
+        if (it->path().extension() != g_diskCacheExtension)
+            continue;
+        Entry entry;
+        entry.path = it->path();
+        entry.size = (std::uint64_t)it->file_size(error);
+        if (error)
+            continue;
+        entry.accessTime = it->last_write_time(error);
+        if (error)
+            continue;
+        totalSize += entry.size;
+        entries.push_back(std::move(entry));
+    }
+    if (totalSize > m_sizeLimit) {
+        std::sort(entries.begin(), entries.end(), [](const Entry& first, const Entry& second) {
+            return first.accessTime < second.accessTime;
+        });
+        // Go well under the limit, so the next few saves don't rescan the directory each time
+        std::uint64_t targetSize = m_sizeLimit / 4 * 3;
+        for (const auto& entry : entries) {
+            if (totalSize <= targetSize)
+                break;
+            // Another process may have removed it already, it no longer counts either way
+            std::filesystem::remove(entry.path, error);
+            totalSize -= entry.size;
+        }
+    }
+    std::lock_guard<std::mutex> lock(m_sizeMutex);
+    m_size = totalSize;
+    m_isSizeKnown = true;
+}
+
+bool MeshGeneratorDiskCache::load(const std::string& key,
+    MeshGenerator::GeneratedComponent* component,
+    MeshGenerator::GeneratedPart* part,
+    bool* hasPart,
+    std::map<Uuid, MeshGenerator::ComponentPreview>* previews)
+{
+    std::ifstream file(entryPath(key), std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+        return false;
+    std::streamoff fileSize = file.tellg();
+    if (fileSize <= 0)
+        return false;
+    std::vector<std::uint8_t> byteArray((size_t)fileSize);
+    file.seekg(0);
+    if (!file.read((char*)byteArray.data(), fileSize))
+        return false;
+    file.close();
+
+    DiskCacheReader reader(byteArray.data(), byteArray.size());
+    char magic[sizeof(g_diskCacheMagic)];
+    std::uint64_t version = 0;
+    if (!reader.readBytes(magic, sizeof(magic)) || 0 != std::memcmp(magic, g_diskCacheMagic, sizeof(magic)))
+        return false;
+    if (!reader.readUint64(&version) || version != m_version)
+        return false;
+    if (!readComponent(reader, component))
+        return false;
+    if (!reader.read(hasPart))
+        return false;
+    if (*hasPart && !readPart(reader, part))
+        return false;
+    std::uint64_t previewCount = 0;
+    if (!reader.readUint64(&previewCount))
+        return false;
+    for (std::uint64_t i = 0; i < previewCount; ++i) {
+        Uuid componentId;
+        MeshGenerator::ComponentPreview preview;
+        if (!reader.read(&componentId) || !readPreview(reader, &preview))
+            return false;
+        (*previews)[componentId] = std::move(preview);
+    }
+
+    // Mark the entry as recently used, so pruning removes it last
+    std::error_code error;
+    std::filesystem::last_write_time(entryPath(key), std::filesystem::file_time_type::clock::now(), error);
+    return true;
+}
+
+void MeshGeneratorDiskCache::save(const std::string& key,
+    const MeshGenerator::GeneratedComponent& component,
+    const MeshGenerator::GeneratedPart* part,
+    const std::map<Uuid, const MeshGenerator::ComponentPreview*>& previews)
+{
+    std::string path = entryPath(key);
+
+    // The content of an entry is determined by its key, an existing one is already up to date
+    if (std::ifstream(path).is_open())
+        return;
+
+    std::vector<std::uint8_t> byteArray;
+    DiskCacheWriter writer(byteArray);
+    writer.writeBytes(g_diskCacheMagic, sizeof(g_diskCacheMagic));
+    writer.writeUint64(m_version);
+    writeComponent(writer, component);
+    writer.write(nullptr != part);
+    if (nullptr != part)
+        writePart(writer, *part);
+    writer.writeUint64(previews.size());
+    for (const auto& it : previews) {
+        writer.write(it.first);
+        writePreview(writer, *it.second);
+    }
+
+    std::string temporaryPath = path + "." + Uuid::createUuid().toString() + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            return;
+        file.write((const char*)byteArray.data(), byteArray.size());
+        if (!file) {
+            file.close();
+            std::remove(temporaryPath.c_str());
+            return;
+        }
+    }
+    // Renaming fails on some platforms when another process has written the same entry meanwhile
+    if (0 != std::rename(temporaryPath.c_str(), path.c_str())) {
+        std::remove(temporaryPath.c_str());
+        return;
+    }
+    addEntrySize(byteArray.size());
+}
+
+}
@@ -0,0 +1,87 @@
+/*
+ *  Copyright (c) 2016-2026 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef DUST3D_MESH_MESH_GENERATOR_DISK_CACHE_H_
+#define DUST3D_MESH_MESH_GENERATOR_DISK_CACHE_H_
+
+#include <cstdint>
+#include <dust3d/mesh/mesh_generator.h>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace dust3d {
+
+// Keeps generated components in a directory, so they survive the process.
+// Each entry holds one component together with its linked part and the previews
+// added while it was built, and is named after a hash of every snapshot record
+// the component was generated from, so an entry is never invalidated, a changed
+// component simply gets a new name. Entries are written to a temporary file first
+// and renamed into place, so generators of several processes can share one directory.
+// Loading an entry refreshes its modification time, which serves as its access time;
+// once the entries written through this cache push the directory over the size limit,
+// the least recently used ones are removed until it is back under three quarters of it.
+class MeshGeneratorDiskCache {
+public:
+    // Bump whenever the generator produces different results from the same snapshot
+    static const std::uint32_t m_version;
+    static const std::uint64_t m_defaultSizeLimit;
+
+    class KeyBuilder {
+    public:
+        KeyBuilder();
+        void addString(const std::string& string);
+        void addAttributes(const std::map<std::string, std::string>& attributes);
+        std::string key() const;
+
+    private:
+        std::uint64_t m_hashes[2];
+    };
+
+    MeshGeneratorDiskCache(const std::string& directory, std::uint64_t sizeLimit = m_defaultSizeLimit);
+    bool load(const std::string& key,
+        MeshGenerator::GeneratedComponent* component,
+        MeshGenerator::GeneratedPart* part,
+        bool* hasPart,
+        std::map<Uuid, MeshGenerator::ComponentPreview>* previews);
+    void save(const std::string& key,
+        const MeshGenerator::GeneratedComponent& component,
+        const MeshGenerator::GeneratedPart* part,
+        const std::map<Uuid, const MeshGenerator::ComponentPreview*>& previews);
+
+    // Removes the least recently used entries until the directory is under the size limit
+    void prune();
+
+private:
+    std::string m_directory;
+    std::uint64_t m_sizeLimit = 0;
+    std::mutex m_sizeMutex;
+    std::uint64_t m_size = 0;
+    bool m_isSizeKnown = false;
+
+    std::string entryPath(const std::string& key) const;
+    void addEntrySize(std::uint64_t entrySize);
+};
+
+}
+
+#endif
@@ -54,7 +54,8 @@ bool MeshState::isNull() const
 }
 
 std::unique_ptr<MeshState> MeshState::combine(const MeshState& first, const MeshState& second,
-    MeshCombiner::Method method)
+    MeshCombiner::Method method,
+    const CancellationToken* cancellationToken)
 {
     if (first.mesh->isNull() || second.mesh->isNull())
         return nullptr;
@@ -63,8 +64,9 @@ std::unique_ptr<MeshState> MeshState::combine(const MeshState& first, const Mesh
     auto newMesh = std::unique_ptr<MeshCombiner::Mesh>(MeshCombiner::combine(*first.mesh,
         *second.mesh,
         method,
-        &combinedVerticesSources));
-    if (nullptr == newMesh)
+        &combinedVerticesSources,
+        cancellationToken));
+    if (nullptr == newMesh || CancellationToken::isCancelled(cancellationToken))
         return nullptr;
     if (!newMesh->isNull()) {
         MeshRecombiner recombiner;
@@ -116,6 +118,34 @@ std::unique_ptr<MeshState> MeshState::combine(const MeshState& first, const Mesh
     return newMeshState;
 }
 
+// Put meshes together without any boolean operation, the result may self intersect
+std::unique_ptr<MeshState> MeshState::merge(const std::vector<const MeshState*>& meshes)
+{
+    std::vector<Vector3> vertices;
+    std::vector<std::vector<size_t>> faces;
+    std::vector<std::pair<std::set<std::array<PositionKey, 3>>, std::set<std::array<PositionKey, 3>>>> seamTriangleUvs;
+    for (const auto& it : meshes) {
+        if (nullptr == it || it->isNull())
+            continue;
+        std::vector<Vector3> meshVertices;
+        std::vector<std::vector<size_t>> meshFaces;
+        it->fetch(meshVertices, meshFaces);
+        size_t vertexStartIndex = vertices.size();
+        vertices.insert(vertices.end(), meshVertices.begin(), meshVertices.end());
+        for (auto& face : meshFaces) {
+            for (auto& index : face)
+                index += vertexStartIndex;
+            faces.emplace_back(std::move(face));
+        }
+        seamTriangleUvs.insert(seamTriangleUvs.end(), it->seamTriangleUvs.begin(), it->seamTriangleUvs.end());
+    }
+    if (vertices.empty())
+        return nullptr;
+    auto newMeshState = std::make_unique<MeshState>(vertices, faces);
+    newMeshState->seamTriangleUvs = std::move(seamTriangleUvs);
+    return newMeshState;
+}
+
 bool MeshState::isWatertight(const std::vector<std::vector<size_t>>& faces)
 {
     std::set<std::pair<size_t, size_t>> halfEdges;
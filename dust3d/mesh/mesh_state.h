@@ -42,7 +42,9 @@ public:
     void fetch(std::vector<Vector3>& vertices, std::vector<std::vector<size_t>>& faces) const;
     bool isNull() const;
     static std::unique_ptr<MeshState> combine(const MeshState& first, const MeshState& second,
-        MeshCombiner::Method method);
+        MeshCombiner::Method method,
+        const CancellationToken* cancellationToken = nullptr);
+    static std::unique_ptr<MeshState> merge(const std::vector<const MeshState*>& meshes);
     static bool isWatertight(const std::vector<std::vector<size_t>>& faces);
 };
 
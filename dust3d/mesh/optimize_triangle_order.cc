@@ -0,0 +1,343 @@
+/*
+ *  Copyright (c) 2016-2026 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <algorithm>
+#include <dust3d/mesh/optimize_triangle_order.h>
+#include <limits>
+
+namespace dust3d {
+
+static const size_t NoVertex = std::numeric_limits<size_t>::max();
+
+void optimizeVertexCache(const std::vector<std::vector<size_t>>& triangles,
+    size_t vertexCount,
+    std::vector<size_t>* triangleOrder,
+    std::vector<size_t>* clusterStarts,
+    size_t cacheSize)
+{
+    triangleOrder->clear();
+    triangleOrder->reserve(triangles.size());
+    if (nullptr != clusterStarts)
+        clusterStarts->clear();
+    if (triangles.empty())
+        return;
+
+    // Triangles around each vertex, in compressed rows
+    std::vector<size_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (const auto& triangle : triangles) {
+        for (size_t j = 0; j < 3; ++j)
+            ++adjacencyOffsets[triangle[j] + 1];
+    }
+    for (size_t v = 0; v < vertexCount; ++v)
+        adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+    std::vector<size_t> adjacency(adjacencyOffsets[vertexCount]);
+    std::vector<size_t> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (size_t t = 0; t < triangles.size(); ++t) {
+        for (size_t j = 0; j < 3; ++j)
+            adjacency[fillOffsets[triangles[t][j]]++] = t;
+    }
+
+    std::vector<size_t> liveTriangles(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+        liveTriangles[v] = adjacencyOffsets[v + 1] - adjacencyOffsets[v];
+    std::vector<size_t> cacheTimestamps(vertexCount, 0);
+    std::vector<bool> emitted(triangles.size(), false);
+    std::vector<size_t> deadEnd;
+    std::vector<size_t> candidates;
+    size_t timestamp = cacheSize + 1;
+    size_t cursor = 0;
+
+    auto nextLiveVertex = [&]() {
+        while (cursor < vertexCount) {
+            if (liveTriangles[cursor] > 0)
+                return cursor;
+            ++cursor;
+        }
+        return NoVertex;
+    };
+
+    size_t fanningVertex = nextLiveVertex();
+    if (nullptr != clusterStarts && NoVertex != fanningVertex)
+        clusterStarts->push_back(0);
+    while (NoVertex != fanningVertex) {
+        candidates.clear();
+        for (size_t k = adjacencyOffsets[fanningVertex]; k < adjacencyOffsets[fanningVertex + 1]; ++k) {
+            size_t t = adjacency[k];
+            if (emitted[t])
+                continue;
+            for (size_t j = 0; j < 3; ++j) {
+                size_t v = triangles[t][j];
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                --liveTriangles[v];
+                if (timestamp - cacheTimestamps[v] > cacheSize)
+                    cacheTimestamps[v] = timestamp++;
+            }
+            emitted[t] = true;
+            triangleOrder->push_back(t);
+        }
+
+        // Prefer the candidate which stays in cache for all its remaining triangles and entered it earliest
+        fanningVertex = NoVertex;
+        size_t bestPriority = 0;
+        for (size_t v : candidates) {
+            if (0 == liveTriangles[v])
+                continue;
+            size_t priority = 0;
+            if (timestamp - cacheTimestamps[v] + 2 * liveTriangles[v] <= cacheSize)
+                priority = timestamp - cacheTimestamps[v];
+            if (NoVertex == fanningVertex || priority > bestPriority) {
+                fanningVertex = v;
+                bestPriority = priority;
+            }
+        }
+        if (NoVertex != fanningVertex)
+            continue;
+
+        while (!deadEnd.empty()) {
+            size_t v = deadEnd.back();
+            deadEnd.pop_back();
+            if (liveTriangles[v] > 0) {
+                fanningVertex = v;
+                break;
+            }
+        }
+        if (NoVertex != fanningVertex)
+            continue;
+
+        fanningVertex = nextLiveVertex();
+        if (nullptr != clusterStarts && NoVertex != fanningVertex)
+            clusterStarts->push_back(triangleOrder->size());
+    }
+}
+
+void optimizeOverdraw(const std::vector<Vector3>& vertices,
+    const std::vector<std::vector<size_t>>& triangles,
+    const std::vector<size_t>& clusterStarts,
+    std::vector<size_t>* triangleOrder,
+    float threshold,
+    size_t cacheSize)
+{
+    const auto& order = *triangleOrder;
+    if (order.empty())
+        return;
+
+    std::vector<size_t> cacheTimestamps(vertices.size(), 0);
+    size_t timestamp = cacheSize + 1;
+    auto countMisses = [&](size_t t) {
+        size_t misses = 0;
+        for (size_t j = 0; j < 3; ++j) {
+            size_t v = triangles[t][j];
+            if (timestamp - cacheTimestamps[v] > cacheSize) {
+                cacheTimestamps[v] = timestamp++;
+                ++misses;
+            }
+        }
+        return misses;
+    };
+    auto flushCache = [&]() {
+        timestamp += cacheSize + 1;
+    };
+
+    size_t totalMisses = 0;
+    for (size_t t : order)
+        totalMisses += countMisses(t);
+    double meshMissRatio = (double)totalMisses / order.size();
+
+    std::vector<size_t> hardStarts = clusterStarts;
+    hardStarts.push_back(0);
+    std::sort(hardStarts.begin(), hardStarts.end());
+    hardStarts.erase(std::unique(hardStarts.begin(), hardStarts.end()), hardStarts.end());
+    hardStarts.erase(std::remove_if(hardStarts.begin(), hardStarts.end(), [&](size_t start) {
+        return start >= order.size();
+    }),
+        hardStarts.end());
+
+    // Clusters end wherever their own miss ratio is not much worse than the whole mesh
+    std::vector<std::pair<size_t, size_t>> clusters;
+    for (size_t h = 0; h < hardStarts.size(); ++h) {
+        size_t hardEnd = h + 1 < hardStarts.size() ? hardStarts[h + 1] : order.size();
+        size_t clusterBegin = hardStarts[h];
+        size_t clusterMisses = 0;
+        flushCache();
+        for (size_t i = hardStarts[h]; i < hardEnd; ++i) {
+            clusterMisses += countMisses(order[i]);
+            if ((double)clusterMisses / (i + 1 - clusterBegin) <= meshMissRatio * threshold) {
+                clusters.push_back({ clusterBegin, i + 1 });
+                clusterBegin = i + 1;
+                clusterMisses = 0;
+                flushCache();
+            }
+        }
+        if (clusterBegin < hardEnd)
+            clusters.push_back({ clusterBegin, hardEnd });
+    }
+
+    // Sort clusters by how far they face away from the mesh center
+    Vector3 meshCentroidSum;
+    double meshArea = 0.0;
+    std::vector<Vector3> clusterCentroids(clusters.size());
+    std::vector<Vector3> clusterNormals(clusters.size());
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        Vector3 centroidSum;
+        Vector3 normalSum;
+        double area = 0.0;
+        for (size_t i = clusters[c].first; i < clusters[c].second; ++i) {
+            const auto& triangle = triangles[order[i]];
+            const auto& p0 = vertices[triangle[0]];
+            const auto& p1 = vertices[triangle[1]];
+            const auto& p2 = vertices[triangle[2]];
+            Vector3 normal = Vector3::crossProduct(p1 - p0, p2 - p0);
+            double triangleArea = normal.length() * 0.5;
+            centroidSum += (p0 + p1 + p2) * (triangleArea / 3.0);
+            normalSum += normal;
+            area += triangleArea;
+        }
+        meshCentroidSum += centroidSum;
+        meshArea += area;
+        clusterCentroids[c] = area > 0.0 ? centroidSum / area : centroidSum;
+        clusterNormals[c] = normalSum.normalized();
+    }
+    Vector3 meshCentroid = meshArea > 0.0 ? meshCentroidSum / meshArea : meshCentroidSum;
+    std::vector<double> clusterKeys(clusters.size());
+    for (size_t c = 0; c < clusters.size(); ++c)
+        clusterKeys[c] = Vector3::dotProduct(clusterCentroids[c] - meshCentroid, clusterNormals[c]);
+
+    std::vector<size_t> clusterOrder(clusters.size());
+    for (size_t c = 0; c < clusterOrder.size(); ++c)
+        clusterOrder[c] = c;
+    std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&](size_t a, size_t b) {
+        return clusterKeys[a] > clusterKeys[b];
+    });
+
+    std::vector<size_t> newOrder;
+    newOrder.reserve(order.size());
+    for (size_t c : clusterOrder)
+        newOrder.insert(newOrder.end(), order.begin() + clusters[c].first, order.begin() + clusters[c].second);
+    *triangleOrder = std::move(newOrder);
+}
+
+void optimizeVertexFetch(const std::vector<std::vector<size_t>>& triangles,
+    size_t vertexCount,
+    std::vector<size_t>* vertexRemap)
+{
+    vertexRemap->assign(vertexCount, NoVertex);
+    size_t nextIndex = 0;
+    for (const auto& triangle : triangles) {
+        for (size_t j = 0; j < 3; ++j) {
+            size_t& newIndex = (*vertexRemap)[triangle[j]];
+            if (NoVertex == newIndex)
+                newIndex = nextIndex++;
+        }
+    }
+    for (auto& newIndex : *vertexRemap) {
+        if (NoVertex == newIndex)
+            newIndex = nextIndex++;
+    }
+}
+
+template <class T>
+static void reorderByTriangle(std::vector<T>& values, const std::vector<size_t>& triangleOrder)
+{
+    if (values.size() != triangleOrder.size())
+        return;
+    std::vector<T> reordered;
+    reordered.reserve(values.size());
+    for (size_t t : triangleOrder)
+        reordered.push_back(std::move(values[t]));
+    values = std::move(reordered);
+}
+
+template <class T>
+static void remapByVertex(std::vector<T>& values, const std::vector<size_t>& vertexRemap)
+{
+    if (values.size() != vertexRemap.size())
+        return;
+    std::vector<T> remapped(values.size());
+    for (size_t v = 0; v < values.size(); ++v)
+        remapped[vertexRemap[v]] = std::move(values[v]);
+    values = std::move(remapped);
+}
+
+void optimizeTriangleOrder(Object* object)
+{
+    if (object->triangles.empty() || nullptr != object->triangleLinks())
+        return;
+    size_t vertexCount = object->vertices.size();
+    for (const auto& triangle : object->triangles) {
+        if (3 != triangle.size())
+            return;
+        for (size_t j = 0; j < 3; ++j) {
+            if (triangle[j] >= vertexCount)
+                return;
+        }
+    }
+
+    std::vector<size_t> triangleOrder;
+    std::vector<size_t> clusterStarts;
+    optimizeVertexCache(object->triangles, vertexCount, &triangleOrder, &clusterStarts);
+    optimizeOverdraw(object->vertices, object->triangles, clusterStarts, &triangleOrder);
+
+    reorderByTriangle(object->triangles, triangleOrder);
+    reorderByTriangle(object->triangleNormals, triangleOrder);
+    if (nullptr != object->triangleVertexNormals()) {
+        auto triangleVertexNormals = *object->triangleVertexNormals();
+        reorderByTriangle(triangleVertexNormals, triangleOrder);
+        object->setTriangleVertexNormals(triangleVertexNormals);
+    }
+    if (nullptr != object->triangleVertexUvs()) {
+        auto triangleVertexUvs = *object->triangleVertexUvs();
+        reorderByTriangle(triangleVertexUvs, triangleOrder);
+        object->setTriangleVertexUvs(triangleVertexUvs);
+    }
+    if (nullptr != object->triangleTangents()) {
+        auto triangleTangents = *object->triangleTangents();
+        reorderByTriangle(triangleTangents, triangleOrder);
+        object->setTriangleTangents(triangleTangents);
+    }
+    if (nullptr != object->triangleSourceNodes()) {
+        auto triangleSourceNodes = *object->triangleSourceNodes();
+        reorderByTriangle(triangleSourceNodes, triangleOrder);
+        object->setTriangleSourceNodes(triangleSourceNodes);
+    }
+
+    std::vector<size_t> vertexRemap;
+    optimizeVertexFetch(object->triangles, vertexCount, &vertexRemap);
+    for (auto& triangle : object->triangles) {
+        for (auto& index : triangle)
+            index = vertexRemap[index];
+    }
+    for (auto& face : object->triangleAndQuads) {
+        for (auto& index : face) {
+            if (index < vertexCount)
+                index = vertexRemap[index];
+        }
+    }
+    remapByVertex(object->vertices, vertexRemap);
+    remapByVertex(object->vertexColors, vertexRemap);
+    remapByVertex(object->vertexSmoothCutoffDegrees, vertexRemap);
+    remapByVertex(object->vertexSourceNodes, vertexRemap);
+    remapByVertex(object->vertexBone1, vertexRemap);
+    remapByVertex(object->vertexBone2, vertexRemap);
+}
+
+}
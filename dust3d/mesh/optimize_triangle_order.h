@@ -0,0 +1,62 @@
+/*
+ *  Copyright (c) 2016-2026 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef DUST3D_MESH_OPTIMIZE_TRIANGLE_ORDER_H_
+#define DUST3D_MESH_OPTIMIZE_TRIANGLE_ORDER_H_
+
+#include <dust3d/base/object.h>
+#include <dust3d/base/vector3.h>
+#include <vector>
+
+namespace dust3d {
+
+// Orders triangles for the post-transform vertex cache (Tipsify, Sander et al. 2007).
+// triangleOrder receives indices into triangles, clusterStarts the positions in triangleOrder
+// where the walk had to jump to a vertex outside the simulated cache.
+void optimizeVertexCache(const std::vector<std::vector<size_t>>& triangles,
+    size_t vertexCount,
+    std::vector<size_t>* triangleOrder,
+    std::vector<size_t>* clusterStarts = nullptr,
+    size_t cacheSize = 16);
+
+// Splits a cache optimized order further wherever it costs little cache efficiency,
+// then draws outward facing clusters first so they occlude the rest
+void optimizeOverdraw(const std::vector<Vector3>& vertices,
+    const std::vector<std::vector<size_t>>& triangles,
+    const std::vector<size_t>& clusterStarts,
+    std::vector<size_t>* triangleOrder,
+    float threshold = 1.05f,
+    size_t cacheSize = 16);
+
+// vertexRemap[oldIndex] is the new index, vertices are numbered by first use, unused ones last
+void optimizeVertexFetch(const std::vector<std::vector<size_t>>& triangles,
+    size_t vertexCount,
+    std::vector<size_t>* vertexRemap);
+
+// Runs the passes above on the object and reorders every per triangle and per vertex
+// attribute it carries along: normals, UVs, tangents, source nodes, colors and bone bindings.
+// Objects which are not all triangles, or carry triangle links, are left as they are.
+void optimizeTriangleOrder(Object* object);
+
+}
+
+#endif
@@ -0,0 +1,811 @@
+/*
+ *  Copyright (c) 2016-2026 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <dust3d/base/parallel.h>
+#include <dust3d/base/position_key.h>
+#include <dust3d/mesh/optimize_triangle_order.h>
+#include <dust3d/mesh/resolve_triangle_tangent.h>
+#include <dust3d/mesh/simplify_mesh.h>
+#include <dust3d/mesh/smooth_normal.h>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <tuple>
+#include <unordered_map>
+
+namespace dust3d {
+
+namespace {
+
+    struct Quadric {
+        double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0;
+        double b2 = 0.0, bc = 0.0, bd = 0.0;
+        double c2 = 0.0, cd = 0.0;
+        double d2 = 0.0;
+
+        void addPlane(const Vector3& normal, double d, double weight)
+        {
+            double a = normal.x(), b = normal.y(), c = normal.z();
+            a2 += weight * a * a;
+            ab += weight * a * b;
+            ac += weight * a * c;
+            ad += weight * a * d;
+            b2 += weight * b * b;
+            bc += weight * b * c;
+            bd += weight * b * d;
+            c2 += weight * c * c;
+            cd += weight * c * d;
+            d2 += weight * d * d;
+        }
+
+        void add(const Quadric& other)
+        {
+            a2 += other.a2;
+            ab += other.ab;
+            ac += other.ac;
+            ad += other.ad;
+            b2 += other.b2;
+            bc += other.bc;
+            bd += other.bd;
+            c2 += other.c2;
+            cd += other.cd;
+            d2 += other.d2;
+        }
+
+        double evaluate(const Vector3& p) const
+        {
+            double x = p.x(), y = p.y(), z = p.z();
+            return a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x
+                + b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y
+                + c2 * z * z + 2.0 * cd * z
+                + d2;
+        }
+    };
+
+    class HalfEdgeCollapser {
+    public:
+        HalfEdgeCollapser(const std::vector<Vector3>& vertices,
+            const std::vector<std::vector<size_t>>& triangles,
+            const std::vector<size_t>* vertexGroups,
+            const std::vector<bool>* lockedVertices)
+            : m_vertices(vertices)
+            , m_quadrics(vertices.size())
+            , m_vertexTriangles(vertices.size())
+            , m_locked(nullptr != lockedVertices ? *lockedVertices : std::vector<bool>(vertices.size(), false))
+            , m_removed(vertices.size(), false)
+            , m_candidatePositions(vertices.size(), m_notQueued)
+        {
+            m_triangles.reserve(triangles.size());
+            m_triangleAlive.resize(triangles.size(), true);
+            m_aliveTriangleCount = triangles.size();
+            std::vector<std::pair<size_t, size_t>> edges;
+            edges.reserve(triangles.size() * 3);
+            for (size_t t = 0; t < triangles.size(); ++t) {
+                const auto& triangle = triangles[t];
+                m_triangles.push_back({ triangle[0], triangle[1], triangle[2] });
+                for (size_t i = 0; i < 3; ++i) {
+                    m_vertexTriangles[triangle[i]].push_back(t);
+                    size_t j = (i + 1) % 3;
+                    edges.push_back(std::make_pair(std::min(triangle[i], triangle[j]), std::max(triangle[i], triangle[j])));
+                }
+                if (triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[2] == triangle[0]) {
+                    for (size_t i = 0; i < 3; ++i)
+                        m_locked[triangle[i]] = true;
+                    continue;
+                }
+                const Vector3& p0 = vertices[triangle[0]];
+                Vector3 direction = Vector3::crossProduct(vertices[triangle[1]] - p0, vertices[triangle[2]] - p0);
+                double length = direction.length();
+                if (length <= 0.0)
+                    continue;
+                Vector3 normal = direction / length;
+                double d = -Vector3::dotProduct(normal, p0);
+                for (size_t i = 0; i < 3; ++i)
+                    m_quadrics[triangle[i]].addPlane(normal, d, length * 0.5);
+            }
+            m_vertexErrors.resize(vertices.size());
+            for (size_t v = 0; v < vertices.size(); ++v)
+                m_vertexErrors[v] = m_quadrics[v].evaluate(vertices[v]);
+
+            // Edges not shared by exactly two triangles are open or non-manifold borders
+            std::sort(edges.begin(), edges.end());
+            for (size_t i = 0; i < edges.size();) {
+                size_t j = i + 1;
+                while (j < edges.size() && edges[j] == edges[i])
+                    ++j;
+                if (2 != j - i) {
+                    m_locked[edges[i].first] = true;
+                    m_locked[edges[i].second] = true;
+                }
+                if (nullptr != vertexGroups && (*vertexGroups)[edges[i].first] != (*vertexGroups)[edges[i].second]) {
+                    m_locked[edges[i].first] = true;
+                    m_locked[edges[i].second] = true;
+                }
+                i = j;
+            }
+        }
+
+        void collapse(size_t targetTriangleCount)
+        {
+            // Candidates are queued by the cheapest collapse ignoring validity, which is a lower bound,
+            // the validity checks only run for the candidate on top of the queue
+            for (size_t v = 0; v < m_vertices.size(); ++v) {
+                double cost = 0.0;
+                if (!lowerBoundCost(v, &cost))
+                    continue;
+                m_candidatePositions[v] = m_candidates.size();
+                m_candidates.push_back({ cost, v });
+            }
+            for (size_t i = m_candidates.size() / 2; i-- > 0;)
+                siftDown(i);
+            while (m_aliveTriangleCount > targetTriangleCount && !m_candidates.empty()) {
+                size_t u = m_candidates[0].vertex;
+                size_t v = 0;
+                double cost = 0.0;
+                if (!findBestTarget(u, &v, &cost)) {
+                    removeCandidate(u);
+                    continue;
+                }
+                // The cheapest target failed the checks, so the candidate goes back with the cost it can actually have
+                if (cost > m_candidates[0].cost) {
+                    updateCandidate(u, cost);
+                    continue;
+                }
+                removeCandidate(u);
+                collapseEdge(u, v);
+            }
+        }
+
+        void fetch(std::vector<std::vector<size_t>>* simplifiedTriangles, std::vector<size_t>* triangleSources) const
+        {
+            simplifiedTriangles->clear();
+            simplifiedTriangles->reserve(m_aliveTriangleCount);
+            if (nullptr != triangleSources) {
+                triangleSources->clear();
+                triangleSources->reserve(m_aliveTriangleCount);
+            }
+            for (size_t t = 0; t < m_triangles.size(); ++t) {
+                if (!m_triangleAlive[t])
+                    continue;
+                const auto& triangle = m_triangles[t];
+                simplifiedTriangles->push_back({ triangle[0], triangle[1], triangle[2] });
+                if (nullptr != triangleSources)
+                    triangleSources->push_back(t);
+            }
+        }
+
+    private:
+        const std::vector<Vector3>& m_vertices;
+        std::vector<std::array<size_t, 3>> m_triangles;
+        std::vector<bool> m_triangleAlive;
+        size_t m_aliveTriangleCount = 0;
+        std::vector<Quadric> m_quadrics;
+        // Error of every quadric at its own vertex, the part of a collapse cost that only changes when the target does
+        std::vector<double> m_vertexErrors;
+        std::vector<std::vector<size_t>> m_vertexTriangles;
+        std::vector<bool> m_locked;
+        std::vector<bool> m_removed;
+        struct Candidate {
+            double cost;
+            size_t vertex;
+
+            bool operator<(const Candidate& other) const
+            {
+                if (cost != other.cost)
+                    return cost < other.cost;
+                return vertex < other.vertex;
+            }
+        };
+
+        // Binary min heap with at most one entry per vertex, so a change around a vertex updates its entry in place
+        static constexpr size_t m_notQueued = (size_t)-1;
+        std::vector<Candidate> m_candidates;
+        std::vector<size_t> m_candidatePositions;
+        std::vector<size_t> m_neighbors;
+        std::vector<size_t> m_neighborsOfTarget;
+        std::vector<size_t> m_changedVertices;
+        std::vector<std::pair<double, size_t>> m_targets;
+
+        static double triangleQuality(const std::array<Vector3, 3>& positions, const Vector3& direction)
+        {
+            double edgeLengthSquaredSum = (positions[1] - positions[0]).lengthSquared()
+                + (positions[2] - positions[1]).lengthSquared()
+                + (positions[0] - positions[2]).lengthSquared();
+            if (edgeLengthSquaredSum <= 0.0)
+                return 0.0;
+            return direction.length() / edgeLengthSquaredSum;
+        }
+
+        void collectNeighbors(size_t v, std::vector<size_t>* neighbors) const
+        {
+            neighbors->clear();
+            for (const auto& t : m_vertexTriangles[v]) {
+                if (!m_triangleAlive[t])
+                    continue;
+                for (const auto& w : m_triangles[t]) {
+                    if (w != v)
+                        neighbors->push_back(w);
+                }
+            }
+            std::sort(neighbors->begin(), neighbors->end());
+            neighbors->erase(std::unique(neighbors->begin(), neighbors->end()), neighbors->end());
+        }
+
+        double collapseCost(size_t u, size_t v) const
+        {
+            return std::max(0.0, m_quadrics[u].evaluate(m_vertices[v]) + m_vertexErrors[v]);
+        }
+
+        bool isCollapseValid(size_t u, size_t v, const std::vector<size_t>& neighborsOfU)
+        {
+            // Link condition: the two vertices may only share the neighbors opposite their shared triangles,
+            // otherwise the collapse would fold the surface onto itself
+            size_t sharedTriangleCount = 0;
+            for (const auto& t : m_vertexTriangles[u]) {
+                if (!m_triangleAlive[t])
+                    continue;
+                const auto& triangle = m_triangles[t];
+                if (triangle[0] == v || triangle[1] == v || triangle[2] == v)
+                    ++sharedTriangleCount;
+            }
+            collectNeighbors(v, &m_neighborsOfTarget);
+            size_t commonNeighborCount = 0;
+            for (auto i = neighborsOfU.cbegin(), j = m_neighborsOfTarget.cbegin(); i != neighborsOfU.cend() && j != m_neighborsOfTarget.cend();) {
+                if (*i < *j) {
+                    ++i;
+                } else if (*j < *i) {
+                    ++j;
+                } else {
+                    ++commonNeighborCount;
+                    ++i;
+                    ++j;
+                }
+            }
+            if (commonNeighborCount != sharedTriangleCount)
+                return false;
+
+            // The triangles moving with u must not flip or degenerate
+            const Vector3& target = m_vertices[v];
+            for (const auto& t : m_vertexTriangles[u]) {
+                if (!m_triangleAlive[t])
+                    continue;
+                const auto& triangle = m_triangles[t];
+                if (triangle[0] == v || triangle[1] == v || triangle[2] == v)
+                    continue;
+                std::array<Vector3, 3> positions = { m_vertices[triangle[0]], m_vertices[triangle[1]], m_vertices[triangle[2]] };
+                Vector3 before = Vector3::crossProduct(positions[1] - positions[0], positions[2] - positions[0]);
+                double beforeQuality = triangleQuality(positions, before);
+                for (size_t i = 0; i < 3; ++i) {
+                    if (triangle[i] == u)
+                        positions[i] = target;
+                }
+                Vector3 after = Vector3::crossProduct(positions[1] - positions[0], positions[2] - positions[0]);
+                if (Vector3::dotProduct(before, after) <= 0.2 * before.length() * after.length())
+                    return false;
+                // Slivers have no reliable normal, so later collapses could flip them unnoticed
+                if (triangleQuality(positions, after) < 0.5 * std::min(0.1, beforeQuality))
+                    return false;
+            }
+            return true;
+        }
+
+        bool findBestTarget(size_t u, size_t* bestTarget, double* bestCost)
+        {
+            if (m_locked[u] || m_removed[u])
+                return false;
+            collectNeighbors(u, &m_neighbors);
+            // Cheapest first, so the validity checks stop at the first target that passes
+            m_targets.clear();
+            for (const auto& v : m_neighbors)
+                m_targets.push_back(std::make_pair(collapseCost(u, v), v));
+            std::sort(m_targets.begin(), m_targets.end());
+            for (const auto& it : m_targets) {
+                if (!isCollapseValid(u, it.second, m_neighbors))
+                    continue;
+                *bestTarget = it.second;
+                *bestCost = it.first;
+                return true;
+            }
+            return false;
+        }
+
+        bool lowerBoundCost(size_t u, double* cost) const
+        {
+            if (m_locked[u] || m_removed[u])
+                return false;
+            // Neighbors come up twice around a manifold vertex, which is still cheaper than collecting them uniquely
+            bool found = false;
+            *cost = std::numeric_limits<double>::max();
+            for (const auto& t : m_vertexTriangles[u]) {
+                for (const auto& v : m_triangles[t]) {
+                    if (v == u)
+                        continue;
+                    *cost = std::min(*cost, collapseCost(u, v));
+                    found = true;
+                }
+            }
+            return found;
+        }
+
+        void placeCandidate(size_t position, const Candidate& candidate)
+        {
+            m_candidates[position] = candidate;
+            m_candidatePositions[candidate.vertex] = position;
+        }
+
+        void siftUp(size_t position)
+        {
+            Candidate candidate = m_candidates[position];
+            while (position > 0) {
+                size_t parent = (position - 1) / 2;
+                if (!(candidate < m_candidates[parent]))
+                    break;
+                placeCandidate(position, m_candidates[parent]);
+                position = parent;
+            }
+            placeCandidate(position, candidate);
+        }
+
+        void siftDown(size_t position)
+        {
+            Candidate candidate = m_candidates[position];
+            for (;;) {
+                size_t child = position * 2 + 1;
+                if (child >= m_candidates.size())
+                    break;
+                if (child + 1 < m_candidates.size() && m_candidates[child + 1] < m_candidates[child])
+                    ++child;
+                if (!(m_candidates[child] < candidate))
+                    break;
+                placeCandidate(position, m_candidates[child]);
+                position = child;
+            }
+            placeCandidate(position, candidate);
+        }
+
+        void updateCandidate(size_t v, double cost)
+        {
+            size_t position = m_candidatePositions[v];
+            if (m_notQueued == position) {
+                m_candidates.push_back({ cost, v });
+                siftUp(m_candidates.size() - 1);
+                return;
+            }
+            double oldCost = m_candidates[position].cost;
+            m_candidates[position].cost = cost;
+            if (cost < oldCost)
+                siftUp(position);
+            else
+                siftDown(position);
+        }
+
+        void removeCandidate(size_t v)
+        {
+            size_t position = m_candidatePositions[v];
+            if (m_notQueued == position)
+                return;
+            m_candidatePositions[v] = m_notQueued;
+            Candidate last = m_candidates.back();
+            m_candidates.pop_back();
+            if (position == m_candidates.size())
+                return;
+            placeCandidate(position, last);
+            siftUp(position);
+            siftDown(m_candidatePositions[last.vertex]);
+        }
+
+        void requeueCandidate(size_t v)
+        {
+            double cost = 0.0;
+            if (lowerBoundCost(v, &cost))
+                updateCandidate(v, cost);
+            else
+                removeCandidate(v);
+        }
+
+        void collapseEdge(size_t u, size_t v)
+        {
+            for (const auto& t : m_vertexTriangles[u]) {
+                if (!m_triangleAlive[t])
+                    continue;
+                auto& triangle = m_triangles[t];
+                if (triangle[0] == v || triangle[1] == v || triangle[2] == v) {
+                    m_triangleAlive[t] = false;
+                    --m_aliveTriangleCount;
+                    continue;
+                }
+                for (auto& w : triangle) {
+                    if (w == u)
+                        w = v;
+                }
+                m_vertexTriangles[v].push_back(t);
+            }
+            m_vertexTriangles[u].clear();
+            m_removed[u] = true;
+            m_quadrics[v].add(m_quadrics[u]);
+            m_vertexErrors[v] = m_quadrics[v].evaluate(m_vertices[v]);
+
+            // Only alive triangles stay listed around the vertices left, so walking them needs no checks
+            collectNeighbors(v, &m_changedVertices);
+            m_changedVertices.push_back(v);
+            for (const auto& w : m_changedVertices) {
+                auto& triangles = m_vertexTriangles[w];
+                triangles.erase(std::remove_if(triangles.begin(), triangles.end(), [&](size_t t) {
+                    return !m_triangleAlive[t];
+                }),
+                    triangles.end());
+            }
+            for (const auto& w : m_changedVertices)
+                requeueCandidate(w);
+        }
+    };
+
+}
+
+void simplifyTriangles(const std::vector<Vector3>& vertices,
+    const std::vector<std::vector<size_t>>& triangles,
+    size_t targetTriangleCount,
+    std::vector<std::vector<size_t>>* simplifiedTriangles,
+    std::vector<size_t>* triangleSources,
+    const std::vector<size_t>* vertexGroups,
+    const std::vector<bool>* lockedVertices)
+{
+    bool simplifiable = targetTriangleCount < triangles.size();
+    if (nullptr != vertexGroups && vertexGroups->size() != vertices.size())
+        simplifiable = false;
+    if (nullptr != lockedVertices && lockedVertices->size() != vertices.size())
+        simplifiable = false;
+    for (const auto& triangle : triangles) {
+        if (!simplifiable)
+            break;
+        if (3 != triangle.size()) {
+            simplifiable = false;
+            break;
+        }
+        for (const auto& v : triangle) {
+            if (v >= vertices.size())
+                simplifiable = false;
+        }
+    }
+    if (!simplifiable) {
+        *simplifiedTriangles = triangles;
+        if (nullptr != triangleSources) {
+            triangleSources->resize(triangles.size());
+            std::iota(triangleSources->begin(), triangleSources->end(), 0);
+        }
+        return;
+    }
+
+    HalfEdgeCollapser collapser(vertices, triangles, vertexGroups, lockedVertices);
+    collapser.collapse(targetTriangleCount);
+    collapser.fetch(simplifiedTriangles, triangleSources);
+}
+
+void simplifyObject(const Object& object, float ratio, Object* simplifiedObject)
+{
+    bool simplifiable = ratio < 1.0f && !object.triangles.empty();
+    for (const auto& triangle : object.triangles) {
+        if (!simplifiable)
+            break;
+        if (3 != triangle.size()) {
+            simplifiable = false;
+            break;
+        }
+        for (const auto& v : triangle) {
+            if (v >= object.vertices.size())
+                simplifiable = false;
+        }
+    }
+    if (!simplifiable) {
+        *simplifiedObject = object;
+        return;
+    }
+
+    const std::vector<std::vector<Vector2>>* triangleVertexUvs = object.triangleVertexUvs();
+    if (nullptr != triangleVertexUvs && triangleVertexUvs->size() != object.triangles.size())
+        triangleVertexUvs = nullptr;
+
+    // Charts before UV unwrapping: the generated component UVs and both sides of every seam
+    std::vector<size_t> triangleCharts(object.triangles.size(), 0);
+    if (!object.componentTriangleUvs.empty() || !object.seamTriangleUvs.empty()) {
+        std::map<std::array<PositionKey, 3>, size_t> chartMap;
+        size_t chartCount = 0;
+        auto addChart = [&](const std::array<PositionKey, 3>& key, size_t chart) {
+            chartMap[key] = chart;
+            chartMap[{ key[1], key[2], key[0] }] = chart;
+            chartMap[{ key[2], key[0], key[1] }] = chart;
+        };
+        for (const auto& component : object.componentTriangleUvs) {
+            ++chartCount;
+            for (const auto& it : component.second)
+                addChart(it.first, chartCount);
+        }
+        for (const auto& seam : object.seamTriangleUvs) {
+            ++chartCount;
+            for (const auto& key : seam.first)
+                addChart(key, chartCount);
+            ++chartCount;
+            for (const auto& key : seam.second)
+                addChart(key, chartCount);
+        }
+        for (size_t t = 0; t < object.triangles.size(); ++t) {
+            const auto& triangle = object.triangles[t];
+            auto findChart = chartMap.find({ PositionKey(object.vertices[triangle[0]]),
+                PositionKey(object.vertices[triangle[1]]),
+                PositionKey(object.vertices[triangle[2]]) });
+            if (findChart != chartMap.end())
+                triangleCharts[t] = findChart->second;
+        }
+    }
+
+    // A wedge is a vertex as seen from one chart with one UV, so every UV seam turns into a border
+    // between wedges and is locked by the simplifier
+    struct Wedge {
+        size_t vertex;
+        size_t chart;
+        long long u;
+        long long v;
+        Vector2 uv;
+    };
+    std::vector<Wedge> wedges;
+    std::vector<std::vector<size_t>> vertexWedges(object.vertices.size());
+    std::vector<std::vector<size_t>> wedgeTriangles(object.triangles.size());
+    for (size_t t = 0; t < object.triangles.size(); ++t) {
+        const auto& triangle = object.triangles[t];
+        auto& wedgeTriangle = wedgeTriangles[t];
+        wedgeTriangle.resize(3);
+        for (size_t i = 0; i < 3; ++i) {
+            Wedge wedge = { triangle[i], triangleCharts[t], 0, 0, Vector2() };
+            if (nullptr != triangleVertexUvs && i < (*triangleVertexUvs)[t].size()) {
+                wedge.uv = (*triangleVertexUvs)[t][i];
+                wedge.u = std::llround(wedge.uv.x() * 1000000.0);
+                wedge.v = std::llround(wedge.uv.y() * 1000000.0);
+            }
+            size_t wedgeIndex = wedges.size();
+            for (const auto& candidate : vertexWedges[triangle[i]]) {
+                const auto& existing = wedges[candidate];
+                if (existing.chart == wedge.chart && existing.u == wedge.u && existing.v == wedge.v) {
+                    wedgeIndex = candidate;
+                    break;
+                }
+            }
+            if (wedgeIndex == wedges.size()) {
+                vertexWedges[triangle[i]].push_back(wedgeIndex);
+                wedges.push_back(wedge);
+            }
+            wedgeTriangle[i] = wedgeIndex;
+        }
+    }
+
+    // Vertices of different colors or bone bindings are kept apart
+    std::vector<size_t> vertexGroups(object.vertices.size(), 0);
+    {
+        bool hasColors = object.vertexColors.size() == object.vertices.size();
+        bool hasBones = object.vertexBone1.size() == object.vertices.size()
+            && object.vertexBone2.size() == object.vertices.size();
+        std::map<std::tuple<double, double, double, double, int, int>, size_t> groupMap;
+        for (size_t v = 0; v < object.vertices.size(); ++v) {
+            std::tuple<double, double, double, double, int, int> key(0.0, 0.0, 0.0, 0.0, -1, -1);
+            if (hasColors) {
+                const auto& color = object.vertexColors[v];
+                std::get<0>(key) = color.r();
+                std::get<1>(key) = color.g();
+                std::get<2>(key) = color.b();
+                std::get<3>(key) = color.alpha();
+            }
+            if (hasBones) {
+                std::get<4>(key) = object.vertexBone1[v].first;
+                std::get<5>(key) = object.vertexBone2[v].first;
+            }
+            vertexGroups[v] = groupMap.insert({ key, groupMap.size() }).first->second;
+        }
+    }
+
+    // Parts are the components generating the triangles, in order of their first triangle. A CSG union usually
+    // leaves one connected surface, so components are what actually spreads the work over threads.
+    // Triangles with no source node on any corner, like the thin strips along some union seams, go together
+    std::vector<Uuid> vertexComponentIds(object.vertices.size());
+    if (object.vertexSourceNodes.size() == object.vertices.size()) {
+        std::vector<Uuid> sourceNodeComponentIds(object.vertexSourceNodeIds.size());
+        for (size_t i = 0; i < object.vertexSourceNodeIds.size(); ++i) {
+            auto findNode = object.nodeMap.find(object.vertexSourceNodeIds[i]);
+            if (findNode != object.nodeMap.end())
+                sourceNodeComponentIds[i] = findNode->second.componentId;
+        }
+        for (size_t v = 0; v < object.vertices.size(); ++v) {
+            int sourceNode = object.vertexSourceNodes[v];
+            if (sourceNode >= 0 && (size_t)sourceNode < sourceNodeComponentIds.size())
+                vertexComponentIds[v] = sourceNodeComponentIds[sourceNode];
+        }
+    }
+    std::unordered_map<Uuid, size_t> componentToPartMap;
+    std::vector<std::vector<size_t>> partTriangles;
+    std::vector<size_t> triangleParts(object.triangles.size());
+    for (size_t t = 0; t < object.triangles.size(); ++t) {
+        Uuid componentId;
+        for (const auto& v : object.triangles[t]) {
+            if (!vertexComponentIds[v].isNull()) {
+                componentId = vertexComponentIds[v];
+                break;
+            }
+        }
+        auto insertResult = componentToPartMap.insert({ componentId, partTriangles.size() });
+        if (insertResult.second)
+            partTriangles.emplace_back();
+        partTriangles[insertResult.first->second].push_back(t);
+        triangleParts[t] = insertResult.first->second;
+    }
+
+    // Wedges used by more than one part are on the boundary between them and stay where they are,
+    // so the parts can be simplified independently without opening cracks
+    std::vector<size_t> wedgeParts(wedges.size(), (size_t)-1);
+    std::vector<bool> sharedWedges(wedges.size(), false);
+    for (size_t t = 0; t < wedgeTriangles.size(); ++t) {
+        for (const auto& wedge : wedgeTriangles[t]) {
+            if ((size_t)-1 == wedgeParts[wedge])
+                wedgeParts[wedge] = triangleParts[t];
+            else if (wedgeParts[wedge] != triangleParts[t])
+                sharedWedges[wedge] = true;
+        }
+    }
+
+    std::vector<std::vector<std::vector<size_t>>> partSimplifiedTriangles(partTriangles.size());
+    std::vector<std::vector<size_t>> partTriangleSources(partTriangles.size());
+    parallelFor(partTriangles.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t part = begin; part < end; ++part) {
+            const auto& sourceTriangles = partTriangles[part];
+            std::map<size_t, size_t> wedgeToLocalMap;
+            std::vector<size_t> localToWedge;
+            std::vector<Vector3> localVertices;
+            std::vector<size_t> localGroups;
+            std::vector<bool> localLocked;
+            std::vector<std::vector<size_t>> localTriangles;
+            localTriangles.reserve(sourceTriangles.size());
+            for (const auto& t : sourceTriangles) {
+                std::vector<size_t> localTriangle(3);
+                for (size_t i = 0; i < 3; ++i) {
+                    size_t wedge = wedgeTriangles[t][i];
+                    auto insertResult = wedgeToLocalMap.insert({ wedge, localToWedge.size() });
+                    if (insertResult.second) {
+                        localToWedge.push_back(wedge);
+                        localVertices.push_back(object.vertices[wedges[wedge].vertex]);
+                        localGroups.push_back(vertexGroups[wedges[wedge].vertex]);
+                        localLocked.push_back(sharedWedges[wedge]);
+                    }
+                    localTriangle[i] = insertResult.first->second;
+                }
+                localTriangles.push_back(localTriangle);
+            }
+            size_t targetTriangleCount = (size_t)std::ceil(ratio * sourceTriangles.size());
+            std::vector<std::vector<size_t>> simplifiedTriangles;
+            std::vector<size_t> triangleSources;
+            simplifyTriangles(localVertices, localTriangles, targetTriangleCount,
+                &simplifiedTriangles, &triangleSources, &localGroups, &localLocked);
+            for (auto& triangle : simplifiedTriangles) {
+                for (auto& v : triangle)
+                    v = localToWedge[v];
+            }
+            for (auto& source : triangleSources)
+                source = sourceTriangles[source];
+            partSimplifiedTriangles[part] = std::move(simplifiedTriangles);
+            partTriangleSources[part] = std::move(triangleSources);
+        }
+    });
+
+    std::vector<std::vector<size_t>> resultWedgeTriangles;
+    std::vector<size_t> resultTriangleSources;
+    for (size_t part = 0; part < partTriangles.size(); ++part) {
+        resultWedgeTriangles.insert(resultWedgeTriangles.end(), partSimplifiedTriangles[part].begin(), partSimplifiedTriangles[part].end());
+        resultTriangleSources.insert(resultTriangleSources.end(), partTriangleSources[part].begin(), partTriangleSources[part].end());
+    }
+
+    std::vector<size_t> newVertexIndices(object.vertices.size(), (size_t)-1);
+    for (const auto& triangle : resultWedgeTriangles) {
+        for (const auto& wedge : triangle)
+            newVertexIndices[wedges[wedge].vertex] = 0;
+    }
+
+    Object result;
+    for (size_t v = 0; v < object.vertices.size(); ++v) {
+        if ((size_t)-1 == newVertexIndices[v])
+            continue;
+        newVertexIndices[v] = result.vertices.size();
+        result.vertices.push_back(object.vertices[v]);
+        if (object.vertexColors.size() == object.vertices.size())
+            result.vertexColors.push_back(object.vertexColors[v]);
+        if (object.vertexSmoothCutoffDegrees.size() == object.vertices.size())
+            result.vertexSmoothCutoffDegrees.push_back(object.vertexSmoothCutoffDegrees[v]);
+        if (object.vertexSourceNodes.size() == object.vertices.size())
+            result.vertexSourceNodes.push_back(object.vertexSourceNodes[v]);
+        if (object.vertexBone1.size() == object.vertices.size())
+            result.vertexBone1.push_back(object.vertexBone1[v]);
+        if (object.vertexBone2.size() == object.vertices.size())
+            result.vertexBone2.push_back(object.vertexBone2[v]);
+    }
+    result.positionToNodeIdMap = object.positionToNodeIdMap;
+    result.nodeMap = object.nodeMap;
+    result.componentTriangleUvs = object.componentTriangleUvs;
+    result.seamTriangleUvs = object.seamTriangleUvs;
+    result.brokenTrianglesToComponentIdMap = object.brokenTrianglesToComponentIdMap;
+    result.vertexSourceNodeIds = object.vertexSourceNodeIds;
+    result.boneNames = object.boneNames;
+    result.alphaEnabled = object.alphaEnabled;
+    result.meshId = object.meshId;
+    if (nullptr != object.partUvRects())
+        result.setPartUvRects(*object.partUvRects());
+
+    result.triangles.reserve(resultWedgeTriangles.size());
+    result.triangleNormals.reserve(resultWedgeTriangles.size());
+    for (const auto& wedgeTriangle : resultWedgeTriangles) {
+        std::vector<size_t> triangle = {
+            newVertexIndices[wedges[wedgeTriangle[0]].vertex],
+            newVertexIndices[wedges[wedgeTriangle[1]].vertex],
+            newVertexIndices[wedges[wedgeTriangle[2]].vertex]
+        };
+        result.triangleNormals.push_back(Vector3::normal(result.vertices[triangle[0]],
+            result.vertices[triangle[1]],
+            result.vertices[triangle[2]]));
+        result.triangles.push_back(triangle);
+    }
+
+    if (nullptr != object.triangleVertexNormals()) {
+        std::vector<std::vector<Vector3>> triangleVertexNormals;
+        smoothNormal(result.vertices, result.triangles, result.triangleNormals,
+            result.vertexSmoothCutoffDegrees.size() == result.vertices.size() ? &result.vertexSmoothCutoffDegrees : nullptr,
+            &triangleVertexNormals);
+        result.setTriangleVertexNormals(triangleVertexNormals);
+    }
+
+    if (nullptr != triangleVertexUvs) {
+        std::vector<std::vector<Vector2>> uvs(resultWedgeTriangles.size());
+        for (size_t t = 0; t < resultWedgeTriangles.size(); ++t) {
+            for (const auto& wedge : resultWedgeTriangles[t])
+                uvs[t].push_back(wedges[wedge].uv);
+        }
+        result.setTriangleVertexUvs(uvs);
+        if (nullptr != object.triangleTangents()) {
+            std::vector<Vector3> tangents;
+            resolveTriangleTangent(result, tangents);
+            result.setTriangleTangents(tangents);
+        }
+    }
+
+    const std::vector<std::pair<Uuid, Uuid>>* triangleSourceNodes = object.triangleSourceNodes();
+    if (nullptr != triangleSourceNodes && triangleSourceNodes->size() == object.triangles.size()) {
+        std::vector<std::pair<Uuid, Uuid>> sourceNodes;
+        sourceNodes.reserve(resultTriangleSources.size());
+        for (const auto& source : resultTriangleSources)
+            sourceNodes.push_back((*triangleSourceNodes)[source]);
+        result.setTriangleSourceNodes(sourceNodes);
+    }
+
+    // Parts are collected one after another and collapses move their vertices, so the order the
+    // source object was drawn in is gone, the level is ordered for the vertex cache again
+    optimizeTriangleOrder(&result);
+    result.triangleAndQuads = result.triangles;
+
+    *simplifiedObject = std::move(result);
+}
+
+}
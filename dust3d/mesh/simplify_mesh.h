@@ -0,0 +1,54 @@
+/*
+ *  Copyright (c) 2016-2026 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef DUST3D_MESH_SIMPLIFY_MESH_H_
+#define DUST3D_MESH_SIMPLIFY_MESH_H_
+
+#include <dust3d/base/object.h>
+#include <dust3d/base/vector3.h>
+#include <vector>
+
+namespace dust3d {
+
+// Quadric error metric simplification (Garland and Heckbert 1997) restricted to half edge collapses,
+// so the result only refers to input vertices and any per vertex data stays valid as it is.
+// Vertices on open or non-manifold borders, vertices with neighbors of another vertexGroups entry
+// and vertices set in lockedVertices are never removed, so borders and group boundaries come out exactly as they went in.
+// Surviving triangles keep their input order, triangleSources receives their input indices.
+// The result only depends on the input, not on timing, so it is safe to run parts concurrently.
+void simplifyTriangles(const std::vector<Vector3>& vertices,
+    const std::vector<std::vector<size_t>>& triangles,
+    size_t targetTriangleCount,
+    std::vector<std::vector<size_t>>* simplifiedTriangles,
+    std::vector<size_t>* triangleSources = nullptr,
+    const std::vector<size_t>* vertexGroups = nullptr,
+    const std::vector<bool>* lockedVertices = nullptr);
+
+// Simplifies the triangles of every source component of the object to about ratio of their count, components
+// run side by side and the vertices they share are kept.
+// UV seams, vertex color borders and bone binding borders are kept; normals, tangents and quads are rebuilt
+// and vertices no longer used are dropped.
+void simplifyObject(const Object& object, float ratio, Object* simplifiedObject);
+
+}
+
+#endif
@@ -44,6 +44,11 @@ SolidMeshBooleanOperation::SolidMeshBooleanOperation(const SolidMesh* m_firstMes
 {
 }
 
+void SolidMeshBooleanOperation::setCancellationToken(const CancellationToken* cancellationToken)
+{
+    m_cancellationToken = cancellationToken;
+}
+
 SolidMeshBooleanOperation::~SolidMeshBooleanOperation()
 {
 }
@@ -288,6 +293,8 @@ bool SolidMeshBooleanOperation::addUnintersectedTriangles(const SolidMesh* mesh,
 bool SolidMeshBooleanOperation::combine()
 {
     searchPotentialIntersectedPairs();
+    if (CancellationToken::isCancelled(m_cancellationToken))
+        return false;
 
     struct IntersectedContext {
         std::vector<Vector3> points;
@@ -305,7 +312,10 @@ bool SolidMeshBooleanOperation::combine()
         return insertResult.first->second;
     };
 
-    for (const auto& pair : m_potentialIntersectedPairs) {
+    for (size_t pairIndex = 0; pairIndex < m_potentialIntersectedPairs.size(); ++pairIndex) {
+        if (0 == (pairIndex & 0x3ff) && CancellationToken::isCancelled(m_cancellationToken))
+            return false;
+        const auto& pair = m_potentialIntersectedPairs[pairIndex];
         std::pair<Vector3, Vector3> newEdge;
         if (intersectTwoFaces(pair.first, pair.second, newEdge)) {
             m_firstIntersectedFaces.insert(pair.first);
@@ -392,6 +402,9 @@ bool SolidMeshBooleanOperation::combine()
         return true;
     };
 
+    if (CancellationToken::isCancelled(m_cancellationToken))
+        return false;
+
     size_t firstRemainingStartTriangleIndex = m_newTriangles.size();
     if (!addUnintersectedTriangles(m_firstMesh, m_firstIntersectedFaces, &firstHalfEdges)) {
         dust3dDebug << "Add first mesh remaining triangles failed";
@@ -415,6 +428,9 @@ bool SolidMeshBooleanOperation::combine()
         return false;
     }
 
+    if (CancellationToken::isCancelled(m_cancellationToken))
+        return false;
+
     if (!buildPolygonsFromEdges(firstEdges, firstIntersections)) {
         dust3dDebug << "Build polygons from edges failed";
         return false;
@@ -433,6 +449,9 @@ bool SolidMeshBooleanOperation::combine()
         secondRemainingTriangleCount,
         m_secondTriangleGroups);
 
+    if (CancellationToken::isCancelled(m_cancellationToken))
+        return false;
+
     decideGroupSide(m_firstTriangleGroups,
         m_secondMesh,
         m_secondMesh->axisAlignedBoundingBoxTree(),
@@ -23,6 +23,7 @@
 #ifndef DUST3D_MESH_SOLID_MESH_BOOLEAN_OPERATION_H_
 #define DUST3D_MESH_SOLID_MESH_BOOLEAN_OPERATION_H_
 
+#include <dust3d/base/cancellation_token.h>
 #include <dust3d/base/position_key.h>
 #include <dust3d/base/vector3.h>
 #include <dust3d/mesh/solid_mesh.h>
@@ -36,6 +37,7 @@ public:
     SolidMeshBooleanOperation(const SolidMesh* firstMesh,
         const SolidMesh* secondMesh);
     ~SolidMeshBooleanOperation();
+    void setCancellationToken(const CancellationToken* cancellationToken);
     bool combine();
     void fetchUnion(std::vector<std::vector<size_t>>& resultTriangles);
     void fetchDiff(std::vector<std::vector<size_t>>& resultTriangles);
@@ -46,6 +48,7 @@ public:
 private:
     const SolidMesh* m_firstMesh = nullptr;
     const SolidMesh* m_secondMesh = nullptr;
+    const CancellationToken* m_cancellationToken = nullptr;
     std::vector<std::pair<size_t, size_t>> m_potentialIntersectedPairs;
     std::vector<Vector3> m_newVertices;
     std::vector<std::vector<size_t>> m_newTriangles;
@@ -92,6 +92,12 @@ public:
         m_baseNormal = BaseNormal::calculateTubeBaseNormal(positions);
         if (m_baseNormal.isZero())
             m_baseNormal = Vector3(1, 0, 0);
+
+        // Cross-section frames only depend on the segment, so every vertex shares them
+        m_segmentRights.resize(meshNodes.size());
+        m_segmentUps.resize(meshNodes.size());
+        for (size_t i = 0; i < meshNodes.size(); ++i)
+            computeCrossSectionBasis(i, &m_segmentRights[i], &m_segmentUps[i]);
     }
 
     // Map a source vertex onto the spine.
@@ -153,24 +159,25 @@ public:
     }
 
 private:
+    // The segment whose far node is the first one reaching targetDist, found by
+    // binary search over the cumulative spine distances
     size_t segmentForDistance(double targetDist) const
     {
-        size_t segIdx = 0;
-        for (size_t i = 1; i < m_meshNodes.size(); ++i) {
-            if (m_spineDistances[i] >= targetDist) {
-                segIdx = i - 1;
-                break;
-            }
-            segIdx = i - 1;
-        }
         if (m_meshNodes.size() < 2)
-            segIdx = 0;
-        else if (segIdx + 1 >= m_meshNodes.size())
-            segIdx = m_meshNodes.size() - 2;
-        return segIdx;
+            return 0;
+        auto findNode = std::lower_bound(m_spineDistances.begin() + 1, m_spineDistances.end(), targetDist);
+        if (findNode == m_spineDistances.end())
+            return m_meshNodes.size() - 2;
+        return (size_t)(findNode - m_spineDistances.begin()) - 1;
     }
 
     void crossSectionBasis(size_t segIdx, Vector3* right, Vector3* realUp) const
+    {
+        *right = m_segmentRights[segIdx];
+        *realUp = m_segmentUps[segIdx];
+    }
+
+    void computeCrossSectionBasis(size_t segIdx, Vector3* right, Vector3* realUp) const
     {
         Vector3 forward = m_spineForwards[segIdx];
         // Re-orthogonalise the global base normal against the local forward
@@ -199,6 +206,8 @@ private:
     double m_totalSpineLength = 0.0001;
     std::vector<Vector3> m_spineForwards;
     Vector3 m_baseNormal;
+    std::vector<Vector3> m_segmentRights;
+    std::vector<Vector3> m_segmentUps;
 };
 
 }
@@ -0,0 +1,195 @@
+/*
+ *  Copyright (c) 2016-2026 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <dust3d/base/parallel.h>
+#include <dust3d/mesh/write_obj.h>
+#include <thread>
+#include <vector>
+
+namespace dust3d {
+
+namespace {
+
+    const size_t g_linesPerChunk = 16384;
+
+    void appendNumber(std::string& text, float value)
+    {
+        char digits[32];
+#if defined(__APPLE__)
+        // Floating point to_chars is missing from older macOS deployment targets, nine significant digits still round-trip;
+        // printf follows the locale the application set, which may use a decimal comma
+        int length = std::max(0, std::min((int)sizeof(digits) - 1, std::snprintf(digits, sizeof(digits), "%.9g", value)));
+        std::replace(digits, digits + length, ',', '.');
+        text.append(digits, (size_t)length);
+#else
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        text.append(digits, result.ptr);
+#endif
+    }
+
+    void appendNumber(std::string& text, size_t value)
+    {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        text.append(digits, result.ptr);
+    }
+
+    // Formats runs of lines chunk by chunk, a batch of chunks at a time, one thread per chunk,
+    // into buffers which keep their capacity from one batch and one section to the next
+    class ObjChunkWriter {
+    public:
+        ObjChunkWriter(const std::function<bool(const char* data, size_t size)>& write)
+            : m_write(write)
+            , m_buffers(std::max<size_t>(1, std::thread::hardware_concurrency()) * 2)
+        {
+        }
+
+        template <typename FormatLine>
+        bool writeLines(size_t lineCount, FormatLine formatLine)
+        {
+            size_t chunkCount = (lineCount + g_linesPerChunk - 1) / g_linesPerChunk;
+            for (size_t batchBegin = 0; batchBegin < chunkCount; batchBegin += m_buffers.size()) {
+                size_t batchSize = std::min(m_buffers.size(), chunkCount - batchBegin);
+                parallelFor(batchSize, 1, [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; ++i) {
+                        std::string& buffer = m_buffers[i];
+                        buffer.clear();
+                        size_t lineBegin = (batchBegin + i) * g_linesPerChunk;
+                        size_t lineEnd = std::min(lineCount, lineBegin + g_linesPerChunk);
+                        for (size_t line = lineBegin; line < lineEnd; ++line)
+                            formatLine(line, buffer);
+                    }
+                });
+                for (size_t i = 0; i < batchSize; ++i) {
+                    if (!m_write(m_buffers[i].data(), m_buffers[i].size()))
+                        return false;
+                }
+            }
+            return true;
+        }
+
+    private:
+        const std::function<bool(const char* data, size_t size)>& m_write;
+        std::vector<std::string> m_buffers;
+    };
+
+}
+
+bool writeObj(const Object& object,
+    const std::string& header,
+    bool withNormals,
+    bool withUvs,
+    bool withVertexColors,
+    const std::function<bool(const char* data, size_t size)>& write)
+{
+    const std::vector<std::vector<Vector3>>* triangleVertexNormals = object.triangleVertexNormals();
+    const std::vector<std::vector<Vector2>>* triangleVertexUvs = object.triangleVertexUvs();
+    withNormals = withNormals && nullptr != triangleVertexNormals && triangleVertexNormals->size() == object.triangles.size();
+    withUvs = withUvs && nullptr != triangleVertexUvs && triangleVertexUvs->size() == object.triangles.size();
+    withVertexColors = withVertexColors && object.vertexColors.size() == object.vertices.size();
+
+    if (!header.empty() && !write(header.data(), header.size()))
+        return false;
+
+    ObjChunkWriter writer(write);
+
+    if (!writer.writeLines(object.vertices.size(), [&](size_t i, std::string& text) {
+            const Vector3& position = object.vertices[i];
+            text += "v ";
+            appendNumber(text, (float)position.x());
+            text += ' ';
+            appendNumber(text, (float)position.y());
+            text += ' ';
+            appendNumber(text, (float)position.z());
+            if (withVertexColors) {
+                const Color& color = object.vertexColors[i];
+                text += ' ';
+                appendNumber(text, (float)color.r());
+                text += ' ';
+                appendNumber(text, (float)color.g());
+                text += ' ';
+                appendNumber(text, (float)color.b());
+            }
+            text += '\n';
+        }))
+        return false;
+
+    if (!withNormals && !withUvs) {
+        const std::vector<std::vector<size_t>>& faces = object.triangleAndQuads.empty() ? object.triangles : object.triangleAndQuads;
+        return writer.writeLines(faces.size(), [&](size_t i, std::string& text) {
+            text += 'f';
+            for (const auto& index : faces[i]) {
+                text += ' ';
+                appendNumber(text, index + 1);
+            }
+            text += '\n';
+        });
+    }
+
+    // One UV and one normal per triangle corner, numbered as the corners are
+    size_t cornerCount = object.triangles.size() * 3;
+    if (withUvs) {
+        if (!writer.writeLines(cornerCount, [&](size_t i, std::string& text) {
+                const Vector2& uv = (*triangleVertexUvs)[i / 3][i % 3];
+                text += "vt ";
+                appendNumber(text, (float)uv.x());
+                text += ' ';
+                appendNumber(text, (float)uv.y());
+                text += '\n';
+            }))
+            return false;
+    }
+    if (withNormals) {
+        if (!writer.writeLines(cornerCount, [&](size_t i, std::string& text) {
+                const Vector3& normal = (*triangleVertexNormals)[i / 3][i % 3];
+                text += "vn ";
+                appendNumber(text, (float)normal.x());
+                text += ' ';
+                appendNumber(text, (float)normal.y());
+                text += ' ';
+                appendNumber(text, (float)normal.z());
+                text += '\n';
+            }))
+            return false;
+    }
+    return writer.writeLines(object.triangles.size(), [&](size_t i, std::string& text) {
+        text += 'f';
+        for (size_t j = 0; j < 3; ++j) {
+            size_t corner = i * 3 + j + 1;
+            text += ' ';
+            appendNumber(text, object.triangles[i][j] + 1);
+            text += '/';
+            if (withUvs)
+                appendNumber(text, corner);
+            if (withNormals) {
+                text += '/';
+                appendNumber(text, corner);
+            }
+        }
+        text += '\n';
+    });
+}
+
+}
@@ -0,0 +1,48 @@
+/*
+ *  Copyright (c) 2016-2026 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef DUST3D_MESH_WRITE_OBJ_H_
+#define DUST3D_MESH_WRITE_OBJ_H_
+
+#include <cstddef>
+#include <dust3d/base/object.h>
+#include <functional>
+#include <string>
+
+namespace dust3d {
+
+// Writes the object as Wavefront OBJ text, starting with the header as it is given.
+// The lines are formatted in parallel, in chunks, and handed to write in file order;
+// write returns false on an output error, which stops the export and is returned.
+// Faces are the triangles and quads of the object, unless normals or UVs are written,
+// then they are its triangles, each corner referring to a normal and UV of its own.
+// Vertex colors are appended to the v lines, the way most OBJ readers accept them.
+bool writeObj(const Object& object,
+    const std::string& header,
+    bool withNormals,
+    bool withUvs,
+    bool withVertexColors,
+    const std::function<bool(const char* data, size_t size)>& write);
+
+}
+
+#endif
@@ -24,12 +24,14 @@
 #include <cmath>
 #include <dust3d/base/debug.h>
 #include <dust3d/base/matrix4x4.h>
+#include <dust3d/base/parallel.h>
 #include <dust3d/base/part_target.h>
 #include <dust3d/base/position_key.h>
 #include <dust3d/base/quaternion.h>
 #include <dust3d/base/string.h>
 #include <dust3d/base/vector3.h>
 #include <dust3d/rig/rig_generator.h>
+#include <functional>
 #include <limits>
 
 namespace dust3d {
@@ -48,35 +50,6 @@ static bool targetPartIsModel(const Snapshot* snapshot, const std::string& partI
     return PartTarget::Model == target || PartTarget::StitchingLine == target || PartTarget::StitchingLoop == target || PartTarget::ImportedModel == target;
 }
 
-static bool nodeBelongsToModelPart(const Snapshot* snapshot, const Uuid& nodeId)
-{
-    if (!snapshot)
-        return false;
-
-    auto it = snapshot->nodes.find(nodeId.toString());
-    if (it == snapshot->nodes.end())
-        return false;
-
-    return targetPartIsModel(snapshot, String::valueOrEmpty(it->second, "partId"));
-}
-
-static bool edgeBelongsToModelPart(const Snapshot* snapshot,
-    const std::map<std::string, std::string>& edgeAttributes)
-{
-    if (!snapshot)
-        return false;
-
-    std::string fromNode = String::valueOrEmpty(edgeAttributes, "from");
-    std::string toNode = String::valueOrEmpty(edgeAttributes, "to");
-    if (fromNode.empty() || toNode.empty())
-        return false;
-
-    Uuid fromId(fromNode);
-    Uuid toId(toNode);
-    return nodeBelongsToModelPart(snapshot, fromId)
-        && nodeBelongsToModelPart(snapshot, toId);
-}
-
 static bool boneUsesParentEndAsReference(const std::string& boneName)
 {
     return boneName.find("Left") != std::string::npos
@@ -121,35 +94,20 @@ bool RigGenerator::generateRig(const Snapshot* snapshot, const RigStructure& tem
         boneNameToIndex[actualRig.bones[i].name] = i;
     }
 
-    // Pre-collect edge connectivity info in a single pass over edges:
+    buildSnapshotIndex(snapshot);
+
+    // Edge connectivity info from the snapshot index:
     // - allEdgeNodes: nodes that appear in any bone-assigned edge
     // - boneEdgeNodesMap: bone name -> set of nodes in edges assigned to that bone
-    // - nodesWithAnyEdge: nodes that appear in ANY model edge (even without bone assignment)
     std::set<Uuid> allEdgeNodes;
     std::map<std::string, std::set<Uuid>> boneEdgeNodesMap;
-    std::set<Uuid> nodesWithAnyEdge;
-    for (const auto& edgePair : snapshot->edges) {
-        const auto& edgeAttributes = edgePair.second;
-        if (!edgeBelongsToModelPart(snapshot, edgeAttributes))
-            continue;
-        std::string fromNode = String::valueOrEmpty(edgeAttributes, "from");
-        std::string toNode = String::valueOrEmpty(edgeAttributes, "to");
-        if (!fromNode.empty())
-            nodesWithAnyEdge.insert(Uuid(fromNode));
-        if (!toNode.empty())
-            nodesWithAnyEdge.insert(Uuid(toNode));
-        std::string edgeBoneName = String::valueOrEmpty(edgeAttributes, "boneName");
-        if (edgeBoneName.empty())
-            continue;
-        if (!fromNode.empty()) {
-            Uuid id(fromNode);
-            allEdgeNodes.insert(id);
-            boneEdgeNodesMap[edgeBoneName].insert(id);
-        }
-        if (!toNode.empty()) {
-            Uuid id(toNode);
-            allEdgeNodes.insert(id);
-            boneEdgeNodesMap[edgeBoneName].insert(id);
+    for (const auto& boneEdgesIt : m_snapshotIndex.boneEdges) {
+        auto& boneEdgeNodes = boneEdgeNodesMap[boneEdgesIt.first];
+        for (const auto& edge : boneEdgesIt.second) {
+            allEdgeNodes.insert(edge.first);
+            allEdgeNodes.insert(edge.second);
+            boneEdgeNodes.insert(edge.first);
+            boneEdgeNodes.insert(edge.second);
         }
     }
 
@@ -188,7 +146,7 @@ bool RigGenerator::generateRig(const Snapshot* snapshot, const RigStructure& tem
         auto& bone = actualRig.bones[boneIdx];
 
         std::vector<std::vector<Uuid>> nodeChains;
-        if (!extractNodeChainsForBone(snapshot, bone.name, nodeChains)) {
+        if (!extractNodeChainsForBone(bone.name, nodeChains)) {
             dust3dDebug << "No edges assigned to bone:" << bone.name;
             if (bone.parent.empty()) {
                 // Root bone with no bindings: give it a tiny upward tail so it has
@@ -201,8 +159,8 @@ bool RigGenerator::generateRig(const Snapshot* snapshot, const RigStructure& tem
         // Attach truly isolated nodes (no edges at all) to this bone
         // if they are nearest to this bone's edge-connected nodes.
         if (!boneEdgeNodesMap[bone.name].empty()) {
-            attachSingleNodesToBone(snapshot, bone.name,
-                boneEdgeNodesMap[bone.name], allEdgeNodes, nodesWithAnyEdge, nodeChains);
+            attachSingleNodesToBone(bone.name,
+                boneEdgeNodesMap[bone.name], allEdgeNodes, m_snapshotIndex.nodesWithAnyEdge, nodeChains);
         }
 
         // Determine reference point from parent bone position.
@@ -228,15 +186,15 @@ bool RigGenerator::generateRig(const Snapshot* snapshot, const RigStructure& tem
 
         // Orient each chain so its end closest to the reference comes first
         for (auto& chain : nodeChains) {
-            orientChainTowardPoint(snapshot, chain, refX, refY, refZ);
+            orientChainTowardPoint(chain, refX, refY, refZ);
         }
 
         // Sort chains by distance of their front node to the reference
         std::sort(nodeChains.begin(), nodeChains.end(),
             [&](const std::vector<Uuid>& a, const std::vector<Uuid>& b) {
                 float ax = 0, ay = 0, az = 0, bx = 0, by = 0, bz = 0;
-                getNodePosition(snapshot, a.front(), ax, ay, az);
-                getNodePosition(snapshot, b.front(), bx, by, bz);
+                getNodePosition(a.front(), ax, ay, az);
+                getNodePosition(b.front(), bx, by, bz);
                 float da = (ax - refX) * (ax - refX) + (ay - refY) * (ay - refY) + (az - refZ) * (az - refZ);
                 float db = (bx - refX) * (bx - refX) + (by - refY) * (by - refY) + (bz - refZ) * (bz - refZ);
                 return da < db;
@@ -256,7 +214,7 @@ bool RigGenerator::generateRig(const Snapshot* snapshot, const RigStructure& tem
 
         for (const auto& chain : nodeChains) {
             float fx, fy, fz, bx, by, bz;
-            if (getNodePosition(snapshot, chain.front(), fx, fy, fz) && getNodePosition(snapshot, chain.back(), bx, by, bz)) {
+            if (getNodePosition(chain.front(), fx, fy, fz) && getNodePosition(chain.back(), bx, by, bz)) {
                 sumBeginX += fx;
                 sumBeginY += fy;
                 sumBeginZ += fz;
@@ -291,7 +249,7 @@ bool RigGenerator::generateRig(const Snapshot* snapshot, const RigStructure& tem
                 for (const auto& chain : nodeChains) {
                     float px, py, pz;
                     for (const Uuid& endNode : { chain.front(), chain.back() }) {
-                        if (!getNodePosition(snapshot, endNode, px, py, pz))
+                        if (!getNodePosition(endNode, px, py, pz))
                             continue;
                         float t = (px - avgBeginX) * dx + (py - avgBeginY) * dy + (pz - avgBeginZ) * dz;
                         if (firstProjection) {
@@ -747,7 +705,7 @@ bool RigGenerator::generateRig(const Snapshot* snapshot, const RigStructure& tem
         }
         if (headBone && jawBone) {
             std::vector<std::vector<Uuid>> jawChains;
-            if (extractNodeChainsForBone(snapshot, jawBone->name, jawChains)) {
+            if (extractNodeChainsForBone(jawBone->name, jawChains)) {
                 float startX = headBone->posX;
                 float startY = headBone->posY;
                 float startZ = headBone->posZ;
@@ -759,7 +717,7 @@ bool RigGenerator::generateRig(const Snapshot* snapshot, const RigStructure& tem
                 for (const auto& chain : jawChains) {
                     for (const auto& nodeId : chain) {
                         float nx = 0, ny = 0, nz = 0;
-                        if (!getNodePosition(snapshot, nodeId, nx, ny, nz))
+                        if (!getNodePosition(nodeId, nx, ny, nz))
                             continue;
                         float dx = nx - startX;
                         float dy = ny - startY;
@@ -834,19 +792,13 @@ bool RigGenerator::generateRig(const Snapshot* snapshot, const RigStructure& tem
         std::vector<std::vector<Uuid>> nodeChains;
         float radiusSum = 0.0f;
         size_t radiusCount = 0;
-        if (extractNodeChainsForBone(snapshot, bone.name, nodeChains)) {
+        if (extractNodeChainsForBone(bone.name, nodeChains)) {
             for (const auto& chain : nodeChains) {
                 for (const auto& nodeId : chain) {
-                    float nx = 0, ny = 0, nz = 0;
-                    if (getNodePosition(snapshot, nodeId, nx, ny, nz)) {
-                        auto it = snapshot->nodes.find(nodeId.toString());
-                        if (it != snapshot->nodes.end()) {
-                            float nodeRadius = String::toFloat(String::valueOrEmpty(it->second, "radius"));
-                            if (nodeRadius > 1e-6f) {
-                                radiusSum += nodeRadius;
-                                ++radiusCount;
-                            }
-                        }
+                    auto it = m_snapshotIndex.nodeRadiuses.find(nodeId);
+                    if (it != m_snapshotIndex.nodeRadiuses.end() && it->second > 1e-6f) {
+                        radiusSum += it->second;
+                        ++radiusCount;
                     }
                 }
             }
@@ -1068,33 +1020,16 @@ bool RigGenerator::computeNodeBoneInfluences(const Snapshot* snapshot,
 
     nodeBoneInfluences.clear();
 
-    // Pre-build a map from node -> set of bone names from connected edges (single pass over edges)
-    std::map<std::string, std::set<std::string>> nodeToBoneNames;
-    for (const auto& edgePair : snapshot->edges) {
-        const auto& edgeAttributes = edgePair.second;
-        if (!edgeBelongsToModelPart(snapshot, edgeAttributes))
-            continue;
-        std::string boneName = String::valueOrEmpty(edgeAttributes, "boneName");
-        if (boneName.empty())
-            continue;
-        std::string fromNode = String::valueOrEmpty(edgeAttributes, "from");
-        std::string toNode = String::valueOrEmpty(edgeAttributes, "to");
-        if (!fromNode.empty())
-            nodeToBoneNames[fromNode].insert(boneName);
-        if (!toNode.empty())
-            nodeToBoneNames[toNode].insert(boneName);
-    }
+    // The index built by generateRig is reused when the same snapshot is bound afterwards
+    if (m_snapshotIndex.snapshot != snapshot)
+        buildSnapshotIndex(snapshot);
 
     // For each node in the snapshot, determine which bones influence it
-    for (const auto& nodePair : snapshot->nodes) {
-        const std::string& nodeIdString = nodePair.first;
-        Uuid nodeId(nodeIdString);
+    for (const auto& nodeId : m_snapshotIndex.modelNodes) {
+        const std::string nodeIdString = nodeId.toString();
 
-        if (!nodeBelongsToModelPart(snapshot, nodeId))
-            continue;
-
-        const auto& boneNamesIt = nodeToBoneNames.find(nodeIdString);
-        if (boneNamesIt == nodeToBoneNames.end() || boneNamesIt->second.empty()) {
+        const auto& boneNamesIt = m_snapshotIndex.nodeBoneNames.find(nodeId);
+        if (boneNamesIt == m_snapshotIndex.nodeBoneNames.end() || boneNamesIt->second.empty()) {
             // No bone-assigned edges for this node.
             // Use m_singleNodeBoneMap (populated by attachSingleNodesToBone) for truly isolated nodes.
             auto singleIt = m_singleNodeBoneMap.find(nodeId);
@@ -1158,56 +1093,82 @@ bool RigGenerator::computeVertexBoneBindings(Object* object,
         return false;
     }
 
+    // Bone names are kept once on the object, vertices refer to them by index
+    struct IndexedBinding {
+        int bone1 = -1;
+        float weight1 = 0.0f;
+        int bone2 = -1;
+        float weight2 = 0.0f;
+    };
+    object->boneNames.clear();
+    auto toIndexedBinding = [&](const NodeBoneInfluence& influence) {
+        VertexBoneBinding binding = influence.toVertexBinding();
+        IndexedBinding indexedBinding;
+        indexedBinding.bone1 = object->addBoneName(binding.bone1);
+        indexedBinding.weight1 = binding.weight1;
+        indexedBinding.bone2 = object->addBoneName(binding.bone2);
+        indexedBinding.weight2 = binding.weight2;
+        return indexedBinding;
+    };
+
     // Initialize vertex bone arrays parallel to vertices
-    object->vertexBone1.resize(object->vertices.size());
-    object->vertexBone2.resize(object->vertices.size());
-
-    // For each vertex, trace back to its source node and apply bone influence
-    for (size_t i = 0; i < object->vertices.size(); ++i) {
-        const Vector3& vertexPos = object->vertices[i];
-        PositionKey posKey(vertexPos);
-
-        // Find source node for this vertex
-        auto it = object->positionToNodeIdMap.find(posKey);
-        if (it == object->positionToNodeIdMap.end()) {
-            // Vertex has no source node mapping
-            continue;
-        }
+    object->vertexBone1.assign(object->vertices.size(), { -1, 0.0f });
+    object->vertexBone2.assign(object->vertices.size(), { -1, 0.0f });
 
-        Uuid nodeId = it->second;
+    auto storeBinding = [&](size_t vertexIndex, const IndexedBinding& binding) {
+        object->vertexBone1[vertexIndex] = { binding.bone1, binding.weight1 };
+        object->vertexBone2[vertexIndex] = { binding.bone2, binding.weight2 };
+    };
 
-        // Look up bone influence for this node
-        auto boneIt = nodeBoneInfluences.find(nodeId);
-        if (boneIt == nodeBoneInfluences.end()) {
-            // Node has no bone influence
-            continue;
+    if (object->vertexSourceNodes.size() == object->vertices.size()) {
+        // The mesh generator recorded the source node of each vertex, so influences
+        // are resolved once per node and vertices only copy them by index
+        std::vector<IndexedBinding> sourceNodeBindings(object->vertexSourceNodeIds.size());
+        std::vector<bool> sourceNodeBound(object->vertexSourceNodeIds.size(), false);
+        for (size_t k = 0; k < object->vertexSourceNodeIds.size(); ++k) {
+            auto boneIt = nodeBoneInfluences.find(object->vertexSourceNodeIds[k]);
+            if (boneIt == nodeBoneInfluences.end())
+                continue;
+            sourceNodeBindings[k] = toIndexedBinding(boneIt->second);
+            sourceNodeBound[k] = true;
         }
-
-        const NodeBoneInfluence& influence = boneIt->second;
-        VertexBoneBinding binding = influence.toVertexBinding();
-
-        // Store binding in parallel arrays
-        object->vertexBone1[i] = { binding.bone1, binding.weight1 };
-        object->vertexBone2[i] = { binding.bone2, binding.weight2 };
+        parallelFor(object->vertices.size(), 4096, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                int sourceNode = object->vertexSourceNodes[i];
+                if (sourceNode < 0 || !sourceNodeBound[sourceNode])
+                    continue;
+                storeBinding(i, sourceNodeBindings[sourceNode]);
+            }
+        });
+    } else {
+        // Objects not coming from the mesh generator are traced back to nodes by position
+        std::map<Uuid, IndexedBinding> nodeBindings;
+        for (const auto& it : nodeBoneInfluences)
+            nodeBindings[it.first] = toIndexedBinding(it.second);
+        parallelFor(object->vertices.size(), 4096, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                auto it = object->positionToNodeIdMap.find(PositionKey(object->vertices[i]));
+                if (it == object->positionToNodeIdMap.end())
+                    continue;
+                auto bindingIt = nodeBindings.find(it->second);
+                if (bindingIt == nodeBindings.end())
+                    continue;
+                storeBinding(i, bindingIt->second);
+            }
+        });
     }
 
     m_errorMessage = "";
     return true;
 }
 
-void RigGenerator::attachSingleNodesToBone(const Snapshot* snapshot,
-    const std::string& boneName,
+void RigGenerator::attachSingleNodesToBone(const std::string& boneName,
     const std::set<Uuid>& boneEdgeNodes,
     const std::set<Uuid>& allEdgeNodes,
     const std::set<Uuid>& nodesWithAnyEdge,
     std::vector<std::vector<Uuid>>& nodeChains)
 {
-    for (const auto& nodePair : snapshot->nodes) {
-        Uuid nodeId(nodePair.first);
-
-        if (!nodeBelongsToModelPart(snapshot, nodeId))
-            continue;
-
+    for (const auto& nodeId : m_snapshotIndex.modelNodes) {
         // Only attach nodes that have NO edges at all (truly isolated).
         // If a node has edges (even without bone assignment), skip it.
         if (nodesWithAnyEdge.count(nodeId))
@@ -1218,7 +1179,7 @@ void RigGenerator::attachSingleNodesToBone(const Snapshot* snapshot,
             continue;
 
         float nx = 0, ny = 0, nz = 0;
-        if (!getNodePosition(snapshot, nodeId, nx, ny, nz))
+        if (!getNodePosition(nodeId, nx, ny, nz))
             continue;
 
         // Find nearest node among this bone's edge-connected nodes
@@ -1226,7 +1187,7 @@ void RigGenerator::attachSingleNodesToBone(const Snapshot* snapshot,
         bool foundNearest = false;
         for (const auto& candidateId : boneEdgeNodes) {
             float cx = 0, cy = 0, cz = 0;
-            if (!getNodePosition(snapshot, candidateId, cx, cy, cz))
+            if (!getNodePosition(candidateId, cx, cy, cz))
                 continue;
             float dx = nx - cx, dy = ny - cy, dz = nz - cz;
             float dist = dx * dx + dy * dy + dz * dz;
@@ -1243,7 +1204,7 @@ void RigGenerator::attachSingleNodesToBone(const Snapshot* snapshot,
                 if (boneEdgeNodes.count(candidateId))
                     continue;
                 float cx = 0, cy = 0, cz = 0;
-                if (!getNodePosition(snapshot, candidateId, cx, cy, cz))
+                if (!getNodePosition(candidateId, cx, cy, cz))
                     continue;
                 float dx = nx - cx, dy = ny - cy, dz = nz - cz;
                 float dist = dx * dx + dy * dy + dz * dz;
@@ -1262,15 +1223,14 @@ void RigGenerator::attachSingleNodesToBone(const Snapshot* snapshot,
     }
 }
 
-bool RigGenerator::extractNodeChainsForBone(const Snapshot* snapshot,
-    const std::string& boneName,
+bool RigGenerator::extractNodeChainsForBone(const std::string& boneName,
     std::vector<std::vector<Uuid>>& nodeChains)
 {
     nodeChains.clear();
 
     std::map<Uuid, std::vector<Uuid>> adjacency;
     std::set<Uuid> allNodes;
-    buildNodeAdjacency(snapshot, boneName, adjacency, allNodes);
+    buildNodeAdjacency(boneName, adjacency, allNodes);
 
     if (allNodes.empty()) {
         return false;
@@ -1338,8 +1298,7 @@ bool RigGenerator::extractNodeChainsForBone(const Snapshot* snapshot,
     return !nodeChains.empty();
 }
 
-void RigGenerator::orientChainTowardPoint(const Snapshot* snapshot,
-    std::vector<Uuid>& chain,
+void RigGenerator::orientChainTowardPoint(std::vector<Uuid>& chain,
     float refX, float refY, float refZ)
 {
     if (chain.size() < 2)
@@ -1348,9 +1307,9 @@ void RigGenerator::orientChainTowardPoint(const Snapshot* snapshot,
     float frontX, frontY, frontZ;
     float backX, backY, backZ;
 
-    if (!getNodePosition(snapshot, chain.front(), frontX, frontY, frontZ))
+    if (!getNodePosition(chain.front(), frontX, frontY, frontZ))
         return;
-    if (!getNodePosition(snapshot, chain.back(), backX, backY, backZ))
+    if (!getNodePosition(chain.back(), backX, backY, backZ))
         return;
 
     float distFront = (frontX - refX) * (frontX - refX)
@@ -1365,123 +1324,119 @@ void RigGenerator::orientChainTowardPoint(const Snapshot* snapshot,
     }
 }
 
-bool RigGenerator::getNodePositionInternal(const Snapshot* snapshot, const Uuid& nodeId,
-    float& x, float& y, float& z, std::set<std::string>& visited)
+void RigGenerator::buildSnapshotIndex(const Snapshot* snapshot)
 {
-    if (!snapshot)
-        return false;
-
-    std::string nodeIdString = nodeId.toString();
-    if (visited.count(nodeIdString))
-        return false; // cycle detected
+    m_snapshotIndex = SnapshotIndex();
+    m_snapshotIndex.snapshot = snapshot;
 
-    visited.insert(nodeIdString);
-
-    auto it = snapshot->nodes.find(nodeIdString);
-    if (it == snapshot->nodes.end())
-        return false;
+    std::set<std::string> modelPartIds;
+    for (const auto& partPair : snapshot->parts) {
+        if (targetPartIsModel(snapshot, partPair.first))
+            modelPartIds.insert(partPair.first);
+    }
 
-    std::string mirrorFromNodeId = String::valueOrEmpty(it->second, "__mirrorFromNodeId");
-    if (!mirrorFromNodeId.empty()) {
-        Uuid mirrorNode(mirrorFromNodeId);
-        float mx = 0, my = 0, mz = 0;
-        if (getNodePositionInternal(snapshot, mirrorNode, mx, my, mz, visited)) {
-            x = -mx;
-            y = my;
-            z = mz;
-            return true;
+    // Parse every node once, mirrors are resolved after all own positions are known
+    std::unordered_map<Uuid, std::array<float, 3>> ownPositions;
+    std::unordered_map<Uuid, Uuid> mirrorFromNodeIds;
+    std::set<Uuid> modelNodeSet;
+    ownPositions.reserve(snapshot->nodes.size());
+    for (const auto& nodePair : snapshot->nodes) {
+        Uuid nodeId(nodePair.first);
+        const auto& nodeAttributes = nodePair.second;
+        // Apply same coordinate transformation as MeshGenerator uses
+        ownPositions[nodeId] = {
+            String::toFloat(String::valueOrEmpty(nodeAttributes, "x")) - m_mainProfileMiddleX,
+            m_mainProfileMiddleY - String::toFloat(String::valueOrEmpty(nodeAttributes, "y")),
+            m_sideProfileMiddleX - String::toFloat(String::valueOrEmpty(nodeAttributes, "z"))
+        };
+        m_snapshotIndex.nodeRadiuses[nodeId] = String::toFloat(String::valueOrEmpty(nodeAttributes, "radius"));
+        std::string mirrorFromNodeId = String::valueOrEmpty(nodeAttributes, "__mirrorFromNodeId");
+        if (!mirrorFromNodeId.empty())
+            mirrorFromNodeIds[nodeId] = Uuid(mirrorFromNodeId);
+        if (modelPartIds.end() != modelPartIds.find(String::valueOrEmpty(nodeAttributes, "partId"))) {
+            m_snapshotIndex.modelNodes.push_back(nodeId);
+            modelNodeSet.insert(nodeId);
         }
+    }
 
-        // Fall back to this node when mirror source fails
+    // A mirrored node takes the flipped position of its source, a missing source or a mirror loop falls back to its own position
+    std::function<bool(const Uuid&, std::array<float, 3>&, std::set<Uuid>&)> resolvePosition;
+    resolvePosition = [&](const Uuid& nodeId, std::array<float, 3>& position, std::set<Uuid>& visited) {
+        if (!visited.insert(nodeId).second)
+            return false;
+        auto ownIt = ownPositions.find(nodeId);
+        if (ownIt == ownPositions.end())
+            return false;
+        auto mirrorIt = mirrorFromNodeIds.find(nodeId);
+        if (mirrorIt != mirrorFromNodeIds.end()) {
+            std::array<float, 3> mirrorPosition;
+            if (resolvePosition(mirrorIt->second, mirrorPosition, visited)) {
+                position = { -mirrorPosition[0], mirrorPosition[1], mirrorPosition[2] };
+                return true;
+            }
+        }
+        position = ownIt->second;
+        return true;
+    };
+    m_snapshotIndex.nodePositions.reserve(ownPositions.size());
+    for (const auto& it : ownPositions) {
+        std::array<float, 3> position;
+        std::set<Uuid> visited;
+        if (resolvePosition(it.first, position, visited))
+            m_snapshotIndex.nodePositions[it.first] = position;
     }
 
-    // Apply same coordinate transformation as MeshGenerator uses
-    x = (String::toFloat(String::valueOrEmpty(it->second, "x")) - m_mainProfileMiddleX);
-    y = (m_mainProfileMiddleY - String::toFloat(String::valueOrEmpty(it->second, "y")));
-    z = (m_sideProfileMiddleX - String::toFloat(String::valueOrEmpty(it->second, "z")));
-    return true;
+    for (const auto& edgePair : snapshot->edges) {
+        const auto& edgeAttributes = edgePair.second;
+        std::string fromNode = String::valueOrEmpty(edgeAttributes, "from");
+        std::string toNode = String::valueOrEmpty(edgeAttributes, "to");
+        if (fromNode.empty() || toNode.empty())
+            continue;
+        Uuid fromId(fromNode);
+        Uuid toId(toNode);
+        if (modelNodeSet.end() == modelNodeSet.find(fromId) || modelNodeSet.end() == modelNodeSet.find(toId))
+            continue;
+        m_snapshotIndex.nodesWithAnyEdge.insert(fromId);
+        m_snapshotIndex.nodesWithAnyEdge.insert(toId);
+        std::string boneName = String::valueOrEmpty(edgeAttributes, "boneName");
+        if (boneName.empty())
+            continue;
+        m_snapshotIndex.boneEdges[boneName].push_back({ fromId, toId });
+        m_snapshotIndex.nodeBoneNames[fromId].insert(boneName);
+        m_snapshotIndex.nodeBoneNames[toId].insert(boneName);
+    }
 }
 
-bool RigGenerator::getNodePosition(const Snapshot* snapshot, const Uuid& nodeId,
-    float& x, float& y, float& z)
+bool RigGenerator::getNodePosition(const Uuid& nodeId,
+    float& x, float& y, float& z) const
 {
-    std::set<std::string> visited;
-    return getNodePositionInternal(snapshot, nodeId, x, y, z, visited);
+    auto it = m_snapshotIndex.nodePositions.find(nodeId);
+    if (it == m_snapshotIndex.nodePositions.end())
+        return false;
+    x = it->second[0];
+    y = it->second[1];
+    z = it->second[2];
+    return true;
 }
 
-void RigGenerator::buildNodeAdjacency(const Snapshot* snapshot,
-    const std::string& boneName,
+void RigGenerator::buildNodeAdjacency(const std::string& boneName,
     std::map<Uuid, std::vector<Uuid>>& adjacency,
     std::set<Uuid>& allNodes)
 {
     adjacency.clear();
     allNodes.clear();
 
-    auto edgesForBone = getEdgesWithBoneName(snapshot, boneName);
-
-    for (const auto* edge : edgesForBone) {
-        if (!edge)
-            continue;
-
-        std::string fromNodeIdString = String::valueOrEmpty(*edge, "from");
-        std::string toNodeIdString = String::valueOrEmpty(*edge, "to");
-
-        if (fromNodeIdString.empty() || toNodeIdString.empty())
-            continue;
-
-        Uuid n1(fromNodeIdString);
-        Uuid n2(toNodeIdString);
-
-        adjacency[n1].push_back(n2);
-        adjacency[n2].push_back(n1);
-
-        allNodes.insert(n1);
-        allNodes.insert(n2);
-    }
-}
-
-std::vector<const std::map<std::string, std::string>*> RigGenerator::getEdgesWithBoneName(
-    const Snapshot* snapshot,
-    const std::string& boneName)
-{
-    std::vector<const std::map<std::string, std::string>*> result;
-
-    for (const auto& edgePair : snapshot->edges) {
-        const auto& edgeAttributes = edgePair.second;
-        std::string edgeBoneName = String::valueOrEmpty(edgeAttributes, "boneName");
-        if (edgeBoneName == boneName && edgeBelongsToModelPart(snapshot, edgeAttributes)) {
-            result.push_back(&edgeAttributes);
-        }
-    }
-
-    return result;
-}
-
-bool RigGenerator::nodeHasEdgeWithBoneName(const Snapshot* snapshot,
-    const Uuid& nodeId,
-    const std::string& boneName)
-{
-    std::string nodeIdString = nodeId.toString();
+    auto findEdges = m_snapshotIndex.boneEdges.find(boneName);
+    if (findEdges == m_snapshotIndex.boneEdges.end())
+        return;
 
-    for (const auto& edgePair : snapshot->edges) {
-        const auto& edgeAttributes = edgePair.second;
-        std::string fromNode = String::valueOrEmpty(edgeAttributes, "from");
-        std::string toNode = String::valueOrEmpty(edgeAttributes, "to");
-        std::string edgeBoneName = String::valueOrEmpty(edgeAttributes, "boneName");
+    for (const auto& edge : findEdges->second) {
+        adjacency[edge.first].push_back(edge.second);
+        adjacency[edge.second].push_back(edge.first);
 
-        if ((fromNode == nodeIdString || toNode == nodeIdString) && edgeBoneName == boneName) {
-            return true;
-        }
+        allNodes.insert(edge.first);
+        allNodes.insert(edge.second);
     }
-
-    return false;
-}
-
-std::string RigGenerator::getEdgeBoneName(const std::map<std::string, std::string>* edge)
-{
-    if (!edge)
-        return "";
-    return String::valueOrEmpty(*edge, "boneName");
 }
 
 bool RigGenerator::generateEyelidBones(Object* object, const Snapshot* snapshot, RigStructure& actualRig)
@@ -1503,7 +1458,7 @@ bool RigGenerator::generateEyelidBones(Object* object, const Snapshot* snapshot,
     // Collect vertices bound to Head bone
     std::set<size_t> headVertices;
     for (size_t i = 0; i < object->vertexBone1.size(); ++i) {
-        if (object->vertexBone1[i].first == "Head")
+        if (object->vertexBoneName(object->vertexBone1[i].first) == "Head")
             headVertices.insert(i);
     }
     if (headVertices.empty()) {
@@ -1887,6 +1842,8 @@ bool RigGenerator::generateEyelidBones(Object* object, const Snapshot* snapshot,
 
         Vector3 boneMid = holes[hi].center;
 
+        int upperBone = object->addBoneName(upperName);
+        int lowerBone = object->addBoneName(lowerName);
         size_t upperCount = 0, lowerCount = 0;
         for (size_t vi = 0; vi < object->vertices.size(); ++vi) {
             PositionKey pk(object->vertices[vi]);
@@ -1895,12 +1852,12 @@ bool RigGenerator::generateEyelidBones(Object* object, const Snapshot* snapshot,
                 continue;
             size_t pid = it->second;
             if (upperSet.count(pid)) {
-                object->vertexBone1[vi] = { upperName, 1.0f };
-                object->vertexBone2[vi] = { "", 0.0f };
+                object->vertexBone1[vi] = { upperBone, 1.0f };
+                object->vertexBone2[vi] = { -1, 0.0f };
                 ++upperCount;
             } else if (lowerSet.count(pid)) {
-                object->vertexBone1[vi] = { lowerName, 1.0f };
-                object->vertexBone2[vi] = { "", 0.0f };
+                object->vertexBone1[vi] = { lowerBone, 1.0f };
+                object->vertexBone2[vi] = { -1, 0.0f };
                 ++lowerCount;
             }
         }
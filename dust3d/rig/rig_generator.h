@@ -23,6 +23,7 @@
 #ifndef DUST3D_RIG_RIG_GENERATOR_H_
 #define DUST3D_RIG_RIG_GENERATOR_H_
 
+#include <array>
 #include <dust3d/base/bone_binding.h>
 #include <dust3d/base/matrix4x4.h>
 #include <dust3d/base/object.h>
@@ -31,6 +32,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace dust3d {
@@ -80,8 +82,8 @@ public:
         std::map<Uuid, NodeBoneInfluence>& nodeBoneInfluences);
 
     // Compute vertex bone bindings for a generated mesh object
-    // Uses the mesh's positionToNodeIdMap to trace vertices back to nodes,
-    // then applies node bone influences to create vertex bindings
+    // Uses the mesh's vertexSourceNodes to trace vertices back to nodes, falling back to
+    // positionToNodeIdMap, then applies node bone influences to create vertex bindings
     bool computeVertexBoneBindings(Object* object,
         const std::map<Uuid, NodeBoneInfluence>& nodeBoneInfluences);
 
@@ -112,44 +114,45 @@ private:
     float m_mainProfileMiddleY = 0.0f;
     float m_sideProfileMiddleX = 0.0f;
 
+    // Snapshot lookups shared by every step, built in one pass over the snapshot,
+    // so no step scans all edges or parses node attributes again
+    struct SnapshotIndex {
+        const Snapshot* snapshot = nullptr;
+        // Node positions, resolved through mirrors and moved by the canvas origin
+        std::unordered_map<Uuid, std::array<float, 3>> nodePositions;
+        std::unordered_map<Uuid, float> nodeRadiuses;
+        // Nodes of model parts, in snapshot order
+        std::vector<Uuid> modelNodes;
+        // Model edges assigned to each bone, in snapshot order
+        std::map<std::string, std::vector<std::pair<Uuid, Uuid>>> boneEdges;
+        // Bone names of the model edges around each node
+        std::unordered_map<Uuid, std::set<std::string>> nodeBoneNames;
+        // Nodes with any model edge, assigned to a bone or not
+        std::set<Uuid> nodesWithAnyEdge;
+    };
+    SnapshotIndex m_snapshotIndex;
+
+    // Helper: Build m_snapshotIndex, node positions use the current canvas origin
+    void buildSnapshotIndex(const Snapshot* snapshot);
+
     // Helper: Extract all connected chains of nodes for a given bone name
     // Each chain is an ordered list of node UUIDs.
     // Multiple disconnected groups of edges produce multiple chains.
-    bool extractNodeChainsForBone(const Snapshot* snapshot,
-        const std::string& boneName,
+    bool extractNodeChainsForBone(const std::string& boneName,
         std::vector<std::vector<Uuid>>& nodeChains);
 
     // Helper: Build node connectivity graph from edges with a given bone name
-    void buildNodeAdjacency(const Snapshot* snapshot,
-        const std::string& boneName,
+    void buildNodeAdjacency(const std::string& boneName,
         std::map<Uuid, std::vector<Uuid>>& adjacency,
         std::set<Uuid>& allNodes);
 
     // Helper: Orient a chain so its end closest to refPoint comes first
-    void orientChainTowardPoint(const Snapshot* snapshot,
-        std::vector<Uuid>& chain,
+    void orientChainTowardPoint(std::vector<Uuid>& chain,
         float refX, float refY, float refZ);
 
-    // Helper: Get position of a single node from the snapshot
-    bool getNodePosition(const Snapshot* snapshot, const Uuid& nodeId,
-        float& x, float& y, float& z);
-
-    // Internal helper that tracks visited node ids to prevent mirror loops
-    bool getNodePositionInternal(const Snapshot* snapshot, const Uuid& nodeId,
-        float& x, float& y, float& z, std::set<std::string>& visited);
-
-    // Helper: Get all edges with a specific bone name
-    std::vector<const std::map<std::string, std::string>*> getEdgesWithBoneName(
-        const Snapshot* snapshot,
-        const std::string& boneName);
-
-    // Helper: Check if node has edge with given boneName
-    bool nodeHasEdgeWithBoneName(const Snapshot* snapshot,
-        const Uuid& nodeId,
-        const std::string& boneName);
-
-    // Helper: Get bone name from edge (or empty string if not assigned)
-    std::string getEdgeBoneName(const std::map<std::string, std::string>* edge);
+    // Helper: Get position of a single node from the snapshot index
+    bool getNodePosition(const Uuid& nodeId,
+        float& x, float& y, float& z) const;
 
     // Helper: Compute lerp weight for a node influenced by two bones,
     // using rig hierarchy and bone semantics
@@ -160,8 +163,7 @@ private:
     // Helper: Find truly isolated nodes (no edges at all) that are nearest
     // to the given bone's edge-connected nodes, and append them as single-node chains.
     // Also records the mapping in m_singleNodeBoneMap for use by computeNodeBoneInfluences.
-    void attachSingleNodesToBone(const Snapshot* snapshot,
-        const std::string& boneName,
+    void attachSingleNodesToBone(const std::string& boneName,
         const std::set<Uuid>& boneEdgeNodes,
         const std::set<Uuid>& allEdgeNodes,
         const std::set<Uuid>& nodesWithAnyEdge,
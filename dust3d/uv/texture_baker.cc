@@ -0,0 +1,297 @@
+/*
+ *  Copyright (c) 2016-2026 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <dust3d/base/parallel.h>
+#include <dust3d/mesh/resolve_triangle_tangent.h>
+#include <dust3d/uv/texture_baker.h>
+
+namespace dust3d {
+
+const size_t TextureBaker::m_tileSize = 32;
+
+static uint32_t hashTexelIndex(uint32_t value)
+{
+    value = (value ^ 61) ^ (value >> 16);
+    value *= 9;
+    value = value ^ (value >> 4);
+    value *= 0x27d4eb2d;
+    value = value ^ (value >> 15);
+    return value;
+}
+
+static double radicalInverse(uint32_t bits)
+{
+    bits = (bits << 16) | (bits >> 16);
+    bits = ((bits & 0x55555555u) << 1) | ((bits & 0xAAAAAAAAu) >> 1);
+    bits = ((bits & 0x33333333u) << 2) | ((bits & 0xCCCCCCCCu) >> 2);
+    bits = ((bits & 0x0F0F0F0Fu) << 4) | ((bits & 0xF0F0F0F0u) >> 4);
+    bits = ((bits & 0x00FF00FFu) << 8) | ((bits & 0xFF00FF00u) >> 8);
+    return (double)bits * 2.3283064365386963e-10;
+}
+
+static Vector3 orthogonalTangent(const Vector3& tangent, const Vector3& normal)
+{
+    Vector3 result = (tangent - normal * Vector3::dotProduct(tangent, normal)).normalized();
+    if (result.isZero())
+        result = Vector3::crossProduct(normal, std::abs(normal.x()) < 0.9 ? Vector3(1.0, 0.0, 0.0) : Vector3(0.0, 1.0, 0.0)).normalized();
+    return result;
+}
+
+static bool intersectRayAndBox(const Vector3& origin, const Vector3& inverseDirection, double maxDistance,
+    const AxisAlignedBoudingBox& box)
+{
+    double nearest = 0.0;
+    double farthest = maxDistance;
+    for (size_t i = 0; i < 3; ++i) {
+        double t0 = (box.lowerBound()[i] - origin[i]) * inverseDirection[i];
+        double t1 = (box.upperBound()[i] - origin[i]) * inverseDirection[i];
+        if (t0 > t1)
+            std::swap(t0, t1);
+        nearest = std::max(nearest, t0);
+        farthest = std::min(farthest, t1);
+        if (nearest > farthest)
+            return false;
+    }
+    return true;
+}
+
+static bool intersectRayAndTriangle(const Vector3& origin, const Vector3& direction, double maxDistance,
+    const Vector3& a, const Vector3& b, const Vector3& c)
+{
+    Vector3 ab = b - a;
+    Vector3 ac = c - a;
+    Vector3 p = Vector3::crossProduct(direction, ac);
+    double determinant = Vector3::dotProduct(ab, p);
+    if (std::abs(determinant) <= std::numeric_limits<double>::epsilon())
+        return false;
+    double inverseDeterminant = 1.0 / determinant;
+    Vector3 s = origin - a;
+    double u = Vector3::dotProduct(s, p) * inverseDeterminant;
+    if (u < 0.0 || u > 1.0)
+        return false;
+    Vector3 q = Vector3::crossProduct(s, ab);
+    double v = Vector3::dotProduct(direction, q) * inverseDeterminant;
+    if (v < 0.0 || u + v > 1.0)
+        return false;
+    double t = Vector3::dotProduct(ac, q) * inverseDeterminant;
+    return t > 0.0 && t <= maxDistance;
+}
+
+TextureBaker::TextureBaker(const Object* object)
+    : m_object(object)
+{
+}
+
+void TextureBaker::setTextureSize(size_t textureSize)
+{
+    m_textureSize = textureSize;
+}
+
+void TextureBaker::setAmbientOcclusionSampleCount(size_t sampleCount)
+{
+    m_ambientOcclusionSampleCount = sampleCount;
+}
+
+void TextureBaker::setAmbientOcclusionDistance(double distance)
+{
+    m_ambientOcclusionDistance = distance;
+}
+
+size_t TextureBaker::textureSize() const
+{
+    return m_textureSize;
+}
+
+const std::vector<bool>& TextureBaker::texelCoverage() const
+{
+    return m_texelCoverage;
+}
+
+const std::vector<float>& TextureBaker::ambientOcclusionMap() const
+{
+    return m_ambientOcclusionMap;
+}
+
+void TextureBaker::rasterizeTriangles()
+{
+    const auto& triangleVertexUvs = *m_object->triangleVertexUvs();
+    const double size = (double)m_textureSize;
+    for (size_t triangleIndex = 0; triangleIndex < m_object->triangles.size(); ++triangleIndex) {
+        const auto& uvs = triangleVertexUvs[triangleIndex];
+        Vector2 a = uvs[0] * size;
+        Vector2 b = uvs[1] * size;
+        Vector2 c = uvs[2] * size;
+        double area = (b.x() - a.x()) * (c.y() - a.y()) - (c.x() - a.x()) * (b.y() - a.y());
+        if (Math::isZero(area))
+            continue;
+        double inverseArea = 1.0 / area;
+        int left = std::max(0, (int)std::floor(std::min({ a.x(), b.x(), c.x() })));
+        int right = std::min((int)m_textureSize - 1, (int)std::ceil(std::max({ a.x(), b.x(), c.x() })));
+        int top = std::max(0, (int)std::floor(std::min({ a.y(), b.y(), c.y() })));
+        int bottom = std::min((int)m_textureSize - 1, (int)std::ceil(std::max({ a.y(), b.y(), c.y() })));
+        for (int y = top; y <= bottom; ++y) {
+            for (int x = left; x <= right; ++x) {
+                Vector2 point(x + 0.5, y + 0.5);
+                double alpha = ((b.x() - point.x()) * (c.y() - point.y()) - (c.x() - point.x()) * (b.y() - point.y())) * inverseArea;
+                double beta = ((c.x() - point.x()) * (a.y() - point.y()) - (a.x() - point.x()) * (c.y() - point.y())) * inverseArea;
+                double gamma = 1.0 - alpha - beta;
+                if (alpha < 0.0 || beta < 0.0 || gamma < 0.0)
+                    continue;
+                size_t texelIndex = (size_t)y * m_textureSize + x;
+                m_texelCoverage[texelIndex] = true;
+                m_texelSamples[texelIndex].triangleIndex = triangleIndex;
+                m_texelSamples[texelIndex].barycentric = Vector3(alpha, beta, gamma);
+            }
+        }
+    }
+}
+
+bool TextureBaker::isOccluded(const Vector3& origin, const Vector3& direction, double maxDistance, size_t ignoreTriangleIndex) const
+{
+    const auto& vertices = *m_solidMesh.vertices();
+    const auto& triangles = *m_solidMesh.triangles();
+    const auto* tree = m_solidMesh.axisAlignedBoundingBoxTree();
+    Vector3 inverseDirection(1.0 / direction.x(), 1.0 / direction.y(), 1.0 / direction.z());
+    // One traversal stack per baking thread, reused by all of its rays instead of allocated for each one
+    static thread_local std::vector<const AxisAlignedBoudingBoxTree::Node*> stack;
+    stack.clear();
+    stack.push_back(tree->root());
+    while (!stack.empty()) {
+        const auto* node = stack.back();
+        stack.pop_back();
+        if (!intersectRayAndBox(origin, inverseDirection, maxDistance, node->boundingBox))
+            continue;
+        if (node->isLeaf()) {
+            for (const auto& triangleIndex : node->boxIndices) {
+                if (triangleIndex == ignoreTriangleIndex)
+                    continue;
+                const auto& triangle = triangles[triangleIndex];
+                if (intersectRayAndTriangle(origin, direction, maxDistance,
+                        vertices[triangle[0]], vertices[triangle[1]], vertices[triangle[2]]))
+                    return true;
+            }
+            continue;
+        }
+        stack.push_back(node->left);
+        stack.push_back(node->right);
+    }
+    return false;
+}
+
+void TextureBaker::bakeTile(size_t tileIndex, double rayOffset, double rayDistance)
+{
+    const auto* triangleVertexNormals = m_object->triangleVertexNormals();
+    const auto& triangleNormals = *m_solidMesh.triangleNormals();
+    size_t tilesPerRow = (m_textureSize + m_tileSize - 1) / m_tileSize;
+    size_t left = (tileIndex % tilesPerRow) * m_tileSize;
+    size_t top = (tileIndex / tilesPerRow) * m_tileSize;
+    size_t right = std::min(m_textureSize, left + m_tileSize);
+    size_t bottom = std::min(m_textureSize, top + m_tileSize);
+    for (size_t y = top; y < bottom; ++y) {
+        for (size_t x = left; x < right; ++x) {
+            size_t texelIndex = y * m_textureSize + x;
+            if (!m_texelCoverage[texelIndex])
+                continue;
+            const auto& sample = m_texelSamples[texelIndex];
+            const auto& triangle = m_object->triangles[sample.triangleIndex];
+            const auto& barycentric = sample.barycentric;
+            Vector3 position = m_object->vertices[triangle[0]] * barycentric[0]
+                + m_object->vertices[triangle[1]] * barycentric[1]
+                + m_object->vertices[triangle[2]] * barycentric[2];
+            const Vector3& faceNormal = triangleNormals[sample.triangleIndex];
+            Vector3 normal = faceNormal;
+            if (nullptr != triangleVertexNormals) {
+                const auto& cornerNormals = (*triangleVertexNormals)[sample.triangleIndex];
+                normal = (cornerNormals[0] * barycentric[0]
+                    + cornerNormals[1] * barycentric[1]
+                    + cornerNormals[2] * barycentric[2])
+                             .normalized();
+                if (normal.isZero())
+                    normal = faceNormal;
+            }
+
+            // Cosine weighted Hammersley directions, rotated per texel to trade banding for noise
+            Vector3 tangent = orthogonalTangent(m_triangleTangents[sample.triangleIndex], normal);
+            Vector3 bitangent = Vector3::crossProduct(normal, tangent);
+            uint32_t seed = hashTexelIndex((uint32_t)texelIndex);
+            double rotationU = (double)(seed & 0xffff) / 65536.0;
+            double rotationV = (double)(seed >> 16) / 65536.0;
+            Vector3 origin = position + faceNormal * rayOffset;
+            size_t hitCount = 0;
+            for (size_t i = 0; i < m_ambientOcclusionSampleCount; ++i) {
+                double u = std::fmod((i + 0.5) / m_ambientOcclusionSampleCount + rotationU, 1.0);
+                double v = std::fmod(radicalInverse((uint32_t)i) + rotationV, 1.0);
+                double radius = std::sqrt(u);
+                double phi = 2.0 * Math::Pi * v;
+                Vector3 direction = tangent * (radius * std::cos(phi))
+                    + bitangent * (radius * std::sin(phi))
+                    + normal * std::sqrt(std::max(0.0, 1.0 - u));
+                if (Vector3::dotProduct(direction, faceNormal) <= 0.0)
+                    direction -= faceNormal * (2.0 * Vector3::dotProduct(direction, faceNormal));
+                if (isOccluded(origin, direction, rayDistance, sample.triangleIndex))
+                    ++hitCount;
+            }
+            m_ambientOcclusionMap[texelIndex] = 1.0f - (float)hitCount / m_ambientOcclusionSampleCount;
+        }
+    }
+}
+
+bool TextureBaker::bake()
+{
+    if (nullptr == m_object || 0 == m_textureSize)
+        return false;
+    if (nullptr == m_object->triangleVertexUvs() || m_object->triangles.empty())
+        return false;
+
+    if (nullptr != m_object->triangleTangents())
+        m_triangleTangents = *m_object->triangleTangents();
+    else
+        resolveTriangleTangent(*m_object, m_triangleTangents);
+
+    m_solidMesh.setVertices(&m_object->vertices);
+    m_solidMesh.setTriangles(&m_object->triangles);
+    m_solidMesh.prepare();
+
+    const auto& rootBox = m_solidMesh.axisAlignedBoundingBoxTree()->root()->boundingBox;
+    double diagonal = (rootBox.upperBound() - rootBox.lowerBound()).length();
+    double rayDistance = m_ambientOcclusionDistance > 0.0 ? m_ambientOcclusionDistance : diagonal * 0.15;
+    double rayOffset = diagonal * 0.0001;
+
+    size_t texelCount = m_textureSize * m_textureSize;
+    m_texelSamples.assign(texelCount, TexelSample());
+    m_texelCoverage.assign(texelCount, false);
+    m_ambientOcclusionMap.assign(texelCount, 1.0f);
+
+    rasterizeTriangles();
+    if (0 == m_ambientOcclusionSampleCount)
+        return true;
+
+    size_t tilesPerRow = (m_textureSize + m_tileSize - 1) / m_tileSize;
+    parallelFor(tilesPerRow * tilesPerRow, 1, [&](size_t begin, size_t end) {
+        for (size_t tileIndex = begin; tileIndex < end; ++tileIndex)
+            bakeTile(tileIndex, rayOffset, rayDistance);
+    });
+
+    return true;
+}
+
+}
@@ -0,0 +1,77 @@
+/*
+ *  Copyright (c) 2016-2026 Jeremy HU <jeremy-at-dust3d dot org>. All rights reserved. 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef DUST3D_UV_TEXTURE_BAKER_H_
+#define DUST3D_UV_TEXTURE_BAKER_H_
+
+#include <dust3d/base/object.h>
+#include <dust3d/base/vector3.h>
+#include <dust3d/mesh/solid_mesh.h>
+#include <vector>
+
+namespace dust3d {
+
+// Bake per-texel ambient occlusion of an object into its UV atlas on the CPU.
+// There is no normal map: sampled from the surface it is baked into, in the interpolated
+// normal and tangent frame the renderers decode it with, it would be flat everywhere.
+// Every triangle is rasterized into the atlas through triangleVertexUvs, then
+// the covered texels are processed in tiles on all hardware threads, tracing
+// hemisphere rays against a bounding volume hierarchy of the object itself.
+// Sample directions are derived from the texel index only, so the result is
+// identical between runs and independent of thread scheduling.
+class TextureBaker {
+public:
+    TextureBaker(const Object* object);
+    void setTextureSize(size_t textureSize);
+    void setAmbientOcclusionSampleCount(size_t sampleCount);
+    void setAmbientOcclusionDistance(double distance);
+    bool bake();
+    size_t textureSize() const;
+    const std::vector<bool>& texelCoverage() const;
+    const std::vector<float>& ambientOcclusionMap() const;
+
+private:
+    struct TexelSample {
+        size_t triangleIndex = 0;
+        Vector3 barycentric;
+    };
+
+    const Object* m_object = nullptr;
+    size_t m_textureSize = 512;
+    size_t m_ambientOcclusionSampleCount = 16;
+    double m_ambientOcclusionDistance = 0.0;
+    std::vector<Vector3> m_triangleTangents;
+    SolidMesh m_solidMesh;
+    std::vector<TexelSample> m_texelSamples;
+    std::vector<bool> m_texelCoverage;
+    std::vector<float> m_ambientOcclusionMap;
+
+    static const size_t m_tileSize;
+
+    void rasterizeTriangles();
+    void bakeTile(size_t tileIndex, double rayOffset, double rayDistance);
+    bool isOccluded(const Vector3& origin, const Vector3& direction, double maxDistance, size_t ignoreTriangleIndex) const;
+};
+
+}
+
+#endif